@@ -0,0 +1,73 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#include "block_device.h"
+#include <string.h>
+
+static bool block_device_range_valid(const block_device_t *dev, uint32_t address, uint32_t size) {
+    uint64_t device_size = (uint64_t)dev->sector_size * dev->sector_count;
+    return (uint64_t)address + size <= device_size;
+}
+
+esp_err_t block_device_read(block_device_t *dev, uint32_t address, void *buffer, uint32_t size) {
+
+    if (!block_device_range_valid(dev, address, size)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    esp_err_t ret = dev->ops->read(dev, address, buffer, size);
+    if (ret == ESP_OK) {
+        dev->stats.bytes_read += size;
+        dev->stats.read_count++;
+    }
+    return ret;
+}
+
+esp_err_t block_device_prog(block_device_t *dev, uint32_t address, const void *buffer, uint32_t size) {
+
+    if (!block_device_range_valid(dev, address, size)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    esp_err_t ret = dev->ops->prog(dev, address, buffer, size);
+    if (ret == ESP_OK && size > 0) {
+        dev->stats.bytes_programmed += size;
+        dev->stats.prog_count++;
+        /* Pages touched by this prog - every one is a separate page program command */
+        dev->stats.page_prog_count += (address + size - 1) / dev->page_size - address / dev->page_size + 1;
+    }
+    return ret;
+}
+
+esp_err_t block_device_erase(block_device_t *dev, uint32_t sector) {
+
+    if (sector >= dev->sector_count) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    esp_err_t ret = dev->ops->erase(dev, sector * dev->sector_size);
+    if (ret == ESP_OK) {
+        dev->stats.erase_count++;
+    }
+    return ret;
+}
+
+esp_err_t block_device_sync(block_device_t *dev) {
+
+    if (dev->ops->sync == NULL) {
+        return ESP_OK;
+    }
+    return dev->ops->sync(dev);
+}
+
+void block_device_get_stats(const block_device_t *dev, block_device_stats_t *stats) {
+    *stats = dev->stats;
+}
+
+void block_device_reset_stats(block_device_t *dev) {
+    memset(&dev->stats, 0, sizeof(dev->stats));
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#ifndef BLOCK_DEVICE_H
+#define BLOCK_DEVICE_H
+
+/*
+ * Block device under LittleFS
+ *
+ * A NOR flash seen as sectors (erase unit) made of pages (program unit). Backends:
+ *  - block_device_w25q.c: the external W25Q128JV over SPI (ext_flash.h)
+ *  - block_device_emu.c:  NOR flash emulator in RAM or in an mmap'd file (Linux only), for host builds and benchmarks
+ *
+ * All calls go through block_device_read/prog/erase/sync, which check the range and count the IO.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+typedef struct block_device block_device_t;
+
+/* Backend functions, addresses and sizes are already checked against the device size */
+typedef struct {
+    esp_err_t (*read)(block_device_t *dev, uint32_t address, void *buffer, uint32_t size);
+    esp_err_t (*prog)(block_device_t *dev, uint32_t address, const void *buffer, uint32_t size);
+    esp_err_t (*erase)(block_device_t *dev, uint32_t address); // Erase the sector at a sector-aligned address
+    esp_err_t (*sync)(block_device_t *dev);                      // Wait for pending operations, can be NULL
+} block_device_ops_t;
+
+/* IO done on a block device since it was created (or block_device_reset_stats) */
+typedef struct {
+    uint64_t bytes_read;
+    uint64_t bytes_programmed;
+    uint32_t read_count;
+    uint32_t prog_count;
+    uint32_t page_prog_count;       // Page program commands (a prog is split at page boundaries)
+    uint32_t erase_count;
+    uint64_t busy_time_us;          // Time spent in flash operations (measured on hardware, modelled by the emulator)
+} block_device_stats_t;
+
+struct block_device {
+    const char *name;
+    const block_device_ops_t *ops;
+    uint32_t page_size;             // Program unit in bytes
+    uint32_t sector_size;           // Erase unit in bytes
+    uint32_t sector_count;
+    block_device_stats_t stats;
+    void *ctx;                      // Backend state
+};
+
+/**
+ * @brief Reads data from a block device.
+ *
+ * @param dev Block device.
+ * @param address Byte address.
+ * @param buffer Destination buffer.
+ * @param size Number of bytes.
+ * @return ESP_OK on success, ESP_ERR_INVALID_SIZE if the range is outside the device, or a backend error.
+ */
+esp_err_t block_device_read(block_device_t *dev, uint32_t address, void *buffer, uint32_t size);
+
+/**
+ * @brief Programs data to a block device. Like on NOR flash, programming can only clear bits.
+ *
+ * @param dev Block device.
+ * @param address Byte address (any alignment, split at page boundaries by the backend).
+ * @param buffer Data to program.
+ * @param size Number of bytes.
+ * @return ESP_OK on success, ESP_ERR_INVALID_SIZE if the range is outside the device, or a backend error.
+ */
+esp_err_t block_device_prog(block_device_t *dev, uint32_t address, const void *buffer, uint32_t size);
+
+/**
+ * @brief Erases one sector (all bytes become 0xFF).
+ *
+ * @param dev Block device.
+ * @param sector Sector index.
+ * @return ESP_OK on success, ESP_ERR_INVALID_SIZE if the sector does not exist, or a backend error.
+ */
+esp_err_t block_device_erase(block_device_t *dev, uint32_t sector);
+
+/**
+ * @brief Waits until all operations on the device are finished.
+ *
+ * @param dev Block device.
+ * @return ESP_OK on success, or a backend error.
+ */
+esp_err_t block_device_sync(block_device_t *dev);
+
+/**
+ * @brief Gets the IO counters of a block device.
+ */
+void block_device_get_stats(const block_device_t *dev, block_device_stats_t *stats);
+
+/**
+ * @brief Clears the IO counters of a block device.
+ */
+void block_device_reset_stats(block_device_t *dev);
+
+/**
+ * @brief Gets the block device for the external W25Q128JV flash.
+ *
+ * The flash must be initialized with ext_flash_init() before the device is used.
+ *
+ * @return Pointer to the static W25Q128JV block device.
+ */
+block_device_t *block_device_w25q_get(void);
+
+#endif // BLOCK_DEVICE_H
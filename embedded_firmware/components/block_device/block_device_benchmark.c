@@ -0,0 +1,123 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#include "block_device_benchmark.h"
+#include "block_device_emu.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include <string.h>
+
+static const char *TAG = "BLOCK_DEVICE_BENCHMARK";
+
+const block_device_benchmark_read_t block_device_benchmark_reads[] = {
+    { "standard (0x0B)",    W25Q128JV_FAST_READ_CLOCKS,          1 },
+    { "dual output (0x3B)", W25Q128JV_FAST_READ_DUAL_OUT_CLOCKS, 2 },
+    { "dual I/O (0xBB)",    W25Q128JV_FAST_READ_DUAL_IO_CLOCKS,  2 },
+    { "quad output (0x6B)", W25Q128JV_FAST_READ_QUAD_OUT_CLOCKS, 4 },
+    { "quad I/O (0xEB)",    W25Q128JV_FAST_READ_QUAD_IO_CLOCKS,  4 },
+};
+const uint32_t block_device_benchmark_read_count = sizeof(block_device_benchmark_reads) / sizeof(block_device_benchmark_reads[0]);
+
+static uint8_t benchmark_buffer[BLOCK_DEVICE_BENCHMARK_LARGE_READ] __attribute__((aligned(4)));
+
+static uint8_t benchmark_pattern(uint32_t address) {
+    return (uint8_t)(address ^ (address >> 8) ^ (address >> 16));
+}
+
+static uint32_t benchmark_kb_s(uint64_t elapsed_us) {
+    return elapsed_us > 0 ? (uint32_t)((uint64_t)BLOCK_DEVICE_BENCHMARK_SIZE * 1000000 / 1024 / elapsed_us) : 0;
+}
+
+/* Reads BLOCK_DEVICE_BENCHMARK_SIZE bytes in reads of read_size, checks them against the pattern if asked */
+static esp_err_t benchmark_read(block_device_t *dev, uint32_t read_size, bool verify, uint64_t *elapsed_us) {
+
+    uint64_t start_us = dev->stats.busy_time_us;
+
+    for (uint32_t address = 0; address < BLOCK_DEVICE_BENCHMARK_SIZE; address += read_size) {
+        ESP_RETURN_ON_ERROR(block_device_read(dev, address, benchmark_buffer, read_size),
+                            TAG, "Read failed at 0x%06lX", address);
+        for (uint32_t i = 0; verify && i < read_size; i++) {
+            if (benchmark_buffer[i] != benchmark_pattern(address + i)) {
+                ESP_LOGE(TAG, "Wrong data at 0x%06lX", address + i);
+                return ESP_ERR_INVALID_CRC;
+            }
+        }
+    }
+    *elapsed_us = dev->stats.busy_time_us - start_us;
+    return ESP_OK;
+}
+
+static esp_err_t benchmark_run(block_device_t *dev, bool verify, block_device_benchmark_result_t *result) {
+
+    memset(result, 0, sizeof(*result));
+    if ((uint64_t)dev->sector_size * dev->sector_count < BLOCK_DEVICE_BENCHMARK_SIZE) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    ESP_RETURN_ON_ERROR(benchmark_read(dev, BLOCK_DEVICE_BENCHMARK_LARGE_READ, verify, &result->large_read_us), TAG, "Large reads failed");
+    ESP_RETURN_ON_ERROR(benchmark_read(dev, BLOCK_DEVICE_BENCHMARK_SMALL_READ, verify, &result->small_read_us), TAG, "Small reads failed");
+    result->large_read_kb_s = benchmark_kb_s(result->large_read_us);
+    result->small_read_kb_s = benchmark_kb_s(result->small_read_us);
+    return ESP_OK;
+}
+
+esp_err_t block_device_read_benchmark_run(block_device_t *dev, block_device_benchmark_result_t *result) {
+    return benchmark_run(dev, false, result);
+}
+
+esp_err_t block_device_read_benchmark_emu(const block_device_benchmark_read_t *read, uint32_t clock_speed_hz,
+                                          block_device_benchmark_result_t *result) {
+
+    block_device_emu_t emu;
+    block_device_emu_config_t config = BLOCK_DEVICE_EMU_W25Q128JV_CONFIG();
+    config.sector_count = BLOCK_DEVICE_BENCHMARK_SIZE / W25Q128JV_SECTOR_SIZE;
+    config.timing.ns_per_byte = (uint32_t)(8ULL * 1000000000 / clock_speed_hz);
+    config.timing.read_command_clocks = read->command_clocks;
+    config.timing.read_data_lines = read->data_lines;
+    esp_err_t ret = ESP_OK;
+
+    ESP_RETURN_ON_ERROR(block_device_emu_create_ram(&emu, &config), TAG, "Failed to create the flash emulator");
+
+    for (uint32_t address = 0; address < BLOCK_DEVICE_BENCHMARK_SIZE; address += sizeof(benchmark_buffer)) {
+        for (uint32_t i = 0; i < sizeof(benchmark_buffer); i++) {
+            benchmark_buffer[i] = benchmark_pattern(address + i);
+        }
+        ESP_GOTO_ON_ERROR(block_device_prog(&emu.dev, address, benchmark_buffer, sizeof(benchmark_buffer)),
+                          cleanup, TAG, "Failed to fill the emulator");
+    }
+    block_device_reset_stats(&emu.dev);
+
+    ret = benchmark_run(&emu.dev, true, result);
+
+cleanup:
+    block_device_emu_destroy(&emu);
+    return ret;
+}
+
+void block_device_read_benchmark_sweep(void) {
+
+    const uint32_t clock_speeds[] = { BLOCK_DEVICE_BENCHMARK_CLOCK, BLOCK_DEVICE_BENCHMARK_CLOCK_FAST };
+    block_device_benchmark_result_t result;
+
+    ESP_LOGI(TAG, "%d KB per read size, emulated W25Q128JV", BLOCK_DEVICE_BENCHMARK_SIZE / 1024);
+    ESP_LOGI(TAG, "read command         clock kHz | %4d B reads KB/s | %4d B reads KB/s",
+             BLOCK_DEVICE_BENCHMARK_LARGE_READ, BLOCK_DEVICE_BENCHMARK_SMALL_READ);
+
+    for (size_t c = 0; c < sizeof(clock_speeds) / sizeof(clock_speeds[0]); c++) {
+        for (uint32_t r = 0; r < block_device_benchmark_read_count; r++) {
+
+            const block_device_benchmark_read_t *read = &block_device_benchmark_reads[r];
+            esp_err_t ret = block_device_read_benchmark_emu(read, clock_speeds[c], &result);
+            if (ret != ESP_OK) {
+                ESP_LOGE(TAG, "%s at %lu kHz failed: %s", read->name, clock_speeds[c] / 1000, esp_err_to_name(ret));
+                continue;
+            }
+            ESP_LOGI(TAG, "%-20s %9lu | %17lu | %17lu",
+                     read->name, clock_speeds[c] / 1000, result.large_read_kb_s, result.small_read_kb_s);
+        }
+    }
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#ifndef BLOCK_DEVICE_BENCHMARK_H
+#define BLOCK_DEVICE_BENCHMARK_H
+
+/*
+ * Read throughput benchmark
+ *
+ * The read benchmark of ext_flash_read_benchmark() on a block device, so it also runs on the NOR flash emulator
+ * (block_device_emu.h). The time is taken from stats.busy_time_us: measured on the W25Q128JV, modelled by the emulator.
+ *
+ * Two read sizes are timed, since the fixed command time of a read weighs more on short reads:
+ *  - BLOCK_DEVICE_BENCHMARK_LARGE_READ: one SPI transaction (SPI_MAX_TRANSFER_SIZE), as in track downloads
+ *  - BLOCK_DEVICE_BENCHMARK_SMALL_READ: one page, as LittleFS reads metadata when it mounts
+ *
+ * The sweep emulates every W25Q128JV read command at the two SPI clocks of ext_flash.h, so the read modes
+ * can be compared without the board.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "block_device.h"
+#include "external_flash/w25q128jv.h"
+
+#define BLOCK_DEVICE_BENCHMARK_SIZE         (64 * 1024)         // Bytes read per read size, EXT_FLASH_BENCHMARK_SIZE
+#define BLOCK_DEVICE_BENCHMARK_LARGE_READ   4096                // SPI_MAX_TRANSFER_SIZE
+#define BLOCK_DEVICE_BENCHMARK_SMALL_READ   W25Q128JV_PAGE_SIZE
+#define BLOCK_DEVICE_BENCHMARK_CLOCK        (8 * 1000 * 1000)   // SPI_CLOCK_SPEED
+#define BLOCK_DEVICE_BENCHMARK_CLOCK_FAST   (20 * 1000 * 1000)  // SPI_CLOCK_SPEED_FAST
+
+/* W25Q128JV read command, in the order of ext_flash_read_mode_t */
+typedef struct {
+    const char *name;
+    uint32_t command_clocks;        // W25Q128JV_FAST_READ_*_CLOCKS
+    uint32_t data_lines;            // 1, 2 or 4
+} block_device_benchmark_read_t;
+
+typedef struct {
+    uint64_t large_read_us;         // Flash time of BLOCK_DEVICE_BENCHMARK_SIZE bytes in large reads
+    uint64_t small_read_us;         // Flash time of BLOCK_DEVICE_BENCHMARK_SIZE bytes in small reads
+    uint32_t large_read_kb_s;
+    uint32_t small_read_kb_s;
+} block_device_benchmark_result_t;
+
+extern const block_device_benchmark_read_t block_device_benchmark_reads[];
+extern const uint32_t block_device_benchmark_read_count;
+
+/**
+ * @brief Times BLOCK_DEVICE_BENCHMARK_SIZE bytes from address 0 in large reads, then in small reads.
+ *
+ * Only reads, the data on the device is not changed. The IO counters of the device keep counting.
+ *
+ * @param dev Block device of at least BLOCK_DEVICE_BENCHMARK_SIZE bytes.
+ * @param result Output results.
+ * @return ESP_OK on success, ESP_ERR_INVALID_SIZE if the device is too small, or the first read error.
+ */
+esp_err_t block_device_read_benchmark_run(block_device_t *dev, block_device_benchmark_result_t *result);
+
+/**
+ * @brief Runs the read benchmark on a RAM emulator of the W25Q128JV with one read command and SPI clock.
+ *
+ * The emulator is filled with a known pattern first and every read is checked against it.
+ *
+ * @param read Read command to emulate, e.g. &block_device_benchmark_reads[i].
+ * @param clock_speed_hz SPI clock.
+ * @param result Output results.
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the emulator can not be created,
+ *         ESP_ERR_INVALID_CRC if the data read back is wrong, or the first block device error.
+ */
+esp_err_t block_device_read_benchmark_emu(const block_device_benchmark_read_t *read, uint32_t clock_speed_hz,
+                                          block_device_benchmark_result_t *result);
+
+/**
+ * @brief Runs the read benchmark on the emulator for every read command at BLOCK_DEVICE_BENCHMARK_CLOCK and
+ * BLOCK_DEVICE_BENCHMARK_CLOCK_FAST, and logs a table. Host builds, the emulator needs 64 KB of RAM per run.
+ */
+void block_device_read_benchmark_sweep(void);
+
+#endif // BLOCK_DEVICE_BENCHMARK_H
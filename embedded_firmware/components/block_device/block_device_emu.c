@@ -0,0 +1,214 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#include "block_device_emu.h"
+#include "esp_log.h"
+#include "esp_check.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+static const char *TAG = "BLOCK_DEVICE_EMU";
+
+/* Adds modelled time, the part below 1 us is kept so many short reads do not round down to nothing */
+static void emu_add_busy_ns(block_device_emu_t *emu, uint64_t ns) {
+    ns += emu->busy_remainder_ns;
+    emu->dev.stats.busy_time_us += ns / 1000;
+    emu->busy_remainder_ns = ns % 1000;
+}
+
+static esp_err_t emu_read(block_device_t *dev, uint32_t address, void *buffer, uint32_t size) {
+    block_device_emu_t *emu = dev->ctx;
+    const block_device_emu_timing_t *timing = &emu->config.timing;
+
+    memcpy(buffer, emu->memory + address, size);
+
+    /* Command, address and dummy clocks, then 8 clocks per byte on one line, 4 on two, 2 on four */
+    uint64_t clocks = timing->read_command_clocks + (uint64_t)size * 8 / timing->read_data_lines;
+    emu_add_busy_ns(emu, clocks * timing->ns_per_byte / 8);
+    return ESP_OK;
+}
+
+static esp_err_t emu_prog(block_device_t *dev, uint32_t address, const void *buffer, uint32_t size) {
+    block_device_emu_t *emu = dev->ctx;
+    const uint8_t *data = buffer;
+    uint8_t *flash = emu->memory + address;
+
+    /* Check first, so a strict emulator does not leave a half programmed range */
+    bool dirty = false;
+    for (uint32_t i = 0; i < size; i++) {
+        if (data[i] & ~flash[i]) {
+            dirty = true;
+            break;
+        }
+    }
+    if (dirty) {
+        emu->dirty_prog_count++;
+        if (emu->config.strict_program) {
+            ESP_LOGE(TAG, "Program at 0x%06lX would set erased bits, sector not erased", (unsigned long)address);
+            return ESP_ERR_INVALID_STATE;
+        }
+    }
+
+    // NOR program: a bit can only go from 1 to 0
+    for (uint32_t i = 0; i < size; i++) {
+        flash[i] &= data[i];
+    }
+
+    /* One page program per touched page, plus the data transfer */
+    uint32_t pages = (address + size - 1) / emu->config.page_size - address / emu->config.page_size + 1;
+    dev->stats.busy_time_us += (uint64_t)pages * emu->config.timing.page_program_us;
+    emu_add_busy_ns(emu, (uint64_t)(pages * 4 + size) * emu->config.timing.ns_per_byte);
+    return ESP_OK;
+}
+
+static esp_err_t emu_erase(block_device_t *dev, uint32_t address) {
+    block_device_emu_t *emu = dev->ctx;
+
+    memset(emu->memory + address, 0xFF, emu->config.sector_size);
+    emu->sector_erases[address / emu->config.sector_size]++;
+    dev->stats.busy_time_us += emu->config.timing.sector_erase_us;
+    return ESP_OK;
+}
+
+static const block_device_ops_t emu_ops = {
+    .read = emu_read,
+    .prog = emu_prog,
+    .erase = emu_erase,
+    .sync = NULL, // Operations finish immediately
+};
+
+/* Common part of the RAM and file backends, memory is set by the caller */
+static esp_err_t emu_init(block_device_emu_t *emu, const block_device_emu_config_t *config, const char *name) {
+
+    if (config->page_size == 0 || config->sector_size % config->page_size != 0 || config->sector_count == 0) {
+        ESP_LOGE(TAG, "Invalid geometry: page %lu, sector %lu, %lu sectors",
+                 (unsigned long)config->page_size, (unsigned long)config->sector_size, (unsigned long)config->sector_count);
+        return ESP_ERR_INVALID_ARG;
+    }
+    uint32_t lines = config->timing.read_data_lines;
+    if (lines != 1 && lines != 2 && lines != 4) {
+        ESP_LOGE(TAG, "Invalid read data lines: %lu", (unsigned long)lines);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(emu, 0, sizeof(*emu));
+    emu->config = *config;
+    emu->size = (size_t)config->sector_size * config->sector_count;
+    emu->fd = -1;
+
+    emu->sector_erases = calloc(config->sector_count, sizeof(uint32_t));
+    if (emu->sector_erases == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    emu->dev.name = name;
+    emu->dev.ops = &emu_ops;
+    emu->dev.page_size = config->page_size;
+    emu->dev.sector_size = config->sector_size;
+    emu->dev.sector_count = config->sector_count;
+    emu->dev.ctx = emu;
+    return ESP_OK;
+}
+
+esp_err_t block_device_emu_create_ram(block_device_emu_t *emu, const block_device_emu_config_t *config) {
+
+    ESP_RETURN_ON_ERROR(emu_init(emu, config, "NOR emulator (RAM)"), TAG, "Failed to initialize emulator");
+
+    emu->memory = malloc(emu->size);
+    if (emu->memory == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate %lu bytes", (unsigned long)emu->size);
+        block_device_emu_destroy(emu);
+        return ESP_ERR_NO_MEM;
+    }
+    memset(emu->memory, 0xFF, emu->size);
+    return ESP_OK;
+}
+
+esp_err_t block_device_emu_create_file(block_device_emu_t *emu, const char *path, const block_device_emu_config_t *config) {
+#if defined(__linux__)
+
+    ESP_RETURN_ON_ERROR(emu_init(emu, config, "NOR emulator (file)"), TAG, "Failed to initialize emulator");
+
+    emu->fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (emu->fd < 0) {
+        ESP_LOGE(TAG, "Failed to open %s", path);
+        block_device_emu_destroy(emu);
+        return ESP_FAIL;
+    }
+
+    struct stat st;
+    if (fstat(emu->fd, &st) != 0 || ftruncate(emu->fd, emu->size) != 0) {
+        ESP_LOGE(TAG, "Failed to resize %s to %lu bytes", path, (unsigned long)emu->size);
+        block_device_emu_destroy(emu);
+        return ESP_FAIL;
+    }
+
+    emu->memory = mmap(NULL, emu->size, PROT_READ | PROT_WRITE, MAP_SHARED, emu->fd, 0);
+    if (emu->memory == MAP_FAILED) {
+        ESP_LOGE(TAG, "Failed to mmap %s", path);
+        emu->memory = NULL;
+        block_device_emu_destroy(emu);
+        return ESP_FAIL;
+    }
+
+    // ftruncate fills new bytes with 0x00 - a fresh flash is erased
+    if ((size_t)st.st_size < emu->size) {
+        memset(emu->memory + st.st_size, 0xFF, emu->size - st.st_size);
+    }
+    return ESP_OK;
+
+#else
+    ESP_LOGE(TAG, "File backed emulator is only available on Linux");
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+void block_device_emu_destroy(block_device_emu_t *emu) {
+
+#if defined(__linux__)
+    if (emu->fd >= 0) {
+        if (emu->memory != NULL) {
+            msync(emu->memory, emu->size, MS_SYNC);
+            munmap(emu->memory, emu->size);
+        }
+        close(emu->fd);
+        emu->fd = -1;
+        emu->memory = NULL;
+    }
+#endif
+    free(emu->memory);
+    emu->memory = NULL;
+    free(emu->sector_erases);
+    emu->sector_erases = NULL;
+}
+
+void block_device_emu_get_wear(const block_device_emu_t *emu, block_device_emu_wear_t *wear) {
+
+    memset(wear, 0, sizeof(*wear));
+    wear->min_erases = UINT32_MAX;
+    for (uint32_t i = 0; i < emu->config.sector_count; i++) {
+        uint32_t erases = emu->sector_erases[i];
+        wear->min_erases = erases < wear->min_erases ? erases : wear->min_erases;
+        wear->max_erases = erases > wear->max_erases ? erases : wear->max_erases;
+        wear->total_erases += erases;
+    }
+    wear->dirty_prog_count = emu->dirty_prog_count;
+}
+
+uint32_t block_device_emu_get_sector_erases(const block_device_emu_t *emu, uint32_t sector) {
+    if (sector >= emu->config.sector_count) {
+        return 0;
+    }
+    return emu->sector_erases[sector];
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#ifndef BLOCK_DEVICE_EMU_H
+#define BLOCK_DEVICE_EMU_H
+
+/*
+ * NOR flash emulator
+ *
+ * Behaves like the W25Q128JV as LittleFS sees it:
+ *  - erase sets the whole sector to 0xFF
+ *  - program can only clear bits (new = old & data), programming a 0 bit back to 1 is counted as a dirty program
+ *  - page program, sector erase and SPI transfer times are added to stats.busy_time_us instead of sleeping,
+ *    so benchmarks run fast and still report flash time. Reads are timed for the read command in the timing
+ *    (Fast Read on 1 line by default, Dual/Quad Output and I/O like ext_flash_read_mode_t)
+ *  - erase count per sector, for wear levelling checks
+ *
+ * The memory is either malloc'd (RAM) or an mmap'd file (Linux only), so an image survives between runs.
+ */
+
+#include <stddef.h>
+#include "block_device.h"
+#include "external_flash/w25q128jv.h"
+
+#define BLOCK_DEVICE_EMU_NS_PER_BYTE    1000 // 8 MHz single line SPI (SPI_CLOCK_SPEED)
+
+typedef struct {
+    uint32_t page_program_us;       // Time of one page program
+    uint32_t sector_erase_us;       // Time of one sector erase
+    uint32_t ns_per_byte;           // SPI transfer time per byte on one line (8 clocks)
+    uint32_t read_command_clocks;   // Clocks of a read before the data, W25Q128JV_FAST_READ_*_CLOCKS
+    uint32_t read_data_lines;       // Lines the read data comes on: 1, 2 or 4
+} block_device_emu_timing_t;
+
+typedef struct {
+    uint32_t page_size;
+    uint32_t sector_size;
+    uint32_t sector_count;
+    block_device_emu_timing_t timing;
+    bool strict_program;            // Fail programs that would set bits to 1, instead of only counting them
+} block_device_emu_config_t;
+
+#define BLOCK_DEVICE_EMU_W25Q128JV_CONFIG() {                               \
+    .page_size = W25Q128JV_PAGE_SIZE,                                       \
+    .sector_size = W25Q128JV_SECTOR_SIZE,                                   \
+    .sector_count = W25Q128JV_TOTAL_SIZE_BYTES / W25Q128JV_SECTOR_SIZE,     \
+    .timing = {                                                             \
+        .page_program_us = W25Q128JV_T_PP_TYP_US,                           \
+        .sector_erase_us = W25Q128JV_T_SE_TYP_US,                           \
+        .ns_per_byte = BLOCK_DEVICE_EMU_NS_PER_BYTE,                        \
+        .read_command_clocks = W25Q128JV_FAST_READ_CLOCKS,                  \
+        .read_data_lines = 1,                                               \
+    },                                                                      \
+    .strict_program = false,                                                \
+}
+
+/* Sector wear summary */
+typedef struct {
+    uint32_t min_erases;
+    uint32_t max_erases;
+    uint64_t total_erases;
+    uint32_t dirty_prog_count;      // Programs that tried to set a 0 bit back to 1
+} block_device_emu_wear_t;
+
+typedef struct {
+    block_device_t dev;             // Pass &emu->dev to the block_device functions
+    block_device_emu_config_t config;
+    uint8_t *memory;
+    size_t size;
+    uint32_t *sector_erases;        // Erase count per sector (in RAM, also for the file backend)
+    uint32_t dirty_prog_count;
+    uint32_t busy_remainder_ns;     // Modelled time below 1 us, not in stats.busy_time_us yet
+    int fd;                         // File backend, -1 for RAM
+} block_device_emu_t;
+
+/**
+ * @brief Creates a RAM backed NOR flash emulator. The memory starts erased (0xFF).
+ *
+ * @param emu Emulator to initialize.
+ * @param config Geometry and timing, e.g. BLOCK_DEVICE_EMU_W25Q128JV_CONFIG().
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG on bad geometry, ESP_ERR_NO_MEM if the memory can not be allocated.
+ */
+esp_err_t block_device_emu_create_ram(block_device_emu_t *emu, const block_device_emu_config_t *config);
+
+/**
+ * @brief Creates a NOR flash emulator on an mmap'd image file (Linux only).
+ *
+ * A new or shorter file is extended with erased (0xFF) bytes, an existing image is used as is,
+ * so a filesystem can be mounted again in a later run. Erase counts start at 0.
+ *
+ * @param emu Emulator to initialize.
+ * @param path Path of the image file.
+ * @param config Geometry and timing, e.g. BLOCK_DEVICE_EMU_W25Q128JV_CONFIG().
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED if not built for Linux, ESP_FAIL if the file can not be mapped.
+ */
+esp_err_t block_device_emu_create_file(block_device_emu_t *emu, const char *path, const block_device_emu_config_t *config);
+
+/**
+ * @brief Frees the emulator memory. A file image is synced and unmapped.
+ */
+void block_device_emu_destroy(block_device_emu_t *emu);
+
+/**
+ * @brief Gets the sector wear summary.
+ */
+void block_device_emu_get_wear(const block_device_emu_t *emu, block_device_emu_wear_t *wear);
+
+/**
+ * @brief Gets the number of erases of one sector (0 if the sector does not exist).
+ */
+uint32_t block_device_emu_get_sector_erases(const block_device_emu_t *emu, uint32_t sector);
+
+#endif // BLOCK_DEVICE_EMU_H
@@ -0,0 +1,53 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#include "block_device.h"
+#include "external_flash/ext_flash.h"
+
+static esp_err_t w25q_read(block_device_t *dev, uint32_t address, void *buffer, uint32_t size) {
+    int64_t start_us = esp_timer_get_time();
+    esp_err_t ret = ext_flash_read(address, (uint8_t *)buffer, size);
+    dev->stats.busy_time_us += esp_timer_get_time() - start_us;
+    return ret;
+}
+
+static esp_err_t w25q_prog(block_device_t *dev, uint32_t address, const void *buffer, uint32_t size) {
+    int64_t start_us = esp_timer_get_time();
+    esp_err_t ret = ext_flash_write(address, (const uint8_t *)buffer, size); // Split into pages in ext_flash_write
+    dev->stats.busy_time_us += esp_timer_get_time() - start_us;
+    return ret;
+}
+
+static esp_err_t w25q_erase(block_device_t *dev, uint32_t address) {
+    int64_t start_us = esp_timer_get_time();
+    esp_err_t ret = ext_flash_erase_sector(address);
+    dev->stats.busy_time_us += esp_timer_get_time() - start_us;
+    return ret;
+}
+
+static esp_err_t w25q_sync(block_device_t *dev) {
+    return ext_flash_wait_for_idle(5000);
+}
+
+static const block_device_ops_t w25q_ops = {
+    .read = w25q_read,
+    .prog = w25q_prog,
+    .erase = w25q_erase,
+    .sync = w25q_sync,
+};
+
+static block_device_t w25q_device = {
+    .name = "W25Q128JV",
+    .ops = &w25q_ops,
+    .page_size = W25Q128JV_PAGE_SIZE,
+    .sector_size = W25Q128JV_SECTOR_SIZE,
+    .sector_count = W25Q128JV_TOTAL_SIZE_BYTES / W25Q128JV_SECTOR_SIZE,
+};
+
+block_device_t *block_device_w25q_get(void) {
+    return &w25q_device;
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+/*
+ * Host test of the flash read benchmark (block_device_benchmark.c) on the W25Q128JV emulator (block_device_emu.h).
+ * Logs the sweep of every read command at both SPI clocks, then checks for every read command and clock:
+ *
+ * - the data read back matches what was programmed
+ * - the flash time is the one of the W25Q128JV read timing (command clocks, then 8 / data lines clocks per byte)
+ * - more data lines and a shorter command are faster: quad I/O > quad output > dual I/O > dual output > standard,
+ *   and every command is faster at SPI_CLOCK_SPEED_FAST than at SPI_CLOCK_SPEED
+ *
+ * This is a check of the emulator timing model and of the benchmark code, not of the flash driver: ext_flash.c
+ * (read commands, DMA transactions, splitting at SPI_MAX_TRANSFER_SIZE) is not built here, so a regression in the
+ * quad or DMA read path is only seen with ext_flash_read_benchmark() on the board.
+ *
+ *     ./test_read_benchmark
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "block_device/block_device_benchmark.h"
+
+#define TEST_CLOCK_COUNT 2
+
+static const uint32_t test_clock_speeds[TEST_CLOCK_COUNT] = { BLOCK_DEVICE_BENCHMARK_CLOCK, BLOCK_DEVICE_BENCHMARK_CLOCK_FAST };
+
+/* Flash time of BLOCK_DEVICE_BENCHMARK_SIZE bytes in reads of read_size, from the datasheet timing */
+static uint64_t test_expected_us(const block_device_benchmark_read_t *read, uint32_t clock_speed_hz, uint32_t read_size) {
+    uint64_t reads = BLOCK_DEVICE_BENCHMARK_SIZE / read_size;
+    uint64_t clocks = reads * (read->command_clocks + read_size * 8 / read->data_lines);
+    return clocks * 1000000 / clock_speed_hz;
+}
+
+static int test_check_time(const char *name, uint32_t clock_speed_hz, const char *what, uint64_t got_us, uint64_t expected_us) {
+    // 1 us for rounding of the clock period to whole ns
+    if (got_us + 1 < expected_us || got_us > expected_us + 1) {
+        fprintf(stderr, "%s at %lu kHz: %s took %llu us, expected %llu us\n", name, clock_speed_hz / 1000, what,
+                got_us, expected_us);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1) {
+        fprintf(stderr, "Usage: %s\n", argv[0]);
+        return 2;
+    }
+
+    block_device_read_benchmark_sweep();
+
+    block_device_benchmark_result_t results[TEST_CLOCK_COUNT][block_device_benchmark_read_count];
+    int failed = 0;
+
+    for (uint32_t c = 0; c < TEST_CLOCK_COUNT; c++) {
+        for (uint32_t r = 0; r < block_device_benchmark_read_count; r++) {
+
+            const block_device_benchmark_read_t *read = &block_device_benchmark_reads[r];
+            block_device_benchmark_result_t *result = &results[c][r];
+            esp_err_t ret = block_device_read_benchmark_emu(read, test_clock_speeds[c], result);
+            if (ret != ESP_OK) {
+                fprintf(stderr, "%s at %lu kHz: %s\n", read->name, test_clock_speeds[c] / 1000, esp_err_to_name(ret));
+                failed++;
+                continue;
+            }
+            failed += test_check_time(read->name, test_clock_speeds[c], "large reads", result->large_read_us,
+                                      test_expected_us(read, test_clock_speeds[c], BLOCK_DEVICE_BENCHMARK_LARGE_READ));
+            failed += test_check_time(read->name, test_clock_speeds[c], "small reads", result->small_read_us,
+                                      test_expected_us(read, test_clock_speeds[c], BLOCK_DEVICE_BENCHMARK_SMALL_READ));
+
+            // The reads are in order from the slowest to the fastest command
+            if (r > 0 && (result->large_read_us >= results[c][r - 1].large_read_us ||
+                          result->small_read_us >= results[c][r - 1].small_read_us)) {
+                fprintf(stderr, "%s at %lu kHz is not faster than %s\n", read->name, test_clock_speeds[c] / 1000,
+                        block_device_benchmark_reads[r - 1].name);
+                failed++;
+            }
+            if (c > 0 && result->large_read_kb_s <= results[c - 1][r].large_read_kb_s) {
+                fprintf(stderr, "%s is not faster at %lu kHz than at %lu kHz\n", read->name,
+                        test_clock_speeds[c] / 1000, test_clock_speeds[c - 1] / 1000);
+                failed++;
+            }
+        }
+    }
+
+    if (failed) {
+        fprintf(stderr, "%d read benchmark cases failed\n", failed);
+        return 1;
+    }
+    return 0;
+}
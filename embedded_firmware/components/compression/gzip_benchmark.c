@@ -0,0 +1,92 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#include "gzip_benchmark.h"
+
+static const char *TAG = "GZIP_BENCHMARK";
+
+/* Output sink, only counts bytes */
+static esp_err_t benchmark_count_write(const char *data, size_t len, void *ctx) {
+    *(uint32_t *)ctx += len;
+    return ESP_OK;
+}
+
+esp_err_t gzip_benchmark_track(const char *filename, track_export_format_t format, gzip_benchmark_result_t *result) {
+
+    gzip_stream_stats_t stats;
+    uint32_t gzip_bytes = 0;
+
+    memset(result, 0, sizeof(*result));
+
+    // 1) Render only, the time the download takes on the collar without compression
+    int64_t start_us = esp_timer_get_time();
+    ESP_RETURN_ON_ERROR(track_file_export(filename, format, benchmark_count_write, &result->text_bytes),
+                        TAG, "Failed to render %s", filename);
+    result->render_us = esp_timer_get_time() - start_us;
+
+    // 2) Render and compress
+    start_us = esp_timer_get_time();
+    gzip_stream_t *stream = gzip_stream_begin(benchmark_count_write, &gzip_bytes);
+    if (stream == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    esp_err_t err = track_file_export(filename, format, gzip_stream_write, stream);
+    if (err != ESP_OK) {
+        gzip_stream_abort(stream);
+        ESP_LOGE(TAG, "Failed to compress %s", filename);
+        return err;
+    }
+    ESP_RETURN_ON_ERROR(gzip_stream_finish(stream, &stats), TAG, "Failed to finish %s", filename);
+    result->gzip_us = esp_timer_get_time() - start_us;
+    result->gzip_bytes = stats.out_bytes;
+    return ESP_OK;
+}
+
+static void benchmark_log_result(const char *filename, const char *format, const gzip_benchmark_result_t *result) {
+
+    int64_t compress_us = result->gzip_us - result->render_us;
+    ESP_LOGI(TAG, "%-32s %-3s | %9lu %9lu %5lu%% | %8lld %8lld %9llu",
+             filename, format, result->text_bytes, result->gzip_bytes,
+             result->text_bytes ? (uint32_t)((uint64_t)result->gzip_bytes * 100 / result->text_bytes) : 0,
+             result->render_us, result->gzip_us,
+             compress_us > 0 ? (uint64_t)result->text_bytes * 1000000 / compress_us : 0);
+}
+
+void gzip_benchmark_all_tracks(void) {
+
+    lfs_dir_t dir;
+    struct lfs_info info;
+    gzip_benchmark_result_t result;
+    uint64_t total_text = 0;
+    uint64_t total_gzip = 0;
+
+    if (lfs_dir_open(&lfs, &dir, "/") < 0) {
+        ESP_LOGE(TAG, "Failed to open directory /");
+        return;
+    }
+
+    ESP_LOGI(TAG, "GZIP window %d B, hash %d bits, chain %d, RAM %d B per stream",
+             GZIP_STREAM_WINDOW_SIZE, GZIP_STREAM_HASH_BITS, GZIP_STREAM_MAX_CHAIN, (int)sizeof(gzip_stream_t));
+    ESP_LOGI(TAG, "%-32s fmt |      text      gzip ratio | render us  gzip us  gzip B/s", "file");
+
+    while (lfs_dir_read(&lfs, &dir, &info) > 0) {
+        if (info.type != LFS_TYPE_REG || !track_file_is_track(info.name)) {
+            continue;
+        }
+        if (gzip_benchmark_track(info.name, TRACK_EXPORT_CSV, &result) == ESP_OK) {
+            benchmark_log_result(info.name, "csv", &result);
+            total_text += result.text_bytes;
+            total_gzip += result.gzip_bytes;
+        }
+        if (gzip_benchmark_track(info.name, TRACK_EXPORT_GPX, &result) == ESP_OK) {
+            benchmark_log_result(info.name, "gpx", &result);
+        }
+    }
+    lfs_dir_close(&lfs, &dir);
+
+    ESP_LOGI(TAG, "All CSV: %llu -> %llu bytes (%llu%%)", total_text, total_gzip, total_text ? total_gzip * 100 / total_text : 0);
+}
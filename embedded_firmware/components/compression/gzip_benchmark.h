@@ -0,0 +1,48 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#ifndef GZIP_BENCHMARK_H
+#define GZIP_BENCHMARK_H
+
+/*
+ * Compression benchmark
+ *
+ * Renders track files to CSV/GPX the same way /download does and compresses them with gzip_stream,
+ * to see how many bytes Content-Encoding: gzip saves on the sync link and what it costs in CPU time.
+ * Nothing in the firmware calls it, so it is not in the firmware build: tests/test_gzip_host runs it on a track
+ * on the flash emulator. To time it on the ESP32-C3, add it back to src/CMakeLists.txt and call it after the mount.
+ */
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "esp_timer.h"
+#include "gzip_stream.h"
+#include "track_format/track_file.h"
+
+typedef struct {
+    uint32_t text_bytes;        // Rendered CSV/GPX bytes
+    uint32_t gzip_bytes;        // Compressed bytes
+    int64_t render_us;          // Time to render the track without compression
+    int64_t gzip_us;            // Time to render and compress the track
+} gzip_benchmark_result_t;
+
+/**
+ * @brief Renders one track file twice, without and with compression, and measures both.
+ *
+ * @param filename Name of the track file.
+ * @param format Output format.
+ * @param result Output results.
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the gzip stream pool is in use, or the track export error.
+ */
+esp_err_t gzip_benchmark_track(const char *filename, track_export_format_t format, gzip_benchmark_result_t *result);
+
+/**
+ * @brief Runs gzip_benchmark_track() for every track file in CSV and GPX and logs a table.
+ */
+void gzip_benchmark_all_tracks(void);
+
+#endif // GZIP_BENCHMARK_H
@@ -0,0 +1,346 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#include "gzip_stream.h"
+
+static const char *TAG = "GZIP_STREAM";
+
+#define GZIP_MIN_MATCH          3
+#define GZIP_MAX_MATCH          258
+#define GZIP_MIN_LOOKAHEAD      (GZIP_MAX_MATCH + GZIP_MIN_MATCH + 1)  // Input kept back so every match can reach its max length
+#define GZIP_MAX_DIST           (GZIP_STREAM_WINDOW_SIZE - GZIP_MIN_LOOKAHEAD) // Matches further back may be slid out of the window
+#define GZIP_HASH_MASK          ((1 << GZIP_STREAM_HASH_BITS) - 1)
+#define GZIP_WINDOW_MASK        (GZIP_STREAM_WINDOW_SIZE - 1)
+#define GZIP_END_OF_BLOCK       256
+
+_Static_assert(GZIP_STREAM_WINDOW_SIZE >= 2 * GZIP_MIN_LOOKAHEAD, "gzip window too small");
+_Static_assert(GZIP_STREAM_WINDOW_BITS <= 15, "gzip window too large for deflate and 16 bit positions");
+
+static gzip_stream_t pool[GZIP_STREAM_POOL_SIZE];
+static portMUX_TYPE pool_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// RFC 1951 3.2.5 - length codes 257..285 and distance codes 0..29
+static const uint16_t length_base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t length_extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t dist_base[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769,
+    1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t dist_extra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+// Fixed Huffman codes (RFC 1951 3.2.6), bit reversed because deflate writes Huffman codes MSB first
+static uint16_t fixed_code[288];
+static uint8_t fixed_code_bits[288];
+static uint8_t fixed_dist_code[30];
+static uint8_t length_code[GZIP_MAX_MATCH - GZIP_MIN_MATCH + 1];    // Match length - 3 to length code index
+static bool tables_ready = false;
+
+static uint16_t gzip_reverse_bits(uint16_t code, uint8_t bits) {
+    uint16_t reversed = 0;
+    for (uint8_t i = 0; i < bits; i++) {
+        reversed = (reversed << 1) | (code & 1);
+        code >>= 1;
+    }
+    return reversed;
+}
+
+static void gzip_init_tables(void) {
+
+    if (tables_ready) {
+        return;
+    }
+    for (int symbol = 0; symbol < 288; symbol++) {
+        uint16_t code;
+        uint8_t bits;
+        if (symbol < 144) {
+            code = 0x30 + symbol;
+            bits = 8;
+        } else if (symbol < 256) {
+            code = 0x190 + (symbol - 144);
+            bits = 9;
+        } else if (symbol < 280) {
+            code = symbol - 256;
+            bits = 7;
+        } else {
+            code = 0xC0 + (symbol - 280);
+            bits = 8;
+        }
+        fixed_code[symbol] = gzip_reverse_bits(code, bits);
+        fixed_code_bits[symbol] = bits;
+    }
+    for (int code = 0; code < 30; code++) {
+        fixed_dist_code[code] = (uint8_t)gzip_reverse_bits(code, 5);
+    }
+    for (int code = 0; code < 28; code++) {
+        for (int extra = 0; extra < (1 << length_extra[code]); extra++) {
+            length_code[length_base[code] - GZIP_MIN_MATCH + extra] = code;
+        }
+    }
+    length_code[GZIP_MAX_MATCH - GZIP_MIN_MATCH] = 28; // 258 has its own code, 284 + 31 extra is not valid
+    tables_ready = true;
+}
+
+static void gzip_flush_out(gzip_stream_t *stream) {
+
+    if (stream->out_len == 0) {
+        return;
+    }
+    if (stream->error == ESP_OK) {
+        stream->error = stream->write((const char *)stream->out, stream->out_len, stream->ctx);
+    }
+    stream->out_bytes += stream->out_len;
+    stream->out_len = 0;
+}
+
+static void gzip_put_byte(gzip_stream_t *stream, uint8_t byte) {
+    stream->out[stream->out_len++] = byte;
+    if (stream->out_len == sizeof(stream->out)) {
+        gzip_flush_out(stream);
+    }
+}
+
+static void gzip_put_u32(gzip_stream_t *stream, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        gzip_put_byte(stream, (value >> (8 * i)) & 0xFF);
+    }
+}
+
+/* Deflate packs bits starting at the least significant bit of each byte */
+static void gzip_put_bits(gzip_stream_t *stream, uint32_t value, uint32_t bits) {
+    stream->bit_buffer |= value << stream->bit_count;
+    stream->bit_count += bits;
+    while (stream->bit_count >= 8) {
+        gzip_put_byte(stream, stream->bit_buffer & 0xFF);
+        stream->bit_buffer >>= 8;
+        stream->bit_count -= 8;
+    }
+}
+
+static void gzip_put_symbol(gzip_stream_t *stream, uint16_t symbol) {
+    gzip_put_bits(stream, fixed_code[symbol], fixed_code_bits[symbol]);
+}
+
+static void gzip_put_match(gzip_stream_t *stream, uint32_t length, uint32_t dist) {
+
+    uint8_t code = length_code[length - GZIP_MIN_MATCH];
+    gzip_put_symbol(stream, 257 + code);
+    gzip_put_bits(stream, length - length_base[code], length_extra[code]);
+
+    code = 29;
+    while (dist_base[code] > dist) {
+        code--;
+    }
+    gzip_put_bits(stream, fixed_dist_code[code], 5);
+    gzip_put_bits(stream, dist - dist_base[code], dist_extra[code]);
+}
+
+static uint32_t gzip_hash(const uint8_t *data) {
+    return ((data[0] << 6) ^ (data[1] << 3) ^ data[2]) & GZIP_HASH_MASK;
+}
+
+/* Adds a position to its hash chain and returns the previous position with the same hash */
+static uint32_t gzip_insert(gzip_stream_t *stream, uint32_t position) {
+    uint32_t hash = gzip_hash(stream->window + position);
+    uint32_t previous = stream->head[hash];
+    stream->prev[position & GZIP_WINDOW_MASK] = previous;
+    stream->head[hash] = position;
+    return previous;
+}
+
+static uint32_t gzip_longest_match(gzip_stream_t *stream, uint32_t candidate, uint32_t max_length, uint32_t *match_dist) {
+
+    const uint8_t *scan = stream->window + stream->position;
+    uint32_t best_length = 0;
+
+    for (int chain = 0; chain < GZIP_STREAM_MAX_CHAIN && candidate > 0; chain++) {
+        uint32_t dist = stream->position - candidate;
+        if (dist > GZIP_MAX_DIST) {
+            break;
+        }
+        const uint8_t *match = stream->window + candidate;
+        if (match[best_length] == scan[best_length] && match[0] == scan[0]) {
+            uint32_t length = 1;
+            while (length < max_length && match[length] == scan[length]) {
+                length++;
+            }
+            if (length > best_length) {
+                best_length = length;
+                *match_dist = dist;
+                if (length == max_length) {
+                    break;
+                }
+            }
+        }
+        uint32_t next = stream->prev[candidate & GZIP_WINDOW_MASK];
+        if (next >= candidate) {
+            break; // Slot was reused by a newer position, the chain ends here
+        }
+        candidate = next;
+    }
+    return best_length;
+}
+
+/* Compresses the window, leaving GZIP_MIN_LOOKAHEAD bytes for the next input unless this is the end */
+static void gzip_compress(gzip_stream_t *stream, bool flush) {
+
+    uint32_t lookahead;
+
+    while ((lookahead = stream->window_end - stream->position) > 0 && (flush || lookahead >= GZIP_MIN_LOOKAHEAD)) {
+
+        uint32_t length = 0;
+        uint32_t dist = 0;
+
+        if (lookahead >= GZIP_MIN_MATCH) {
+            uint32_t candidate = gzip_insert(stream, stream->position);
+            uint32_t max_length = lookahead < GZIP_MAX_MATCH ? lookahead : GZIP_MAX_MATCH;
+            length = gzip_longest_match(stream, candidate, max_length, &dist);
+        }
+
+        if (length < GZIP_MIN_MATCH) {
+            gzip_put_symbol(stream, stream->window[stream->position]);
+            stream->position++;
+            continue;
+        }
+
+        gzip_put_match(stream, length, dist);
+        // Bytes inside the match become match candidates too
+        uint32_t match_end = stream->position + length;
+        for (stream->position++; stream->position < match_end; stream->position++) {
+            if (stream->position + GZIP_MIN_MATCH <= stream->window_end) {
+                gzip_insert(stream, stream->position);
+            }
+        }
+    }
+}
+
+/* Drops the older half of the window, positions in the hash chains move with it */
+static void gzip_slide_window(gzip_stream_t *stream) {
+
+    memmove(stream->window, stream->window + GZIP_STREAM_WINDOW_SIZE, GZIP_STREAM_WINDOW_SIZE);
+    stream->window_end -= GZIP_STREAM_WINDOW_SIZE;
+    stream->position -= GZIP_STREAM_WINDOW_SIZE;
+
+    for (size_t i = 0; i < sizeof(stream->head) / sizeof(stream->head[0]); i++) {
+        stream->head[i] = stream->head[i] >= GZIP_STREAM_WINDOW_SIZE ? stream->head[i] - GZIP_STREAM_WINDOW_SIZE : 0;
+    }
+    for (size_t i = 0; i < sizeof(stream->prev) / sizeof(stream->prev[0]); i++) {
+        stream->prev[i] = stream->prev[i] >= GZIP_STREAM_WINDOW_SIZE ? stream->prev[i] - GZIP_STREAM_WINDOW_SIZE : 0;
+    }
+}
+
+static void gzip_release(gzip_stream_t *stream) {
+    portENTER_CRITICAL(&pool_lock);
+    stream->in_use = false;
+    portEXIT_CRITICAL(&pool_lock);
+}
+
+gzip_stream_t *gzip_stream_begin(gzip_stream_write_t write, void *ctx) {
+
+    gzip_stream_t *stream = NULL;
+
+    portENTER_CRITICAL(&pool_lock);
+    for (int i = 0; i < GZIP_STREAM_POOL_SIZE; i++) {
+        if (!pool[i].in_use) {
+            stream = &pool[i];
+            stream->in_use = true;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&pool_lock);
+
+    if (stream == NULL) {
+        ESP_LOGW(TAG, "All %d streams are in use", GZIP_STREAM_POOL_SIZE);
+        return NULL;
+    }
+    gzip_init_tables();
+
+    stream->write = write;
+    stream->ctx = ctx;
+    stream->error = ESP_OK;
+    memset(stream->head, 0, sizeof(stream->head));
+    stream->window_end = 0;
+    stream->position = 0;
+    stream->bit_buffer = 0;
+    stream->bit_count = 0;
+    stream->out_len = 0;
+    stream->crc32 = 0;
+    stream->in_bytes = 0;
+    stream->out_bytes = 0;
+
+    // gzip header (RFC 1952): deflate, no flags, no mtime, no extra flags, unknown OS
+    static const uint8_t header[10] = { 0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF };
+    for (size_t i = 0; i < sizeof(header); i++) {
+        gzip_put_byte(stream, header[i]);
+    }
+
+    // One fixed Huffman block for the whole stream, it does not need to know the input size
+    gzip_put_bits(stream, 0, 1);    // BFINAL = 0, a final empty block is added at the end
+    gzip_put_bits(stream, 1, 2);    // BTYPE = 01 fixed Huffman
+    return stream;
+}
+
+esp_err_t gzip_stream_write(const char *data, size_t len, void *ctx) {
+
+    gzip_stream_t *stream = (gzip_stream_t *)ctx;
+
+    stream->crc32 = esp_rom_crc32_le(stream->crc32, (const uint8_t *)data, len);
+    stream->in_bytes += len;
+
+    while (len > 0 && stream->error == ESP_OK) {
+        if (stream->window_end == sizeof(stream->window)) {
+            gzip_slide_window(stream); // Compressed up to GZIP_MIN_LOOKAHEAD before the end, so the upper half is still needed
+        }
+        size_t chunk = sizeof(stream->window) - stream->window_end;
+        if (chunk > len) {
+            chunk = len;
+        }
+        memcpy(stream->window + stream->window_end, data, chunk);
+        stream->window_end += chunk;
+        data += chunk;
+        len -= chunk;
+        gzip_compress(stream, false);
+    }
+    return stream->error;
+}
+
+esp_err_t gzip_stream_finish(gzip_stream_t *stream, gzip_stream_stats_t *stats) {
+
+    gzip_compress(stream, true);
+    gzip_put_symbol(stream, GZIP_END_OF_BLOCK);
+
+    // Empty final block
+    gzip_put_bits(stream, 1, 1);    // BFINAL = 1
+    gzip_put_bits(stream, 1, 2);    // BTYPE = 01 fixed Huffman
+    gzip_put_symbol(stream, GZIP_END_OF_BLOCK);
+    if (stream->bit_count > 0) {
+        gzip_put_bits(stream, 0, 8 - stream->bit_count);
+    }
+
+    // gzip trailer: CRC-32 and size of the uncompressed data
+    gzip_put_u32(stream, stream->crc32);
+    gzip_put_u32(stream, stream->in_bytes);
+    gzip_flush_out(stream);
+
+    esp_err_t err = stream->error;
+    if (stats != NULL) {
+        stats->in_bytes = stream->in_bytes;
+        stats->out_bytes = stream->out_bytes;
+    }
+    gzip_release(stream);
+    ESP_RETURN_ON_ERROR(err, TAG, "Failed to write compressed data");
+    return ESP_OK;
+}
+
+void gzip_stream_abort(gzip_stream_t *stream) {
+    gzip_release(stream);
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#ifndef GZIP_STREAM_H
+#define GZIP_STREAM_H
+
+/*
+ * Streaming gzip compressor
+ *
+ * Small deflate (RFC 1951) compressor for HTTP Content-Encoding: gzip. Greedy LZ77 matching over a
+ * GZIP_STREAM_WINDOW_SIZE window and the fixed Huffman codes, so there are no code tables to build or send.
+ * That is far from zlib level 9, but CSV/GPX lines repeat most of the previous line and are mostly
+ * covered by matches one line back.
+ *
+ * Streams come from a static pool, nothing is allocated per stream. Input can be written in pieces
+ * of any size, output is passed to the write function in pieces of up to GZIP_STREAM_OUT_SIZE bytes.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_err.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+
+#define GZIP_STREAM_WINDOW_BITS     10      // 1 KB window, about 15 CSV lines back
+#define GZIP_STREAM_WINDOW_SIZE     (1 << GZIP_STREAM_WINDOW_BITS)
+#define GZIP_STREAM_HASH_BITS       9
+#define GZIP_STREAM_MAX_CHAIN       16      // Match candidates tried per position, more is slower and barely smaller
+#define GZIP_STREAM_OUT_SIZE        512
+#define GZIP_STREAM_POOL_SIZE       1       // Streams that can run at once, httpd handles one request at a time
+
+/* Receives compressed data. Returning an error stops the stream. */
+typedef esp_err_t (*gzip_stream_write_t)(const char *data, size_t len, void *ctx);
+
+typedef struct {
+    gzip_stream_write_t write;
+    void *ctx;
+    bool in_use;
+    esp_err_t error;                                    // First error of the write function
+
+    uint8_t window[2 * GZIP_STREAM_WINDOW_SIZE];        // Last window of input + input not compressed yet
+    uint16_t head[1 << GZIP_STREAM_HASH_BITS];          // Last position of each 3 byte hash, 0 if none
+    uint16_t prev[GZIP_STREAM_WINDOW_SIZE];             // Previous position with the same hash
+    uint32_t window_end;                                // Bytes in window
+    uint32_t position;                                  // Next byte to compress
+
+    uint32_t bit_buffer;
+    uint32_t bit_count;
+    uint8_t out[GZIP_STREAM_OUT_SIZE];
+    size_t out_len;
+
+    uint32_t crc32;                                     // Of the uncompressed data, for the gzip trailer
+    uint32_t in_bytes;
+    uint32_t out_bytes;
+} gzip_stream_t;
+
+typedef struct {
+    uint32_t in_bytes;          // Uncompressed bytes
+    uint32_t out_bytes;         // gzip bytes, header and trailer included
+} gzip_stream_stats_t;
+
+/**
+ * @brief Takes a stream from the pool and writes the gzip header.
+ *
+ * @param write Function that receives the compressed data.
+ * @param ctx User context passed to the write function.
+ * @return The stream, or NULL if all streams of the pool are in use (send the data uncompressed then).
+ */
+gzip_stream_t *gzip_stream_begin(gzip_stream_write_t write, void *ctx);
+
+/**
+ * @brief Compresses data. Has the same signature as the track export and manifest write functions,
+ *        so a stream can be put in front of any of them.
+ *
+ * @param data Uncompressed data.
+ * @param len Number of bytes.
+ * @param ctx The stream (gzip_stream_t *).
+ * @return ESP_OK on success, or the error returned by the write function.
+ */
+esp_err_t gzip_stream_write(const char *data, size_t len, void *ctx);
+
+/**
+ * @brief Compresses the rest of the data, writes the gzip trailer and returns the stream to the pool.
+ *
+ * @param stream The stream, not valid after this call.
+ * @param stats Output statistics, can be NULL.
+ * @return ESP_OK on success, or the first error returned by the write function.
+ */
+esp_err_t gzip_stream_finish(gzip_stream_t *stream, gzip_stream_stats_t *stats);
+
+/**
+ * @brief Returns the stream to the pool without finishing it, e.g. after a write error.
+ *
+ * @param stream The stream, not valid after this call.
+ */
+void gzip_stream_abort(gzip_stream_t *stream);
+
+#endif // GZIP_STREAM_H
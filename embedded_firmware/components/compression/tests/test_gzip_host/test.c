@@ -0,0 +1,317 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+/*
+ * Host test of the streaming gzip compressor (gzip_stream.c), checked against zlib.
+ * A one hour track is written to a RAM emulator of the W25Q128JV through track_file.c and exported to CSV and GPX,
+ * as /download renders it. Every input below is compressed in writes of 1, 7 and 1460 bytes (one TCP segment):
+ *
+ * - empty, 1 byte
+ * - run-heavy: runs of one byte of random length
+ * - random bytes, that deflate can not compress
+ * - the CSV and GPX export of the track
+ *
+ * zlib must inflate the output back to the input (zlib also checks the CRC-32 and size of the gzip trailer),
+ * no output piece may be larger than GZIP_STREAM_OUT_SIZE, and the ratio must be in the range of the input.
+ * Prints the ratio and the compression throughput of every case, then the table of gzip_benchmark_all_tracks().
+ *
+ *     ./test_gzip [-n fixes of the track]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <zlib.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "compression/gzip_stream.h"
+#include "compression/gzip_benchmark.h"
+#include "track_format/track_file.h"
+#include "block_device/block_device_emu.h"
+
+#define TEST_SECTORS        512             // 2 MB of the W25Q128JV
+#define TEST_BINARY_SIZE    (64 * 1024)     // Run-heavy and random inputs
+
+typedef struct {
+    uint8_t *data;
+    size_t len;
+    size_t size;
+    size_t max_piece;       // Largest piece passed to the write function
+} test_buffer_t;
+
+typedef struct {
+    const char *name;
+    test_buffer_t *input;
+    uint32_t max_ratio;     // Max gzip size in % of the input, 0 if not checked
+} test_input_t;
+
+static const size_t test_chunk_sizes[] = { 1, 7, 1460 };
+
+static gps_fix_t test_fix;
+
+/* gps_l96.c is not linked: the track starts at the fix of test_make_fix(0) */
+void gps_l96_get_current_fix(gps_fix_t *fix) {
+    *fix = test_fix;
+}
+
+esp_err_t gps_l96_get_date_string_from_data(char *date_string, size_t date_string_size) {
+    snprintf(date_string, date_string_size, "%04d-%02d-%02d", test_fix.date.year, test_fix.date.month, test_fix.date.day);
+    return ESP_OK;
+}
+
+/* LittleFS is always on the emulator, lfs_set_block_device() is called before the mount */
+block_device_t *block_device_w25q_get(void) {
+    return NULL;
+}
+
+/* A dog walking at 1 Hz, with GPS noise */
+static void test_make_fix(gps_fix_t *fix, uint32_t n) {
+    memset(fix, 0, sizeof(*fix));
+    fix->date.year = 2025;
+    fix->date.month = 6;
+    fix->date.day = 1 + n / 86400;
+    fix->time.hours = (n / 3600) % 24;
+    fix->time.minutes = (n / 60) % 60;
+    fix->time.seconds = n % 60;
+    fix->latitude_e6 = 46050000 + (int32_t)((n * 2654435761u) % 20) - 10 + 12 * (int32_t)n;
+    fix->longitude_e6 = 14500000 + (int32_t)((n * 40503u) % 20) - 10 + 5 * (int32_t)n;
+    fix->speed_mm_s = 1300 + (n * 37) % 400;
+    fix->course_cdeg = 2200 + (n * 113) % 800;
+    fix->altitude_dm = 2950 + (int32_t)(n % 50);
+    fix->hdop_x100 = 90 + (n % 40);
+    fix->satellites = 8;
+    fix->valid = true;
+}
+
+static esp_err_t test_buffer_write(const char *data, size_t len, void *ctx) {
+    test_buffer_t *buffer = (test_buffer_t *)ctx;
+
+    if (len == 0) {
+        return ESP_OK;
+    }
+    if (buffer->len + len > buffer->size) {
+        size_t size = buffer->size ? buffer->size : 4096;
+        while (size < buffer->len + len) {
+            size *= 2;
+        }
+        uint8_t *data_new = realloc(buffer->data, size);
+        if (data_new == NULL) {
+            return ESP_ERR_NO_MEM;
+        }
+        buffer->data = data_new;
+        buffer->size = size;
+    }
+    memcpy(buffer->data + buffer->len, data, len);
+    buffer->len += len;
+    buffer->max_piece = len > buffer->max_piece ? len : buffer->max_piece;
+    return ESP_OK;
+}
+
+static void test_buffer_reset(test_buffer_t *buffer) {
+    buffer->len = 0;
+    buffer->max_piece = 0;
+}
+
+/* Track of 1 Hz fixes on the emulator, exported as /download does */
+static esp_err_t test_make_track(block_device_t *dev, uint32_t fixes, char *filename, size_t filename_size,
+                                 test_buffer_t *csv, test_buffer_t *gpx) {
+    for (uint32_t sector = 0; sector < 2; sector++) {
+        ESP_RETURN_ON_ERROR(block_device_erase(dev, sector), "TEST", "Failed to erase superblock");
+    }
+    ESP_RETURN_ON_ERROR(lfs_set_block_device(dev), "TEST", "Failed to select the emulator");
+    ESP_RETURN_ON_ERROR(lfs_mount_filesystem(true), "TEST", "Failed to format");
+
+    test_make_fix(&test_fix, 0);
+    ESP_RETURN_ON_ERROR(track_file_create(filename, filename_size), "TEST", "Failed to create track");
+    ESP_RETURN_ON_ERROR(track_writer_open(filename), "TEST", "Failed to open track");
+    for (uint32_t n = 0; n < fixes; n++) {
+        gps_fix_t fix;
+        test_make_fix(&fix, n);
+        ESP_RETURN_ON_ERROR(track_file_append_fix(&fix), "TEST", "Failed to append fix %lu", n);
+    }
+    ESP_RETURN_ON_ERROR(track_writer_close(), "TEST", "Failed to close track");
+
+    ESP_RETURN_ON_ERROR(track_file_export(filename, TRACK_EXPORT_CSV, test_buffer_write, csv), "TEST", "CSV export failed");
+    ESP_RETURN_ON_ERROR(track_file_export(filename, TRACK_EXPORT_GPX, test_buffer_write, gpx), "TEST", "GPX export failed");
+    return ESP_OK;
+}
+
+static void test_make_binary(test_buffer_t *runs, test_buffer_t *random) {
+    uint32_t seed = 12345;
+    char byte;
+
+    while (random->len < TEST_BINARY_SIZE) {
+        seed = seed * 1103515245 + 12345;
+        byte = (char)(seed >> 16);
+        test_buffer_write(&byte, 1, random);
+    }
+    while (runs->len < TEST_BINARY_SIZE) {
+        seed = seed * 1103515245 + 12345;
+        byte = (char)(seed >> 24);
+        for (uint32_t run = 1 + (seed >> 8) % 300; run > 0 && runs->len < TEST_BINARY_SIZE; run--) {
+            test_buffer_write(&byte, 1, runs);
+        }
+    }
+}
+
+/* Compresses the input in writes of chunk_size bytes, inflates it with zlib and compares */
+static int test_compress(const test_input_t *input, size_t chunk_size, test_buffer_t *gzip, test_buffer_t *inflated) {
+    gzip_stream_stats_t stats;
+    esp_err_t err = ESP_OK;
+
+    test_buffer_reset(gzip);
+    test_buffer_reset(inflated);
+
+    int64_t start_us = esp_timer_get_time();
+    gzip_stream_t *stream = gzip_stream_begin(test_buffer_write, gzip);
+    if (stream == NULL) {
+        fprintf(stderr, "%s: no free stream\n", input->name);
+        return 1;
+    }
+    for (size_t offset = 0; err == ESP_OK && offset < input->input->len; offset += chunk_size) {
+        size_t len = input->input->len - offset < chunk_size ? input->input->len - offset : chunk_size;
+        err = gzip_stream_write((const char *)input->input->data + offset, len, stream);
+    }
+    if (err != ESP_OK) {
+        gzip_stream_abort(stream);
+    } else {
+        err = gzip_stream_finish(stream, &stats);
+    }
+    int64_t elapsed_us = esp_timer_get_time() - start_us;
+    if (err != ESP_OK) {
+        fprintf(stderr, "%s in %zu B writes: %s\n", input->name, chunk_size, esp_err_to_name(err));
+        return 1;
+    }
+
+    // 15 + 16: gzip wrapper, any window, zlib checks the CRC-32 and size in the trailer
+    z_stream zs = {0};
+    uint8_t out[4096];
+    int zret = inflateInit2(&zs, 15 + 16);
+    zs.next_in = gzip->data;
+    zs.avail_in = gzip->len;
+    while (zret == Z_OK) {
+        zs.next_out = out;
+        zs.avail_out = sizeof(out);
+        zret = inflate(&zs, Z_NO_FLUSH);
+        test_buffer_write((const char *)out, sizeof(out) - zs.avail_out, inflated);
+        if (zret == Z_OK && zs.avail_in == 0 && zs.avail_out != 0) {
+            zret = Z_DATA_ERROR; // Ended before the trailer
+        }
+    }
+    inflateEnd(&zs);
+
+    int failed = 0;
+    if (zret != Z_STREAM_END || zs.avail_in != 0) {
+        fprintf(stderr, "%s in %zu B writes: zlib inflate %s (%d), %u bytes left\n", input->name, chunk_size,
+                zs.msg ? zs.msg : "failed", zret, zs.avail_in);
+        failed++;
+    } else if (inflated->len != input->input->len ||
+               (inflated->len > 0 && memcmp(inflated->data, input->input->data, inflated->len) != 0)) {
+        fprintf(stderr, "%s in %zu B writes: inflated %zu bytes differ from the %zu input bytes\n", input->name,
+                chunk_size, inflated->len, input->input->len);
+        failed++;
+    }
+    if (stats.in_bytes != input->input->len || stats.out_bytes != gzip->len) {
+        fprintf(stderr, "%s in %zu B writes: stats %lu -> %lu bytes, expected %zu -> %zu\n", input->name, chunk_size,
+                stats.in_bytes, stats.out_bytes, input->input->len, gzip->len);
+        failed++;
+    }
+    if (gzip->max_piece > GZIP_STREAM_OUT_SIZE) {
+        fprintf(stderr, "%s in %zu B writes: %zu byte output piece\n", input->name, chunk_size, gzip->max_piece);
+        failed++;
+    }
+    uint32_t ratio = input->input->len ? (uint32_t)(gzip->len * 100 / input->input->len) : 0;
+    if (input->max_ratio && ratio > input->max_ratio) {
+        fprintf(stderr, "%s in %zu B writes: %lu%% of the input, expected at most %lu%%\n", input->name, chunk_size,
+                ratio, input->max_ratio);
+        failed++;
+    }
+
+    printf("%-10s %5zu B writes | %7zu -> %7zu B %4lu%% | %6llu KB/s\n", input->name, chunk_size,
+           input->input->len, gzip->len, ratio,
+           elapsed_us > 0 ? (uint64_t)input->input->len * 1000000 / 1024 / elapsed_us : 0);
+    return failed;
+}
+
+int main(int argc, char **argv) {
+    uint32_t fixes = 3600;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        switch (opt) {
+            case 'n': fixes = strtoul(optarg, NULL, 10); break;
+            default:
+                fprintf(stderr, "Usage: %s [-n fixes]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (fixes == 0) {
+        fprintf(stderr, "At least 1 fix\n");
+        return 2;
+    }
+
+    // Only the results, not the info logs of the mount and the exports
+    esp_log_level_set("*", ESP_LOG_WARN);
+    esp_log_level_set("LFS_INTEGRATION", ESP_LOG_ERROR); // The first mount of the erased emulator fails by design
+
+    block_device_emu_t emu;
+    block_device_emu_config_t config = BLOCK_DEVICE_EMU_W25Q128JV_CONFIG();
+    config.sector_count = TEST_SECTORS;
+    config.strict_program = true;
+    char filename[LFS_MAX_FILE_NAME_SIZE];
+    test_buffer_t empty = {0}, one = {0}, runs = {0}, random = {0}, csv = {0}, gpx = {0};
+    test_buffer_t gzip = {0}, inflated = {0};
+    int failed = 0;
+
+    if (block_device_emu_create_ram(&emu, &config) != ESP_OK ||
+        test_make_track(&emu.dev, fixes, filename, sizeof(filename), &csv, &gpx) != ESP_OK) {
+        fprintf(stderr, "No track on the emulator\n");
+        block_device_emu_destroy(&emu);
+        return 1;
+    }
+    test_buffer_write("2", 1, &one);
+    test_make_binary(&runs, &random);
+
+    // Fixed Huffman codes: a literal takes up to 9 bits, so random data grows by up to 1/8 plus header and trailer
+    const test_input_t inputs[] = {
+        { "empty",  &empty,  0 },
+        { "1 byte", &one,    0 },
+        { "runs",   &runs,   10 },
+        { "random", &random, 113 },
+        { "CSV",    &csv,    50 },
+        { "GPX",    &gpx,    30 },
+    };
+
+    for (size_t i = 0; i < sizeof(inputs) / sizeof(inputs[0]); i++) {
+        for (size_t c = 0; c < sizeof(test_chunk_sizes) / sizeof(test_chunk_sizes[0]); c++) {
+            failed += test_compress(&inputs[i], test_chunk_sizes[c], &gzip, &inflated);
+        }
+    }
+
+    // The on-collar benchmark on the same track: render only vs. render and compress, from LittleFS
+    gzip_benchmark_result_t result;
+    if (gzip_benchmark_track(filename, TRACK_EXPORT_CSV, &result) != ESP_OK || result.text_bytes != csv.len ||
+        result.gzip_bytes == 0 || result.gzip_bytes >= result.text_bytes) {
+        fprintf(stderr, "gzip_benchmark_track of %s failed\n", filename);
+        failed++;
+    }
+    fflush(stdout); // The logs go to stderr
+    esp_log_level_set("GZIP_BENCHMARK", ESP_LOG_INFO);
+    gzip_benchmark_all_tracks();
+
+    lfs_unmount_filesystem();
+    block_device_emu_destroy(&emu);
+    free(empty.data); free(one.data); free(runs.data); free(random.data); free(csv.data); free(gpx.data);
+    free(gzip.data); free(inflated.data);
+
+    if (failed) {
+        fprintf(stderr, "%d gzip cases failed\n", failed);
+        return 1;
+    }
+    return 0;
+}
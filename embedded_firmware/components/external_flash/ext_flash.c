@@ -13,6 +13,20 @@ static bool spi_initialized = false;
 /* SPI device handle */
 static spi_device_handle_t spi;
 
+/* Read mode used by ext_flash_read(), set with ext_flash_set_read_mode() */
+static ext_flash_config_t active_config = {
+    .read_mode = EXT_FLASH_READ_MODE_STANDARD,
+    .clock_speed_hz = SPI_CLOCK_SPEED,
+};
+
+static const char *read_mode_names[EXT_FLASH_READ_MODE_COUNT] = {
+    [EXT_FLASH_READ_MODE_STANDARD]    = "standard (0x0B)",
+    [EXT_FLASH_READ_MODE_DUAL_OUTPUT] = "dual output (0x3B)",
+    [EXT_FLASH_READ_MODE_DUAL_IO]     = "dual I/O (0xBB)",
+    [EXT_FLASH_READ_MODE_QUAD_OUTPUT] = "quad output (0x6B)",
+    [EXT_FLASH_READ_MODE_QUAD_IO]     = "quad I/O (0xEB)",
+};
+
 spi_bus_config_t get_spi_bus_config(void) {
     spi_bus_config_t spi_bus_config;
     memset(&spi_bus_config, 0, sizeof(spi_bus_config)); // Clear all fields to 0
@@ -20,15 +34,20 @@ spi_bus_config_t get_spi_bus_config(void) {
     spi_bus_config.mosi_io_num = SPI_PIN_MOSI;
     spi_bus_config.miso_io_num = SPI_PIN_MISO;
     spi_bus_config.sclk_io_num = SPI_PIN_CLK;
+#if EXT_FLASH_QUAD_PINS_AVAILABLE
+    spi_bus_config.quadwp_io_num = SPI_PIN_NUM_WP;   // WP# is IO2 in quad reads
+    spi_bus_config.quadhd_io_num = SPI_PIN_NUM_HOLD; // HOLD# is IO3 in quad reads
+#else
     spi_bus_config.quadwp_io_num = -1; // Not using Quad Write Protect (IO2)
     spi_bus_config.quadhd_io_num = -1; // Not using Quad Hold (IO3)
+#endif
     spi_bus_config.max_transfer_sz = SPI_MAX_TRANSFER_SIZE; // Max size for a single transaction
 
     return spi_bus_config;
 }
 
 /* Helper function to get SPI device configuration */
-static spi_device_interface_config_t get_spi_device_config(void) {
+static spi_device_interface_config_t get_spi_device_config(uint32_t clock_speed_hz) {
 
     spi_device_interface_config_t devcfg;
     memset(&devcfg, 0, sizeof(devcfg)); 
@@ -36,15 +55,21 @@ static spi_device_interface_config_t get_spi_device_config(void) {
     devcfg.command_bits = 8; // All commands are 8-bit
     devcfg.address_bits = 0; // Are adjusted in each command
     devcfg.dummy_bits = 0;   // Are adjusted in each command
-    devcfg.queue_size = 1; // Only one transaction at a time
-    devcfg.clock_speed_hz = SPI_CLOCK_SPEED; 
+    devcfg.queue_size = SPI_QUEUE_SIZE; // Long reads queue several transactions
+    devcfg.clock_speed_hz = clock_speed_hz; 
     devcfg.mode = W25Q128JV_MODE;        
     devcfg.spics_io_num = SPI_PIN_CS; 
+    devcfg.flags = SPI_DEVICE_HALFDUPLEX; // Needed for dual/quad data phases, commands never send and receive at once
 
     return devcfg;
 }
 
 esp_err_t ext_flash_init(void) {
+    ext_flash_config_t config = EXT_FLASH_DEFAULT_CONFIG();
+    return ext_flash_init_with_config(&config);
+}
+
+esp_err_t ext_flash_init_with_config(const ext_flash_config_t *config) {
 
     /* Guard against multiple initializations */
     if(spi_initialized) {
@@ -61,11 +86,17 @@ esp_err_t ext_flash_init(void) {
 
     /* Initialize the SPI bus */
     spi_bus_config_t buscfg = get_spi_bus_config();
-    spi_device_interface_config_t devcfg = get_spi_device_config();
+    spi_device_interface_config_t devcfg = get_spi_device_config(active_config.clock_speed_hz);
 
     ESP_RETURN_ON_ERROR(spi_bus_initialize(SPI2_HOST, &buscfg, SPI_DMA_CH_AUTO),
                         TAG, "Failed to initialize SPI bus");
 
+#if EXT_FLASH_QUAD_PINS_AVAILABLE
+    /* WP# and HOLD# are now driven by the SPI peripheral - keep them pulled up, so they never float low */
+    gpio_pullup_en(SPI_PIN_NUM_WP);
+    gpio_pullup_en(SPI_PIN_NUM_HOLD);
+#endif
+
     /* Add the flash device to the bus */
     ESP_RETURN_ON_ERROR(spi_bus_add_device(SPI2_HOST, &devcfg, &spi),
                         TAG, "Failed to add SPI device");
@@ -78,9 +109,22 @@ esp_err_t ext_flash_init(void) {
     ESP_RETURN_ON_ERROR(ext_flash_global_block_unlock(),
                         TAG, "Failed to unlock global block");
 
-    ESP_LOGI(TAG, "External flash initialized successfully");
-
     spi_initialized = true; // Set the flag to true after successful initialization
+
+    /* Switch to the fast read mode, fall back to the slow clock and then to standard SPI if it does not verify */
+    ext_flash_config_t fallbacks[] = {
+        *config,
+        { .read_mode = config->read_mode, .clock_speed_hz = SPI_CLOCK_SPEED },
+        { .read_mode = EXT_FLASH_READ_MODE_STANDARD, .clock_speed_hz = SPI_CLOCK_SPEED },
+    };
+    for (size_t i = 0; i < sizeof(fallbacks) / sizeof(fallbacks[0]); i++) {
+        if (ext_flash_set_read_mode(&fallbacks[i]) == ESP_OK) {
+            break;
+        }
+    }
+
+    ESP_LOGI(TAG, "External flash initialized successfully, reads use %s at %lu kHz",
+             ext_flash_read_mode_to_string(active_config.read_mode), active_config.clock_speed_hz / 1000);
     return ESP_OK;
 }
 
@@ -121,7 +165,7 @@ esp_err_t ext_flash_read_jedec_data(void) {
     spi_transaction_ext_t t = {0}; 
     t.base.cmd = SPI_CMD_JEDEC_ID;
     t.base.rxlength = SPI_JEDEC_DATA_BITS; 
-    t.base.length = SPI_JEDEC_DATA_BITS; 
+    t.base.length = 0; // Half duplex - nothing is sent after the command
     t.base.flags = SPI_TRANS_VARIABLE_ADDR | SPI_TRANS_VARIABLE_DUMMY; 
     t.address_bits = 0;    
     t.dummy_bits = 0;      
@@ -163,89 +207,165 @@ esp_err_t ext_flash_read_status_register(uint8_t *status_reg_value) {
     /* Initialize the transaction structure for reading the status register */
     spi_transaction_ext_t t = {0}; 
     t.base.cmd = SPI_CMD_READ_STATUS_REG1;
-    t.base.length = 8;       
+    t.base.length = 0;       
     t.base.rxlength = 8;     
     t.base.flags = SPI_TRANS_VARIABLE_ADDR | SPI_TRANS_VARIABLE_DUMMY; 
     t.address_bits = 0;
     t.dummy_bits = 0;       
 
     /* Set the RX buffer for the status register and read the register from external flash chip*/
+    /* Polling transmit - no interrupt and context switch, since it is called in busy-wait loops */
     t.base.rx_buffer = status_reg_value;
-    ESP_RETURN_ON_ERROR(spi_device_transmit(spi, (spi_transaction_t*)&t),
+    ESP_RETURN_ON_ERROR(spi_device_polling_transmit(spi, (spi_transaction_t*)&t),
                         TAG, "Failed to read status register"
     );
 
     return ESP_OK;
 }
 
-esp_err_t ext_flash_wait_for_idle(int timeout_ms) {
+/* Waits until the BUSY bit is cleared. Sleeps through long operations and spins with sub-tick waits on short ones. */
+static esp_err_t ext_flash_wait_until_ready(uint32_t typical_us, int64_t timeout_us) {
     uint8_t status_reg;
-    TickType_t start_time = xTaskGetTickCount(); // Start time for timeout calculation
+    int64_t start_time = esp_timer_get_time();
+
+    /* 1) Long operations (erase) - sleep through most of the typical time, so other tasks can run */
+    if (typical_us >= 2 * portTICK_PERIOD_MS * 1000) {
+        vTaskDelay(pdMS_TO_TICKS(typical_us / 1000) - 1);
+    }
 
+    /* 2) Poll the status register */
+    int64_t poll_start_time = esp_timer_get_time();
     do {
-        /* Read the status register to check if the flash is busy */
         ESP_RETURN_ON_ERROR(ext_flash_read_status_register(&status_reg), 
                             TAG, "Failed to read status register"
         );
 
         /* Check the BUSY bit (LSB of status register -> S0). It's 0 when idle. */
-        if (!(status_reg & (1 << 0))) { 
+        int64_t now = esp_timer_get_time();
+        if (!(status_reg & W25Q128JV_STATUS_BUSY)) { 
+            metrics_add(METRICS_FLASH_BUSY_WAIT_US, (uint32_t)(now - start_time));
             return ESP_OK; //break out if flash is idle-ready to accept new commands
         }
 
-        vTaskDelay(pdMS_TO_TICKS(1)); // Wait 1ms before polling again
-
-        // Check for timeout
-        if ((xTaskGetTickCount() - start_time) * portTICK_PERIOD_MS > timeout_ms) {
+        if (now - start_time > timeout_us) {
+            metrics_add(METRICS_FLASH_BUSY_WAIT_US, (uint32_t)(now - start_time));
             ESP_LOGE(TAG, "Timeout waiting for flash operation to complete. Final Status: 0x%02X", status_reg);
             return ESP_ERR_TIMEOUT;
         }
+
+        if (now - poll_start_time < EXT_FLASH_SPIN_LIMIT_US) {
+            esp_rom_delay_us(EXT_FLASH_POLL_INTERVAL_US); // Short wait, operation should finish any moment
+        } else {
+            vTaskDelay(1); // Taking longer than expected - do not block other tasks
+        }
     } while (true); 
 }
-esp_err_t ext_flash_read(uint32_t address, uint8_t *buffer, uint32_t size) {
 
-    if (size == 0) {
-        return ESP_OK; // Nothing to read
-    }
+esp_err_t ext_flash_wait_for_idle(int timeout_ms) {
+    return ext_flash_wait_until_ready(0, (int64_t)timeout_ms * 1000);
+}
 
-    if (size > SPI_MAX_TRANSFER_SIZE) {
-        ESP_LOGE(TAG, "Read size (%lu) exceeds max transfer size (%d). Consider breaking into smaller reads.", size, SPI_MAX_TRANSFER_SIZE);
-        return ESP_ERR_INVALID_SIZE;
+/* Fills a read transaction for the given mode. The command is always sent on one line. */
+static void ext_flash_setup_read(spi_transaction_ext_t *t, ext_flash_read_mode_t mode,
+                                 uint32_t address, uint8_t *buffer, uint32_t size) {
+
+    memset(t, 0, sizeof(*t));
+    t->base.addr = address;
+    t->base.rx_buffer = buffer;     // Buffer to receive data
+    t->base.rxlength = size * 8;    // Total bits to receive
+    t->base.length = 0;             // Half duplex - nothing is sent after the address
+    t->base.flags = SPI_TRANS_VARIABLE_ADDR | SPI_TRANS_VARIABLE_DUMMY;
+    t->address_bits = 24;
+    t->dummy_bits = 8;              // Dummy clock cycles
+
+    switch (mode) {
+        case EXT_FLASH_READ_MODE_DUAL_OUTPUT:
+            t->base.cmd = SPI_CMD_FAST_READ_DUAL_OUT;
+            t->base.flags |= SPI_TRANS_MODE_DIO;
+            break;
+        case EXT_FLASH_READ_MODE_DUAL_IO:
+            /* Address + mode bits on 2 lines take 16 clocks, no extra dummy clocks */
+            t->base.cmd = SPI_CMD_FAST_READ_DUAL_IO;
+            t->base.flags |= SPI_TRANS_MODE_DIO | SPI_TRANS_MULTILINE_ADDR;
+            t->base.addr = (address << 8) | W25Q128JV_MODE_BITS;
+            t->address_bits = 32;
+            t->dummy_bits = 0;
+            break;
+        case EXT_FLASH_READ_MODE_QUAD_OUTPUT:
+            t->base.cmd = SPI_CMD_FAST_READ_QUAD_OUT;
+            t->base.flags |= SPI_TRANS_MODE_QIO;
+            break;
+        case EXT_FLASH_READ_MODE_QUAD_IO:
+            /* Address + mode bits on 4 lines take 8 clocks, followed by 4 dummy clocks */
+            t->base.cmd = SPI_CMD_FAST_READ_QUAD_IO;
+            t->base.flags |= SPI_TRANS_MODE_QIO | SPI_TRANS_MULTILINE_ADDR;
+            t->base.addr = (address << 8) | W25Q128JV_MODE_BITS;
+            t->address_bits = 32;
+            t->dummy_bits = 4;
+            break;
+        case EXT_FLASH_READ_MODE_STANDARD:
+        default:
+            t->base.cmd = SPI_CMD_FAST_READ;
+            break;
     }
+}
 
-    /* Initialize the transaction structure for reading the data */
-    spi_transaction_ext_t t = {0}; 
-    t.base.cmd = SPI_CMD_FAST_READ; 
-    t.base.addr = address;          
-    t.base.rx_buffer = buffer;      // Buffer to receive data
-    t.base.rxlength = size * 8;     // Total bits to receive
-    t.base.length = size * 8;       // Length equal to rxlength for full-duplex read
-    t.base.flags = SPI_TRANS_VARIABLE_ADDR | SPI_TRANS_VARIABLE_DUMMY;
-    t.address_bits = 24; 
-    t.dummy_bits = 8;    
+esp_err_t ext_flash_read(uint32_t address, uint8_t *buffer, uint32_t size) {
 
-    ESP_RETURN_ON_ERROR(spi_device_transmit(spi, (spi_transaction_t*)&t),
-                        TAG, "Failed to read the data off the external flash chip."
-    );
+    spi_transaction_ext_t transactions[SPI_QUEUE_SIZE];
+    spi_transaction_t *done_transaction;
+    uint32_t offset = 0;
+    uint32_t queued = 0;
+    uint32_t completed = 0;
+    esp_err_t ret = ESP_OK;
+
+    /* Keep up to SPI_QUEUE_SIZE chunks queued - the driver starts the next DMA transfer as soon as one ends */
+    while (completed < queued || (offset < size && ret == ESP_OK)) {
+
+        while (ret == ESP_OK && offset < size && queued - completed < SPI_QUEUE_SIZE) {
+            uint32_t chunk_size = size - offset;
+            if (chunk_size > SPI_MAX_TRANSFER_SIZE) {
+                chunk_size = SPI_MAX_TRANSFER_SIZE;
+            }
+
+            /* Initialize the transaction structure for reading the data */
+            spi_transaction_ext_t *t = &transactions[queued % SPI_QUEUE_SIZE];
+            ext_flash_setup_read(t, active_config.read_mode, address + offset, buffer + offset, chunk_size);
+
+            ret = spi_device_queue_trans(spi, (spi_transaction_t*)t, portMAX_DELAY);
+            if (ret != ESP_OK) {
+                ESP_LOGE(TAG, "Failed to queue read of %lu bytes at 0x%06lX: %s", chunk_size, address + offset, esp_err_to_name(ret));
+                break;
+            }
+            queued++;
+            offset += chunk_size;
+        }
 
-    return ESP_OK;
-}
-esp_err_t ext_flash_write(uint32_t address, const uint8_t *buffer, uint32_t size) {
-    // Ensure write size does not exceed page size
-    if (size == 0 || size > W25Q128JV_PAGE_SIZE) {
-        ESP_LOGE(TAG, "Invalid write size: %lu bytes. Must be 1 to %d bytes.", size, W25Q128JV_PAGE_SIZE);
-        return ESP_ERR_INVALID_SIZE;
+        if (completed == queued) {
+            break; // Nothing in flight (queueing failed)
+        }
+
+        /* Results must be collected even after an error, so the queue is empty for the next caller */
+        esp_err_t result = spi_device_get_trans_result(spi, &done_transaction, portMAX_DELAY);
+        if (result != ESP_OK && ret == ESP_OK) {
+            ret = result;
+        }
+        completed++;
     }
 
-    // 1. Send Write Enable command
-    esp_err_t ret = ext_flash_write_enable();
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Failed to enable write for address 0x%06lX", address);
-        return ret;
+        ESP_LOGE(TAG, "Failed to read the data off the external flash chip.");
     }
-    ret = ext_flash_wait_for_idle(5000); 
+    return ret;
+}
+
+/* Programs data inside one page (address + size must not cross a page boundary) */
+static esp_err_t ext_flash_program_page(uint32_t address, const uint8_t *buffer, uint32_t size) {
+
+    // 1. Send Write Enable command (WEL is set when the command ends, no need to wait)
+    esp_err_t ret = ext_flash_write_enable();
     if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Flash not idle after Write Enable for write operation to 0x%06lX.", address);
+        ESP_LOGE(TAG, "Failed to enable write for address 0x%06lX", address);
         return ret;
     }
 
@@ -263,18 +383,35 @@ esp_err_t ext_flash_write(uint32_t address, const uint8_t *buffer, uint32_t size
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to send write command for 0x%06lX: %s", address, esp_err_to_name(ret));
         return ret;
-    } else {
-        ESP_LOGI(TAG, "Sent write command for 0x%06lX", address);
     }
+    ESP_LOGD(TAG, "Sent write command for 0x%06lX (%lu bytes)", address, size);
+    metrics_inc(METRICS_FLASH_PROGRAMS);
 
-    // 2. Wait for the program operation to complete
-    ret = ext_flash_wait_for_idle(5000); // Increased timeout for write (tPP max 3ms)
+    // 2. Wait for the program operation to complete (tPP typ 0.4 ms, max 3 ms)
+    ret = ext_flash_wait_until_ready(W25Q128JV_T_PP_TYP_US, W25Q128JV_T_PP_MAX_US * 2);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Flash not idle after write operation to 0x%06lX", address);
     }
     return ret;
 }
 
+esp_err_t ext_flash_write(uint32_t address, const uint8_t *buffer, uint32_t size) {
+
+    /* Split the data at page boundaries - Page Program wraps around inside the page otherwise */
+    while (size > 0) {
+        uint32_t page_remaining = W25Q128JV_PAGE_SIZE - (address % W25Q128JV_PAGE_SIZE);
+        uint32_t chunk_size = size < page_remaining ? size : page_remaining;
+
+        ESP_RETURN_ON_ERROR(ext_flash_program_page(address, buffer, chunk_size),
+                            TAG, "Failed to write %lu bytes at 0x%06lX", chunk_size, address);
+
+        address += chunk_size;
+        buffer += chunk_size;
+        size -= chunk_size;
+    }
+    return ESP_OK;
+}
+
 esp_err_t ext_flash_erase_sector(uint32_t address) {
     // Ensure the address is sector-aligned
     if (address % W25Q128JV_SECTOR_SIZE != 0) {
@@ -284,19 +421,13 @@ esp_err_t ext_flash_erase_sector(uint32_t address) {
 
     esp_err_t ret;
 
-    // 1. Send Write Enable command
+    // 1. Send Write Enable command (WEL is set when the command ends, no need to wait)
     ret = ext_flash_write_enable();
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to enable write for sector erase at 0x%06lX", address);
         return ret;
     }
 
-    ret = ext_flash_wait_for_idle(5000); 
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Flash not idle after Write Enable for erase operation at 0x%06lX.", address);
-        return ret;
-    }
-
     spi_transaction_ext_t t = {0}; 
     t.base.flags = SPI_TRANS_VARIABLE_ADDR | SPI_TRANS_VARIABLE_DUMMY;
     t.base.cmd = SPI_CMD_SECTOR_ERASE; // Command: Sector Erase (0x20)
@@ -310,11 +441,12 @@ esp_err_t ext_flash_erase_sector(uint32_t address) {
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to send Sector Erase command for 0x%06lX: %s", address, esp_err_to_name(ret));
         return ret;
-    } else {
-        ESP_LOGI(TAG, "Sent Sector Erase command for 0x%06lX", address);
     }
+    ESP_LOGD(TAG, "Sent Sector Erase command for 0x%06lX", address);
+    metrics_inc(METRICS_FLASH_ERASES);
 
-    ret = ext_flash_wait_for_idle(5000); 
+    // 2. Wait for the erase operation to complete (tSE typ 45 ms, max 400 ms)
+    ret = ext_flash_wait_until_ready(W25Q128JV_T_SE_TYP_US, W25Q128JV_T_SE_MAX_US * 2); 
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Flash not idle after sector erase operation at 0x%06lX.", address);
     }
@@ -332,12 +464,6 @@ esp_err_t ext_flash_chip_erase(void) {
         return ret;
     }
 
-    ret = ext_flash_wait_for_idle(5000); 
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Flash not idle after Write Enable for chip erase operation.");
-        return ret;
-    }
-
     spi_transaction_ext_t t = {0}; 
 
     t.base.cmd = SPI_CMD_CHIP_ERASE; 
@@ -354,6 +480,7 @@ esp_err_t ext_flash_chip_erase(void) {
         return ret;
     } else {
         ESP_LOGI(TAG, "Sent Chip Erase command (0x%02X).", SPI_CMD_CHIP_ERASE);
+        metrics_inc(METRICS_FLASH_ERASES);
     }
 
     // 2. Wait for the erase operation to complete
@@ -367,18 +494,12 @@ esp_err_t ext_flash_chip_erase(void) {
 esp_err_t ext_flash_global_block_unlock(void) {
     esp_err_t ret;
 
-    // Must send Write Enable before Global Block Unlock
+    // Must send Write Enable before Global Block Unlock (WEL is set when the command ends)
     ret = ext_flash_write_enable();
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to enable write for global block unlock.");
         return ret;
     }
-    // Wait for WEL to be set and flash to be ready
-    ret = ext_flash_wait_for_idle(5000); 
-    if (ret != ESP_OK) {
-        ESP_LOGE(TAG, "Flash not idle after Write Enable for global block unlock.");
-        return ret;
-    }
 
     spi_transaction_ext_t t = {0}; 
     t.base.cmd = SPI_CMD_GLOBAL_BLOCK_UNLOCK; 
@@ -404,6 +525,145 @@ esp_err_t ext_flash_global_block_unlock(void) {
     }
     return ret;
 }
+
+/*-------------------- read mode selection --------------------*/
+
+static bool read_mode_is_quad(ext_flash_read_mode_t mode) {
+    return mode == EXT_FLASH_READ_MODE_QUAD_OUTPUT || mode == EXT_FLASH_READ_MODE_QUAD_IO;
+}
+
+static esp_err_t ext_flash_read_status_register2(uint8_t *status_reg_value) {
+
+    spi_transaction_ext_t t = {0}; 
+    t.base.cmd = SPI_CMD_READ_STATUS_REG2;
+    t.base.length = 0;       
+    t.base.rxlength = 8;     
+    t.base.flags = SPI_TRANS_VARIABLE_ADDR | SPI_TRANS_VARIABLE_DUMMY; 
+    t.base.rx_buffer = status_reg_value;
+
+    ESP_RETURN_ON_ERROR(spi_device_polling_transmit(spi, (spi_transaction_t*)&t),
+                        TAG, "Failed to read status register 2");
+    return ESP_OK;
+}
+
+/* Sets the Quad Enable bit, so WP# and HOLD# work as IO2 and IO3. QE is non-volatile, so it is written only once. */
+static esp_err_t ext_flash_enable_quad(void) {
+
+    uint8_t status_reg2;
+    ESP_RETURN_ON_ERROR(ext_flash_read_status_register2(&status_reg2), TAG, "Failed to read QE bit");
+    if (status_reg2 & W25Q128JV_STATUS2_QE) {
+        return ESP_OK;
+    }
+
+    ESP_RETURN_ON_ERROR(ext_flash_write_enable(), TAG, "Failed to enable write for status register 2");
+
+    uint8_t new_status_reg2 = status_reg2 | W25Q128JV_STATUS2_QE; // Keep the other bits (CMP, LB, ...)
+    spi_transaction_ext_t t = {0}; 
+    t.base.cmd = SPI_CMD_WRITE_STATUS_REG2;
+    t.base.length = 8;
+    t.base.tx_buffer = &new_status_reg2;
+    t.base.flags = SPI_TRANS_VARIABLE_ADDR | SPI_TRANS_VARIABLE_DUMMY; 
+
+    ESP_RETURN_ON_ERROR(spi_device_transmit(spi, (spi_transaction_t*)&t),
+                        TAG, "Failed to write status register 2");
+
+    // Wait for the status register write to complete (tW typ 10 ms, max 15 ms)
+    ESP_RETURN_ON_ERROR(ext_flash_wait_until_ready(W25Q128JV_T_W_TYP_US, W25Q128JV_T_W_MAX_US * 2),
+                        TAG, "Flash not idle after writing status register 2");
+
+    ESP_RETURN_ON_ERROR(ext_flash_read_status_register2(&status_reg2), TAG, "Failed to read QE bit");
+    if (!(status_reg2 & W25Q128JV_STATUS2_QE)) {
+        ESP_LOGE(TAG, "QE bit not set after write (SR2: 0x%02X)", status_reg2);
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    ESP_LOGI(TAG, "Quad Enable bit set (SR2: 0x%02X)", status_reg2);
+    return ESP_OK;
+}
+
+/* Re-adds the SPI device with a new clock and sets the read mode used by ext_flash_read() */
+static esp_err_t ext_flash_apply_config(const ext_flash_config_t *config) {
+
+    if (config->clock_speed_hz != active_config.clock_speed_hz) {
+        spi_device_interface_config_t devcfg = get_spi_device_config(config->clock_speed_hz);
+        ESP_RETURN_ON_ERROR(spi_bus_remove_device(spi), TAG, "Failed to remove SPI device");
+        ESP_RETURN_ON_ERROR(spi_bus_add_device(SPI2_HOST, &devcfg, &spi), TAG, "Failed to add SPI device");
+        active_config.clock_speed_hz = config->clock_speed_hz;
+    }
+
+    if (read_mode_is_quad(config->read_mode)) {
+        ESP_RETURN_ON_ERROR(ext_flash_enable_quad(), TAG, "Failed to enable quad mode");
+    }
+
+    active_config.read_mode = config->read_mode;
+    return ESP_OK;
+}
+
+esp_err_t ext_flash_set_read_mode(const ext_flash_config_t *config) {
+
+    static uint8_t reference[EXT_FLASH_VERIFY_SIZE] __attribute__((aligned(4)));
+    static uint8_t verify[EXT_FLASH_VERIFY_SIZE] __attribute__((aligned(4)));
+    const ext_flash_config_t standard_config = {
+        .read_mode = EXT_FLASH_READ_MODE_STANDARD,
+        .clock_speed_hz = SPI_CLOCK_SPEED,
+    };
+
+    if (config == NULL || config->read_mode >= EXT_FLASH_READ_MODE_COUNT || config->clock_speed_hz == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!spi_initialized) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (read_mode_is_quad(config->read_mode) && !EXT_FLASH_QUAD_PINS_AVAILABLE) {
+        ESP_LOGW(TAG, "Read mode %s needs WP/HOLD on the SPI bus", ext_flash_read_mode_to_string(config->read_mode));
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    ext_flash_config_t previous_config = active_config;
+
+    /* 1) Reference read in the slowest, safest mode */
+    ESP_RETURN_ON_ERROR(ext_flash_apply_config(&standard_config), TAG, "Failed to switch to standard read");
+    ESP_RETURN_ON_ERROR(ext_flash_read(0, reference, sizeof(reference)), TAG, "Failed to read reference data");
+
+    bool all_erased = true;
+    for (size_t i = 0; i < sizeof(reference); i++) {
+        if (reference[i] != 0xFF) {
+            all_erased = false;
+            break;
+        }
+    }
+
+    /* 2) Same read in the new mode */
+    memset(verify, 0, sizeof(verify));
+    esp_err_t ret = ext_flash_apply_config(config);
+    if (ret == ESP_OK) {
+        ret = ext_flash_read(0, verify, sizeof(verify));
+    }
+    if (ret == ESP_OK && memcmp(reference, verify, sizeof(reference)) != 0) {
+        ret = ESP_ERR_INVALID_RESPONSE;
+    }
+
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Read mode %s at %lu kHz failed verification (%s), keeping %s at %lu kHz",
+                 ext_flash_read_mode_to_string(config->read_mode), config->clock_speed_hz / 1000, esp_err_to_name(ret),
+                 ext_flash_read_mode_to_string(previous_config.read_mode), previous_config.clock_speed_hz / 1000);
+        ext_flash_apply_config(&previous_config);
+        return ret;
+    }
+
+    if (all_erased && config->read_mode != EXT_FLASH_READ_MODE_STANDARD) {
+        ESP_LOGW(TAG, "Address 0 is erased, read mode %s could not be fully verified",
+                 ext_flash_read_mode_to_string(config->read_mode));
+    }
+    ESP_LOGD(TAG, "Read mode %s at %lu kHz", ext_flash_read_mode_to_string(config->read_mode), config->clock_speed_hz / 1000);
+    return ESP_OK;
+}
+
+const char *ext_flash_read_mode_to_string(ext_flash_read_mode_t mode) {
+    if (mode >= EXT_FLASH_READ_MODE_COUNT) {
+        return "unknown";
+    }
+    return read_mode_names[mode];
+}
 void ext_flash_complete_test(void) {
 
     uint32_t test_address = 0x000000; 
@@ -461,4 +721,79 @@ void ext_flash_complete_test(void) {
         }
         ESP_LOGI(TAG, "[%02d-%02d]: %s", i, i + 15, hex_line);
     }
-}
\ No newline at end of file
+
+    // 4. Write across page boundaries and read the whole sector back with one long read
+    static uint8_t sector_buffer[W25Q128JV_SECTOR_SIZE];
+    uint32_t multi_page_offset = W25Q128JV_PAGE_SIZE + 100; // Starts in the middle of page 1, ends in page 4
+    uint32_t multi_page_size = 3 * W25Q128JV_PAGE_SIZE;
+
+    for (uint32_t i = 0; i < multi_page_size; i++) {
+        sector_buffer[i] = (uint8_t)(i * 7 + 3);
+    }
+    int64_t start_us = esp_timer_get_time();
+    if (ext_flash_write(test_address + multi_page_offset, sector_buffer, multi_page_size) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to write %lu bytes across pages. Aborting test.", multi_page_size);
+        return;
+    }
+    int64_t write_us = esp_timer_get_time() - start_us;
+
+    memset(sector_buffer, 0, sizeof(sector_buffer));
+    start_us = esp_timer_get_time();
+    if (ext_flash_read(test_address, sector_buffer, sizeof(sector_buffer)) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to read %d bytes. Aborting test.", (int)sizeof(sector_buffer));
+        return;
+    }
+    int64_t read_us = esp_timer_get_time() - start_us;
+
+    // Expected: page 0 from step 2, written pattern, 0xFF everywhere else
+    for (uint32_t i = 0; i < sizeof(sector_buffer); i++) {
+        uint8_t expected = 0xFF;
+        if (i < W25Q128JV_PAGE_SIZE) {
+            expected = (uint8_t)i;
+        } else if (i >= multi_page_offset && i < multi_page_offset + multi_page_size) {
+            expected = (uint8_t)((i - multi_page_offset) * 7 + 3);
+        }
+        if (sector_buffer[i] != expected) {
+            ESP_LOGE(TAG, "Multi-page test failed at offset %lu: read 0x%02X, expected 0x%02X", i, sector_buffer[i], expected);
+            return;
+        }
+    }
+    ESP_LOGI(TAG, "Multi-page test OK: wrote %lu bytes in %lld us, read %d bytes in %lld us",
+             multi_page_size, write_us, (int)sizeof(sector_buffer), read_us);
+}
+
+void ext_flash_read_benchmark(void) {
+
+    static uint8_t benchmark_buffer[SPI_MAX_TRANSFER_SIZE] __attribute__((aligned(4)));
+    const uint32_t clock_speeds[] = { SPI_CLOCK_SPEED, SPI_CLOCK_SPEED_FAST };
+    ext_flash_config_t previous_config = active_config;
+
+    for (size_t c = 0; c < sizeof(clock_speeds) / sizeof(clock_speeds[0]); c++) {
+        for (int mode = 0; mode < EXT_FLASH_READ_MODE_COUNT; mode++) {
+
+            ext_flash_config_t config = { .read_mode = mode, .clock_speed_hz = clock_speeds[c] };
+            if (ext_flash_set_read_mode(&config) != ESP_OK) {
+                ESP_LOGW(TAG, "Benchmark: %s at %lu kHz not available", ext_flash_read_mode_to_string(mode), clock_speeds[c] / 1000);
+                continue;
+            }
+
+            int64_t start_us = esp_timer_get_time();
+            for (uint32_t address = 0; address < EXT_FLASH_BENCHMARK_SIZE; address += sizeof(benchmark_buffer)) {
+                if (ext_flash_read(address, benchmark_buffer, sizeof(benchmark_buffer)) != ESP_OK) {
+                    ESP_LOGE(TAG, "Benchmark: read failed at 0x%06lX", address);
+                    break;
+                }
+            }
+            int64_t elapsed_us = esp_timer_get_time() - start_us;
+
+            ESP_LOGI(TAG, "Benchmark: %-20s %5lu kHz: %d KB in %lld us = %lld KB/s",
+                     ext_flash_read_mode_to_string(mode), clock_speeds[c] / 1000,
+                     EXT_FLASH_BENCHMARK_SIZE / 1024, elapsed_us,
+                     elapsed_us > 0 ? (int64_t)EXT_FLASH_BENCHMARK_SIZE * 1000000 / 1024 / elapsed_us : 0);
+        }
+    }
+
+    if (ext_flash_set_read_mode(&previous_config) != ESP_OK) {
+        ESP_LOGE(TAG, "Benchmark: failed to restore %s", ext_flash_read_mode_to_string(previous_config.read_mode));
+    }
+}
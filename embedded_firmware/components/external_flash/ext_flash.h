@@ -14,11 +14,15 @@
 #include "driver/gpio.h"
 #include "esp_err.h"
 #include "external_flash_gpio.h" // For WP and HOLD pin definitions
+#include "w25q128jv.h"
 #include "driver/gpio.h"
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_check.h"
+#include "esp_timer.h"
+#include "esp_rom_sys.h"
+#include "metrics/metrics.h"
 
 #include <string.h>
 
@@ -27,6 +31,8 @@
 #define SPI_PIN_CLK  GPIO_NUM_20
 #define SPI_PIN_CS   GPIO_NUM_3
 // WP and HOLD pins are defined in spi_gpio_config.h , since they are manually controlled
+// WP and HOLD are ESP32 GPIOs (not expander pins), so they can also be routed to the SPI bus as IO2/IO3 for quad reads
+#define EXT_FLASH_QUAD_PINS_AVAILABLE 1
 
 #define SPI_CMD_JEDEC_ID     0x9F
 #define SPI_CMD_ENABLE_RESET 0x66
@@ -34,8 +40,10 @@
 
 #define SPI_JEDEC_DATA_BITS 24 // JEDEC ID is 3 bytes (3*8 bits)
 
-#define SPI_MAX_TRANSFER_SIZE 512
+#define SPI_MAX_TRANSFER_SIZE 4096 // Max size of one DMA transaction (longer reads are split into queued transactions)
 #define SPI_CLOCK_SPEED 8 * 1000 * 1000 // 8 MHz
+#define SPI_CLOCK_SPEED_FAST (20 * 1000 * 1000) // 20 MHz - max we use through the GPIO matrix (pins are not the SPI2 IOMUX pins)
+#define SPI_QUEUE_SIZE 4           // Read transactions queued at once, so the next DMA transfer starts right after the previous one
 
 
 // --- W25Q128JV Specific Commands (from datasheet) ---
@@ -44,6 +52,12 @@
 #define SPI_CMD_READ_STATUS_REG1    0x05 // Read Status Register-1
 #define SPI_CMD_READ_DATA           0x03 // Read Data (Standard SPI)
 #define SPI_CMD_FAST_READ           0x0B // Fast Read (Standard SPI)
+#define SPI_CMD_FAST_READ_DUAL_OUT  0x3B // Fast Read Dual Output (1-1-2)
+#define SPI_CMD_FAST_READ_DUAL_IO   0xBB // Fast Read Dual I/O (1-2-2)
+#define SPI_CMD_FAST_READ_QUAD_OUT  0x6B // Fast Read Quad Output (1-1-4)
+#define SPI_CMD_FAST_READ_QUAD_IO   0xEB // Fast Read Quad I/O (1-4-4)
+#define SPI_CMD_READ_STATUS_REG2    0x35 // Read Status Register-2
+#define SPI_CMD_WRITE_STATUS_REG2   0x31 // Write Status Register-2
 #define SPI_CMD_PAGE_PROGRAM        0x02 // Page Program
 #define SPI_CMD_SECTOR_ERASE        0x20 // Sector Erase (4KB)
 #define SPI_CMD_BLOCK_ERASE_32KB    0x52 // Block Erase (32KB)
@@ -53,13 +67,74 @@
 #define SPI_CMD_ENABLE_RESET        0x66 // Enable Reset
 #define SPI_CMD_RESET_DEVICE        0x99 // Reset Device
 #define SPI_CMD_GLOBAL_BLOCK_UNLOCK 0x98 // Global Block Unlock (W25Q128JV specific)
-// --- W25Q128JV Flash Parameters ---
-#define W25Q128JV_PAGE_SIZE         256      // Bytes per page
-#define W25Q128JV_SECTOR_SIZE       4096     // Bytes per 4KB sector
-#define W25Q128JV_TOTAL_SIZE_BYTES  (16 * 1024 * 1024) // 128M-bit = 16M-byte
+// --- W25Q128JV Flash Parameters (geometry and timing are in w25q128jv.h) ---
 #define W25Q128JV_MODE              0       // Mode 0
+#define W25Q128JV_STATUS_BUSY       (1 << 0) // Status Register-1 BUSY bit
+#define W25Q128JV_STATUS2_QE        (1 << 1) // Status Register-2 Quad Enable bit (IO2/IO3 instead of WP/HOLD)
+#define W25Q128JV_MODE_BITS         0xFF     // M7-0 sent after the address in Dual/Quad I/O reads (not continuous read mode)
+
+#define EXT_FLASH_POLL_INTERVAL_US  50       // Busy-wait between status register reads (well below one RTOS tick)
+#define EXT_FLASH_SPIN_LIMIT_US     W25Q128JV_T_PP_MAX_US // After spinning this long, poll once per tick to not block other tasks
+
+#define EXT_FLASH_VERIFY_SIZE       256      // Bytes read at address 0 to verify a read mode against standard SPI
+#define EXT_FLASH_BENCHMARK_SIZE    (64 * 1024) // Bytes read per mode in ext_flash_read_benchmark()
+
+/* Read command used by ext_flash_read() (commands are always sent on one line) */
+typedef enum {
+    EXT_FLASH_READ_MODE_STANDARD,       // 0x0B Fast Read - 1 line
+    EXT_FLASH_READ_MODE_DUAL_OUTPUT,    // 0x3B - address on 1 line, data on 2 lines
+    EXT_FLASH_READ_MODE_DUAL_IO,        // 0xBB - address and data on 2 lines
+    EXT_FLASH_READ_MODE_QUAD_OUTPUT,    // 0x6B - address on 1 line, data on 4 lines (needs WP/HOLD as IO2/IO3)
+    EXT_FLASH_READ_MODE_QUAD_IO,        // 0xEB - address and data on 4 lines (needs WP/HOLD as IO2/IO3)
+    EXT_FLASH_READ_MODE_COUNT,
+} ext_flash_read_mode_t;
+
+typedef struct {
+    ext_flash_read_mode_t read_mode;
+    uint32_t clock_speed_hz;
+} ext_flash_config_t;
+
+#define EXT_FLASH_DEFAULT_CONFIG() {                    \
+    .read_mode = EXT_FLASH_READ_MODE_QUAD_OUTPUT,       \
+    .clock_speed_hz = SPI_CLOCK_SPEED_FAST,             \
+}
+
+/**
+ * @brief Initialize the SPI bus and the external flash chip with EXT_FLASH_DEFAULT_CONFIG().
+ * 
+ * @return ESP_OK on success, or an error code on failure.
+ */
 esp_err_t ext_flash_init(void);
 
+/**
+ * @brief Initialize the SPI bus and the external flash chip with the given read mode and clock.
+ * 
+ * The chip is first set up in standard SPI at SPI_CLOCK_SPEED, then the requested mode is verified against
+ * a standard read. If it fails, the requested mode at SPI_CLOCK_SPEED and then standard SPI are used.
+ * 
+ * @param config Read mode and clock speed.
+ * @return ESP_OK on success (also if a fallback mode is used), or an error code on failure.
+ */
+esp_err_t ext_flash_init_with_config(const ext_flash_config_t *config);
+
+/**
+ * @brief Switch the read mode and the SPI clock.
+ * 
+ * Enables the Quad Enable bit for quad modes and verifies the new mode by comparing EXT_FLASH_VERIFY_SIZE bytes
+ * at address 0 with a standard read at SPI_CLOCK_SPEED. The previous mode is kept if verification fails.
+ * 
+ * @note The check is inconclusive if address 0 is erased (all 0xFF), in that case a warning is logged.
+ * @note The SPI device is re-added to the bus, so no other task may access the flash during the call.
+ * @param config Read mode and clock speed.
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED if the board can not use the mode, ESP_ERR_INVALID_RESPONSE if verification failed.
+ */
+esp_err_t ext_flash_set_read_mode(const ext_flash_config_t *config);
+
+/**
+ * @brief Get the name of a read mode, e.g. "quad output (0x6B)".
+ */
+const char *ext_flash_read_mode_to_string(ext_flash_read_mode_t mode);
+
 /**
  * @brief Reset the external flash chip.
  * 
@@ -109,6 +184,7 @@ esp_err_t ext_flash_read_status_register(uint8_t *status);
  * 
  * This function waits for the external flash chip to be idle (not busy).
  * With polling (while loop) it checks the status register until the BUSY bit is cleared or a timeout occurs.
+ * The status is polled every EXT_FLASH_POLL_INTERVAL_US for the first EXT_FLASH_SPIN_LIMIT_US, then once per tick.
  * 
  * @param timeout_ms Timeout in milliseconds to wait for the flash to become idle.
  * @note Some block deletion commands may take even 1-2 seconds, so a timeout of 1000 ms is recommended.
@@ -117,37 +193,31 @@ esp_err_t ext_flash_read_status_register(uint8_t *status);
 esp_err_t ext_flash_wait_for_idle(int timeout_ms);
 
 
+/* --------------------------Functions for littlefs integration ---------------------------*/
 /**
  * @brief Read data from the external flash chip.
  * 
  * This function reads a specified number of bytes from the external flash chip starting at a given address.
+ * Reads longer than SPI_MAX_TRANSFER_SIZE are split into chunks that are queued as back-to-back DMA transactions.
  * 
+ * @note For DMA without an extra copy, the buffer should be 4-byte aligned and in internal RAM.
  * @param address The starting address to read from.
  * @param buffer Pointer to the buffer where the read data will be stored.
- * @param size Number of bytes to read.
+ * @param size Number of bytes to read (any size).
  * @return ESP_OK on success, or an error code on failure.
  */
-
- /* --------------------------Functions for littlefs integration ---------------------------*/
- /**
-  * @brief Read data from the external flash chip.
-  * This function reads a specified number of bytes from the external flash chip starting at a given address.
-  * @param address The starting address to read from.
-  * @param buffer Pointer to the buffer where the read data will be stored.
-  * @param size Number of bytes to read.
-  * @return ESP_OK on success, or an error code on failure.
-  */
 esp_err_t ext_flash_read(uint32_t address, uint8_t *buffer, uint32_t size);
 
 /**
  * @brief Write data to the external flash chip.
  * 
  * This function writes a specified number of bytes to the external flash chip starting at a given address.
- * @note size must be less than or equal to the page size (256 bytes for W25Q128JV).
+ * The data is split at page boundaries (256 bytes for W25Q128JV), so any address and size can be used.
+ * Each page program is followed by a busy wait sized to tPP.
  * 
  * @param address The starting address to write to.
  * @param buffer Pointer to the buffer containing the data to write.
- * @param size Number of bytes to write (must be <= 256).
+ * @param size Number of bytes to write (any size).
  * @return ESP_OK on success, or an error code on failure.
  */
 esp_err_t ext_flash_write(uint32_t address, const uint8_t *buffer, uint32_t size);
@@ -168,4 +238,13 @@ esp_err_t ext_flash_global_block_unlock(void);
 
 void ext_flash_complete_test(void); //Just a quick test function to check if the flash is working correctly
 
+/**
+ * @brief Read throughput benchmark.
+ * 
+ * Reads EXT_FLASH_BENCHMARK_SIZE bytes in SPI_MAX_TRANSFER_SIZE reads in every read mode the board supports
+ * at SPI_CLOCK_SPEED and SPI_CLOCK_SPEED_FAST, and logs the throughput. The active mode is restored at the end.
+ * block_device_read_benchmark_sweep() (block_device_benchmark.h) runs the same reads on the flash emulator.
+ */
+void ext_flash_read_benchmark(void);
+
 #endif  // EXT_FLASH_H
\ No newline at end of file
@@ -0,0 +1,35 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#ifndef W25Q128JV_H
+#define W25Q128JV_H
+
+/*
+ * W25Q128JV geometry and timing (datasheet).
+ * Kept free of ESP-IDF includes, so the flash emulator in block_device can use the same numbers off-target.
+ */
+
+// --- W25Q128JV Flash Parameters ---
+#define W25Q128JV_PAGE_SIZE         256      // Bytes per page
+#define W25Q128JV_SECTOR_SIZE       4096     // Bytes per 4KB sector
+#define W25Q128JV_TOTAL_SIZE_BYTES  (16 * 1024 * 1024) // 128M-bit = 16M-byte
+#define W25Q128JV_ERASE_CYCLES      100000   // Min program/erase cycles per sector
+// --- W25Q128JV Timing (datasheet AC characteristics) ---
+#define W25Q128JV_T_PP_TYP_US       400      // Page program time, typical
+#define W25Q128JV_T_PP_MAX_US       3000     // Page program time, max
+#define W25Q128JV_T_SE_TYP_US       45000    // Sector erase (4KB) time, typical
+#define W25Q128JV_T_SE_MAX_US       400000   // Sector erase (4KB) time, max
+#define W25Q128JV_T_W_TYP_US        10000    // Write status register time, typical
+#define W25Q128JV_T_W_MAX_US        15000    // Write status register time, max
+// --- W25Q128JV read commands: clocks before the first data bit (command on 1 line, address, mode bits, dummy) ---
+#define W25Q128JV_FAST_READ_CLOCKS          40  // 0x0B: 8 command + 24 address + 8 dummy, data on 1 line
+#define W25Q128JV_FAST_READ_DUAL_OUT_CLOCKS 40  // 0x3B: 8 command + 24 address + 8 dummy, data on 2 lines
+#define W25Q128JV_FAST_READ_DUAL_IO_CLOCKS  24  // 0xBB: 8 command + 16 address and mode bits on 2 lines, data on 2 lines
+#define W25Q128JV_FAST_READ_QUAD_OUT_CLOCKS 40  // 0x6B: 8 command + 24 address + 8 dummy, data on 4 lines
+#define W25Q128JV_FAST_READ_QUAD_IO_CLOCKS  20  // 0xEB: 8 command + 8 address and mode bits on 4 lines + 4 dummy, data on 4 lines
+
+#endif // W25Q128JV_H
@@ -17,23 +17,69 @@ lfs_t lfs;
 // Variables for caching and lookahead buffer
 // These must be defined here as they are used by the LittleFS library internally.
 // Their sizes are defined in file_system_littlefs.h
-static uint8_t lfs_read_buffer[LFS_READ_SIZE];
-static uint8_t lfs_prog_buffer[LFS_PROG_SIZE];
+// Read/prog caches are cache_size bytes (LittleFS uses the whole buffer), 4-byte aligned so SPI DMA needs no bounce buffer
+static uint8_t lfs_read_buffer[LFS_CACHE_SIZE] __attribute__((aligned(4)));
+static uint8_t lfs_prog_buffer[LFS_CACHE_SIZE] __attribute__((aligned(4)));
 static uint8_t lfs_lookahead_buffer[LFS_LOOKAHEAD_SIZE];
 
+// Flash IO counters, used to measure write amplification
+static lfs_io_stats_t lfs_io_stats = {0};
+
+/*
+ * Allocator (lookahead) state saved at unmount and kept in RTC memory over deep sleep.
+ * After mount LittleFS has an empty lookahead window, so the first write traverses the whole filesystem
+ * (all metadata and every data block pointer) to find free blocks. With a valid checkpoint the window from
+ * before the sleep is used instead.
+ *
+ * The window is only valid if the filesystem did not change in between. lfs.seed after mount is a CRC of all
+ * metadata commits, and every allocated block is committed to metadata, so equal seeds mean the same filesystem.
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t block_count;
+    uint32_t lookahead_size;
+    uint32_t seed;                      // lfs.seed after mounting the saved filesystem state
+    lfs_block_t root[2];
+    lfs_block_t start;                  // lfs.lookahead state
+    lfs_block_t size;
+    lfs_block_t next;
+    uint8_t buffer[LFS_LOOKAHEAD_SIZE];
+    uint32_t crc;                       // lfs_crc of all fields above
+} lfs_lookahead_checkpoint_t;
+
+static RTC_DATA_ATTR lfs_lookahead_checkpoint_t lookahead_checkpoint;
+
+/* lfs_checkpoint_save/restore read and write lfs.lookahead directly. Check the allocator in lfs.c (lfs_alloc,
+   lfs_alloc_ckpoint, lfs_alloc_scan) still works that way before moving to another LittleFS version. */
+_Static_assert(LFS_VERSION == 0x0002000b, "Allocator checkpoint written for LittleFS 2.11, check lfs.lookahead");
+
+// Block device under LittleFS, the external W25Q128JV unless lfs_set_block_device() was called
+static block_device_t *lfs_block_device = NULL;
+
+// Cache/lookahead sizes and block cycles, changed only by the benchmark (lfs_set_tuning)
+static lfs_tuning_t lfs_tuning = LFS_DEFAULT_TUNING();
+
+// Highest sync cursor handed out (lfs_file_sync_attr_t), found again after every mount
+static uint32_t sync_cursor = 0;
+static bool sync_cursor_loaded = false;
+
+// Filesystem lock, recursive so lfs_lock_filesystem() sequences can call LittleFS (which takes it again)
+static SemaphoreHandle_t lfs_mutex = NULL;
 
-// ---------- LittleFS private Callback Functions (using basic low-level functions from ext_flash.h) --------
+
+// ---------- LittleFS private Callback Functions (forwarded to the block device in cfg.context) --------
 
 static int lfs_read(const struct lfs_config *c, lfs_block_t block,
                      lfs_off_t off, void *buffer, lfs_size_t size) {
     ESP_LOGD(LFS_TAG, "lfs_read: block=%lu, off=%lu, size=%lu", block, off, size);
-    uint32_t address = (block * LFS_BLOCK_SIZE) + off;
-    esp_err_t ret = ext_flash_read(address, (uint8_t *)buffer, size);
+    uint32_t address = (block * c->block_size) + off;
+    esp_err_t ret = block_device_read(c->context, address, buffer, size);
     if (ret != ESP_OK) {
         ESP_LOGE(LFS_TAG, "LFS Read Error: Failed to read from 0x%06lX, size %lu, ret %d",
                  address, size, ret);
         return LFS_ERR_IO; 
     }
+    lfs_io_stats.bytes_read += size;
     return LFS_ERR_OK; 
 }
 
@@ -41,14 +87,16 @@ static int lfs_read(const struct lfs_config *c, lfs_block_t block,
 static int lfs_prog(const struct lfs_config *c, lfs_block_t block,
                     lfs_off_t off, const void *buffer, lfs_size_t size) {
     ESP_LOGD(LFS_TAG, "lfs_prog: block=%lu, off=%lu, size=%lu", block, off, size);
-    uint32_t address = (block * LFS_BLOCK_SIZE) + off;
+    uint32_t address = (block * c->block_size) + off;
 
-    esp_err_t ret = ext_flash_write(address, (const uint8_t *)buffer, size); //Size is checked in ext_flash_write
+    esp_err_t ret = block_device_prog(c->context, address, buffer, size); // Split into pages by the block device
     if (ret != ESP_OK) {
         ESP_LOGE(LFS_TAG, "LFS Program Error: Failed to write to 0x%06lX, size %lu, ret %d",
                  address, size, ret);
         return LFS_ERR_IO;
     }
+    lfs_io_stats.bytes_programmed += size;
+    lfs_io_stats.prog_count++;
     return LFS_ERR_OK;
 }
 
@@ -56,21 +104,21 @@ static int lfs_prog(const struct lfs_config *c, lfs_block_t block,
 static int lfs_erase(const struct lfs_config *c, lfs_block_t block) {
     ESP_LOGD(LFS_TAG, "lfs_erase: block=%lu", block);
 
-    uint32_t address = block * LFS_BLOCK_SIZE;
-    esp_err_t ret = ext_flash_erase_sector(address);
+    esp_err_t ret = block_device_erase(c->context, block);
 
     if (ret != ESP_OK) {
-        ESP_LOGE(LFS_TAG, "LFS Erase Error: Failed to erase block at 0x%06lX, ret %d",
-                 address, ret);
+        ESP_LOGE(LFS_TAG, "LFS Erase Error: Failed to erase block %lu, ret %d",
+                 block, ret);
         return LFS_ERR_IO;
     }
+    lfs_io_stats.erase_count++;
     return LFS_ERR_OK;
 }
 
 // Synchronize the flash memory (ensure all pending operations are complete)
 static int lfs_sync(const struct lfs_config *c) {
 
-    esp_err_t ret = ext_flash_wait_for_idle(5000); 
+    esp_err_t ret = block_device_sync(c->context); 
     if (ret != ESP_OK) {
         ESP_LOGE(LFS_TAG, "LFS Sync Error: Flash not idle, ret %d", ret);
         return LFS_ERR_IO;
@@ -78,28 +126,160 @@ static int lfs_sync(const struct lfs_config *c) {
     return LFS_ERR_OK;
 }
 
+// Lock/unlock of every LittleFS call (LFS_THREADSAFE)
+static int lfs_lock(const struct lfs_config *c) {
+    lfs_lock_filesystem();
+    return LFS_ERR_OK;
+}
+
+static int lfs_unlock(const struct lfs_config *c) {
+    lfs_unlock_filesystem();
+    return LFS_ERR_OK;
+}
+
+void lfs_lock_filesystem(void) {
+    if (lfs_mutex != NULL) { // NULL only before the first mount, when no other task uses the filesystem yet
+        xSemaphoreTakeRecursive(lfs_mutex, portMAX_DELAY);
+    }
+}
+
+void lfs_unlock_filesystem(void) {
+    if (lfs_mutex != NULL) {
+        xSemaphoreGiveRecursive(lfs_mutex);
+    }
+}
+
+esp_err_t lfs_set_block_device(block_device_t *dev) {
+
+    if (dev == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (dev->sector_size != LFS_BLOCK_SIZE || LFS_BLOCK_SIZE % dev->page_size != 0) {
+        ESP_LOGE(LFS_TAG, "Block device %s geometry (page %lu, sector %lu) does not match LFS_BLOCK_SIZE",
+                 dev->name, dev->page_size, dev->sector_size);
+        return ESP_ERR_INVALID_SIZE;
+    }
+    lfs_block_device = dev;
+    return ESP_OK;
+}
+
+static uint32_t lfs_checkpoint_crc(const lfs_lookahead_checkpoint_t *checkpoint) {
+    return lfs_crc(0xFFFFFFFF, checkpoint, offsetof(lfs_lookahead_checkpoint_t, crc));
+}
+
+/* Saves the lookahead window, must be called while mounted, right before lfs_unmount */
+static void lfs_checkpoint_save(lfs_lookahead_checkpoint_t *checkpoint) {
+
+    memset(checkpoint, 0, sizeof(*checkpoint));
+    if (!lfs_tuning.lookahead_checkpoint || cfg.lookahead_size > sizeof(checkpoint->buffer) ||
+        lfs.lookahead.next >= lfs.lookahead.size) {
+        return; // Disabled, does not fit or no free blocks left in the window (the next write scans anyway)
+    }
+
+    checkpoint->block_count = lfs.block_count;
+    checkpoint->lookahead_size = cfg.lookahead_size;
+    checkpoint->start = lfs.lookahead.start;
+    checkpoint->size = lfs.lookahead.size;
+    checkpoint->next = lfs.lookahead.next;
+    memcpy(checkpoint->buffer, lfs.lookahead.buffer, cfg.lookahead_size);
+    checkpoint->magic = LFS_CHECKPOINT_MAGIC;
+}
+
+/* Restores the lookahead window after lfs_mount if the filesystem is unchanged. The checkpoint is used only once. */
+static void lfs_checkpoint_restore(void) {
+
+    lfs_lookahead_checkpoint_t *checkpoint = &lookahead_checkpoint;
+
+    if (checkpoint->magic != LFS_CHECKPOINT_MAGIC) {
+        return; // Cold boot or nothing saved
+    }
+    bool valid = lfs_tuning.lookahead_checkpoint &&
+                 checkpoint->crc == lfs_checkpoint_crc(checkpoint) &&
+                 checkpoint->block_count == lfs.block_count &&
+                 checkpoint->lookahead_size == cfg.lookahead_size &&
+                 checkpoint->seed == lfs.seed &&
+                 checkpoint->root[0] == lfs.root[0] && checkpoint->root[1] == lfs.root[1] &&
+                 checkpoint->next < checkpoint->size && checkpoint->size <= 8 * cfg.lookahead_size &&
+                 checkpoint->start < lfs.block_count;
+    checkpoint->magic = 0;
+
+    if (!valid) {
+        lfs_io_stats.checkpoint_rejects++;
+        ESP_LOGW(LFS_TAG, "Allocator checkpoint does not match the filesystem, ignoring it");
+        return;
+    }
+
+    // Same state as after lfs_alloc_ckpoint, with the saved window instead of an empty one
+    lfs.lookahead.start = checkpoint->start;
+    lfs.lookahead.size = checkpoint->size;
+    lfs.lookahead.next = checkpoint->next;
+    lfs.lookahead.ckpoint = lfs.block_count;
+    memcpy(lfs.lookahead.buffer, checkpoint->buffer, cfg.lookahead_size);
+    lfs_io_stats.checkpoint_restores++;
+    ESP_LOGI(LFS_TAG, "Restored allocator checkpoint (%lu blocks left in window)", checkpoint->size - checkpoint->next);
+}
+
+esp_err_t lfs_set_tuning(const lfs_tuning_t *tuning) {
+
+    if (tuning->cache_size == 0 || tuning->cache_size % LFS_PROG_SIZE != 0 || LFS_BLOCK_SIZE % tuning->cache_size != 0) {
+        ESP_LOGE(LFS_TAG, "Invalid cache size %lu", tuning->cache_size);
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (tuning->lookahead_size == 0 || tuning->lookahead_size % 8 != 0) {
+        ESP_LOGE(LFS_TAG, "Invalid lookahead size %lu", tuning->lookahead_size);
+        return ESP_ERR_INVALID_ARG;
+    }
+    lfs_tuning = *tuning;
+    return ESP_OK;
+}
+
+static esp_err_t lfs_mount_filesystem_locked(bool format_if_fail);
+
 esp_err_t lfs_mount_filesystem(bool format_if_fail) {
     ESP_LOGI(LFS_TAG, "Initializing LittleFS configuration...");
 
-    // Add LittleFS callback functions (using basic low-level functions from ext_flash.h)
+    if (lfs_mutex == NULL) {
+        lfs_mutex = xSemaphoreCreateRecursiveMutex();
+        if (lfs_mutex == NULL) {
+            ESP_LOGE(LFS_TAG, "Failed to create the filesystem lock");
+            return ESP_ERR_NO_MEM;
+        }
+    }
+
+    lfs_lock_filesystem(); // cfg is read by LittleFS calls of other tasks
+    esp_err_t ret = lfs_mount_filesystem_locked(format_if_fail);
+    lfs_unlock_filesystem();
+    return ret;
+}
+
+static esp_err_t lfs_mount_filesystem_locked(bool format_if_fail) {
+
+    if (lfs_block_device == NULL) {
+        lfs_block_device = block_device_w25q_get();
+    }
+
+    // Add LittleFS callback functions (forwarded to the block device)
+    cfg.context = lfs_block_device;
     cfg.read = lfs_read;
     cfg.prog = lfs_prog;
     cfg.erase = lfs_erase;
     cfg.sync = lfs_sync;
+    cfg.lock = lfs_lock;
+    cfg.unlock = lfs_unlock;
 
     /* LittleFS configuration */
     cfg.read_size = LFS_READ_SIZE;
     cfg.prog_size = LFS_PROG_SIZE;
     cfg.block_size = LFS_BLOCK_SIZE;
-    cfg.block_count = LFS_BLOCK_COUNT;
-    cfg.block_cycles = LFS_BLOCK_CYCLES;
-    cfg.cache_size = LFS_CACHE_SIZE;
-    cfg.lookahead_size = LFS_LOOKAHEAD_SIZE;
-
-    // Assign internal buffers for LittleFS operations
-    cfg.read_buffer = lfs_read_buffer;
-    cfg.prog_buffer = lfs_prog_buffer;
-    cfg.lookahead_buffer = lfs_lookahead_buffer;
+    cfg.block_count = lfs_block_device->sector_count; // LFS_BLOCK_COUNT for the W25Q128JV, emulators can be smaller
+    cfg.block_cycles = lfs_tuning.block_cycles;
+    cfg.cache_size = lfs_tuning.cache_size;
+    cfg.lookahead_size = lfs_tuning.lookahead_size;
+
+    // Assign internal buffers for LittleFS operations (NULL - LittleFS allocates larger ones than the static buffers)
+    cfg.read_buffer = lfs_tuning.cache_size <= LFS_CACHE_SIZE ? lfs_read_buffer : NULL;
+    cfg.prog_buffer = lfs_tuning.cache_size <= LFS_CACHE_SIZE ? lfs_prog_buffer : NULL;
+    cfg.lookahead_buffer = lfs_tuning.lookahead_size <= LFS_LOOKAHEAD_SIZE ? lfs_lookahead_buffer : NULL;
     cfg.name_max = LFS_MAX_FILE_NAME_SIZE; 
     cfg.file_max = 0;  // No limit on file size
     cfg.attr_max = 0;  // No limit on file attributes
@@ -111,6 +291,7 @@ esp_err_t lfs_mount_filesystem(bool format_if_fail) {
         ESP_LOGW(LFS_TAG, "Failed to mount LittleFS (%d).", err);
         if (format_if_fail) {
             ESP_LOGI(LFS_TAG, "Formatting LittleFS partition...");
+            lookahead_checkpoint.magic = 0;
             err = lfs_format(&lfs, &cfg);
             ESP_LOGI(LFS_TAG, "lfs_format returned: %d", err);
             if (err) {
@@ -129,13 +310,51 @@ esp_err_t lfs_mount_filesystem(bool format_if_fail) {
             return ESP_FAIL;
         }
     }
-    ESP_LOGI(LFS_TAG, "LittleFS mounted successfully.");
+    lfs_checkpoint_restore();
+    sync_cursor_loaded = false;
+    ESP_LOGI(LFS_TAG, "LittleFS mounted successfully on %s.", lfs_block_device->name);
     return ESP_OK;
 }
 
 
 // ----------------- Public LittleFS Integration Functions ---------------------
 
+esp_err_t lfs_unmount_filesystem(void) {
+
+    lfs_lookahead_checkpoint_t checkpoint;
+
+    lfs_lock_filesystem(); // Unmount and the remount for the seed as one step
+    lfs_checkpoint_save(&checkpoint);
+    lookahead_checkpoint.magic = 0;
+
+    int err = lfs_unmount(&lfs);
+    if (err) {
+        lfs_unlock_filesystem();
+        ESP_LOGE(LFS_TAG, "Failed to unmount LittleFS (%d).", err);
+        return ESP_FAIL;
+    }
+
+    /* The seed at runtime also includes commits made since mount - mount again (reads metadata only) to get
+       the seed the next mount will see */
+    if (checkpoint.magic == LFS_CHECKPOINT_MAGIC && lfs_mount(&lfs, &cfg) == 0) {
+        checkpoint.seed = lfs.seed;
+        checkpoint.root[0] = lfs.root[0];
+        checkpoint.root[1] = lfs.root[1];
+        checkpoint.crc = lfs_checkpoint_crc(&checkpoint);
+        lfs_unmount(&lfs);
+        lookahead_checkpoint = checkpoint;
+        ESP_LOGD(LFS_TAG, "Saved allocator checkpoint");
+    }
+    lfs_unlock_filesystem();
+
+    ESP_LOGI(LFS_TAG, "LittleFS unmounted.");
+    return ESP_OK;
+}
+
+void lfs_get_io_stats(lfs_io_stats_t *stats) {
+    *stats = lfs_io_stats;
+}
+
 esp_err_t lfs_init(void) {
 
     ESP_RETURN_ON_ERROR(lfs_mount_filesystem(true), 
@@ -285,7 +504,18 @@ esp_err_t lfs_append_to_file(const char* data, const char* filename){
 
     ESP_LOGI(LFS_TAG, "Attempting to append to file: %s", filename);
 
-    ESP_RETURN_ON_ERROR(lfs_file_open(&lfs, &file, filename, LFS_O_WRONLY | LFS_O_APPEND), 
+    // Sync attribute is committed with the data when the file is closed
+    lfs_file_sync_attr_t sync;
+    ESP_RETURN_ON_ERROR(lfs_get_file_sync_attr(filename, &sync), LFS_TAG, "Failed to get sync state of %s", filename);
+    sync.cursor = lfs_next_sync_cursor();
+    sync.crc32 = lfs_crc32_update(sync.crc32, data, strlen(data));
+    sync.crc_size += strlen(data);
+    struct lfs_attr attrs[] = {
+        { .type = LFS_ATTR_SYNC, .buffer = &sync, .size = sizeof(sync) },
+    };
+    struct lfs_file_config file_config = { .attrs = attrs, .attr_count = 1 };
+
+    ESP_RETURN_ON_ERROR(lfs_file_opencfg(&lfs, &file, filename, LFS_O_WRONLY | LFS_O_APPEND, &file_config), 
                         LFS_TAG,
                         "Failed to open file %s for appending", filename);
 
@@ -375,7 +605,7 @@ static esp_err_t lfs_create_new_file_name(const char* prefix, const char* suffix
         "Failed to get current date string for filename creation"
     );
 
-    // Format: prefix + current_date + suffix (.csv)
+    // Format: prefix + current_date + suffix (e.g. .trk)
     int err = snprintf(filename, filename_size, "%s_%s%s", prefix, current_date, suffix);
 
     // snprintf returns the number of characters written, or a negative value on error
@@ -402,11 +632,9 @@ static bool lfs_file_exsists(const char* filename) {
     return false;
 }
 
-esp_err_t lfs_create_new_csv_file(char* filename, size_t filename_size) {
+esp_err_t lfs_create_new_file(const char* file_prefix, const char* file_suffix, const void* header, size_t header_size,
+                              char* filename, size_t filename_size) {
     lfs_file_t file;
-    const char* file_prefix = "dog_run";
-    const char* file_suffix = ".csv";
-    const char* header = "timestamp,latitude,longitude,altitude,speed\n";
     int counter = 0;
 
     // 1) Create a new file name with the current time
@@ -438,15 +666,24 @@ esp_err_t lfs_create_new_csv_file(char* filename, size_t filename_size) {
         }
     }
 
-    // 3) Create new file
+    // 3) Create new file, the sync attribute is committed together with the header
+    lfs_file_sync_attr_t sync = {
+        .cursor = lfs_next_sync_cursor(),
+        .crc32 = lfs_crc32_update(0, header, header_size),
+        .crc_size = header_size,
+    };
+    struct lfs_attr attrs[] = {
+        { .type = LFS_ATTR_SYNC, .buffer = &sync, .size = sizeof(sync) },
+    };
+    struct lfs_file_config file_config = { .attrs = attrs, .attr_count = 1 };
     ESP_RETURN_ON_ERROR(
-    lfs_file_open(&lfs, &file, filename, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC),
+    lfs_file_opencfg(&lfs, &file, filename, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC, &file_config),
         LFS_TAG,
         "Failed to open/create file %s ", filename
     );
 
     // 4) Write the header to the file
-    lfs_ssize_t bytes_written = lfs_file_write(&lfs, &file, header, strlen(header));
+    lfs_ssize_t bytes_written = lfs_file_write(&lfs, &file, header, header_size);
     if (bytes_written < 0) {
         ESP_LOGE(LFS_TAG, "Failed to write header to file %s (%d)", filename, (int)bytes_written);
         lfs_file_close(&lfs, &file);
@@ -455,18 +692,169 @@ esp_err_t lfs_create_new_csv_file(char* filename, size_t filename_size) {
 
     // 5) Close the file
     lfs_file_close(&lfs, &file);
-    ESP_LOGI(LFS_TAG, "Successfully created CSV file %s with header '%s'", filename, header);
+    ESP_LOGI(LFS_TAG, "Successfully created file %s with %u byte header", filename, (unsigned)header_size);
     
     return ESP_OK;
 }
 
 esp_err_t lfs_delete_file(const char* filename) {
 
-    ESP_RETURN_ON_ERROR(
-        lfs_remove(&lfs, filename), 
-        LFS_TAG, "Failed to remove file %s", filename
-    );
+    lfs_lock_filesystem(); // No new cursor between storing the highest one and the remove
+
+    // Keep the cursor of the deleted file, so the next mount does not hand it out again
+    uint32_t cursor = lfs_get_sync_cursor();
+    if (cursor > 0 && lfs_setattr(&lfs, "/", LFS_ATTR_SYNC_CURSOR, &cursor, sizeof(cursor)) < 0) {
+        ESP_LOGW(LFS_TAG, "Failed to store sync cursor %lu", cursor);
+    }
+
+    int err = lfs_remove(&lfs, filename);
+    lfs_unlock_filesystem();
+    ESP_RETURN_ON_ERROR(err, LFS_TAG, "Failed to remove file %s", filename);
     
     ESP_LOGI(LFS_TAG, "Successfully removed file %s", filename);
     return ESP_OK;
-}
\ No newline at end of file
+}
+
+esp_err_t lfs_set_file_mtime(const char* filename, uint32_t mtime) {
+
+    int err = lfs_setattr(&lfs, filename, LFS_ATTR_MTIME, &mtime, sizeof(mtime));
+    if (err < 0) {
+        ESP_LOGE(LFS_TAG, "Failed to set mtime of %s (%d)", filename, err);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t lfs_get_file_etag(const char* filename, char* etag, size_t etag_size, uint32_t* file_size) {
+
+    struct lfs_info info;
+    uint32_t mtime = 0;
+
+    int err = lfs_stat(&lfs, filename, &info);
+    if (err < 0 || info.type != LFS_TYPE_REG) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    // Missing attribute (LFS_ERR_NOATTR) or one of another size: keep mtime 0
+    if (lfs_getattr(&lfs, filename, LFS_ATTR_MTIME, &mtime, sizeof(mtime)) != sizeof(mtime)) {
+        mtime = 0;
+    }
+
+    snprintf(etag, etag_size, "\"%lx-%lx\"", (unsigned long)info.size, (unsigned long)mtime);
+    if (file_size != NULL) {
+        *file_size = info.size;
+    }
+    return ESP_OK;
+}
+
+uint32_t lfs_crc32_update(uint32_t crc, const void* data, size_t len) {
+    // lfs_crc is the reflected CRC-32 without the initial and final inversion
+    return lfs_crc(crc ^ 0xFFFFFFFF, data, len) ^ 0xFFFFFFFF;
+}
+
+/* Highest cursor in use: of the files and of the last deleted file */
+static void lfs_sync_cursor_load(void) {
+
+    lfs_dir_t dir;
+    struct lfs_info info;
+    lfs_file_sync_attr_t sync;
+    uint32_t cursor = 0;
+
+    if (lfs_getattr(&lfs, "/", LFS_ATTR_SYNC_CURSOR, &cursor, sizeof(cursor)) != sizeof(cursor)) {
+        cursor = 0;
+    }
+
+    if (lfs_dir_open(&lfs, &dir, "/") == 0) {
+        while (lfs_dir_read(&lfs, &dir, &info) > 0) {
+            if (info.type == LFS_TYPE_REG &&
+                lfs_getattr(&lfs, info.name, LFS_ATTR_SYNC, &sync, sizeof(sync)) == sizeof(sync) &&
+                sync.cursor > cursor) {
+                cursor = sync.cursor;
+            }
+        }
+        lfs_dir_close(&lfs, &dir);
+    }
+
+    if (cursor > sync_cursor) {
+        sync_cursor = cursor;
+    }
+    sync_cursor_loaded = true;
+    ESP_LOGD(LFS_TAG, "Sync cursor %lu", sync_cursor);
+}
+
+uint32_t lfs_next_sync_cursor(void) {
+    lfs_lock_filesystem();
+    if (!sync_cursor_loaded) {
+        lfs_sync_cursor_load();
+    }
+    uint32_t cursor = ++sync_cursor;
+    lfs_unlock_filesystem();
+    return cursor;
+}
+
+uint32_t lfs_get_sync_cursor(void) {
+    lfs_lock_filesystem();
+    if (!sync_cursor_loaded) {
+        lfs_sync_cursor_load();
+    }
+    uint32_t cursor = sync_cursor;
+    lfs_unlock_filesystem();
+    return cursor;
+}
+
+static esp_err_t lfs_get_file_sync_attr_locked(const char* filename, lfs_file_sync_attr_t* sync);
+
+esp_err_t lfs_get_file_sync_attr(const char* filename, lfs_file_sync_attr_t* sync) {
+    lfs_lock_filesystem(); // The CRC stored must be the one of the file size read before
+    esp_err_t ret = lfs_get_file_sync_attr_locked(filename, sync);
+    lfs_unlock_filesystem();
+    return ret;
+}
+
+static esp_err_t lfs_get_file_sync_attr_locked(const char* filename, lfs_file_sync_attr_t* sync) {
+
+    struct lfs_info info;
+    lfs_file_t file;
+    uint8_t buffer[LFS_CRC32_CHUNK_SIZE];
+    lfs_ssize_t bytes_read;
+
+    int err = lfs_stat(&lfs, filename, &info);
+    if (err < 0 || info.type != LFS_TYPE_REG) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    if (lfs_getattr(&lfs, filename, LFS_ATTR_SYNC, sync, sizeof(*sync)) != sizeof(*sync)) {
+        memset(sync, 0, sizeof(*sync)); // Written before sync attributes existed
+    }
+    if (sync->cursor != 0 && sync->crc_size == info.size) {
+        return ESP_OK;
+    }
+
+    // Stale or missing - read the file once and store the result
+    err = lfs_file_open(&lfs, &file, filename, LFS_O_RDONLY);
+    if (err < 0) {
+        ESP_LOGE(LFS_TAG, "Failed to open %s for CRC (%d)", filename, err);
+        return ESP_FAIL;
+    }
+    sync->crc32 = 0;
+    sync->crc_size = 0;
+    while ((bytes_read = lfs_file_read(&lfs, &file, buffer, sizeof(buffer))) > 0) {
+        sync->crc32 = lfs_crc32_update(sync->crc32, buffer, bytes_read);
+        sync->crc_size += bytes_read;
+    }
+    lfs_file_close(&lfs, &file);
+    if (bytes_read < 0) {
+        ESP_LOGE(LFS_TAG, "Failed to read %s for CRC (%d)", filename, (int)bytes_read);
+        return ESP_FAIL;
+    }
+
+    if (sync->cursor == 0) {
+        sync->cursor = lfs_next_sync_cursor();
+    }
+    err = lfs_setattr(&lfs, filename, LFS_ATTR_SYNC, sync, sizeof(*sync));
+    if (err < 0) {
+        ESP_LOGW(LFS_TAG, "Failed to store sync attribute of %s (%d)", filename, err);
+    }
+    ESP_LOGI(LFS_TAG, "Computed CRC of %s (%lu bytes)", filename, sync->crc_size);
+    return ESP_OK;
+}
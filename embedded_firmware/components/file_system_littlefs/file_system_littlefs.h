@@ -11,13 +11,23 @@
 
 #include "../../drivers/littlefs/lfs.h"    
 #include "external_flash/ext_flash.h" 
+#include "block_device/block_device.h"
 #include "../gps_l96/gps_l96.h" 
 #include "esp_err.h" 
 #include "esp_check.h"
 #include "esp_log.h"
 #include <string.h>
+#include <stddef.h>
 #include <time.h>
+#include "esp_attr.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 
+// lfs is used by the state machine task (tracks, push upload) and by the HTTP server tasks (downloads, /ack),
+// LittleFS takes the lock below in every call only with LFS_THREADSAFE (set for the whole app in src/CMakeLists.txt)
+#ifndef LFS_THREADSAFE
+#error "LFS_THREADSAFE must be defined for every file that includes lfs.h"
+#endif
 
 extern lfs_t lfs;
 extern struct lfs_config cfg;
@@ -31,9 +41,52 @@ extern struct lfs_config cfg;
 #define LFS_BLOCK_SIZE          W25Q128JV_SECTOR_SIZE // 4KB sector for W25Q128JV
 #define LFS_BLOCK_COUNT         (W25Q128JV_TOTAL_SIZE_BYTES / LFS_BLOCK_SIZE) // Total number of 4KB blocks
 #define LFS_BLOCK_CYCLES        500     // LittleFS will prioritize blocks with fewer erase cycles for wear leveling (not a hard limit, more like a differential wear leveling strategy)
-#define LFS_CACHE_SIZE          256     // Cache size for read/write/erase operations (multiple of LFS_PROG_SIZE). For me program crashes if I even try to multiply it, but since my writes are not so frequent and only a couple of bytes the min value of 256 is more than enough sufficient
+#define LFS_CACHE_SIZE          1024    // Cache size for read/write/erase operations (multiple of LFS_PROG_SIZE, divides LFS_BLOCK_SIZE). ext_flash splits it into pages/DMA chunks
 #define LFS_LOOKAHEAD_SIZE      16      // Size of the lookahead buffer (in bytes), multiple of 8. 32 is widely used, but 16 is sufficient for my use case
 #define LFS_MAX_FILE_NAME_SIZE  64      // Maximum file name size 
+#define LFS_CHECKPOINT_MAGIC    0x4C4B4843 // "CHKL" - allocator checkpoint in RTC memory is valid
+#define LFS_ATTR_MTIME          0x74    // Custom attribute: uint32_t Unix time of the last change ('t')
+#define LFS_ETAG_SIZE           24      // "<size hex>-<mtime hex>" with quotes and terminator
+#define LFS_ATTR_SYNC           0x73    // Custom attribute: lfs_file_sync_attr_t ('s')
+#define LFS_ATTR_SYNC_CURSOR    0x63    // Custom attribute of "/": uint32_t sync cursor when a file was last deleted ('c')
+#define LFS_ATTR_ACK_CURSOR     0x61    // Custom attribute of "/": uint32_t sync cursor the sync client acknowledged ('a')
+#define LFS_CRC32_CHUNK_SIZE    256     // Read size when a file CRC has to be computed
+
+/* LittleFS parameters that trade RAM for flash IO, LFS_DEFAULT_TUNING() is used unless lfs_set_tuning() is called */
+typedef struct {
+    uint32_t cache_size;        // Read/prog cache and per-file cache (multiple of LFS_PROG_SIZE, divides LFS_BLOCK_SIZE)
+    uint32_t lookahead_size;    // Lookahead bitmap in bytes (multiple of 8), covers 8 blocks per byte
+    int32_t block_cycles;       // Erase cycles before metadata is moved, -1 disables wear leveling
+    bool lookahead_checkpoint;  // Keep the allocator state over unmount/deep sleep (only if lookahead_size <= LFS_LOOKAHEAD_SIZE)
+} lfs_tuning_t;
+
+#define LFS_DEFAULT_TUNING() {                  \
+    .cache_size = LFS_CACHE_SIZE,               \
+    .lookahead_size = LFS_LOOKAHEAD_SIZE,       \
+    .block_cycles = LFS_BLOCK_CYCLES,           \
+    .lookahead_checkpoint = true,               \
+}
+
+/*
+ * Per-file sync state for clients (see lfs_manifest.h). Every change of a file gets the next value of a
+ * monotonic sync cursor, so a client only needs the files with a cursor above the last one it has seen.
+ * The CRC is kept up to date by the writers, so listing does not read file data.
+ */
+typedef struct {
+    uint32_t cursor;            // Sync cursor of the last change
+    uint32_t crc32;             // CRC-32 (as zlib.crc32) of the first crc_size bytes
+    uint32_t crc_size;          // Bytes covered by crc32, the CRC is stale if this is not the file size
+} lfs_file_sync_attr_t;
+
+/* Flash IO done by LittleFS since boot */
+typedef struct {
+    uint64_t bytes_read;        // Bytes read from flash
+    uint64_t bytes_programmed;  // Bytes programmed to flash
+    uint32_t prog_count;        // Number of program calls
+    uint32_t erase_count;       // Number of erased blocks
+    uint32_t checkpoint_restores; // Mounts that used the allocator checkpoint
+    uint32_t checkpoint_rejects;  // Mounts that ignored it because the filesystem or tuning changed (cold scan)
+} lfs_io_stats_t;
 
 // Public functions for LittleFS integration
 /**
@@ -56,10 +109,47 @@ esp_err_t lfs_init(void);
  */
 esp_err_t lfs_mount_filesystem(bool format_if_fail);
 
+/**
+ * @brief Selects the block device LittleFS is mounted on (call before lfs_mount_filesystem).
+ * 
+ * Without this call the filesystem is on the external W25Q128JV (block_device_w25q_get()).
+ * Used to run the storage stack on a NOR flash emulator (block_device_emu.h).
+ *
+ * @param dev Block device with LFS_BLOCK_SIZE sectors.
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_SIZE if the geometry does not match.
+ */
+esp_err_t lfs_set_block_device(block_device_t *dev);
+
+/**
+ * @brief Sets the cache, lookahead and block cycles used by the next lfs_mount_filesystem().
+ * 
+ * Sizes up to LFS_CACHE_SIZE/LFS_LOOKAHEAD_SIZE use the static buffers, larger ones are allocated by LittleFS.
+ * Used by the storage benchmark (lfs_benchmark.h) to compare configurations.
+ *
+ * @param tuning New parameters.
+ * @return esp_err_t ESP_OK on success, ESP_ERR_INVALID_ARG if the sizes are not valid for LittleFS.
+ */
+esp_err_t lfs_set_tuning(const lfs_tuning_t *tuning);
+
+/**
+ * @brief Takes the filesystem lock, for a sequence of LittleFS calls that must not interleave with other tasks.
+ *
+ * Every LittleFS call takes the same (recursive) lock on its own, so single calls need no lock. Do not hold it
+ * while waiting on the network, all file access of the other tasks waits for it.
+ */
+void lfs_lock_filesystem(void);
+
+/**
+ * @brief Gives the lock taken by lfs_lock_filesystem().
+ */
+void lfs_unlock_filesystem(void);
+
 /**
  * @brief Unmounts the LittleFS filesystem.
  * 
  * This function unmounts the LittleFS filesystem, ensuring all data is written to flash.
+ * The allocator state is kept in RTC memory, so the first write after a deep sleep wake-up
+ * does not have to scan the whole filesystem for free blocks. Call it before deep sleep.
  *
  * @return esp_err_t ESP_OK on success, or an error code on failure.
  */
@@ -107,13 +197,19 @@ void file_system_test(void);
 esp_err_t lfs_append_to_file(const char* data, const char* filename);
 
 /**
- * @brief Creates a new CSV file with a unique random with random numbers
- *  Generates random file name and cheks if it alredy excist, add -1, -2, etc. if it does.
- *  Creates file and adds cvs header to it -> "timestamp,latitude,longitude,altitude,speed\n"
+ * @brief Creates a new file with a unique name made from the current GPS date
+ *  Generates file name <prefix>_<date><suffix> and cheks if it alredy excist, add _1, _2, etc. if it does.
+ *  Creates file and writes the header to it.
  * 
+ * @param file_prefix File name prefix, e.g. "dog_run".
+ * @param file_suffix File name suffix, e.g. ".trk".
+ * @param header Data written at the start of the file.
+ * @param header_size Size of the header in bytes.
  * @param filename Pointer to a buffer where the new file name will be stored. The buffer should be at least LFS_MAX_FILE_NAME_SIZE bytes long.
+ * @param filename_size Size of the filename buffer.
  */
-esp_err_t lfs_create_new_csv_file(char* filename, size_t filename_size);
+esp_err_t lfs_create_new_file(const char* file_prefix, const char* file_suffix, const void* header, size_t header_size,
+                              char* filename, size_t filename_size);
 
 /**
  * @brief Deletes a file from the LittleFS filesystem.
@@ -123,5 +219,73 @@ esp_err_t lfs_create_new_csv_file(char* filename, size_t filename_size);
  */
 esp_err_t lfs_delete_file(const char* filename);
 
+/**
+ * @brief Stores the modification time of a file in the LFS_ATTR_MTIME attribute.
+ *
+ * @param filename The name of the file.
+ * @param mtime Unix time of the last change.
+ * @return esp_err_t ESP_OK on success, or an error code on failure.
+ */
+esp_err_t lfs_set_file_mtime(const char* filename, uint32_t mtime);
+
+/**
+ * @brief Builds a strong HTTP entity tag for a file from its size and LFS_ATTR_MTIME attribute.
+ *
+ * Appending to a file changes its size, so a client can tell whether the bytes it already has are still a prefix
+ * of the file. Files without the attribute use mtime 0.
+ *
+ * @param filename The name of the file.
+ * @param etag Buffer for the quoted ETag, at least LFS_ETAG_SIZE bytes.
+ * @param etag_size Size of the etag buffer.
+ * @param file_size Output, size of the file in bytes. Can be NULL.
+ * @return esp_err_t ESP_OK on success, ESP_ERR_NOT_FOUND if the file does not exist.
+ */
+esp_err_t lfs_get_file_etag(const char* filename, char* etag, size_t etag_size, uint32_t* file_size);
+
+/**
+ * @brief Continues a CRC-32 (same as zlib.crc32(data, crc)), start with crc = 0.
+ *
+ * @param crc CRC of the data so far.
+ * @param data Next data.
+ * @param len Number of bytes.
+ * @return CRC of all data.
+ */
+uint32_t lfs_crc32_update(uint32_t crc, const void* data, size_t len);
+
+/**
+ * @brief Returns the next sync cursor, call it for every change of a file.
+ *
+ * The first call after mount finds the highest cursor in use (LFS_ATTR_SYNC of all files and LFS_ATTR_SYNC_CURSOR of "/").
+ *
+ * @return New sync cursor, higher than any handed out before.
+ */
+uint32_t lfs_next_sync_cursor(void);
+
+/**
+ * @brief Returns the highest sync cursor handed out so far.
+ */
+uint32_t lfs_get_sync_cursor(void);
+
+/**
+ * @brief Gets the sync attribute of a file, with a CRC that matches the current file size.
+ *
+ * Files written before this attribute existed or with a stale CRC are read once to compute it, the result
+ * is stored in the attribute.
+ *
+ * @param filename The name of the file.
+ * @param sync Output sync attribute. crc_size is the file size.
+ * @return esp_err_t ESP_OK on success, ESP_ERR_NOT_FOUND if the file does not exist, ESP_FAIL on read error.
+ */
+esp_err_t lfs_get_file_sync_attr(const char* filename, lfs_file_sync_attr_t* sync);
+
+/**
+ * @brief Gets the flash IO counters of the LittleFS block device callbacks.
+ * 
+ * Used to measure how many bytes are really programmed/erased for the data we write.
+ *
+ * @param stats Pointer to the struct where counters will be copied.
+ */
+void lfs_get_io_stats(lfs_io_stats_t *stats);
+
 
 #endif // LITTLEFS_H
\ No newline at end of file
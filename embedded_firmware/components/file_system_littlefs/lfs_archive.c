@@ -0,0 +1,163 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#include "lfs_archive.h"
+
+static const char *TAG = "LFS_ARCHIVE";
+
+/* Queues the header of the next changed file, or the end of archive entry after the last one */
+static int lfs_archive_next_entry(lfs_archive_t *archive) {
+
+    struct lfs_info info;
+    lfs_file_sync_attr_t sync;
+    lfs_archive_entry_t entry = {0};
+    int err;
+
+    while ((err = lfs_dir_read(&lfs, &archive->dir, &info)) > 0) {
+
+        if (info.type != LFS_TYPE_REG) {
+            continue;
+        }
+        if (lfs_get_file_sync_attr(info.name, &sync) != ESP_OK) {
+            ESP_LOGW(TAG, "Skipping %s, no sync state", info.name);
+            continue;
+        }
+        if (sync.cursor <= archive->since) {
+            continue;
+        }
+
+        err = lfs_file_open(&lfs, &archive->file, info.name, LFS_O_RDONLY);
+        if (err < 0) {
+            ESP_LOGE(TAG, "Failed to open %s (%d)", info.name, err);
+            return err;
+        }
+        archive->file_open = true;
+
+        // crc_size is the size that belongs to the CRC, bytes appended since then are left for the next export
+        entry.size = sync.crc_size;
+        entry.crc32 = sync.crc32;
+        entry.cursor = sync.cursor;
+        entry.name_len = (uint8_t)strlen(info.name);
+        if (lfs_getattr(&lfs, info.name, LFS_ATTR_MTIME, &entry.mtime, sizeof(entry.mtime)) != sizeof(entry.mtime)) {
+            entry.mtime = 0;
+        }
+
+        memcpy(archive->pending, &entry, sizeof(entry));
+        memcpy(archive->pending + sizeof(entry), info.name, entry.name_len);
+        archive->pending_len = sizeof(entry) + entry.name_len;
+        archive->pending_pos = 0;
+        archive->file_remaining = entry.size;
+        archive->entries++;
+        ESP_LOGD(TAG, "Adding %s (%lu bytes, cursor %lu)", info.name, entry.size, entry.cursor);
+        return 0;
+    }
+    if (err < 0) {
+        ESP_LOGE(TAG, "Error reading directory: %d", err);
+        return err;
+    }
+
+    // End of archive
+    entry.cursor = archive->cursor;
+    memcpy(archive->pending, &entry, sizeof(entry));
+    archive->pending_len = sizeof(entry);
+    archive->pending_pos = 0;
+    archive->ended = true;
+    return 0;
+}
+
+esp_err_t lfs_archive_begin(lfs_archive_t *archive, uint32_t since) {
+
+    memset(archive, 0, sizeof(*archive));
+    archive->since = since;
+    archive->cursor = lfs_get_sync_cursor(); // Before listing, files changed during the export are exported again next time
+
+    int err = lfs_dir_open(&lfs, &archive->dir, "/");
+    if (err < 0) {
+        ESP_LOGE(TAG, "Failed to open directory / (%d)", err);
+        return ESP_FAIL;
+    }
+    archive->dir_open = true;
+
+    lfs_archive_header_t header = {
+        .version = LFS_ARCHIVE_VERSION,
+        .header_size = sizeof(lfs_archive_header_t),
+        .entry_size = sizeof(lfs_archive_entry_t),
+        .cursor = archive->cursor,
+    };
+    memcpy(header.magic, LFS_ARCHIVE_MAGIC, sizeof(header.magic));
+    memcpy(archive->pending, &header, sizeof(header));
+    archive->pending_len = sizeof(header);
+    return ESP_OK;
+}
+
+int32_t lfs_archive_read(lfs_archive_t *archive, uint8_t *buffer, size_t size) {
+
+    size_t filled = 0;
+
+    while (filled < size) {
+
+        // 1) Header bytes
+        if (archive->pending_pos < archive->pending_len) {
+            size_t chunk = archive->pending_len - archive->pending_pos;
+            if (chunk > size - filled) {
+                chunk = size - filled;
+            }
+            memcpy(buffer + filled, archive->pending + archive->pending_pos, chunk);
+            archive->pending_pos += chunk;
+            filled += chunk;
+            continue;
+        }
+
+        // 2) File data
+        if (archive->file_open) {
+            if (archive->file_remaining == 0) {
+                lfs_file_close(&lfs, &archive->file);
+                archive->file_open = false;
+                continue;
+            }
+            lfs_size_t chunk = size - filled;
+            if (chunk > archive->file_remaining) {
+                chunk = archive->file_remaining;
+            }
+            lfs_ssize_t bytes_read = lfs_file_read(&lfs, &archive->file, buffer + filled, chunk);
+            if (bytes_read <= 0) {
+                ESP_LOGE(TAG, "File ended %lu bytes early (%d)", archive->file_remaining, (int)bytes_read);
+                return bytes_read < 0 ? bytes_read : LFS_ERR_CORRUPT;
+            }
+            archive->file_remaining -= bytes_read;
+            filled += bytes_read;
+            continue;
+        }
+
+        // 3) Next file
+        if (archive->ended) {
+            break;
+        }
+        int err = lfs_archive_next_entry(archive);
+        if (err < 0) {
+            return err;
+        }
+    }
+
+    archive->bytes += filled;
+    return (int32_t)filled;
+}
+
+void lfs_archive_end(lfs_archive_t *archive) {
+
+    if (archive->file_open) {
+        lfs_file_close(&lfs, &archive->file);
+        archive->file_open = false;
+    }
+    if (archive->dir_open) {
+        lfs_dir_close(&lfs, &archive->dir);
+        archive->dir_open = false;
+    }
+    bool complete = archive->ended && archive->pending_pos == archive->pending_len;
+    ESP_LOGI(TAG, "Exported %lu files since cursor %lu (%llu bytes)%s",
+             archive->entries, archive->since, archive->bytes, complete ? "" : ", not complete");
+}
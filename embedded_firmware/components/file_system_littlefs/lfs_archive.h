@@ -0,0 +1,100 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#ifndef LFS_ARCHIVE_H
+#define LFS_ARCHIVE_H
+
+/*
+ * Export archive (.dca)
+ *
+ * All files changed since a sync cursor in one byte stream, so a client gets them with one request:
+ *
+ *   lfs_archive_header_t
+ *   N * (lfs_archive_entry_t + name (name_len bytes, no terminator) + size bytes of file data)
+ *   lfs_archive_entry_t with name_len 0 - end of archive, a stream without it was cut off
+ *
+ * All fields are little-endian. The data of an entry is the file as it was when the entry was started,
+ * crc32 covers exactly these bytes, so a track that grows during the export still matches.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "file_system_littlefs.h"
+
+#define LFS_ARCHIVE_MAGIC       "DCGA"
+#define LFS_ARCHIVE_VERSION     1
+
+typedef struct __attribute__((packed)) {
+    char magic[4];              // LFS_ARCHIVE_MAGIC
+    uint8_t version;            // LFS_ARCHIVE_VERSION
+    uint8_t header_size;        // sizeof(lfs_archive_header_t)
+    uint8_t entry_size;         // sizeof(lfs_archive_entry_t)
+    uint8_t reserved;
+    uint32_t cursor;            // Sync cursor when the export started, ask for since=cursor next time
+} lfs_archive_header_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t size;              // File data bytes after the name
+    uint32_t mtime;             // LFS_ATTR_MTIME, 0 if not known
+    uint32_t crc32;             // CRC-32 (as zlib.crc32) of the file data
+    uint32_t cursor;            // Sync cursor of the file
+    uint8_t name_len;           // 0 for the end of archive entry
+    uint8_t reserved[3];
+} lfs_archive_entry_t;
+
+_Static_assert(sizeof(lfs_archive_header_t) == 12, "lfs_archive_header_t layout changed");
+_Static_assert(sizeof(lfs_archive_entry_t) == 20, "lfs_archive_entry_t layout changed");
+
+/* Export in progress, read it in pieces of any size with lfs_archive_read() */
+typedef struct {
+    uint32_t since;
+    uint32_t cursor;
+
+    lfs_dir_t dir;
+    bool dir_open;
+    lfs_file_t file;
+    bool file_open;
+    uint32_t file_remaining;    // Data bytes of the current entry not read yet
+    bool ended;                 // End of archive entry is queued
+
+    uint8_t pending[sizeof(lfs_archive_entry_t) + LFS_MAX_FILE_NAME_SIZE]; // Header not read yet
+    size_t pending_len;
+    size_t pending_pos;
+
+    uint32_t entries;           // Files in the archive so far
+    uint64_t bytes;             // Archive bytes read so far
+} lfs_archive_t;
+
+/**
+ * @brief Starts an export of the files with a sync cursor above since.
+ *
+ * @param archive Archive state (large, keep it static).
+ * @param since Sync cursor the client has, 0 exports all files.
+ * @return ESP_OK on success, ESP_FAIL if the root directory can not be opened.
+ */
+esp_err_t lfs_archive_begin(lfs_archive_t *archive, uint32_t since);
+
+/**
+ * @brief Reads the next archive bytes.
+ *
+ * @param archive Archive state.
+ * @param buffer Output buffer.
+ * @param size Size of the buffer.
+ * @return Number of bytes written to the buffer (less than size only at the end), 0 after the end, negative LittleFS error code on failure.
+ */
+int32_t lfs_archive_read(lfs_archive_t *archive, uint8_t *buffer, size_t size);
+
+/**
+ * @brief Closes the files used by the export. Call it also if the export was not read to the end.
+ *
+ * @param archive Archive state.
+ */
+void lfs_archive_end(lfs_archive_t *archive);
+
+#endif // LFS_ARCHIVE_H
@@ -0,0 +1,253 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#include "lfs_benchmark.h"
+#include "track_writer.h"
+#include "track_format/track_format.h"
+#include "block_device/block_device_emu.h"
+#include <stdlib.h>
+#include <stdio.h>
+
+static const char *TAG = "LFS_BENCHMARK";
+
+static const uint32_t sweep_cache_sizes[] = { 256, 512, 1024, 2048, 4096 };
+static const uint32_t sweep_lookahead_sizes[] = { 16, 32, 64, 128, 512 };
+static const int32_t sweep_block_cycles[] = { 100, 500, 1000, -1 };
+static const bool sweep_lookahead_checkpoint[] = { false, true };
+
+static int compare_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+/* Dog walking around: fix n of a session, 1 Hz, small random steps */
+static void benchmark_make_fix(gps_fix_t *fix, uint32_t session, uint32_t n, uint32_t fix_interval_s) {
+
+    uint32_t seconds = session * 86400 + n * fix_interval_s;
+
+    memset(fix, 0, sizeof(*fix));
+    fix->date.year = 2025;
+    fix->date.month = 6;
+    fix->date.day = 1 + seconds / 86400;
+    fix->time.hours = (seconds / 3600) % 24;
+    fix->time.minutes = (seconds / 60) % 60;
+    fix->time.seconds = seconds % 60;
+    fix->latitude_e6 = 46050000 + (int32_t)((n * 2654435761u) % 2000) - 1000 + (int32_t)n;
+    fix->longitude_e6 = 14500000 + (int32_t)((n * 40503u) % 2000) - 1000;
+    fix->speed_mm_s = (n * 37) % 5000;
+    fix->course_cdeg = (n * 113) % 36000;
+    fix->altitude_dm = 2950 + (int32_t)(n % 50);
+    fix->hdop_x100 = 90 + (n % 40);
+    fix->valid = true;
+}
+
+static void benchmark_file_name(char *filename, size_t filename_size, uint32_t session) {
+    snprintf(filename, filename_size, LFS_BENCHMARK_FILE_PREFIX "%03lu%s", (unsigned long)session, TRACK_FILE_SUFFIX);
+}
+
+/* Remount like after a reset and start a new track */
+static esp_err_t benchmark_start_session(uint32_t session, uint32_t fix_interval_s, track_cursor_t *cursor) {
+
+    char filename[LFS_MAX_FILE_NAME_SIZE];
+    track_file_header_t header;
+    gps_fix_t fix;
+
+    benchmark_make_fix(&fix, session, 0, fix_interval_s);
+    uint32_t start_time = track_format_fix_to_unix_time(&fix);
+    track_format_init_header(&header, start_time);
+    track_format_init_cursor(cursor, start_time);
+    benchmark_file_name(filename, sizeof(filename), session);
+
+    ESP_RETURN_ON_ERROR(lfs_mount_filesystem(false), TAG, "Failed to mount");
+    ESP_RETURN_ON_ERROR(track_writer_open(filename), TAG, "Failed to open %s", filename);
+    ESP_RETURN_ON_ERROR(track_writer_append(&header, sizeof(header)), TAG, "Failed to write header");
+    return ESP_OK;
+}
+
+static esp_err_t benchmark_end_session(uint32_t session, uint32_t keep_files) {
+
+    char filename[LFS_MAX_FILE_NAME_SIZE];
+
+    ESP_RETURN_ON_ERROR(track_writer_close(), TAG, "Failed to close track");
+    if (session >= keep_files) {
+        benchmark_file_name(filename, sizeof(filename), session - keep_files);
+        ESP_RETURN_ON_ERROR(lfs_delete_file(filename), TAG, "Failed to delete %s", filename);
+    }
+    return lfs_unmount_filesystem();
+}
+
+esp_err_t lfs_benchmark_run(block_device_t *dev, const lfs_tuning_t *tuning,
+                            const lfs_benchmark_workload_t *workload, lfs_benchmark_result_t *result) {
+
+    const track_writer_flush_policy_t default_policy = {
+        .max_records = TRACK_WRITER_SYNC_MAX_RECORDS,
+        .max_age_ms = TRACK_WRITER_SYNC_MAX_AGE_MS,
+    };
+    /* Same commit interval as on the collar, but counted in fixes - the benchmark runs faster than real time */
+    const track_writer_flush_policy_t benchmark_policy = {
+        .max_records = (TRACK_WRITER_SYNC_MAX_AGE_MS / 1000) / workload->fix_interval_s,
+        .max_age_ms = 0,
+    };
+    const lfs_tuning_t default_tuning = LFS_DEFAULT_TUNING();
+
+    uint32_t fixes_per_session = workload->hours_per_session * 3600 / workload->fix_interval_s;
+    uint32_t total_fixes = fixes_per_session * workload->sessions;
+    esp_err_t ret = ESP_OK;
+
+    memset(result, 0, sizeof(*result));
+    result->tuning = *tuning;
+    result->ram_bytes = 2 * tuning->cache_size + tuning->lookahead_size + sizeof(lfs_t) +
+                        sizeof(lfs_file_t) + tuning->cache_size + TRACK_WRITER_BATCH_SIZE;
+
+    uint32_t *latencies = malloc(total_fixes * sizeof(uint32_t));
+    if (latencies == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_GOTO_ON_ERROR(lfs_set_block_device(dev), cleanup, TAG, "Unsupported block device");
+    ESP_GOTO_ON_ERROR(lfs_set_tuning(tuning), cleanup, TAG, "Unsupported tuning");
+    track_writer_set_flush_policy(&benchmark_policy);
+
+    /* Format: mounting an erased device fails, format_if_fail formats it */
+    block_device_reset_stats(dev);
+    for (uint32_t sector = 0; sector < 2; sector++) {
+        ESP_GOTO_ON_ERROR(block_device_erase(dev, sector), cleanup, TAG, "Failed to erase superblock");
+    }
+    ESP_GOTO_ON_ERROR(lfs_mount_filesystem(true), cleanup, TAG, "Failed to format");
+    ESP_GOTO_ON_ERROR(lfs_unmount_filesystem(), cleanup, TAG, "Failed to unmount");
+    result->format_us = dev->stats.busy_time_us;
+    block_device_reset_stats(dev);
+
+    for (uint32_t session = 0; session < workload->sessions; session++) {
+
+        track_cursor_t cursor;
+        uint64_t session_start_us = dev->stats.busy_time_us;
+        ESP_GOTO_ON_ERROR(benchmark_start_session(session, workload->fix_interval_s, &cursor),
+                          cleanup, TAG, "Failed to start session %lu", session);
+
+        for (uint32_t n = 0; n < fixes_per_session; n++) {
+            gps_fix_t fix;
+            track_record_t records[2];
+
+            benchmark_make_fix(&fix, session, n, workload->fix_interval_s);
+            size_t count = track_format_encode_fix(&cursor, &fix, records);
+
+            uint64_t start_us = dev->stats.busy_time_us;
+            ESP_GOTO_ON_ERROR(track_writer_append(records, count * sizeof(track_record_t)),
+                              cleanup, TAG, "Append failed at fix %lu", n);
+            latencies[result->records++] = (uint32_t)(dev->stats.busy_time_us - start_us);
+
+            /* Boot to first write: mount until the first records are committed (the first data block is allocated) */
+            if (n + 1 == benchmark_policy.max_records || (n + 1 == fixes_per_session && n + 1 < benchmark_policy.max_records)) {
+                uint64_t boot_to_write_us = dev->stats.busy_time_us - session_start_us;
+                result->mount_us += boot_to_write_us;
+                if (boot_to_write_us > result->mount_max_us) {
+                    result->mount_max_us = boot_to_write_us;
+                }
+            }
+        }
+
+        ESP_GOTO_ON_ERROR(benchmark_end_session(session, workload->keep_files), cleanup, TAG, "Failed to end session %lu", session);
+    }
+
+    result->mount_us /= workload->sessions ? workload->sessions : 1;
+    result->bytes_read = dev->stats.bytes_read;
+    result->bytes_programmed = dev->stats.bytes_programmed;
+    result->erase_count = dev->stats.erase_count;
+
+    if (result->records > 0) {
+        qsort(latencies, result->records, sizeof(uint32_t), compare_u32);
+        result->append_p50_us = latencies[result->records * 50 / 100];
+        result->append_p90_us = latencies[result->records * 90 / 100];
+        result->append_p99_us = latencies[result->records * 99 / 100];
+        result->append_max_us = latencies[result->records - 1];
+    }
+
+cleanup:
+    if (ret != ESP_OK) {
+        track_writer_close();
+        lfs_unmount_filesystem();
+    }
+    track_writer_set_flush_policy(&default_policy);
+    lfs_set_tuning(&default_tuning);
+    free(latencies);
+    return ret;
+}
+
+static void benchmark_log_result(const lfs_benchmark_result_t *result) {
+    ESP_LOGI(TAG, "%6lu %6lu %6ld %4s | %8llu %8llu | %6lu %6lu %6lu %7lu | %10llu %10llu %7lu | %6lu",
+             result->tuning.cache_size, result->tuning.lookahead_size, (long)result->tuning.block_cycles,
+             result->tuning.lookahead_checkpoint ? "yes" : "no",
+             result->mount_us, result->mount_max_us,
+             result->append_p50_us, result->append_p90_us, result->append_p99_us, result->append_max_us,
+             result->bytes_read, result->bytes_programmed, result->erase_count,
+             result->ram_bytes);
+}
+
+static esp_err_t benchmark_run_on_emulator(const lfs_tuning_t *tuning, const lfs_benchmark_workload_t *workload) {
+
+    block_device_emu_t emu;
+    block_device_emu_config_t config = BLOCK_DEVICE_EMU_W25Q128JV_CONFIG();
+    config.strict_program = true; // LittleFS must never program a page that is not erased
+    lfs_benchmark_result_t result;
+    block_device_emu_wear_t wear;
+
+    if (block_device_emu_create_ram(&emu, &config) != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to create the flash emulator");
+        return ESP_ERR_NO_MEM;
+    }
+
+    esp_err_t ret = lfs_benchmark_run(&emu.dev, tuning, workload, &result);
+    block_device_emu_get_wear(&emu, &wear);
+    block_device_emu_destroy(&emu);
+
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "cache %lu, lookahead %lu, cycles %ld failed: %s",
+                 tuning->cache_size, tuning->lookahead_size, (long)tuning->block_cycles, esp_err_to_name(ret));
+        return ret;
+    }
+    benchmark_log_result(&result);
+    ESP_LOGD(TAG, "Sector erases: min %lu, max %lu", wear.min_erases, wear.max_erases);
+    return ESP_OK;
+}
+
+esp_err_t lfs_benchmark_sweep(const lfs_benchmark_workload_t *workload) {
+
+    esp_err_t ret = ESP_OK;
+
+    ESP_LOGI(TAG, "Workload: %lu sessions x %lu h, fix every %lu s, keep %lu files",
+             workload->sessions, workload->hours_per_session, workload->fix_interval_s, workload->keep_files);
+    ESP_LOGI(TAG, " cache   look cycles ckpt | mount us  max us  | append us p50    p90    p99     max | bytes read  bytes prog  erases |    RAM");
+
+    for (size_t i = 0; i < sizeof(sweep_cache_sizes) / sizeof(sweep_cache_sizes[0]); i++) {
+        lfs_tuning_t tuning = LFS_DEFAULT_TUNING();
+        tuning.cache_size = sweep_cache_sizes[i];
+        esp_err_t run_ret = benchmark_run_on_emulator(&tuning, workload);
+        ret = ret == ESP_OK ? run_ret : ret;
+    }
+    for (size_t i = 0; i < sizeof(sweep_lookahead_sizes) / sizeof(sweep_lookahead_sizes[0]); i++) {
+        lfs_tuning_t tuning = LFS_DEFAULT_TUNING();
+        tuning.lookahead_size = sweep_lookahead_sizes[i];
+        esp_err_t run_ret = benchmark_run_on_emulator(&tuning, workload);
+        ret = ret == ESP_OK ? run_ret : ret;
+    }
+    for (size_t i = 0; i < sizeof(sweep_block_cycles) / sizeof(sweep_block_cycles[0]); i++) {
+        lfs_tuning_t tuning = LFS_DEFAULT_TUNING();
+        tuning.block_cycles = sweep_block_cycles[i];
+        esp_err_t run_ret = benchmark_run_on_emulator(&tuning, workload);
+        ret = ret == ESP_OK ? run_ret : ret;
+    }
+    /* Cold mount vs. mount with the allocator checkpoint from the previous unmount (deep sleep wake-up) */
+    for (size_t i = 0; i < sizeof(sweep_lookahead_checkpoint) / sizeof(sweep_lookahead_checkpoint[0]); i++) {
+        lfs_tuning_t tuning = LFS_DEFAULT_TUNING();
+        tuning.lookahead_checkpoint = sweep_lookahead_checkpoint[i];
+        esp_err_t run_ret = benchmark_run_on_emulator(&tuning, workload);
+        ret = ret == ESP_OK ? run_ret : ret;
+    }
+    return ret;
+}
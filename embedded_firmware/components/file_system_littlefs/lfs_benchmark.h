@@ -0,0 +1,86 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#ifndef LFS_BENCHMARK_H
+#define LFS_BENCHMARK_H
+
+/*
+ * Storage benchmark
+ *
+ * Replays a tracking workload through the real storage path (lfs_mount_filesystem, track_writer, lfs_delete_file)
+ * on a block device and reports flash time, IO and RAM per LittleFS configuration (lfs_tuning_t).
+ * Meant for a NOR flash emulator (block_device_emu.h), the reported times are then the modelled W25Q128JV times.
+ *
+ * The workload per session: remount (as after a reset), open a new track file, append one 16 byte
+ * record per fix for hours_per_session, close. Older files are deleted so only keep_files are left.
+ */
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "file_system_littlefs.h"
+#include "block_device/block_device.h"
+
+#define LFS_BENCHMARK_FILE_PREFIX   "bench_"
+
+typedef struct {
+    uint32_t sessions;              // Tracking sessions (one track file each)
+    uint32_t hours_per_session;
+    uint32_t fix_interval_s;        // Seconds between fixes
+    uint32_t keep_files;            // Files left after each session, older ones are deleted
+} lfs_benchmark_workload_t;
+
+#define LFS_BENCHMARK_DEFAULT_WORKLOAD() {      \
+    .sessions = 6,                              \
+    .hours_per_session = 4,                     \
+    .fix_interval_s = 1,                        \
+    .keep_files = 3,                            \
+}
+
+typedef struct {
+    lfs_tuning_t tuning;
+    uint32_t records;               // Records appended in all sessions
+    uint64_t format_us;             // Flash time of lfs_format
+    uint64_t mount_us;              // Average flash time from mount until the first records are committed (boot to first write)
+    uint64_t mount_max_us;
+    uint32_t append_p50_us;         // Flash time per appended record, percentiles over all records
+    uint32_t append_p90_us;
+    uint32_t append_p99_us;
+    uint32_t append_max_us;
+    uint64_t bytes_read;
+    uint64_t bytes_programmed;
+    uint32_t erase_count;
+    uint32_t ram_bytes;             // LittleFS buffers + lfs_t + one open file + track writer batch
+} lfs_benchmark_result_t;
+
+/**
+ * @brief Runs the workload on a freshly formatted block device with one LittleFS configuration.
+ *
+ * The block device is selected with lfs_set_block_device() and stays selected, the tuning is reset to
+ * LFS_DEFAULT_TUNING() at the end. Do not use on the W25Q128JV that holds real tracks, it is formatted.
+ *
+ * @param dev Block device, normally a NOR flash emulator.
+ * @param tuning LittleFS configuration.
+ * @param workload Workload to replay.
+ * @param result Output results.
+ * @return ESP_OK on success, or the first error of the storage path.
+ */
+esp_err_t lfs_benchmark_run(block_device_t *dev, const lfs_tuning_t *tuning,
+                            const lfs_benchmark_workload_t *workload, lfs_benchmark_result_t *result);
+
+/**
+ * @brief Runs the workload for a sweep of cache sizes, lookahead sizes and block cycles and logs a table.
+ *
+ * Every parameter is swept on its own around LFS_DEFAULT_TUNING(), the last two runs compare cold mounts with
+ * mounts that restore the allocator checkpoint (lfs_tuning_t.lookahead_checkpoint). Each run gets a new RAM emulator
+ * of the W25Q128JV (16 MB), so this is for host builds, not for the ESP32-C3 (see tests/test_lfs_sweep_host).
+ *
+ * @param workload Workload to replay.
+ * @return ESP_OK if every run passed, or the error of the first run that failed (the sweep goes on).
+ */
+esp_err_t lfs_benchmark_sweep(const lfs_benchmark_workload_t *workload);
+
+#endif // LFS_BENCHMARK_H
@@ -0,0 +1,92 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#include "lfs_manifest.h"
+#include <stdio.h>
+
+static const char *TAG = "LFS_MANIFEST";
+
+static esp_err_t lfs_manifest_write_string(lfs_manifest_write_t write, void *ctx, const char *text) {
+    return write(text, strlen(text), ctx);
+}
+
+/* Copies a file name into a JSON string body (without quotes) */
+static void lfs_manifest_escape(char *buffer, size_t buffer_size, const char *name) {
+    size_t len = 0;
+    for (; *name != '\0' && len + 7 < buffer_size; name++) {
+        unsigned char c = (unsigned char)*name;
+        if (c == '"' || c == '\\') {
+            buffer[len++] = '\\';
+            buffer[len++] = (char)c;
+        } else if (c < 0x20) {
+            len += snprintf(buffer + len, buffer_size - len, "\\u%04x", c);
+        } else {
+            buffer[len++] = (char)c;
+        }
+    }
+    buffer[len] = '\0';
+}
+
+esp_err_t lfs_manifest_write(uint32_t since, lfs_manifest_write_t write, void *ctx) {
+
+    lfs_dir_t dir;
+    struct lfs_info info;
+    lfs_file_sync_attr_t sync;
+    uint32_t mtime;
+    char name[LFS_MAX_FILE_NAME_SIZE * 2];
+    char line[LFS_MANIFEST_LINE_SIZE];
+    uint32_t listed = 0;
+    esp_err_t ret;
+
+    /* Taken before listing: a file that changes while we list gets a higher cursor, so the client sees it
+       again next time instead of missing the change */
+    uint32_t cursor = lfs_get_sync_cursor();
+
+    int err = lfs_dir_open(&lfs, &dir, "/");
+    if (err < 0) {
+        ESP_LOGE(TAG, "Failed to open directory / (%d)", err);
+        return ESP_FAIL;
+    }
+
+    snprintf(line, sizeof(line), "{\"cursor\":%lu,\"files\":[", cursor);
+    ret = lfs_manifest_write_string(write, ctx, line);
+
+    while (ret == ESP_OK && (err = lfs_dir_read(&lfs, &dir, &info)) > 0) {
+
+        if (info.type != LFS_TYPE_REG) {
+            continue;
+        }
+        if (lfs_get_file_sync_attr(info.name, &sync) != ESP_OK) {
+            ESP_LOGW(TAG, "Skipping %s, no sync state", info.name);
+            continue;
+        }
+        if (sync.cursor <= since) {
+            continue;
+        }
+        if (lfs_getattr(&lfs, info.name, LFS_ATTR_MTIME, &mtime, sizeof(mtime)) != sizeof(mtime)) {
+            mtime = 0;
+        }
+
+        lfs_manifest_escape(name, sizeof(name), info.name);
+        snprintf(line, sizeof(line), "%s\n{\"name\":\"%s\",\"size\":%lu,\"mtime\":%lu,\"crc32\":\"%08lx\",\"cursor\":%lu}",
+                 listed ? "," : "", name, (unsigned long)info.size, mtime, sync.crc32, sync.cursor);
+        ret = lfs_manifest_write_string(write, ctx, line);
+        listed++;
+    }
+    lfs_dir_close(&lfs, &dir);
+
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    if (err < 0) {
+        ESP_LOGE(TAG, "Error reading directory: %d", err);
+        return ESP_FAIL;
+    }
+
+    ESP_LOGI(TAG, "Listed %lu files changed since cursor %lu (now %lu)", listed, since, cursor);
+    return lfs_manifest_write_string(write, ctx, "\n]}\n");
+}
@@ -0,0 +1,47 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#ifndef LFS_MANIFEST_H
+#define LFS_MANIFEST_H
+
+/*
+ * Sync manifest
+ *
+ * JSON list of the files for sync clients, streamed one entry at a time so it has no size limit:
+ *
+ *   {"cursor":42,"files":[
+ *   {"name":"dog_run_2025-06-01.trk","size":8208,"mtime":1748772000,"crc32":"1a2b3c4d","cursor":42}
+ *   ]}
+ *
+ * "cursor" at the top is the highest sync cursor (lfs_file_sync_attr_t). A client stores it and asks for
+ * the files changed since then on the next sync. If it is lower than the stored one the filesystem was
+ * formatted and the client should sync everything.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "file_system_littlefs.h"
+
+#define LFS_MANIFEST_LINE_SIZE  (LFS_MAX_FILE_NAME_SIZE * 2 + 128) // One rendered entry, the name may be escaped
+
+/* Called with rendered JSON. Returning an error stops the manifest. */
+typedef esp_err_t (*lfs_manifest_write_t)(const char *data, size_t len, void *ctx);
+
+/**
+ * @brief Writes the manifest of the root directory.
+ *
+ * Size, mtime, CRC and cursor come from file attributes, so only files with a stale CRC are read.
+ *
+ * @param since Only list files with a sync cursor above this, 0 lists all files.
+ * @param write Function that receives the rendered JSON.
+ * @param ctx User context passed to the write function.
+ * @return ESP_OK on success, ESP_FAIL if the directory can not be read, or the error returned by the write function.
+ */
+esp_err_t lfs_manifest_write(uint32_t since, lfs_manifest_write_t write, void *ctx);
+
+#endif // LFS_MANIFEST_H
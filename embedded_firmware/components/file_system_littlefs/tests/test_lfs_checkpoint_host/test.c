@@ -0,0 +1,308 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+/*
+ * Host test of the LittleFS allocator checkpoint (file_system_littlefs.c) on a RAM emulator of the W25Q128JV.
+ * Files are written, the filesystem is unmounted (the checkpoint is saved) and then, before the next mount:
+ *
+ * - nothing changes: the checkpoint must be restored and the first write must read less than after a cold mount
+ * - another mount (a second lfs_t, as a PC writing the image) writes a file
+ * - another mount formats the flash again and writes a file (new seed)
+ * - the lookahead size of the tuning changes
+ *
+ * In the last three the checkpoint must be rejected, so the first write scans the filesystem (cold mount).
+ * Every file must read back unchanged after the writes, no block may be allocated twice.
+ *
+ *     ./test_lfs_checkpoint [-f files before the unmount]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include "file_system_littlefs.h"
+#include "block_device/block_device_emu.h"
+
+#define TEST_SECTORS        512     // 2 MB of the W25Q128JV, enough files for a scan that shows in the reads
+#define TEST_FILE_SIZE      (24 * 1024)
+#define TEST_MAX_FILES      64
+
+typedef enum {
+    TEST_CHANGE_NONE,
+    TEST_CHANGE_OTHER_MOUNT_WRITE,
+    TEST_CHANGE_OTHER_MOUNT_FORMAT,
+    TEST_CHANGE_LOOKAHEAD_SIZE,
+} test_change_t;
+
+typedef struct {
+    const char *name;
+    test_change_t change;
+} test_case_t;
+
+typedef struct {
+    uint32_t restores;
+    uint32_t rejects;
+    uint64_t first_write_read;      // Bytes LittleFS read for the first file written after the mount
+} test_result_t;
+
+/* Files that must be on the flash: name and pattern seed */
+static struct {
+    char name[LFS_MAX_FILE_NAME_SIZE];
+    uint32_t seed;
+} test_files[TEST_MAX_FILES];
+static uint32_t test_file_count = 0;
+
+static uint8_t test_buffer[TEST_FILE_SIZE];
+
+/* gps_l96.c is not linked */
+esp_err_t gps_l96_get_date_string_from_data(char *date_string, size_t date_string_size) {
+    snprintf(date_string, date_string_size, "2025-06-01");
+    return ESP_OK;
+}
+
+/* LittleFS is always on the emulator, lfs_set_block_device() is called before every mount */
+block_device_t *block_device_w25q_get(void) {
+    return NULL;
+}
+
+static void test_fill(uint8_t *buffer, size_t size, uint32_t seed) {
+    for (size_t i = 0; i < size; i++) {
+        buffer[i] = (uint8_t)((i * 2654435761u + seed) >> 13);
+    }
+}
+
+static int test_write_file(lfs_t *fs, const char *name, uint32_t seed) {
+    lfs_file_t file;
+
+    test_fill(test_buffer, sizeof(test_buffer), seed);
+    if (lfs_file_open(fs, &file, name, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_TRUNC) < 0) {
+        return 1;
+    }
+    int failed = lfs_file_write(fs, &file, test_buffer, sizeof(test_buffer)) != (lfs_ssize_t)sizeof(test_buffer);
+    failed |= lfs_file_close(fs, &file) < 0;
+    if (!failed && test_file_count < TEST_MAX_FILES) {
+        snprintf(test_files[test_file_count].name, sizeof(test_files[0].name), "%s", name);
+        test_files[test_file_count].seed = seed;
+        test_file_count++;
+    }
+    return failed;
+}
+
+static int test_check_files(const char *case_name) {
+    static uint8_t expected[TEST_FILE_SIZE];
+    lfs_file_t file;
+    int failed = 0;
+
+    for (uint32_t i = 0; i < test_file_count; i++) {
+        test_fill(expected, sizeof(expected), test_files[i].seed);
+        memset(test_buffer, 0, sizeof(test_buffer));
+        if (lfs_file_open(&lfs, &file, test_files[i].name, LFS_O_RDONLY) < 0) {
+            fprintf(stderr, "%s: %s is gone\n", case_name, test_files[i].name);
+            failed++;
+            continue;
+        }
+        lfs_ssize_t size = lfs_file_read(&lfs, &file, test_buffer, sizeof(test_buffer));
+        lfs_file_close(&lfs, &file);
+        if (size != (lfs_ssize_t)sizeof(test_buffer) || memcmp(test_buffer, expected, sizeof(expected)) != 0) {
+            fprintf(stderr, "%s: %s is corrupted\n", case_name, test_files[i].name);
+            failed++;
+        }
+    }
+    return failed;
+}
+
+/* ---------------- Another mount of the same flash, not through file_system_littlefs.c ---------------- */
+
+static int other_read(const struct lfs_config *c, lfs_block_t block, lfs_off_t off, void *buffer, lfs_size_t size) {
+    return block_device_read(c->context, block * c->block_size + off, buffer, size) == ESP_OK ? 0 : LFS_ERR_IO;
+}
+
+static int other_prog(const struct lfs_config *c, lfs_block_t block, lfs_off_t off, const void *buffer, lfs_size_t size) {
+    return block_device_prog(c->context, block * c->block_size + off, buffer, size) == ESP_OK ? 0 : LFS_ERR_IO;
+}
+
+static int other_erase(const struct lfs_config *c, lfs_block_t block) {
+    return block_device_erase(c->context, block) == ESP_OK ? 0 : LFS_ERR_IO;
+}
+
+static int other_sync(const struct lfs_config *c) {
+    return 0;
+}
+
+static int other_lock(const struct lfs_config *c) {
+    return 0;
+}
+
+static int test_other_mount(block_device_t *dev, bool format, uint32_t seed) {
+    lfs_t other_lfs;
+    const struct lfs_config other_cfg = {
+        .context = dev,
+        .read = other_read,
+        .prog = other_prog,
+        .erase = other_erase,
+        .sync = other_sync,
+        .lock = other_lock,
+        .unlock = other_lock,
+        .read_size = LFS_READ_SIZE,
+        .prog_size = LFS_PROG_SIZE,
+        .block_size = LFS_BLOCK_SIZE,
+        .block_count = dev->sector_count,
+        .block_cycles = LFS_BLOCK_CYCLES,
+        .cache_size = LFS_CACHE_SIZE,
+        .lookahead_size = LFS_LOOKAHEAD_SIZE,
+        .name_max = LFS_MAX_FILE_NAME_SIZE,
+    };
+    int failed = 0;
+
+    if (format) {
+        failed |= lfs_format(&other_lfs, &other_cfg) < 0;
+        test_file_count = 0;
+    }
+    if (failed || lfs_mount(&other_lfs, &other_cfg) < 0) {
+        return 1;
+    }
+    failed |= test_write_file(&other_lfs, "other.bin", seed);
+    failed |= lfs_unmount(&other_lfs) < 0;
+    return failed;
+}
+
+/* ---------------- Cases ---------------- */
+
+static int test_run_case(const test_case_t *tc, uint32_t files, test_result_t *result) {
+    block_device_emu_t emu;
+    block_device_emu_config_t config = BLOCK_DEVICE_EMU_W25Q128JV_CONFIG();
+    config.sector_count = TEST_SECTORS;
+    config.strict_program = true;
+    const lfs_tuning_t default_tuning = LFS_DEFAULT_TUNING();
+    lfs_io_stats_t before, after;
+    char name[LFS_MAX_FILE_NAME_SIZE];
+    int failed = 0;
+
+    memset(result, 0, sizeof(*result));
+    test_file_count = 0;
+    lfs_set_tuning(&default_tuning);
+    if (block_device_emu_create_ram(&emu, &config) != ESP_OK || lfs_set_block_device(&emu.dev) != ESP_OK ||
+        block_device_erase(&emu.dev, 0) != ESP_OK || block_device_erase(&emu.dev, 1) != ESP_OK ||
+        lfs_mount_filesystem(true) != ESP_OK) {
+        fprintf(stderr, "%s: no filesystem on the emulator\n", tc->name);
+        block_device_emu_destroy(&emu);
+        return 1;
+    }
+
+    // 1) Files, then the unmount saves the checkpoint (as before deep sleep)
+    for (uint32_t i = 0; i < files; i++) {
+        snprintf(name, sizeof(name), "track_%03lu.bin", i);
+        failed |= test_write_file(&lfs, name, i);
+    }
+    failed |= lfs_unmount_filesystem() != ESP_OK;
+
+    // 2) The change between the unmount and the next mount
+    switch (tc->change) {
+        case TEST_CHANGE_NONE:
+            break;
+        case TEST_CHANGE_OTHER_MOUNT_WRITE:
+            failed |= test_other_mount(&emu.dev, false, 1000);
+            break;
+        case TEST_CHANGE_OTHER_MOUNT_FORMAT:
+            failed |= test_other_mount(&emu.dev, true, 2000);
+            break;
+        case TEST_CHANGE_LOOKAHEAD_SIZE: {
+            lfs_tuning_t tuning = LFS_DEFAULT_TUNING();
+            tuning.lookahead_size = LFS_LOOKAHEAD_SIZE / 2;
+            failed |= lfs_set_tuning(&tuning) != ESP_OK;
+            break;
+        }
+    }
+    if (failed) {
+        fprintf(stderr, "%s: setup failed\n", tc->name);
+        goto cleanup;
+    }
+
+    // 3) Mount (wake-up) and the first write, which allocates blocks
+    lfs_get_io_stats(&before);
+    failed |= lfs_mount_filesystem(false) != ESP_OK;
+    uint64_t mount_read = 0;
+    lfs_get_io_stats(&after);
+    mount_read = after.bytes_read - before.bytes_read;
+    failed |= test_write_file(&lfs, "after_mount.bin", 3000);
+    lfs_get_io_stats(&after);
+    result->restores = after.checkpoint_restores - before.checkpoint_restores;
+    result->rejects = after.checkpoint_rejects - before.checkpoint_rejects;
+    result->first_write_read = after.bytes_read - before.bytes_read - mount_read;
+
+    // 4) More writes than the saved window covers, then every file must be intact
+    for (uint32_t i = 0; i < files; i++) {
+        snprintf(name, sizeof(name), "more_%03lu.bin", i);
+        failed |= test_write_file(&lfs, name, 4000 + i);
+    }
+    if (failed) {
+        fprintf(stderr, "%s: writes after the mount failed\n", tc->name);
+    }
+    failed |= test_check_files(tc->name);
+    failed |= lfs_unmount_filesystem() != ESP_OK || lfs_mount_filesystem(false) != ESP_OK;
+    failed |= test_check_files(tc->name);
+
+cleanup:
+    lfs_unmount_filesystem();
+    lfs_set_tuning(&default_tuning);
+    block_device_emu_destroy(&emu);
+    return failed;
+}
+
+int main(int argc, char **argv) {
+    uint32_t files = 16;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "f:")) != -1) {
+        switch (opt) {
+            case 'f': files = strtoul(optarg, NULL, 10); break;
+            default:
+                fprintf(stderr, "Usage: %s [-f files]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (files == 0 || 2 * files + 2 > TEST_MAX_FILES) {
+        fprintf(stderr, "1 to %d files\n", (TEST_MAX_FILES - 2) / 2);
+        return 2;
+    }
+
+    static const test_case_t cases[] = {
+        { "unchanged",                  TEST_CHANGE_NONE },
+        { "other mount wrote a file",   TEST_CHANGE_OTHER_MOUNT_WRITE },
+        { "other mount formatted",      TEST_CHANGE_OTHER_MOUNT_FORMAT },
+        { "lookahead size changed",     TEST_CHANGE_LOOKAHEAD_SIZE },
+    };
+    test_result_t results[sizeof(cases) / sizeof(cases[0])];
+
+    int failed = 0;
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        failed += test_run_case(&cases[i], files, &results[i]);
+        printf("%-28s checkpoint %-8s first write read %7llu bytes\n", cases[i].name,
+               results[i].restores ? "restored" : results[i].rejects ? "rejected" : "none",
+               results[i].first_write_read);
+
+        bool restore_expected = cases[i].change == TEST_CHANGE_NONE;
+        if (results[i].restores != (restore_expected ? 1 : 0) || results[i].rejects != (restore_expected ? 0 : 1)) {
+            fprintf(stderr, "%s: checkpoint %s, expected %s\n", cases[i].name,
+                    results[i].restores ? "restored" : "not restored", restore_expected ? "restored" : "rejected");
+            failed++;
+        }
+    }
+
+    // A rejected checkpoint means a cold mount: the first write scans the filesystem
+    if (results[1].first_write_read <= results[0].first_write_read) {
+        fprintf(stderr, "%s: first write read %llu bytes, not more than with the checkpoint (%llu)\n", cases[1].name,
+                results[1].first_write_read, results[0].first_write_read);
+        failed++;
+    }
+
+    if (failed) {
+        fprintf(stderr, "%d allocator checkpoint cases failed\n", failed);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+/*
+ * LittleFS configuration sweep (lfs_benchmark.c) on a RAM emulator of the W25Q128JV (block_device_emu.h).
+ * Replays tracking sessions through file_system_littlefs.c, track_writer.c and LittleFS for every cache size,
+ * lookahead size and block cycles value of the sweep, and prints the table of lfs_benchmark_sweep().
+ * Then runs the workload once with cold mounts and once with the allocator checkpoint of file_system_littlefs.c
+ * and prints the flash time from mount to the first write of both.
+ * Fails if any run fails, or if the mounts with the checkpoint are not faster than the cold ones.
+ *
+ *     ./test_lfs_sweep [-s sessions] [-H hours per session] [-i fix interval s] [-k files kept]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <getopt.h>
+#include "esp_log.h"
+#include "block_device/block_device_emu.h"
+#include "lfs_benchmark.h"
+#include "track_writer.h"
+
+/* gps_l96.c is not linked, the benchmark names its files itself */
+esp_err_t gps_l96_get_date_string_from_data(char *date_string, size_t date_string_size) {
+    snprintf(date_string, date_string_size, "2025-06-01");
+    return ESP_OK;
+}
+
+/* LittleFS is always on the emulator, lfs_set_block_device() is called before every mount */
+block_device_t *block_device_w25q_get(void) {
+    return NULL;
+}
+
+/* One run of the workload on a new emulator */
+static esp_err_t test_run(bool lookahead_checkpoint, const lfs_benchmark_workload_t *workload, lfs_benchmark_result_t *result) {
+    block_device_emu_t emu;
+    block_device_emu_config_t config = BLOCK_DEVICE_EMU_W25Q128JV_CONFIG();
+    config.strict_program = true;
+    lfs_tuning_t tuning = LFS_DEFAULT_TUNING();
+    tuning.lookahead_checkpoint = lookahead_checkpoint;
+
+    if (block_device_emu_create_ram(&emu, &config) != ESP_OK) {
+        return ESP_ERR_NO_MEM;
+    }
+    esp_err_t ret = lfs_benchmark_run(&emu.dev, &tuning, workload, result);
+    block_device_emu_destroy(&emu);
+    return ret;
+}
+
+/* Boot to first write: cold mount (the allocator scans the filesystem) vs. the checkpoint of the last unmount */
+static int test_checkpoint_mount(const lfs_benchmark_workload_t *workload) {
+    lfs_benchmark_result_t cold, checkpoint;
+
+    if (test_run(false, workload, &cold) != ESP_OK || test_run(true, workload, &checkpoint) != ESP_OK) {
+        fprintf(stderr, "Mount comparison failed\n");
+        return 1;
+    }
+    printf("Boot to first write: cold mount %llu us (max %llu us), with the checkpoint %llu us (max %llu us), %llu%%\n",
+           cold.mount_us, cold.mount_max_us, checkpoint.mount_us, checkpoint.mount_max_us,
+           cold.mount_us > 0 ? checkpoint.mount_us * 100 / cold.mount_us : 0);
+    if (checkpoint.mount_us >= cold.mount_us) {
+        fprintf(stderr, "Mounts with the allocator checkpoint are not faster than cold mounts\n");
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    lfs_benchmark_workload_t workload = LFS_BENCHMARK_DEFAULT_WORKLOAD();
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:H:i:k:")) != -1) {
+        switch (opt) {
+            case 's': workload.sessions = strtoul(optarg, NULL, 10); break;
+            case 'H': workload.hours_per_session = strtoul(optarg, NULL, 10); break;
+            case 'i': workload.fix_interval_s = strtoul(optarg, NULL, 10); break;
+            case 'k': workload.keep_files = strtoul(optarg, NULL, 10); break;
+            default:
+                fprintf(stderr, "Usage: %s [-s sessions] [-H hours per session] [-i fix interval s] [-k files kept]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (workload.sessions == 0 || workload.hours_per_session == 0 || workload.fix_interval_s == 0 ||
+        workload.fix_interval_s > TRACK_WRITER_SYNC_MAX_AGE_MS / 1000) {
+        fprintf(stderr, "At least 1 session of 1 hour, fix interval 1 to %d s\n", TRACK_WRITER_SYNC_MAX_AGE_MS / 1000);
+        return 2;
+    }
+
+    // Only the table, not the info logs of every mount and track file
+    esp_log_level_set("*", ESP_LOG_WARN);
+    esp_log_level_set("LFS_INTEGRATION", ESP_LOG_ERROR); // Every run starts with a failed mount of the erased emulator
+    esp_log_level_set("LFS_BENCHMARK", ESP_LOG_INFO);
+
+    int failed = 0;
+    esp_err_t ret = lfs_benchmark_sweep(&workload);
+    if (ret != ESP_OK) {
+        fprintf(stderr, "LittleFS sweep failed: %s\n", esp_err_to_name(ret));
+        failed++;
+    }
+    failed += test_checkpoint_mount(&workload);
+
+    if (failed) {
+        fprintf(stderr, "%d LittleFS sweep cases failed\n", failed);
+        return 1;
+    }
+    return 0;
+}
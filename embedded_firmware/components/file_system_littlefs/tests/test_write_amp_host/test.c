@@ -0,0 +1,328 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+/*
+ * Host test of the write amplification of track logging. One tracking session is written through the real
+ * storage path (file_system_littlefs.c, track_writer.c, LittleFS) on a RAM emulator of the W25Q128JV
+ * (block_device_emu.h), once per way of writing fixes:
+ *
+ * - lfs_append_to_file(): open, append and close for every CSV line, the logging before the track writer
+ * - track_writer with a commit after every fix, and with the default commit every 60 fixes
+ * - track_writer with the packed 16 byte records of track_format.h
+ *
+ * Reports the bytes programmed and erased per fix and the modelled flash time. The file must have every
+ * byte after a remount, and the track writer must program at least TEST_MIN_GAIN times less than
+ * open/append/close per fix. Then the fix is lost after a few records: track_writer_poll() alone must commit
+ * them once the max-age of the flush policy is reached.
+ *
+ *     ./test_write_amp [-n fixes]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include "file_system_littlefs.h"
+#include "track_writer.h"
+#include "track_format/track_format.h"
+#include "block_device/block_device_emu.h"
+
+#define TEST_FILE_PREFIX    "amp_"
+#define TEST_CSV_HEADER     "timestamp,latitude,longitude,speed,altitude\n"
+#define TEST_COMMIT_FIXES   (TRACK_WRITER_SYNC_MAX_AGE_MS / 1000) // Default commit every 60 s at 1 Hz, counted in fixes
+#define TEST_MIN_GAIN       10
+#define TEST_POLL_AGE_MS    50  // Max-age of the poll case, short so the test does not wait 60 s
+#define TEST_POLL_FIXES     3   // Valid fixes before the fix is lost
+
+typedef enum {
+    TEST_WRITE_APPEND_CLOSE,    // lfs_append_to_file() per fix
+    TEST_WRITE_TRACK_WRITER,    // track_writer_append() per fix
+} test_write_t;
+
+typedef struct {
+    const char *name;
+    test_write_t write;
+    uint32_t commit_fixes;      // Track writer commit policy (max_records)
+    bool binary;                // Packed track_format records instead of CSV lines
+} test_case_t;
+
+typedef struct {
+    uint32_t fixes;
+    uint64_t bytes_appended;    // Payload, without the file header
+    uint64_t bytes_programmed;
+    uint32_t erase_count;
+    uint64_t busy_time_us;
+    uint64_t writer_programmed; // track_writer_get_stats(), 0 for lfs_append_to_file()
+} test_result_t;
+
+/* gps_l96.c is not linked, the file name gets a fixed date */
+esp_err_t gps_l96_get_date_string_from_data(char *date_string, size_t date_string_size) {
+    snprintf(date_string, date_string_size, "2025-06-01");
+    return ESP_OK;
+}
+
+/* LittleFS is always on the emulator, lfs_set_block_device() is called before every mount */
+block_device_t *block_device_w25q_get(void) {
+    return NULL;
+}
+
+/* Dog walking around at 1 Hz, like lfs_benchmark.c */
+static void test_make_fix(gps_fix_t *fix, uint32_t n) {
+    memset(fix, 0, sizeof(*fix));
+    fix->date.year = 2025;
+    fix->date.month = 6;
+    fix->date.day = 1 + n / 86400;
+    fix->time.hours = (n / 3600) % 24;
+    fix->time.minutes = (n / 60) % 60;
+    fix->time.seconds = n % 60;
+    fix->latitude_e6 = 46050000 + (int32_t)((n * 2654435761u) % 2000) - 1000 + (int32_t)n;
+    fix->longitude_e6 = 14500000 + (int32_t)((n * 40503u) % 2000) - 1000;
+    fix->speed_mm_s = (n * 37) % 5000;
+    fix->course_cdeg = (n * 113) % 36000;
+    fix->altitude_dm = 2950 + (int32_t)(n % 50);
+    fix->hdop_x100 = 90 + (n % 40);
+    fix->valid = true;
+}
+
+/* CSV line of the logging before track_format.h: ISO 8601 timestamp,latitude,longitude,speed,altitude */
+static size_t test_csv_line(char *line, size_t size, const gps_fix_t *fix) {
+    return (size_t)snprintf(line, size, "%04d-%02d-%02dT%02d:%02d:%02dZ,%f,%f,%f,%f\n",
+                            fix->date.year, fix->date.month, fix->date.day,
+                            fix->time.hours, fix->time.minutes, fix->time.seconds,
+                            fix->latitude_e6 / 1e6, fix->longitude_e6 / 1e6, fix->speed_mm_s / 514.444, 0.0);
+}
+
+static esp_err_t test_format(block_device_t *dev) {
+    for (uint32_t sector = 0; sector < 2; sector++) {
+        ESP_RETURN_ON_ERROR(block_device_erase(dev, sector), "TEST", "Failed to erase superblock");
+    }
+    ESP_RETURN_ON_ERROR(lfs_mount_filesystem(true), "TEST", "Failed to format");
+    return ESP_OK;
+}
+
+static int test_run_case(const test_case_t *tc, uint32_t fixes, test_result_t *result) {
+    block_device_emu_t emu;
+    block_device_emu_config_t config = BLOCK_DEVICE_EMU_W25Q128JV_CONFIG();
+    config.strict_program = true; // LittleFS must never program a page that is not erased
+    char filename[LFS_MAX_FILE_NAME_SIZE];
+    track_file_header_t header;
+    track_cursor_t cursor;
+    gps_fix_t fix;
+    int failed = 0;
+
+    memset(result, 0, sizeof(*result));
+    if (block_device_emu_create_ram(&emu, &config) != ESP_OK || lfs_set_block_device(&emu.dev) != ESP_OK ||
+        test_format(&emu.dev) != ESP_OK) {
+        fprintf(stderr, "%s: no filesystem on the emulator\n", tc->name);
+        return 1;
+    }
+
+    // 1) New track file with its header, as when tracking starts
+    test_make_fix(&fix, 0);
+    track_format_init_header(&header, track_format_fix_to_unix_time(&fix));
+    track_format_init_cursor(&cursor, track_format_fix_to_unix_time(&fix));
+    const void *file_header = tc->binary ? (const void *)&header : TEST_CSV_HEADER;
+    size_t header_size = tc->binary ? sizeof(header) : strlen(TEST_CSV_HEADER);
+    if (lfs_create_new_file(TEST_FILE_PREFIX, tc->binary ? TRACK_FILE_SUFFIX : ".csv", file_header, header_size,
+                            filename, sizeof(filename)) != ESP_OK) {
+        fprintf(stderr, "%s: track file not created\n", tc->name);
+        failed = 1;
+        goto cleanup;
+    }
+    const track_writer_flush_policy_t policy = { .max_records = tc->commit_fixes, .max_age_ms = 0 };
+    track_writer_set_flush_policy(&policy);
+    if (tc->write == TEST_WRITE_TRACK_WRITER && track_writer_open(filename) != ESP_OK) {
+        fprintf(stderr, "%s: track writer not opened\n", tc->name);
+        failed = 1;
+        goto cleanup;
+    }
+
+    // 2) One fix per second, only the writes of the fixes are counted
+    block_device_reset_stats(&emu.dev);
+    for (uint32_t n = 0; n < fixes && !failed; n++) {
+        char line[96];
+        track_record_t records[2];
+        esp_err_t ret;
+
+        test_make_fix(&fix, n);
+        if (tc->binary) {
+            size_t len = track_format_encode_fix(&cursor, &fix, records) * sizeof(track_record_t);
+            ret = track_writer_append(records, len);
+            result->bytes_appended += len;
+        } else if (tc->write == TEST_WRITE_TRACK_WRITER) {
+            size_t len = test_csv_line(line, sizeof(line), &fix);
+            ret = track_writer_append(line, len);
+            result->bytes_appended += len;
+        } else {
+            result->bytes_appended += test_csv_line(line, sizeof(line), &fix);
+            ret = lfs_append_to_file(line, filename);
+        }
+        if (ret != ESP_OK) {
+            fprintf(stderr, "%s: append of fix %lu failed (%s)\n", tc->name, n, esp_err_to_name(ret));
+            failed = 1;
+        }
+        result->fixes++;
+    }
+    if (tc->write == TEST_WRITE_TRACK_WRITER) {
+        track_writer_stats_t stats;
+        if (track_writer_close() != ESP_OK) {
+            fprintf(stderr, "%s: track writer not closed\n", tc->name);
+            failed = 1;
+        }
+        track_writer_get_stats(&stats);
+        result->writer_programmed = stats.bytes_programmed;
+    }
+    result->bytes_programmed = emu.dev.stats.bytes_programmed;
+    result->erase_count = emu.dev.stats.erase_count;
+    result->busy_time_us = emu.dev.stats.busy_time_us;
+
+    // 3) Every byte is there after a remount, as after a reset
+    struct lfs_info info;
+    if (lfs_unmount_filesystem() != ESP_OK || lfs_mount_filesystem(false) != ESP_OK ||
+        lfs_stat(&lfs, filename, &info) < 0 || info.size != header_size + result->bytes_appended) {
+        fprintf(stderr, "%s: %s has %lu bytes after a remount, expected %llu\n", tc->name, filename,
+                (unsigned long)info.size, header_size + result->bytes_appended);
+        failed = 1;
+    }
+    block_device_emu_wear_t wear;
+    block_device_emu_get_wear(&emu, &wear);
+    if (wear.dirty_prog_count != 0) {
+        fprintf(stderr, "%s: %lu programs of pages that were not erased\n", tc->name, wear.dirty_prog_count);
+        failed = 1;
+    }
+
+cleanup:
+    lfs_unmount_filesystem();
+    block_device_emu_destroy(&emu);
+    return failed;
+}
+
+/* Fix lost after TEST_POLL_FIXES records: no more appends, only the poll of every tracking tick */
+static int test_poll_age(void) {
+    block_device_emu_t emu;
+    block_device_emu_config_t config = BLOCK_DEVICE_EMU_W25Q128JV_CONFIG();
+    char filename[LFS_MAX_FILE_NAME_SIZE];
+    track_writer_stats_t stats;
+    struct lfs_info info;
+    gps_fix_t fix;
+    char line[96];
+    size_t appended = 0;
+    int failed = 0;
+
+    if (block_device_emu_create_ram(&emu, &config) != ESP_OK || lfs_set_block_device(&emu.dev) != ESP_OK ||
+        test_format(&emu.dev) != ESP_OK ||
+        lfs_create_new_file(TEST_FILE_PREFIX, ".csv", TEST_CSV_HEADER, strlen(TEST_CSV_HEADER),
+                            filename, sizeof(filename)) != ESP_OK) {
+        fprintf(stderr, "poll: no track file on the emulator\n");
+        block_device_emu_destroy(&emu);
+        return 1;
+    }
+    const track_writer_flush_policy_t policy = { .max_records = 0, .max_age_ms = TEST_POLL_AGE_MS };
+    track_writer_set_flush_policy(&policy);
+    if (track_writer_open(filename) != ESP_OK) {
+        fprintf(stderr, "poll: track writer not opened\n");
+        failed = 1;
+        goto cleanup;
+    }
+
+    for (uint32_t n = 0; n < TEST_POLL_FIXES; n++) {
+        test_make_fix(&fix, n);
+        size_t len = test_csv_line(line, sizeof(line), &fix);
+        appended += len;
+        failed |= track_writer_append(line, len) != ESP_OK;
+    }
+    failed |= track_writer_poll() != ESP_OK;
+    track_writer_get_stats(&stats);
+    uint32_t syncs_before = stats.syncs;
+
+    vTaskDelay(pdMS_TO_TICKS(TEST_POLL_AGE_MS + 10));
+    failed |= track_writer_poll() != ESP_OK;
+    track_writer_get_stats(&stats);
+
+    // Committed without closing: the size on flash already has the records, as after a reset
+    if (lfs_stat(&lfs, filename, &info) < 0) {
+        info.size = 0;
+    }
+    printf("%-30s %lu commits before %d ms, %lu after, %lu of %lu bytes on flash\n", "poll after the fix is lost",
+           syncs_before, TEST_POLL_AGE_MS, stats.syncs, (unsigned long)info.size,
+           (unsigned long)(strlen(TEST_CSV_HEADER) + appended));
+    if (failed || syncs_before != 0 || stats.syncs != 1 || info.size != strlen(TEST_CSV_HEADER) + appended) {
+        fprintf(stderr, "poll: records not committed by the max-age\n");
+        failed = 1;
+    }
+    track_writer_close();
+
+cleanup:
+    lfs_unmount_filesystem();
+    block_device_emu_destroy(&emu);
+    return failed;
+}
+
+static void test_print_result(const test_case_t *tc, const test_result_t *r) {
+    uint32_t fixes = r->fixes ? r->fixes : 1;
+    printf("%-30s %5lu fixes, %3llu B/fix appended, %5llu B/fix programmed (x%.1f), %6.3f erases/fix, "
+           "%5llu us/fix flash time\n", tc->name, r->fixes, r->bytes_appended / fixes, r->bytes_programmed / fixes,
+           r->bytes_appended ? (double)r->bytes_programmed / r->bytes_appended : 0.0,
+           (double)r->erase_count / fixes, r->busy_time_us / fixes);
+}
+
+int main(int argc, char **argv) {
+    uint32_t fixes = 3600;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        switch (opt) {
+            case 'n': fixes = strtoul(optarg, NULL, 10); break;
+            default:
+                fprintf(stderr, "Usage: %s [-n fixes]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (fixes == 0) {
+        fprintf(stderr, "At least 1 fix\n");
+        return 2;
+    }
+
+    static const test_case_t cases[] = {
+        { "open/append/close per fix",  TEST_WRITE_APPEND_CLOSE, 0,                 false },
+        { "writer, commit every fix",   TEST_WRITE_TRACK_WRITER, 1,                 false },
+        { "writer, commit every 60",    TEST_WRITE_TRACK_WRITER, TEST_COMMIT_FIXES, false },
+        { "writer, 16 byte records",    TEST_WRITE_TRACK_WRITER, TEST_COMMIT_FIXES, true },
+    };
+    test_result_t results[sizeof(cases) / sizeof(cases[0])];
+
+    int failed = 0;
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        failed += test_run_case(&cases[i], fixes, &results[i]);
+        test_print_result(&cases[i], &results[i]);
+        if (cases[i].write == TEST_WRITE_TRACK_WRITER && results[i].writer_programmed > results[i].bytes_programmed) {
+            fprintf(stderr, "%s: track writer counted %llu bytes programmed, the flash %llu\n", cases[i].name,
+                    results[i].writer_programmed, results[i].bytes_programmed);
+            failed++;
+        }
+    }
+
+    // Same CSV payload, the batched writer must program a fraction of open/append/close per fix
+    if (results[2].bytes_programmed * TEST_MIN_GAIN > results[0].bytes_programmed) {
+        fprintf(stderr, "%s programs %llu bytes, not %dx less than %s (%llu)\n", cases[2].name,
+                results[2].bytes_programmed, TEST_MIN_GAIN, cases[0].name, results[0].bytes_programmed);
+        failed++;
+    }
+    failed += test_poll_age();
+
+    const track_writer_flush_policy_t default_policy = {
+        .max_records = TRACK_WRITER_SYNC_MAX_RECORDS,
+        .max_age_ms = TRACK_WRITER_SYNC_MAX_AGE_MS,
+    };
+    track_writer_set_flush_policy(&default_policy);
+
+    if (failed) {
+        fprintf(stderr, "%d write amplification cases failed\n", failed);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,264 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#include "track_writer.h"
+#include "esp_timer.h"
+
+_Static_assert(TRACK_WRITER_BATCH_SIZE % LFS_PROG_SIZE == 0, "Track writer batch must be a multiple of LFS_PROG_SIZE");
+
+static const char *TAG = "TRACK_WRITER";
+
+static lfs_file_t track_file;
+static bool track_file_open = false;
+static char track_file_name[LFS_MAX_FILE_NAME_SIZE] = {0};
+
+/* Modification time (HTTP ETag) and sync state (manifest), written by LittleFS with every sync */
+static uint32_t track_file_mtime = 0;
+static lfs_file_sync_attr_t track_file_sync = {0};
+static struct lfs_attr track_file_attrs[] = {
+    { .type = LFS_ATTR_MTIME, .buffer = &track_file_mtime, .size = sizeof(track_file_mtime) },
+    { .type = LFS_ATTR_SYNC, .buffer = &track_file_sync, .size = sizeof(track_file_sync) },
+};
+static const struct lfs_file_config track_file_config = {
+    .attrs = track_file_attrs,
+    .attr_count = sizeof(track_file_attrs) / sizeof(track_file_attrs[0]),
+};
+
+static uint8_t batch[TRACK_WRITER_BATCH_SIZE];
+static size_t batch_len = 0;
+
+static track_writer_flush_policy_t flush_policy = {
+    .max_records = TRACK_WRITER_SYNC_MAX_RECORDS,
+    .max_age_ms = TRACK_WRITER_SYNC_MAX_AGE_MS,
+};
+static uint32_t records_since_sync = 0;
+static int64_t first_unsynced_time_us = 0;
+
+static track_writer_stats_t stats = {0};
+static lfs_io_stats_t io_stats_at_open = {0};
+
+/* Hands the batch to LittleFS. Full batches are page aligned, so LittleFS programs whole pages. */
+static esp_err_t track_writer_write_batch(void) {
+
+    if (batch_len == 0) {
+        return ESP_OK;
+    }
+
+    lfs_ssize_t written = lfs_file_write(&lfs, &track_file, batch, batch_len);
+    if (written < 0 || (size_t)written != batch_len) {
+        ESP_LOGE(TAG, "Failed to write %u bytes to %s (%d)", (unsigned)batch_len, track_file_name, (int)written);
+        return ESP_FAIL;
+    }
+
+    track_file_sync.crc32 = lfs_crc32_update(track_file_sync.crc32, batch, batch_len);
+    track_file_sync.crc_size += batch_len;
+    batch_len = 0;
+    return ESP_OK;
+}
+
+/* Writes the batch and commits data + metadata, so the records survive a reset */
+static esp_err_t track_writer_sync(void) {
+
+    ESP_RETURN_ON_ERROR(track_writer_write_batch(), TAG, "Failed to write batch");
+
+    if (records_since_sync == 0) {
+        return ESP_OK; // Nothing new to commit
+    }
+
+    track_file_sync.cursor = lfs_next_sync_cursor();
+    int err = lfs_file_sync(&lfs, &track_file);
+    if (err < 0) {
+        ESP_LOGE(TAG, "Failed to sync %s (%d)", track_file_name, err);
+        return ESP_FAIL;
+    }
+
+    stats.syncs++;
+    records_since_sync = 0;
+    return ESP_OK;
+}
+
+static bool track_writer_sync_due(void) {
+
+    if (flush_policy.max_records > 0 && records_since_sync >= flush_policy.max_records) {
+        return true;
+    }
+    if (flush_policy.max_age_ms > 0 &&
+        (esp_timer_get_time() - first_unsynced_time_us) >= (int64_t)flush_policy.max_age_ms * 1000) {
+        return true;
+    }
+    return false;
+}
+
+static void track_writer_update_io_stats(void) {
+    lfs_io_stats_t io_stats;
+    lfs_get_io_stats(&io_stats);
+    stats.bytes_programmed = io_stats.bytes_programmed - io_stats_at_open.bytes_programmed;
+    stats.blocks_erased = io_stats.erase_count - io_stats_at_open.erase_count;
+}
+
+static void track_writer_log_stats(void) {
+    track_writer_update_io_stats();
+    ESP_LOGI(TAG, "%s: %lu records, %llu bytes appended, %llu bytes programmed (%llu per fix), %lu erases, %lu syncs",
+             track_file_name,
+             stats.records,
+             stats.bytes_appended,
+             stats.bytes_programmed,
+             stats.records ? stats.bytes_programmed / stats.records : 0,
+             stats.blocks_erased,
+             stats.syncs);
+}
+
+esp_err_t track_writer_open(const char *filename) {
+
+    if (filename == NULL || strlen(filename) == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (track_file_open) {
+        ESP_RETURN_ON_ERROR(track_writer_close(), TAG, "Failed to close previous track file");
+    }
+
+    // Write-only files do not load their attributes, keep the stored mtime until the first append sets a new one
+    if (lfs_getattr(&lfs, filename, LFS_ATTR_MTIME, &track_file_mtime, sizeof(track_file_mtime)) != sizeof(track_file_mtime)) {
+        track_file_mtime = 0;
+    }
+    // CRC of the existing data, continued with every batch
+    esp_err_t ret = lfs_get_file_sync_attr(filename, &track_file_sync);
+    if (ret == ESP_ERR_NOT_FOUND) {
+        memset(&track_file_sync, 0, sizeof(track_file_sync));
+    } else {
+        ESP_RETURN_ON_ERROR(ret, TAG, "Failed to get sync state of %s", filename);
+    }
+
+    int err = lfs_file_opencfg(&lfs, &track_file, filename, LFS_O_WRONLY | LFS_O_CREAT | LFS_O_APPEND, &track_file_config);
+    if (err < 0) {
+        ESP_LOGE(TAG, "Failed to open %s for appending (%d)", filename, err);
+        return ESP_FAIL;
+    }
+
+    strncpy(track_file_name, filename, sizeof(track_file_name) - 1);
+    track_file_name[sizeof(track_file_name) - 1] = '\0';
+    track_file_open = true;
+    batch_len = 0;
+    records_since_sync = 0;
+
+    memset(&stats, 0, sizeof(stats));
+    lfs_get_io_stats(&io_stats_at_open);
+
+    ESP_LOGI(TAG, "Opened track file %s", track_file_name);
+    return ESP_OK;
+}
+
+esp_err_t track_writer_append(const void *data, size_t len) {
+
+    if (!track_file_open) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    int64_t start_us = esp_timer_get_time();
+    if (records_since_sync == 0) {
+        first_unsynced_time_us = start_us;
+    }
+
+    /* Fill the batch up to the page boundary, splitting the record if needed */
+    const uint8_t *src = data;
+    size_t remaining = len;
+    while (remaining > 0) {
+        size_t chunk = sizeof(batch) - batch_len;
+        if (chunk > remaining) {
+            chunk = remaining;
+        }
+        memcpy(batch + batch_len, src, chunk);
+        batch_len += chunk;
+        src += chunk;
+        remaining -= chunk;
+
+        if (batch_len == sizeof(batch)) {
+            ESP_RETURN_ON_ERROR(track_writer_write_batch(), TAG, "Failed to write batch");
+        }
+    }
+
+    stats.records++;
+    stats.bytes_appended += len;
+    records_since_sync++;
+
+    if (track_writer_sync_due()) {
+        ESP_RETURN_ON_ERROR(track_writer_sync(), TAG, "Failed to commit track file");
+        ESP_LOGD(TAG, "Committed %s after %lu records", track_file_name, stats.records);
+    }
+
+    metrics_observe(METRICS_LFS_APPEND_US, (uint32_t)(esp_timer_get_time() - start_us));
+    return ESP_OK;
+}
+
+esp_err_t track_writer_poll(void) {
+
+    if (!track_file_open || records_since_sync == 0 || !track_writer_sync_due()) {
+        return ESP_OK;
+    }
+
+    ESP_RETURN_ON_ERROR(track_writer_sync(), TAG, "Failed to commit track file");
+    ESP_LOGD(TAG, "Committed %s after %lu records, no record for %lu ms", track_file_name, stats.records,
+             flush_policy.max_age_ms);
+    return ESP_OK;
+}
+
+esp_err_t track_writer_flush(void) {
+
+    if (!track_file_open || records_since_sync == 0) {
+        return ESP_OK; // Nothing buffered
+    }
+
+    ESP_RETURN_ON_ERROR(track_writer_sync(), TAG, "Failed to flush track file");
+    track_writer_log_stats();
+    return ESP_OK;
+}
+
+esp_err_t track_writer_close(void) {
+
+    if (!track_file_open) {
+        return ESP_OK;
+    }
+
+    esp_err_t ret = track_writer_write_batch();
+    if (records_since_sync > 0) {
+        track_file_sync.cursor = lfs_next_sync_cursor(); // Closing commits the records
+    }
+
+    // Close even if the write failed, so the file handle is not leaked
+    int err = lfs_file_close(&lfs, &track_file);
+    track_file_open = false;
+    records_since_sync = 0;
+
+    ESP_RETURN_ON_ERROR(ret, TAG, "Failed to write batch before closing");
+    if (err < 0) {
+        ESP_LOGE(TAG, "Failed to close %s (%d)", track_file_name, err);
+        return ESP_FAIL;
+    }
+
+    track_writer_log_stats();
+    return ESP_OK;
+}
+
+void track_writer_set_mtime(uint32_t mtime) {
+    track_file_mtime = mtime;
+}
+
+bool track_writer_is_open(void) {
+    return track_file_open;
+}
+
+void track_writer_set_flush_policy(const track_writer_flush_policy_t *policy) {
+    flush_policy = *policy;
+}
+
+void track_writer_get_stats(track_writer_stats_t *out_stats) {
+    if (track_file_open) {
+        track_writer_update_io_stats();
+    }
+    *out_stats = stats;
+}
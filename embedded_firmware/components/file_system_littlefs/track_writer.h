@@ -0,0 +1,110 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#ifndef TRACK_WRITER_H
+#define TRACK_WRITER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "file_system_littlefs.h"
+#include "metrics/metrics.h"
+
+#define TRACK_WRITER_BATCH_SIZE         (2 * LFS_PROG_SIZE) // RAM batch, must be a multiple of LFS_PROG_SIZE
+#define TRACK_WRITER_SYNC_MAX_RECORDS   60      // Default: commit to flash at least every 60 records...
+#define TRACK_WRITER_SYNC_MAX_AGE_MS    60000   // ...or every 60 s, whatever comes first
+
+/* When buffered records are committed (lfs_file_sync) to flash. 0 disables the condition. */
+typedef struct {
+    uint32_t max_records;   // Commit after this many records since the last commit
+    uint32_t max_age_ms;    // Commit if the oldest uncommitted record is older than this
+} track_writer_flush_policy_t;
+
+typedef struct {
+    uint32_t records;           // Records appended since the file was opened
+    uint32_t syncs;             // Number of lfs_file_sync calls (metadata commits)
+    uint64_t bytes_appended;    // Payload bytes appended since the file was opened
+    uint64_t bytes_programmed;  // Bytes really programmed to flash since the file was opened (data + metadata)
+    uint32_t blocks_erased;     // Blocks erased since the file was opened
+} track_writer_stats_t;
+
+/**
+ * @brief Opens the track file for appending and keeps it open until track_writer_close().
+ *
+ * If another file is already open it is closed first.
+ *
+ * @param filename Name of the track file. It is created if it does not exist.
+ * @return ESP_OK on success, ESP_FAIL if the file can not be opened.
+ */
+esp_err_t track_writer_open(const char *filename);
+
+/**
+ * @brief Appends one record to the track file.
+ *
+ * Data is collected in a RAM batch and handed to LittleFS in full LFS_PROG_SIZE pages.
+ * The file is committed to flash according to the flush policy.
+ *
+ * @param data Record data.
+ * @param len Length of the record in bytes.
+ * @return ESP_OK on success, ESP_ERR_INVALID_STATE if no file is open, ESP_FAIL on write error.
+ */
+esp_err_t track_writer_append(const void *data, size_t len);
+
+/**
+ * @brief Commits the buffered records if the max-age of the flush policy is reached.
+ *
+ * track_writer_append() checks the policy only when a record comes in. Call this on every tracking tick,
+ * also when there is no valid fix, so the last records are committed in time after the fix is lost.
+ *
+ * @return ESP_OK on success (also if no file is open or nothing is due), ESP_FAIL on write error.
+ */
+esp_err_t track_writer_poll(void);
+
+/**
+ * @brief Writes the batch and commits the file to flash. Call it when tracking is paused.
+ *
+ * @return ESP_OK on success (also if no file is open), ESP_FAIL on write error.
+ */
+esp_err_t track_writer_flush(void);
+
+/**
+ * @brief Flushes and closes the track file. Call it when tracking is stopped.
+ *
+ * @return ESP_OK on success (also if no file is open), ESP_FAIL on write error.
+ */
+esp_err_t track_writer_close(void);
+
+/**
+ * @brief Sets the modification time stored with the next commit of the open track file.
+ *
+ * @param mtime Unix time of the newest record.
+ */
+void track_writer_set_mtime(uint32_t mtime);
+
+/**
+ * @brief Returns true if a track file is open.
+ */
+bool track_writer_is_open(void);
+
+/**
+ * @brief Sets when buffered records are committed to flash.
+ *
+ * @param policy New flush policy.
+ */
+void track_writer_set_flush_policy(const track_writer_flush_policy_t *policy);
+
+/**
+ * @brief Gets the statistics of the currently open (or last closed) track file.
+ *
+ * bytes_programmed / records is the write amplification per fix.
+ *
+ * @param stats Pointer to the struct where statistics will be copied.
+ */
+void track_writer_get_stats(track_writer_stats_t *stats);
+
+#endif // TRACK_WRITER_H
@@ -0,0 +1,112 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#include <string.h>
+#include "gps_epoch.h"
+
+#define GPS_EPOCH_FIX_TYPE_3D 3 // GSA fix type: 1 no fix, 2 2D, 3 3D
+
+static bool gps_epoch_same_time(const struct minmea_time *a, const struct minmea_time *b) {
+    return a->hours == b->hours && a->minutes == b->minutes &&
+           a->seconds == b->seconds && a->microseconds == b->microseconds;
+}
+
+static void gps_epoch_publish(gps_epoch_t *epoch) {
+
+    if (!(epoch->have & GPS_EPOCH_HAVE_RMC)) {
+        epoch->stats.dropped++;
+        return;
+    }
+    if (epoch->have == GPS_EPOCH_COMPLETE) {
+        epoch->stats.complete++;
+    } else {
+        epoch->stats.incomplete++;
+    }
+    epoch->published = true;
+    epoch->publish(&epoch->fix, epoch->publish_ctx);
+}
+
+/* Starts a new epoch for a sentence with this time, unless it belongs to the one in progress */
+static bool gps_epoch_enter(gps_epoch_t *epoch, const struct minmea_time *time, int64_t rx_time_us) {
+
+    if (epoch->have != 0 && gps_epoch_same_time(&epoch->fix.time, time)) {
+        return !epoch->published; // Sentences repeated after the publish are ignored
+    }
+
+    gps_epoch_flush(epoch);
+    memset(&epoch->fix, 0, sizeof(epoch->fix));
+    epoch->fix.time = *time;
+    epoch->fix.altitude_dm = GPS_FIX_ALTITUDE_UNKNOWN;
+    epoch->fix.hdop_x100 = GPS_FIX_HDOP_UNKNOWN;
+    epoch->fix.rx_time_us = rx_time_us;
+    epoch->published = false;
+    return true;
+}
+
+static void gps_epoch_publish_if_complete(gps_epoch_t *epoch) {
+    if (epoch->have == GPS_EPOCH_COMPLETE && !epoch->published) {
+        gps_epoch_publish(epoch);
+    }
+}
+
+void gps_epoch_init(gps_epoch_t *epoch, gps_epoch_publish_t publish, void *ctx) {
+    memset(epoch, 0, sizeof(*epoch));
+    epoch->publish = publish;
+    epoch->publish_ctx = ctx;
+}
+
+void gps_epoch_add_rmc(gps_epoch_t *epoch, const nmea_rmc_t *rmc, int64_t rx_time_us) {
+
+    if (!gps_epoch_enter(epoch, &rmc->time, rx_time_us)) {
+        return;
+    }
+    epoch->fix.date = rmc->date;
+    epoch->fix.latitude_e6 = rmc->latitude_e6;
+    epoch->fix.longitude_e6 = rmc->longitude_e6;
+    epoch->fix.speed_mm_s = rmc->speed_mm_s;
+    epoch->fix.course_cdeg = rmc->course_cdeg;
+    epoch->fix.valid = rmc->valid;
+    epoch->have |= GPS_EPOCH_HAVE_RMC;
+    gps_epoch_publish_if_complete(epoch);
+}
+
+void gps_epoch_add_gga(gps_epoch_t *epoch, const nmea_gga_t *gga, int64_t rx_time_us) {
+
+    if (!gps_epoch_enter(epoch, &gga->time, rx_time_us)) {
+        return;
+    }
+    if (gga->fix_quality > 0) { // Altitude and HDOP fields are empty or stale without a fix
+        epoch->fix.altitude_dm = gga->altitude_dm;
+        epoch->fix.hdop_x100 = gga->hdop_x100;
+    }
+    epoch->fix.satellites = gga->satellites;
+    epoch->have |= GPS_EPOCH_HAVE_GGA;
+    gps_epoch_publish_if_complete(epoch);
+}
+
+void gps_epoch_add_gsa(gps_epoch_t *epoch, const struct minmea_sentence_gsa *gsa) {
+
+    if (epoch->have == 0 || epoch->published) {
+        return; // No time in GSA, it only completes the epoch in progress
+    }
+    if (gsa->fix_type < GPS_EPOCH_FIX_TYPE_3D) {
+        epoch->fix.altitude_dm = GPS_FIX_ALTITUDE_UNKNOWN; // 2D fix keeps the last altitude, it is not measured
+    }
+    if (epoch->fix.hdop_x100 == GPS_FIX_HDOP_UNKNOWN && gsa->fix_type >= 2) {
+        epoch->fix.hdop_x100 = gsa->hdop.scale > 0 && gsa->hdop.value >= 0 ?
+                               (uint16_t)((int64_t)gsa->hdop.value * 100 / gsa->hdop.scale) : GPS_FIX_HDOP_UNKNOWN;
+    }
+    epoch->have |= GPS_EPOCH_HAVE_GSA;
+    gps_epoch_publish_if_complete(epoch);
+}
+
+void gps_epoch_flush(gps_epoch_t *epoch) {
+    if (epoch->have != 0 && !epoch->published) {
+        gps_epoch_publish(epoch);
+    }
+    epoch->have = 0;
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#ifndef GPS_EPOCH_H
+#define GPS_EPOCH_H
+
+/*
+ * Fix assembler
+ *
+ * The L96 sends RMC, GGA and GSA once per fix (epoch), in this order. RMC has the position, speed, course and
+ * date, GGA the altitude, HDOP and satellites, GSA the 2D/3D fix type. The assembler collects the sentences of
+ * one epoch into one gps_fix_t and publishes it as soon as all three are there - one fix per epoch.
+ *
+ * RMC and GGA carry the UTC time of the epoch, a sentence with another time starts a new epoch. GSA has no time
+ * and belongs to the epoch in progress, the second GSA (one per constellation) comes after the publish and is
+ * ignored. An epoch that misses a sentence (output mask without GGA/GSA, lost sentence) is published when the
+ * next epoch starts, as long as it has the RMC. Without RMC there is no position, so it is dropped.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "minmea.h"
+#include "gps_fix.h"
+#include "nmea_parser.h"
+
+#define GPS_EPOCH_HAVE_RMC      0x01
+#define GPS_EPOCH_HAVE_GGA      0x02
+#define GPS_EPOCH_HAVE_GSA      0x04
+#define GPS_EPOCH_COMPLETE      (GPS_EPOCH_HAVE_RMC | GPS_EPOCH_HAVE_GGA | GPS_EPOCH_HAVE_GSA)
+
+/**
+ * @brief Callback that receives every assembled fix.
+ *
+ * @note Called from the task that adds the sentences (GPS ingest task), the fix is only valid during the call.
+ */
+typedef void (*gps_epoch_publish_t)(const gps_fix_t *fix, void *ctx);
+
+typedef struct {
+    uint32_t complete;          // Fixes published with RMC, GGA and GSA
+    uint32_t incomplete;        // Fixes published without GGA or GSA
+    uint32_t dropped;           // Epochs without RMC
+} gps_epoch_stats_t;
+
+typedef struct {
+    gps_epoch_publish_t publish;
+    void *publish_ctx;
+
+    gps_fix_t fix;              // Epoch in progress
+    uint8_t have;               // GPS_EPOCH_HAVE_* of the epoch in progress, 0 if there is none
+    bool published;             // Epoch in progress was already published
+
+    gps_epoch_stats_t stats;
+} gps_epoch_t;
+
+/**
+ * @brief Initializes the assembler, there is no epoch in progress after it.
+ *
+ * @param epoch Assembler to initialize.
+ * @param publish Called with every assembled fix.
+ * @param ctx Passed to publish.
+ */
+void gps_epoch_init(gps_epoch_t *epoch, gps_epoch_publish_t publish, void *ctx);
+
+/**
+ * @brief Adds a parsed RMC sentence.
+ *
+ * @param rx_time_us esp_timer time when the sentence was received, the fix keeps the one of its first sentence.
+ */
+void gps_epoch_add_rmc(gps_epoch_t *epoch, const nmea_rmc_t *rmc, int64_t rx_time_us);
+
+/**
+ * @brief Adds a parsed GGA sentence.
+ */
+void gps_epoch_add_gga(gps_epoch_t *epoch, const nmea_gga_t *gga, int64_t rx_time_us);
+
+/**
+ * @brief Adds a parsed GSA sentence to the epoch in progress.
+ */
+void gps_epoch_add_gsa(gps_epoch_t *epoch, const struct minmea_sentence_gsa *gsa);
+
+/**
+ * @brief Publishes the epoch in progress if it has an RMC and was not published yet, and ends it.
+ *
+ * Call it when no more sentences will come (GPS stopped), so the last fix is not kept back.
+ */
+void gps_epoch_flush(gps_epoch_t *epoch);
+
+#endif // GPS_EPOCH_H
@@ -0,0 +1,37 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#ifndef GPS_FIX_H
+#define GPS_FIX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "minmea.h"
+
+#define GPS_FIX_ALTITUDE_UNKNOWN    INT32_MIN   // altitude_dm value when the altitude is not known
+#define GPS_FIX_HDOP_UNKNOWN        UINT16_MAX  // hdop_x100 value when the HDOP is not known
+
+/**
+ * @brief One GPS fix as published by the GPS ingest task.
+ *
+ * All values are fixed point integers, so the fix can be stored and compared without float math.
+ */
+typedef struct {
+    struct minmea_date date;    // Full year (e.g. 2025), month, day
+    struct minmea_time time;    // UTC time
+    int32_t latitude_e6;        // Latitude in microdegrees, positive is north
+    int32_t longitude_e6;       // Longitude in microdegrees, positive is east
+    uint32_t speed_mm_s;        // Speed over ground in mm/s
+    uint16_t course_cdeg;       // Course over ground in 0.01 degrees
+    int32_t altitude_dm;        // Altitude above mean sea level in 0.1 m, GPS_FIX_ALTITUDE_UNKNOWN if not known
+    uint16_t hdop_x100;         // Horizontal dilution of precision * 100, GPS_FIX_HDOP_UNKNOWN if not known
+    uint8_t satellites;         // Satellites used in the fix, 0 if not known
+    bool valid;                 // RMC status 'A' - module has a valid fix
+    int64_t rx_time_us;         // esp_timer time when the line with this fix was received from UART
+} gps_fix_t;
+
+#endif // GPS_FIX_H
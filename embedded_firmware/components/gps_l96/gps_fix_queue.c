@@ -0,0 +1,47 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#include "gps_fix_queue.h"
+#include <string.h>
+
+void gps_fix_queue_init(gps_fix_queue_t *queue) {
+    memset(queue->slots, 0, sizeof(queue->slots));
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->tail, 0);
+    queue->dropped = 0;
+}
+
+bool gps_fix_queue_push(gps_fix_queue_t *queue, const gps_fix_t *fix) {
+    unsigned int head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    unsigned int tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+
+    if (head - tail >= GPS_FIX_QUEUE_SIZE) {
+        queue->dropped++;
+        return false; // Full - consumer is behind
+    }
+
+    queue->slots[head & (GPS_FIX_QUEUE_SIZE - 1)] = *fix;
+
+    // Release: slot content must be visible before the consumer sees the new head
+    atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+    return true;
+}
+
+bool gps_fix_queue_pop(gps_fix_queue_t *queue, gps_fix_t *fix) {
+    unsigned int tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    unsigned int head = atomic_load_explicit(&queue->head, memory_order_acquire);
+
+    if (tail == head) {
+        return false; // Empty
+    }
+
+    *fix = queue->slots[tail & (GPS_FIX_QUEUE_SIZE - 1)];
+
+    // Release: slot must be copied out before the producer can reuse it
+    atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+    return true;
+}
@@ -0,0 +1,50 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#ifndef GPS_FIX_QUEUE_H
+#define GPS_FIX_QUEUE_H
+
+#include <stdatomic.h>
+#include "gps_fix.h"
+
+#define GPS_FIX_QUEUE_SIZE 8 // Must be a power of two. At 1 Hz this is 8 seconds of fixes.
+
+/**
+ * @brief Lock-free single-producer/single-consumer queue of GPS fixes.
+ *
+ * The GPS ingest task is the only producer and the state machine task is the only consumer,
+ * so only head (written by producer) and tail (written by consumer) need to be atomic.
+ */
+typedef struct {
+    gps_fix_t slots[GPS_FIX_QUEUE_SIZE];
+    atomic_uint head;       // Next slot to write - only producer writes it
+    atomic_uint tail;       // Next slot to read - only consumer writes it
+    uint32_t dropped;       // Fixes dropped because the queue was full - only producer writes it
+} gps_fix_queue_t;
+
+/**
+ * @brief Resets the queue to empty.
+ *
+ * @note Call only when neither producer nor consumer is running.
+ */
+void gps_fix_queue_init(gps_fix_queue_t *queue);
+
+/**
+ * @brief Pushes a fix into the queue (producer side).
+ *
+ * @return true on success, false if the queue is full and the fix was dropped.
+ */
+bool gps_fix_queue_push(gps_fix_queue_t *queue, const gps_fix_t *fix);
+
+/**
+ * @brief Pops the oldest fix from the queue (consumer side).
+ *
+ * @return true if a fix was copied to `fix`, false if the queue is empty.
+ */
+bool gps_fix_queue_pop(gps_fix_queue_t *queue, gps_fix_t *fix);
+
+#endif // GPS_FIX_QUEUE_H
@@ -0,0 +1,75 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#include "gps_ingest.h"
+#include "gps_l96.h"
+
+static const char *TAG = "GPS_INGEST";
+static TaskHandle_t gps_ingest_task_handle = NULL;
+
+static void gps_ingest_task(void *pvParameters) {
+
+    static uint8_t line_buffer[GPS_INGEST_LINE_BUF_SIZE];
+    QueueHandle_t uart_queue = uart_get_event_queue();
+    uart_event_t event;
+    size_t read_len = 0;
+
+    while (true) {
+        /* Sleep until the UART driver has something for us, wake up now and then to notice a silent module */
+        if (xQueueReceive(uart_queue, &event, pdMS_TO_TICKS(GPS_INGEST_LINK_CHECK_MS)) != pdTRUE) {
+            gps_l96_check_link();
+            continue;
+        }
+
+        switch (event.type) {
+            case UART_PATTERN_DET:
+                /* Complete line is ready */
+                if (uart_read_line(line_buffer, sizeof(line_buffer), &read_len) == ESP_OK) {
+                    gps_l96_extract_and_process_nmea_sentences(line_buffer, read_len);
+                }
+                break;
+
+            case UART_FIFO_OVF:
+            case UART_BUFFER_FULL:
+                /* We were too slow, data is lost - start clean with the next sentence */
+                ESP_LOGW(TAG, "UART RX overflow (event %d), dropping buffered data", event.type);
+                uart_reset_rx();
+                gps_l96_reset_nmea_framer();
+                break;
+
+            case UART_DATA:
+                /* Partial line - wait for the line end */
+                break;
+
+            default:
+                ESP_LOGD(TAG, "Unhandled UART event %d", event.type);
+                break;
+        }
+        gps_l96_check_link();
+    }
+}
+
+esp_err_t gps_ingest_start(void) {
+
+    if (gps_ingest_task_handle != NULL) {
+        return ESP_OK; // Already running
+    }
+
+    if (uart_get_event_queue() == NULL) {
+        ESP_LOGE(TAG, "UART is not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (xTaskCreate(gps_ingest_task, "gps_ingest_task", GPS_INGEST_TASK_STACK_SIZE, 
+                    NULL, GPS_INGEST_TASK_PRIORITY, &gps_ingest_task_handle) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create GPS ingest task");
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "GPS ingest task started");
+    return ESP_OK;
+}
@@ -0,0 +1,33 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#ifndef GPS_INGEST_H
+#define GPS_INGEST_H
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_err.h"
+
+#define GPS_INGEST_TASK_STACK_SIZE 4096
+#define GPS_INGEST_TASK_PRIORITY   3    // Above state machine (1) and LED task (2), so lines are read as soon as they arrive
+#define GPS_INGEST_LINE_BUF_SIZE   256  // One NMEA line is max 82 bytes, bigger buffer only helps after pattern queue overflow
+#define GPS_INGEST_LINK_CHECK_MS   1000 // Longest sleep without a UART event, see gps_l96_check_link()
+
+/**
+ * @brief Starts the GPS ingest task.
+ *
+ * The task sleeps on the UART event queue and wakes up only when the UART driver detects a '\n'.
+ * It reads the line, passes it to the NMEA framer/parser and the parser publishes fixes
+ * into the fix queue (see gps_l96_get_next_fix()).
+ * After every event, and every GPS_INGEST_LINK_CHECK_MS without one, it runs gps_l96_check_link().
+ *
+ * @note UART must be initialized before calling this function. Calling it again does nothing.
+ * @return ESP_OK on success, or an error code on failure.
+ */
+esp_err_t gps_ingest_start(void);
+
+#endif // GPS_INGEST_H
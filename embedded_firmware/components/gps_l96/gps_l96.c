@@ -6,9 +6,36 @@
  */
 
 #include "gps_l96.h"
+#include "gps_ingest.h"
 static const char *TAG = "GPS_L96";
 
-struct minmea_sentence_rmc gps_rcm_data; // GPS RMC data structure to hold parsed data
+struct minmea_sentence_rmc gps_rcm_data; // RMC parsed by minmea (when the fast parser refuses it)
+static struct minmea_sentence_gga gps_gga_data;
+static struct minmea_sentence_gsa gps_gsa_data;
+static gps_epoch_t gps_epoch; // Groups RMC, GGA and GSA of one epoch into one fix
+
+static nmea_framer_t nmea_framer; // Keeps partial NMEA sentences between UART reads
+static bool nmea_framer_initialized = false;
+static int64_t nmea_rx_time_us = 0; // Time when the UART data that is being parsed was received
+
+static gps_fix_queue_t gps_fix_queue;  // Fixes from GPS ingest task (producer) to state machine (consumer)
+static gps_fix_t gps_current_fix = {0}; // Last fix taken from the queue by the consumer
+static volatile gps_fix_listener_t gps_fix_listener = NULL; // Gets every fix after it is queued
+
+static void gps_l96_publish_fix(const gps_fix_t *fix, void *ctx);
+static esp_err_t gps_l96_send_commands(const char *const *commands, size_t count);
+
+/* Rates the module is probed at after the current one - fast first, the module keeps it until a reset */
+static const uint32_t gps_baud_rates[] = { UART_BAUD_RATE_FAST, UART_BAUD_RATE, 57600, 38400, 19200, 4800 };
+
+/* Link watch - a module reset while recording comes back at its default baud rate and output settings */
+static SemaphoreHandle_t gps_mode_mutex = NULL;     // Mode commands and baud rate sync, recursive (commands re-sync on timeout)
+static TaskHandle_t gps_link_task_handle = NULL;    // Re-syncs when the ingest task sees no valid sentences
+static volatile bool gps_recording = false;         // Sentences are expected every second
+static int64_t gps_last_sentence_us = 0;            // Last valid sentence (ingest task only)
+static uint32_t gps_error_run = 0;                  // Framing and checksum errors since it (ingest task only)
+static int64_t gps_last_resync_us = 0;              // Last re-sync request (ingest task only)
+static void gps_l96_link_task(void *pvParameters);
 
 static esp_err_t gps_nvs_save_session_status(char* filename, size_t filename_size, bool completed_normally);
 static esp_err_t gps_nvs_load_session_status(char* filename, size_t filename_size, bool *completed_normally);
@@ -19,23 +46,43 @@ esp_err_t gps_l96_init(void) {
     ESP_RETURN_ON_ERROR(uart_init(), 
                         TAG, "Failed to initialize UART for GPS L96");
 
+    /* Command acks come in with the NMEA stream, the channel must be there before the ingest task */
+    ESP_RETURN_ON_ERROR(gps_pmtk_init(), 
+                        TAG, "Failed to initialize GPS command channel");
+
+    /* Re-sync runs in its own task, it waits for acks the ingest task reads */
+    gps_mode_mutex = xSemaphoreCreateRecursiveMutex();
+    if (gps_mode_mutex == NULL || xTaskCreate(gps_l96_link_task, "gps_link_task", GPS_L96_LINK_TASK_STACK_SIZE,
+                                              NULL, GPS_L96_LINK_TASK_PRIORITY, &gps_link_task_handle) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to start GPS link task");
+        return ESP_ERR_NO_MEM;
+    }
+
+    /* Start reading GPS data in its own task - fixes are taken with gps_l96_get_next_fix() */
+    gps_fix_queue_init(&gps_fix_queue);
+    ESP_RETURN_ON_ERROR(gps_ingest_start(), 
+                        TAG, "Failed to start GPS ingest task");
+
+    gps_pmtk_expect_boot();
     gpio_reset_gps(); 
 
-    /*Delay so that GPS module can initialize properly - MUST have.*/ 
-    vTaskDelay(pdMS_TO_TICKS(GPS_L96_INIT_WAIT_TIME_MS));
+    /* Wait until the module has booted - commands are retried anyway, so a missed boot message only costs the timeout */
+    if (gps_pmtk_wait_boot(GPS_PMTK_BOOT_TIMEOUT_MS) != ESP_OK) {
+        ESP_LOGW(TAG, "No boot message from GPS module, sending commands anyway");
+    }
+
+    /* Module starts at its default baud rate, switch to the fast one before the sentences start to flow */
+    if (gps_l96_sync_baud_rate() != ESP_OK) {
+        ESP_LOGW(TAG, "GPS baud rate not set up, staying at %lu bps", uart_get_baud_rate());
+    }
 
     /*Enable Easy Mode - it stores the last position so on next gps start it gets fix faster*/
-    ESP_RETURN_ON_ERROR(gps_l96_send_command(GNSS_ENABLE_EASY), 
+    static const char *const init_commands[] = { GNSS_ENABLE_EASY };
+    ESP_RETURN_ON_ERROR(gps_l96_send_commands(init_commands, 1), 
                         TAG, 
                         "Failed to send GNSS_ENABLE_EASY command");
 
-    vTaskDelay(pdMS_TO_TICKS(GPS_L96_INIT_WAIT_TIME_MS));
-
-    ESP_RETURN_ON_ERROR(gps_l96_send_command(GNSS_SET_UPDATE_RATE_1HZ), 
-                        TAG, 
-                        "Failed to send GNSS_SET_UPDATE_RATE_1HZ command");
-
-    gps_l96_start_recording();
+    gps_l96_start_recording(); // Also sets the update rate
 
     ESP_RETURN_ON_ERROR(nvs_flash_init(), 
                         TAG, "Failed to initialize NVS flash");
@@ -52,38 +99,46 @@ bool gps_l96_is_geo_fence_triggered(void) {
 
 esp_err_t gps_l96_go_to_standby_mode(void) {
 
-    ESP_RETURN_ON_ERROR(gps_force_on_set(true), TAG, "Failed to set FORCE_ON pin");  // Set FORCE_ON pin to high (in case we are in deep sleep mode)
-    ESP_RETURN_ON_ERROR(gps_l96_send_command(GPS_STAND_BY_MODE), TAG, "Failed to send GPS_STAND_BY_MODE command");
+    xSemaphoreTakeRecursive(gps_mode_mutex, portMAX_DELAY);
+    gps_recording = false;
+    esp_err_t ret = gps_force_on_set(true); // Set FORCE_ON pin to high (in case we are in deep sleep mode)
+    if (ret == ESP_OK) {
+        static const char *const standby_commands[] = { GPS_STAND_BY_MODE };
+        ret = gps_l96_send_commands(standby_commands, 1);
+    }
+    xSemaphoreGiveRecursive(gps_mode_mutex);
+
+    ESP_RETURN_ON_ERROR(ret, TAG, "Failed to send GPS_STAND_BY_MODE command");
     return ESP_OK;
 }
 
 esp_err_t gps_l96_start_recording(void) {
 
-    gps_force_on_set(true); //Crucial to set it to HIGH
-
-    
-    ESP_RETURN_ON_ERROR(gps_l96_send_command(GNSS_MODE_GPS_GLONASS), 
-                        TAG, 
-                        "Failed to send GNSS_MODE_GPS_GLONASS command");
+    static const char *const recording_commands[] = {
+        GNSS_MODE_GPS_GLONASS,
+        GNSS_SET_UPDATE_RATE_1HZ,
+        GNSS_OUTPUT_RMC_GGA_GSA,
+    };
 
-    vTaskDelay(1000 / portTICK_PERIOD_MS); // TODO: check if this is needed
+    xSemaphoreTakeRecursive(gps_mode_mutex, portMAX_DELAY);
+    gps_recording = true; // Also when the commands fail, the link task tries again
+    gps_force_on_set(true); //Crucial to set it to HIGH
 
-    ESP_RETURN_ON_ERROR(gps_l96_send_command(GNSS_SET_UPDATE_RATE_1HZ), 
-                        TAG, 
-                        "Failed to send GNSS_SET_UPDATE_RATE_1HZ command");
-   
-    vTaskDelay(1000 / portTICK_PERIOD_MS); // TODO: check if this is needed
+    // Each command goes out as soon as the previous one is acknowledged - a module still waking up is covered by the retries
+    esp_err_t ret = gps_l96_send_commands(recording_commands, sizeof(recording_commands) / sizeof(recording_commands[0]));
+    xSemaphoreGiveRecursive(gps_mode_mutex);
 
-    ESP_RETURN_ON_ERROR(gps_l96_send_command(ONLY_GNRMC), 
-                        TAG, 
-                        "Failed to send ONLY_GNRMC command");
+    ESP_RETURN_ON_ERROR(ret, TAG, "Failed to send GPS recording commands");
     return ESP_OK;
 }
 
 esp_err_t gps_l96_go_to_back_up_mode(void) { // same as deep sleep mode
+    xSemaphoreTakeRecursive(gps_mode_mutex, portMAX_DELAY);
+    gps_recording = false;
     gps_force_on_set(false); 
     //note: we can't check if if was send succesfull because gps modeule goes into deep sleep and it does not respond to any commands
     gps_l96_send_command(GPS_DEEP_SLEEP_MODE); 
+    xSemaphoreGiveRecursive(gps_mode_mutex);
     
     return ESP_OK;
 }
@@ -97,6 +152,74 @@ esp_err_t gps_l96_send_command(const char *nmea_sentence) {
     return uart_send_cmd(nmea_sentence, strlen(nmea_sentence));
 }
 
+/* A module that does not answer is most likely back at its default baud rate after a reset or power loss */
+static esp_err_t gps_l96_send_commands(const char *const *commands, size_t count) {
+
+    esp_err_t ret = gps_pmtk_send_all(commands, count);
+    if (ret != ESP_ERR_TIMEOUT) {
+        return ret;
+    }
+
+    ESP_LOGW(TAG, "GPS module not answering, checking the baud rate");
+    ESP_RETURN_ON_ERROR(gps_l96_sync_baud_rate(), 
+                        TAG, "GPS module not answering at any baud rate");
+    return gps_pmtk_send_all(commands, count);
+}
+
+static esp_err_t gps_l96_probe_baud_rate(uint32_t baud_rate) {
+
+    if (uart_get_baud_rate() != baud_rate) {
+        ESP_RETURN_ON_ERROR(uart_set_baud_rate(baud_rate), TAG, "Failed to set UART baud rate");
+    }
+    return gps_pmtk_send(GNSS_TEST, GPS_L96_BAUD_PROBE_TIMEOUT_MS, GPS_L96_BAUD_PROBE_RETRIES);
+}
+
+static esp_err_t gps_l96_sync_baud_rate_locked(void);
+
+esp_err_t gps_l96_sync_baud_rate(void) {
+
+    xSemaphoreTakeRecursive(gps_mode_mutex, portMAX_DELAY); // Startup, unacked commands and the link task
+    esp_err_t ret = gps_l96_sync_baud_rate_locked();
+    xSemaphoreGiveRecursive(gps_mode_mutex);
+    return ret;
+}
+
+static esp_err_t gps_l96_sync_baud_rate_locked(void) {
+
+    // 1) Find the rate the module talks at, the current one first - usually nothing has changed
+    const uint32_t initial = uart_get_baud_rate(); // Every probe below changes the UART rate
+    uint32_t found = initial;
+    if (gps_l96_probe_baud_rate(initial) != ESP_OK) {
+        found = 0;
+        for (size_t i = 0; i < sizeof(gps_baud_rates) / sizeof(gps_baud_rates[0]) && found == 0; i++) {
+            if (gps_baud_rates[i] != initial && gps_l96_probe_baud_rate(gps_baud_rates[i]) == ESP_OK) {
+                found = gps_baud_rates[i];
+            }
+        }
+    }
+    if (found == 0) {
+        ESP_LOGE(TAG, "GPS module not found at any baud rate, staying at %lu bps", initial);
+        uart_set_baud_rate(initial);
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (found == UART_BAUD_RATE_FAST) {
+        return ESP_OK;
+    }
+
+    // 2) Switch the module, then follow with the UART - PMTK251 has no ack, the test command confirms the new rate
+    ESP_RETURN_ON_ERROR(gps_l96_send_command(GNSS_SET_BAUD_115200), 
+                        TAG, "Failed to send GNSS_SET_BAUD_115200 command");
+    vTaskDelay(pdMS_TO_TICKS(GPS_L96_BAUD_SWITCH_TIME_MS));
+
+    if (gps_l96_probe_baud_rate(UART_BAUD_RATE_FAST) != ESP_OK) {
+        ESP_LOGW(TAG, "GPS module did not switch to %lu bps, staying at %lu bps", (uint32_t)UART_BAUD_RATE_FAST, found);
+        ESP_RETURN_ON_ERROR(uart_set_baud_rate(found), TAG, "Failed to set UART baud rate");
+        return ESP_OK;
+    }
+    ESP_LOGI(TAG, "GPS baud rate switched from %lu to %lu bps", found, (uint32_t)UART_BAUD_RATE_FAST);
+    return ESP_OK;
+}
+
 void gpio_reset_gps(void) {
     uint8_t state = gpio_expander_get_output_state();
     state &= ~GPS_RESET;
@@ -105,8 +228,7 @@ void gpio_reset_gps(void) {
 
     state |= GPS_RESET;
     gpio_expander_update_output_state(state);
-    vTaskDelay(1000 / portTICK_PERIOD_MS);
-    ESP_LOGI(TAG, "GPS reset done");
+    ESP_LOGI(TAG, "GPS reset done"); // Boot is signalled by the module, see gps_pmtk_wait_boot()
 }
 
 esp_err_t gps_force_on_set(bool enable){
@@ -123,69 +245,174 @@ esp_err_t gps_force_on_set(bool enable){
     return ESP_OK;
 }
 
-esp_err_t gps_l96_extract_and_process_nmea_sentences(const uint8_t *buffer, size_t read_len) {
+static void gps_l96_nmea_sentence_handler(const char *nmea_sentence, void *ctx) {
+    // ESP_LOGI(TAG, "L96 Response: %s", nmea_sentence);
+    gps_last_sentence_us = nmea_rx_time_us; // Checksum is valid, the baud rate is right
+    gps_error_run = 0;
+    if (gps_pmtk_handle_sentence(nmea_sentence)) {
+        return; // Command ack or boot message
+    }
+    gps_l96_extract_data_from_nmea_sentence(nmea_sentence);
+}
 
-    char NMEA_sentence[NMEA_SENTENCE_BUF_SIZE]; // Buffer to hold the sentence/command
-    int sentence_idx = 0;
-    bool reading_sentence = false; // Flag to indicate if we are currently reading a sentence
+esp_err_t gps_l96_extract_and_process_nmea_sentences(uint8_t *buffer, size_t read_len) {
 
     // Check if buffer is ok and it is not empty
     if (buffer == NULL || read_len == 0) {
         ESP_LOGE(TAG, "Invalid buffer or read length");
         return ESP_ERR_INVALID_ARG;
     }
-    // Loop through each byte in the buffer
-    for (size_t buf_idx = 0; buf_idx < read_len; buf_idx++) {
-        char ch = buffer[buf_idx]; 
 
-        // 1. Check for $ and
-        if(ch == '$'){
-            reading_sentence = true; 
-            sentence_idx = 0; 
-        }
+    // Framer keeps the partial sentence between calls, so sentences split between two UART reads are not lost
+    if (!nmea_framer_initialized) {
+        nmea_framer_init(&nmea_framer, gps_l96_nmea_sentence_handler, NULL);
+        gps_epoch_init(&gps_epoch, gps_l96_publish_fix, NULL);
+        nmea_framer_initialized = true;
+    }
 
-        if(reading_sentence) {
+    nmea_rx_time_us = esp_timer_get_time();
+    nmea_framer_stats_t before = nmea_framer.stats;
 
-            // 2. Add character to the sentence buffer
-            if (sentence_idx < (int)sizeof(NMEA_sentence) - 1) { //- only if sentence buffer is not full
-                NMEA_sentence[sentence_idx++] = ch;
-            } else { //Buffer if full
-                ESP_LOGW(TAG, "NMEA sentence buffer overflow.");
-                sentence_idx = 0;
-                reading_sentence = false; 
-            }
+    ESP_RETURN_ON_ERROR(nmea_framer_feed(&nmea_framer, buffer, read_len),
+                        TAG, "Failed to frame NMEA sentences");
 
-            // 3. Check for end of sentence "\n" or "\r\n"
-            if (ch == '\n' && sentence_idx >= 2 && NMEA_sentence[sentence_idx - 2] == '\r') {
-                NMEA_sentence[sentence_idx] = '\0';
+    // Metrics take the difference once per UART read, not once per sentence
+    metrics_add(METRICS_NMEA_SENTENCES, nmea_framer.stats.sentences - before.sentences);
+    metrics_add(METRICS_NMEA_CHECKSUM_ERRORS, nmea_framer.stats.checksum_errors - before.checksum_errors);
+    metrics_add(METRICS_NMEA_FRAMING_ERRORS, nmea_framer.stats.framing_errors - before.framing_errors);
+    metrics_add(METRICS_NMEA_OVERFLOWS, nmea_framer.stats.overflows - before.overflows);
 
-                sentence_idx = 0; 
-                reading_sentence = false; 
+    if (nmea_framer.stats.overflows != before.overflows) {
+        ESP_LOGW(TAG, "NMEA sentence buffer overflow.");
+    }
 
-                // 4. Process the complete NMEA sentence TODO
-                // ESP_LOGI(TAG, "L96 Response: %s", NMEA_sentence);
-                gps_l96_extract_data_from_nmea_sentence(NMEA_sentence); 
-            }
-        }
+    // Only errors in a read is what a wrong baud rate looks like
+    if (nmea_framer.stats.sentences == before.sentences) {
+        gps_error_run += (nmea_framer.stats.checksum_errors - before.checksum_errors) +
+                         (nmea_framer.stats.framing_errors - before.framing_errors);
     }
     return ESP_OK;
-    
+}
+
+void gps_l96_check_link(void) {
+
+    static bool was_recording = false;
+    int64_t now = esp_timer_get_time();
+    bool recording = gps_recording;
+
+    // Silence is counted from the start of recording
+    if (!recording || !was_recording) {
+        was_recording = recording;
+        gps_last_sentence_us = now;
+        gps_error_run = 0;
+        return;
+    }
+
+    bool silent = now - gps_last_sentence_us >= GPS_L96_LINK_SILENCE_S * 1000000LL;
+    bool garbled = gps_error_run >= GPS_L96_LINK_ERROR_RUN;
+    if ((!silent && !garbled) || now - gps_last_resync_us < GPS_L96_LINK_RESYNC_INTERVAL_S * 1000000LL) {
+        return;
+    }
+
+    ESP_LOGW(TAG, "GPS link lost (%lld ms without a valid sentence, %lu errors in a row), re-syncing",
+             (now - gps_last_sentence_us) / 1000, gps_error_run);
+    gps_last_resync_us = now;
+    gps_last_sentence_us = now;
+    gps_error_run = 0;
+    xTaskNotifyGive(gps_link_task_handle);
+}
+
+static void gps_l96_link_task(void *pvParameters) {
+
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        xSemaphoreTakeRecursive(gps_mode_mutex, portMAX_DELAY);
+        if (gps_recording && gps_l96_sync_baud_rate() == ESP_OK) {
+            gps_l96_start_recording(); // A module that was reset also lost its output settings
+        }
+        xSemaphoreGiveRecursive(gps_mode_mutex);
+    }
+}
+
+void gps_l96_get_nmea_stats(nmea_framer_stats_t *stats) {
+    nmea_framer_get_stats(&nmea_framer, stats);
+}
+
+void gps_l96_reset_nmea_framer(void) {
+    nmea_framer_reset(&nmea_framer);
+    gps_epoch_flush(&gps_epoch); // Sentences of this epoch may be lost, publish what is there
+}
+
+void gps_l96_get_epoch_stats(gps_epoch_stats_t *stats) {
+    *stats = gps_epoch.stats;
+}
+
+bool gps_l96_get_next_fix(gps_fix_t *fix) {
+    if (!gps_fix_queue_pop(&gps_fix_queue, fix)) {
+        return false;
+    }
+    gps_current_fix = *fix;
+    return true;
+}
+
+uint32_t gps_l96_discard_fixes(void) {
+    gps_fix_t fix;
+    uint32_t count = 0;
+
+    while (gps_l96_get_next_fix(&fix)) {
+        count++;
+    }
+    return count;
+}
+
+uint32_t gps_l96_get_dropped_fix_count(void) {
+    return gps_fix_queue.dropped;
 }
 
 esp_err_t gps_l96_extract_data_from_nmea_sentence(const char *nmea_sentence) {
 
+    nmea_rmc_t rmc;
+    nmea_gga_t gga;
+
+    // Sentences of every fix go through the fast parser, minmea parses the rest and what the fast parser refuses
+    if (nmea_parse_rmc(nmea_sentence, &rmc)) {
+        gps_epoch_add_rmc(&gps_epoch, &rmc, nmea_rx_time_us);
+        return ESP_OK;
+    }
+    if (nmea_parse_gga(nmea_sentence, &gga)) {
+        gps_epoch_add_gga(&gps_epoch, &gga, nmea_rx_time_us);
+        return ESP_OK;
+    }
+
     enum minmea_sentence_id nmea_id = minmea_sentence_id(nmea_sentence, false);
 
     switch(nmea_id) {
         case MINMEA_SENTENCE_RMC:
-            minmea_parse_rmc(&gps_rcm_data, nmea_sentence);
-            gps_rcm_data.date.year += 2000; // by default GPS module returns year as 0-99, so we add 2000 for correct year
-            //gps_l96_print_data();
+            if (!minmea_parse_rmc(&gps_rcm_data, nmea_sentence)) {
+                ESP_LOGW(TAG, "Failed to parse RMC sentence");
+                break;
+            }
+            nmea_rmc_from_minmea(&gps_rcm_data, &rmc);
+            gps_epoch_add_rmc(&gps_epoch, &rmc, nmea_rx_time_us);
             break;
-        case MINMEA_SENTENCE_VTG:
-            /*TODO: add parsing for all other sentences types
-            Currently I need only RMC sentence*/
+        case MINMEA_SENTENCE_GGA:
+            if (!minmea_parse_gga(&gps_gga_data, nmea_sentence)) {
+                ESP_LOGW(TAG, "Failed to parse GGA sentence");
+                break;
+            }
+            nmea_gga_from_minmea(&gps_gga_data, &gga);
+            gps_epoch_add_gga(&gps_epoch, &gga, nmea_rx_time_us);
+            break;
+        case MINMEA_SENTENCE_GSA:
+            if (!minmea_parse_gsa(&gps_gsa_data, nmea_sentence)) {
+                ESP_LOGW(TAG, "Failed to parse GSA sentence");
+                break;
+            }
+            gps_epoch_add_gsa(&gps_epoch, &gps_gsa_data);
             break;
+        case MINMEA_SENTENCE_VTG:
+            break; // Same speed and course as RMC, disabled in the output mask
         default:
             ESP_LOGW(TAG, "Unknown NMEA sentence ID: %d", nmea_id);
             break; // Ignore sentences with errors
@@ -193,13 +420,30 @@ esp_err_t gps_l96_extract_data_from_nmea_sentence(const char *nmea_sentence) {
     return ESP_OK;
 }
 
-void gps_l96_print_data(void){ // a DEBUG function to print GPS data
-            printf("Time: %02d:%02d:%02d\n", gps_rcm_data.time.hours, gps_rcm_data.time.minutes, gps_rcm_data.time.seconds);
-            printf("Validity: %c\n", gps_rcm_data.valid ? 'A' : 'V');
-            printf("Latitude: %f\n", minmea_tocoord(&gps_rcm_data.latitude));
-            printf("Longitude: %f\n", minmea_tocoord(&gps_rcm_data.longitude));
-            printf("Speed (knots): %f\n", minmea_tofloat(&gps_rcm_data.speed));
-            printf("Date: %02d/%02d/%04d\n", gps_rcm_data.date.day, gps_rcm_data.date.month, gps_rcm_data.date.year);
+/* Called by the fix assembler with every fix, on the GPS ingest task */
+static void gps_l96_publish_fix(const gps_fix_t *fix, void *ctx) {
+
+    if (!gps_fix_queue_push(&gps_fix_queue, fix)) {
+        ESP_LOGD(TAG, "GPS fix queue full, fix dropped"); // Counted in gps_l96_get_dropped_fix_count()
+    }
+
+    gps_fix_listener_t listener = gps_fix_listener; // After the queue, logging does not wait for the listener
+    if (listener != NULL) {
+        listener(fix);
+    }
+}
+
+void gps_l96_set_fix_listener(gps_fix_listener_t listener) {
+    gps_fix_listener = listener;
+}
+
+void gps_l96_print_data(void){ // a DEBUG function to print GPS data (last fix taken with gps_l96_get_next_fix())
+            printf("Time: %02d:%02d:%02d\n", gps_current_fix.time.hours, gps_current_fix.time.minutes, gps_current_fix.time.seconds);
+            printf("Validity: %c\n", gps_current_fix.valid ? 'A' : 'V');
+            printf("Latitude: %ld (1e-6 deg)\n", gps_current_fix.latitude_e6);
+            printf("Longitude: %ld (1e-6 deg)\n", gps_current_fix.longitude_e6);
+            printf("Speed: %lu mm/s\n", gps_current_fix.speed_mm_s);
+            printf("Date: %02d/%02d/%04d\n", gps_current_fix.date.day, gps_current_fix.date.month, gps_current_fix.date.year);
 
 }
 
@@ -347,40 +591,20 @@ static esp_err_t gps_nvs_load_session_status(char *filename, size_t filename_siz
     return ESP_OK;
 }
 
-esp_err_t gps_l96_format_csv_line_from_data(char *file_line, size_t file_line_size) {
-
-    // Format: ISO 8601 timestamp,latitude,longitude,altitude,speed
-    int written = snprintf(file_line, file_line_size,
-        "%04d-%02d-%02dT%02d:%02d:%02dZ,%f,%f,%f,%f\n",
-        gps_rcm_data.date.year,
-        gps_rcm_data.date.month,
-        gps_rcm_data.date.day,
-        gps_rcm_data.time.hours,
-        gps_rcm_data.time.minutes,
-        gps_rcm_data.time.seconds,
-        minmea_tocoord(&gps_rcm_data.latitude),
-        minmea_tocoord(&gps_rcm_data.longitude),
-        minmea_tofloat(&gps_rcm_data.speed),
-        0.0);
-
-    if (written < 0 || (size_t)written >= file_line_size) {
-        ESP_LOGE(TAG, "Failed to format GPS data into file line");
-        return ESP_ERR_NO_MEM;
-    }
-
-    return ESP_OK;
+void gps_l96_get_current_fix(gps_fix_t *fix) {
+    *fix = gps_current_fix;
 }
 
 bool gps_l96_has_fix(void) {
-    return gps_rcm_data.valid;
+    return gps_current_fix.valid;
 }
 
 esp_err_t gps_l96_get_date_string_from_data(char *date_string, size_t date_string_size) {
 
     int written = snprintf(date_string, date_string_size, "%04d-%02d-%02d",
-                           gps_rcm_data.date.year,
-                           gps_rcm_data.date.month,
-                           gps_rcm_data.date.day);
+                           gps_current_fix.date.year,
+                           gps_current_fix.date.month,
+                           gps_current_fix.date.day);
 
     if (written < 0 || (size_t)written >= date_string_size) {
         ESP_LOGE(TAG, "Failed to format date string");
@@ -13,12 +13,28 @@
 #include "../file_system_littlefs/file_system_littlefs.h" 
 #include "uart.h"
 #include "minmea.h"
+#include "nmea_framer.h"
+#include "gps_fix.h"
+#include "gps_fix_queue.h"
+#include "gps_epoch.h"
+#include "gps_pmtk.h"
+#include "esp_timer.h"
+#include "metrics/metrics.h"
 #include "nvs_flash.h"
 #include "nvs.h"
 
-#define GPS_L96_INIT_WAIT_TIME_MS 1000 // Time to wait for GPS module to process init commands
 #define NMEA_SENTENCE_BUF_SIZE 1024 
 
+#define GPS_L96_BAUD_PROBE_TIMEOUT_MS   200 // Ack of GNSS_TEST, the module may be in the middle of a burst of sentences
+#define GPS_L96_BAUD_PROBE_RETRIES      1
+#define GPS_L96_BAUD_SWITCH_TIME_MS     50  // Module needs a moment to reopen the port after PMTK251
+
+#define GPS_L96_LINK_SILENCE_S          5   // No valid sentence while recording (1 Hz output) for this long re-syncs
+#define GPS_L96_LINK_ERROR_RUN          8   // As do this many framing/checksum errors without a valid sentence
+#define GPS_L96_LINK_RESYNC_INTERVAL_S  30  // Min time between re-syncs, a module that is gone is not probed all the time
+#define GPS_L96_LINK_TASK_STACK_SIZE    3072
+#define GPS_L96_LINK_TASK_PRIORITY      1   // Same as the state machine, below the ingest task that reads the acks
+
 /* NVS (Non-Volatile Storage) keys for GPS tracking state */
 #define NVS_NAMESPACE "dog_collar"
 #define NVS_GPS_RECOVERY_STRUCT_KEY "gps_recovery"
@@ -42,20 +58,6 @@ typedef struct {
  */
 esp_err_t gps_l96_init(void);
 
-/**
- * @brief Extracts and processes NMEA sentences from the received buffer.
- *
- * This function scans the provided buffer for NMEA sentences, extracts them,
- * and processes each complete sentence - parses it and stores it into external flash chip.
- * Sentences should be in NMEA format- .
- *
- * @param buffer Pointer to the buffer containing raw data received from the GPS module via UART.
- * @param read_len The number of bytes in the buffer that were read from the UART.
- * @return ESP_OK on success, or an error code if processing fails.
- *
- * @note Function assumes that the buffer contains complete NMEA sentences: Starts with `$` and ends with `\r\n`
- */
-
 /**
  * @brief Checks if the geo-fence has been triggered.
  *
@@ -68,14 +70,82 @@ bool gps_l96_is_geo_fence_triggered(void);
 /**
  * @brief Receives the buffer with many NMEA sentences and processes them.
  * 
- * This function reads the buffer received from the GPS module via UART,
- * extracts complete NMEA sentences, and processes each sentence at a time.
+ * This function passes the buffer received from the GPS module via UART to the NMEA framer,
+ * which extracts complete NMEA sentences (checksum is checked while scanning) and processes each sentence at a time.
+ * A sentence that is split between two reads is kept by the framer and finished on the next call.
  *
  * @note If more of the same NMEA sentence is received, the last one will be saved.
+ * @note The buffer is temporarily modified (sentences are NULL terminated in place), but restored before returning.
  * @param buffer Pointer to the buffer containing raw data received from the GPS module via UART.
  * @param read_len The number of bytes in the buffer that were read from the UART.
+ * @return ESP_OK on success, or an error code if processing fails.
+ */
+esp_err_t gps_l96_extract_and_process_nmea_sentences(uint8_t *buffer, size_t read_len);
+
+/**
+ * @brief Gets the NMEA framer statistics (parsed sentences, checksum errors, overflows).
+ *
+ * @param stats Pointer to the struct where statistics will be copied.
+ */
+void gps_l96_get_nmea_stats(nmea_framer_stats_t *stats);
+
+/**
+ * @brief Gets the fix assembler statistics (complete, incomplete and dropped epochs).
+ *
+ * @param stats Pointer to the struct where statistics will be copied.
+ */
+void gps_l96_get_epoch_stats(gps_epoch_stats_t *stats);
+
+/**
+ * @brief Drops the partial NMEA sentence kept by the framer (used after UART overflow).
+ */
+void gps_l96_reset_nmea_framer(void);
+
+/**
+ * @brief Function that gets every fix the GPS ingest task publishes.
+ */
+typedef void (*gps_fix_listener_t)(const gps_fix_t *fix);
+
+/**
+ * @brief Sets the fix listener (e.g. the live stream), NULL removes it.
+ *
+ * The listener is called from the GPS ingest task after the fix is queued for the state machine,
+ * so it must return quickly and never block.
+ *
+ * @param listener Function to call for every published fix.
  */
-esp_err_t gps_l96_extract_and_process_nmea_sentences(const uint8_t *buffer, size_t read_len);
+void gps_l96_set_fix_listener(gps_fix_listener_t listener);
+
+/**
+ * @brief Takes the oldest GPS fix published by the GPS ingest task.
+ *
+ * Fixes are published for every parsed RMC sentence (valid or not) into a lock-free queue.
+ * The taken fix also becomes the current fix used by gps_l96_has_fix(), gps_l96_get_date_string_from_data()
+ * and gps_l96_get_current_fix().
+ *
+ * @note Must be called only from one task (the state machine task).
+ * @param fix Pointer to the struct where the fix will be copied.
+ * @return true if a fix was taken, false if there is no new fix.
+ */
+bool gps_l96_get_next_fix(gps_fix_t *fix);
+
+/**
+ * @brief Takes and discards all fixes in the queue, for the states that do not log them.
+ *
+ * The newest fix becomes the current fix, like with gps_l96_get_next_fix(), so gps_l96_has_fix() stays up to date.
+ * Tracking then starts with fresh fixes instead of the ones queued while the collar was not logging.
+ *
+ * @note Must be called only from the task that calls gps_l96_get_next_fix().
+ * @return Number of fixes discarded.
+ */
+uint32_t gps_l96_discard_fixes(void);
+
+/**
+ * @brief Gets the number of fixes dropped because the consumer did not take them in time.
+ *
+ * @return Number of dropped fixes since boot.
+ */
+uint32_t gps_l96_get_dropped_fix_count(void);
 
 /**
  * @brief Sets the GPS module to standby mode.
@@ -83,18 +153,18 @@ esp_err_t gps_l96_extract_and_process_nmea_sentences(const uint8_t *buffer, size
  * This function sends the command to put the GPS module into standby mode - waiting for a command, not recording.
  * It also sets the FORCE_ON pin to high, in case the module is in deep sleep mode.
  *
- * @return ESP_OK on success, or an error code if the command fails.
+ * @return ESP_OK when the command is acknowledged, or an error code if it fails (gps_pmtk_send()).
  */
 esp_err_t gps_l96_go_to_standby_mode(void);
 
 /**
  * @brief Starts recording GPS data.
  *
- * This function sends the command to start recording GPS data at a rate of 1Hz and to only send RMC sentences.
+ * This function sends the commands to start recording GPS data at a rate of 1Hz with RMC, GGA and GSA sentences,
+ * each as soon as the previous one is acknowledged (gps_pmtk.h).
  * It also sets the FORCE_ON pin to high, in case the module is in deep sleep mode.
  *
- * @note We cannot check if it was successful, because the GPS module does not respond to any commands after we send it in deep sleep mode.
- * @return ESP_OK on success, or an error code if the command fails.
+ * @return ESP_OK when all commands are acknowledged, or the error of the first command that failed.
  */
 esp_err_t gps_l96_start_recording(void);
 
@@ -110,6 +180,29 @@ esp_err_t gps_l96_start_recording(void);
 esp_err_t gps_l96_go_to_back_up_mode(void);
 
 
+/**
+ * @brief Finds the baud rate the GPS module talks at and switches both sides to UART_BAUD_RATE_FAST.
+ *
+ * The module is probed with a test command at the known rates until it answers. If it is not at the fast
+ * rate yet, it is switched with PMTK251 and the UART follows. Called at startup, when commands are not
+ * acknowledged and by the link task (see gps_l96_check_link()), since the module falls back to its default
+ * rate after a reset or power loss. The UART is back at its rate from before the call if the module is not found.
+ *
+ * @return ESP_OK when the module answers at UART_BAUD_RATE_FAST (or at the rate it was found at if the switch
+ *         failed), ESP_ERR_NOT_FOUND if it does not answer at any rate.
+ */
+esp_err_t gps_l96_sync_baud_rate(void);
+
+/**
+ * @brief Checks the NMEA input while recording, called by the GPS ingest task after every UART event and at least
+ *        every GPS_INGEST_LINK_CHECK_MS.
+ *
+ * After GPS_L96_LINK_SILENCE_S without a valid sentence or a run of GPS_L96_LINK_ERROR_RUN framing/checksum errors
+ * the link task re-syncs the baud rate and sends the recording commands again, at most every
+ * GPS_L96_LINK_RESYNC_INTERVAL_S.
+ */
+void gps_l96_check_link(void);
+
 /**
  * @brief Sends a command to the GPS module.
  *
@@ -124,7 +217,8 @@ esp_err_t gps_l96_send_command(const char *nmea_sentence);
 /**
  * @brief Extracts-parses GPS data from a NMEA sentence.
  *
- * This function extracts-parses GPS data from NMEA sentence and stores struct gps_rcm_data.
+ * RMC, GGA and GSA are parsed and handed to the fix assembler (gps_epoch.h), which publishes one fix per epoch.
+ * RMC and GGA go through the fast parser (nmea_parser.h), minmea parses everything else.
  *
  * @param nmea_sentence Pointer to the NMEA sentence to be processed.
  * @return ESP_OK on success, or an error code if extraction fails.
@@ -135,15 +229,11 @@ esp_err_t gps_l96_extract_data_from_nmea_sentence(const char *nmea_sentence);
 void gps_l96_print_data(void);
 
 /**
- * @brief Formats a CSV line from the GPS data.
+ * @brief Gets the current GPS fix (last one taken with gps_l96_get_next_fix()).
  *
- * This function formats data from the global struct gps_rcm_data into a CSV line that can be appended to a file.
- *
- * @param file_line Pointer to the buffer where the formatted CSV line will be stored.
- * @param file_line_size Size of the buffer.
- * @return ESP_OK on success, or an error code if formatting fails.
+ * @param fix Pointer to the struct where the fix will be copied.
  */
-esp_err_t gps_l96_format_csv_line_from_data(char *file_line, size_t file_line_size);
+void gps_l96_get_current_fix(gps_fix_t *fix);
 
 /**
  * @brief Checks if the GPS module has a valid fix.
@@ -157,7 +247,7 @@ bool gps_l96_has_fix(void);
 /**
  * @brief Gets the date string from the GPS data.
  *
- * This function formats the date from the global struct gps_rcm_data into a string in the format "YYYY-MM-DD".
+ * This function formats the date from the current GPS fix into a string in the format "YYYY-MM-DD".
  *
  * @param date_string Pointer to the buffer where the formatted date string will be stored.
  * @param date_string_size Size of the buffer.
@@ -165,6 +255,11 @@ bool gps_l96_has_fix(void);
  */
 esp_err_t gps_l96_get_date_string_from_data(char *date_string, size_t date_string_size);
 
+/**
+ * @brief Resets the GPS module with the RESET pin.
+ *
+ * @note Does not wait for the module to boot, see gps_pmtk_wait_boot().
+ */
 void gpio_reset_gps(void);
 
 /**
@@ -0,0 +1,193 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#include "gps_pmtk.h"
+
+static const char *TAG = "GPS_PMTK";
+
+static SemaphoreHandle_t pmtk_mutex = NULL;     // One command in flight
+static SemaphoreHandle_t pmtk_ack = NULL;       // Given by the ingest task when the ack of the pending command comes
+static SemaphoreHandle_t pmtk_boot = NULL;      // Given by the ingest task on the boot message
+
+static portMUX_TYPE pmtk_lock = portMUX_INITIALIZER_UNLOCKED; // Pending command is set by the sender, cleared by the ingest task
+static int pmtk_pending = -1;                   // Command waiting for its ack, -1 if none
+static int pmtk_ack_flag = GPS_PMTK_ACK_INVALID;
+
+/* Reads the 3 digit packet type / command number */
+static bool gps_pmtk_read_number(const char *p, int *number) {
+    for (int i = 0; i < 3; i++) {
+        if (p[i] < '0' || p[i] > '9') {
+            return false;
+        }
+    }
+    *number = (p[0] - '0') * 100 + (p[1] - '0') * 10 + (p[2] - '0');
+    return true;
+}
+
+/* Reads a field of 1 to 3 digits and moves past it - acks write the command without leading zeros */
+static bool gps_pmtk_read_field(const char **p, int *number) {
+    int value = 0;
+    int digits = 0;
+    while (**p >= '0' && **p <= '9') {
+        if (++digits > 3) {
+            return false;
+        }
+        value = value * 10 + (**p - '0');
+        (*p)++;
+    }
+    *number = value;
+    return digits > 0;
+}
+
+esp_err_t gps_pmtk_init(void) {
+
+    if (pmtk_mutex != NULL) {
+        return ESP_OK;
+    }
+
+    pmtk_ack = xSemaphoreCreateBinary();
+    pmtk_boot = xSemaphoreCreateBinary();
+    pmtk_mutex = xSemaphoreCreateMutex();
+    if (pmtk_ack == NULL || pmtk_boot == NULL || pmtk_mutex == NULL) {
+        ESP_LOGE(TAG, "Failed to create semaphores");
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+bool gps_pmtk_handle_sentence(const char *sentence) {
+
+    if (strncmp(sentence, "$PMTK", 5) != 0) {
+        return false;
+    }
+
+    const char *p = sentence + 5;
+    int type, command;
+    if (pmtk_mutex == NULL || !gps_pmtk_read_number(p, &type)) {
+        return true;
+    }
+
+    const char *field = p + 3;
+    if (*field++ != ',') {
+        return true;
+    }
+
+    if (type == GPS_PMTK_ACK) {
+        // $PMTK001,<cmd>,<flag>[,...]*XX - PMTK000 is acked as 0, some commands (PMTK353) add their settings after the flag
+        if (!gps_pmtk_read_field(&field, &command) || *field++ != ',' || *field < '0' || *field > '9') {
+            return true;
+        }
+        bool matched = false;
+        portENTER_CRITICAL(&pmtk_lock);
+        if (command == pmtk_pending) {
+            pmtk_ack_flag = *field - '0';
+            pmtk_pending = -1;
+            matched = true;
+        }
+        portEXIT_CRITICAL(&pmtk_lock);
+
+        if (matched) {
+            xSemaphoreGive(pmtk_ack);
+        }
+    } else if (type == GPS_PMTK_SYSTEM_MESSAGE) {
+        int message;
+        if (gps_pmtk_read_field(&field, &message) && message == GPS_PMTK_SYSTEM_STARTUP) {
+            xSemaphoreGive(pmtk_boot);
+        }
+    }
+    return true;
+}
+
+esp_err_t gps_pmtk_send(const char *command, uint32_t timeout_ms, uint8_t retries) {
+
+    int number;
+    if (command == NULL || strncmp(command, "$PMTK", 5) != 0 || !gps_pmtk_read_number(command + 5, &number)) {
+        ESP_LOGE(TAG, "Invalid PMTK command");
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (pmtk_mutex == NULL) {
+        ESP_LOGE(TAG, "PMTK channel is not initialized");
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    xSemaphoreTake(pmtk_mutex, portMAX_DELAY);
+
+    esp_err_t ret = ESP_ERR_TIMEOUT;
+    for (uint32_t attempt = 0; attempt <= retries; attempt++) {
+        if (attempt > 0) {
+            metrics_inc(METRICS_GPS_COMMAND_RETRIES);
+        }
+
+        xSemaphoreTake(pmtk_ack, 0); // Late ack of the previous try
+        portENTER_CRITICAL(&pmtk_lock);
+        pmtk_pending = number;
+        pmtk_ack_flag = GPS_PMTK_ACK_INVALID;
+        portEXIT_CRITICAL(&pmtk_lock);
+
+        ret = uart_send_cmd(command, strlen(command));
+        if (ret != ESP_OK) {
+            break; // UART error, resending will not help
+        }
+
+        if (xSemaphoreTake(pmtk_ack, pdMS_TO_TICKS(timeout_ms)) != pdTRUE) {
+            ret = ESP_ERR_TIMEOUT;
+            continue;
+        }
+
+        int flag = pmtk_ack_flag; // Written before the give
+        if (flag == GPS_PMTK_ACK_OK) {
+            ret = ESP_OK;
+            break;
+        }
+        if (flag == GPS_PMTK_ACK_UNSUPPORTED) {
+            ret = ESP_ERR_NOT_SUPPORTED;
+            break;
+        }
+        ret = ESP_FAIL;
+    }
+
+    portENTER_CRITICAL(&pmtk_lock);
+    pmtk_pending = -1;
+    portEXIT_CRITICAL(&pmtk_lock);
+    xSemaphoreGive(pmtk_mutex);
+
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "PMTK%03d not acknowledged: %s", number, esp_err_to_name(ret));
+    }
+    return ret;
+}
+
+esp_err_t gps_pmtk_send_all(const char *const *commands, size_t count) {
+
+    int64_t start_us = esp_timer_get_time();
+    for (size_t i = 0; i < count; i++) {
+        ESP_RETURN_ON_ERROR(gps_pmtk_send(commands[i], GPS_PMTK_ACK_TIMEOUT_MS, GPS_PMTK_RETRIES),
+                            TAG, "Command %u of %u failed", (unsigned)(i + 1), (unsigned)count);
+    }
+    ESP_LOGI(TAG, "%u commands acknowledged in %lu ms", (unsigned)count,
+             (uint32_t)((esp_timer_get_time() - start_us) / 1000));
+    return ESP_OK;
+}
+
+void gps_pmtk_expect_boot(void) {
+    if (pmtk_boot != NULL) {
+        xSemaphoreTake(pmtk_boot, 0);
+    }
+}
+
+esp_err_t gps_pmtk_wait_boot(uint32_t timeout_ms) {
+
+    if (pmtk_boot == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    int64_t start_us = esp_timer_get_time();
+    if (xSemaphoreTake(pmtk_boot, pdMS_TO_TICKS(timeout_ms)) != pdTRUE) {
+        return ESP_ERR_TIMEOUT;
+    }
+    ESP_LOGI(TAG, "GPS booted in %lu ms", (uint32_t)((esp_timer_get_time() - start_us) / 1000));
+    return ESP_OK;
+}
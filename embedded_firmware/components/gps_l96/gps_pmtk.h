@@ -0,0 +1,100 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#ifndef GPS_PMTK_H
+#define GPS_PMTK_H
+
+/*
+ * Acknowledged PMTK command channel
+ *
+ * The L96 answers every PMTK command with `$PMTK001,<cmd>,<flag>` in its NMEA stream. A command is sent and the
+ * caller waits for that ack (the GPS ingest task passes it over), so commands go out back to back at the speed
+ * the module takes them, instead of after a fixed delay. A command without an ack in time is sent again.
+ *
+ * After a reset the module sends `$PMTK010,001` once it has booted, gps_pmtk_wait_boot() waits for it.
+ *
+ * One command is in flight at a time, callers from other tasks wait for their turn.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "esp_err.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "uart.h"
+#include "metrics/metrics.h"
+
+#define GPS_PMTK_ACK_TIMEOUT_MS     300  // The L96 acks in tens of ms, the rest is margin for the ingest task
+#define GPS_PMTK_RETRIES            3    // Resends after a missing or failed ack
+#define GPS_PMTK_BOOT_TIMEOUT_MS    1000 // From reset release to the boot message
+
+#define GPS_PMTK_ACK                1    // $PMTK001,<cmd>,<flag>
+#define GPS_PMTK_SYSTEM_MESSAGE     10   // $PMTK010,<msg>
+#define GPS_PMTK_SYSTEM_STARTUP     1    // <msg> sent once the module has booted
+
+typedef enum {
+    GPS_PMTK_ACK_INVALID = 0,       // Invalid command or packet, may be corrupted on the line - sent again
+    GPS_PMTK_ACK_UNSUPPORTED = 1,   // Not supported by the module - not sent again
+    GPS_PMTK_ACK_FAILED = 2,        // Valid, but the action failed - sent again
+    GPS_PMTK_ACK_OK = 3,
+} gps_pmtk_ack_flag_t;
+
+/**
+ * @brief Creates the channel, call it before the GPS ingest task starts. Calling it again does nothing.
+ *
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the semaphores can not be created.
+ */
+esp_err_t gps_pmtk_init(void);
+
+/**
+ * @brief Takes the PMTK sentences out of the NMEA stream (acks and the boot message).
+ *
+ * Called by the GPS ingest task for every sentence with a valid checksum.
+ *
+ * @param sentence NULL terminated sentence starting with `$`.
+ * @return true if it was a PMTK sentence, there is nothing in it for the NMEA parser.
+ */
+bool gps_pmtk_handle_sentence(const char *sentence);
+
+/**
+ * @brief Sends a PMTK command and waits for its ack.
+ *
+ * @param command PMTK sentence with checksum and `\r\n` (nmea_commands.h).
+ * @param timeout_ms Time to wait for the ack of one try.
+ * @param retries Resends after a timeout, an invalid packet ack or a failed ack.
+ * @return ESP_OK when acked as done, ESP_ERR_TIMEOUT if no ack came, ESP_ERR_NOT_SUPPORTED if the module
+ *         does not support it, ESP_FAIL if it failed on every try, ESP_ERR_INVALID_ARG if it is not a PMTK command.
+ */
+esp_err_t gps_pmtk_send(const char *command, uint32_t timeout_ms, uint8_t retries);
+
+/**
+ * @brief Sends PMTK commands one after another, each as soon as the previous is acked.
+ *
+ * Uses GPS_PMTK_ACK_TIMEOUT_MS and GPS_PMTK_RETRIES for every command.
+ *
+ * @return ESP_OK when all are acked, otherwise the error of the first command that failed (the rest is not sent).
+ */
+esp_err_t gps_pmtk_send_all(const char *const *commands, size_t count);
+
+/**
+ * @brief Forgets an earlier boot message, call it before resetting the module.
+ */
+void gps_pmtk_expect_boot(void);
+
+/**
+ * @brief Waits for the boot message after gps_pmtk_expect_boot() and the reset.
+ *
+ * @return ESP_OK once the module has booted, ESP_ERR_TIMEOUT if the message did not come in time.
+ */
+esp_err_t gps_pmtk_wait_boot(uint32_t timeout_ms);
+
+#endif // GPS_PMTK_H
@@ -0,0 +1,167 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#include "nmea_benchmark.h"
+
+static const char *TAG = "NMEA_BENCHMARK";
+
+/* Two L96 epochs as sent at 1 Hz with RMC, GGA and GSA enabled, one with a fix and one without */
+static const char *const benchmark_sentences[] = {
+    "$GNRMC,101523.000,A,4603.1234,N,01430.5678,E,1.20,45.52,170525,,,A*4A\r\n",
+    "$GNGGA,101523.000,4603.1234,N,01430.5678,E,1,09,0.92,296.4,M,47.2,M,,*73\r\n",
+    "$GPGSA,A,3,10,32,24,12,25,15,,,,,,,1.21,0.92,0.79*03\r\n",
+    "$GLGSA,A,3,81,79,88,,,,,,,,,,1.21,0.92,0.79*1E\r\n",
+    "$GNRMC,101524.000,V,,,,,,,170525,,,N*54\r\n",
+    "$GNGGA,101524.000,,,,,0,00,,,M,,M,,*65\r\n",
+};
+
+typedef enum {
+    BENCHMARK_NONE = 0,
+    BENCHMARK_RMC,
+    BENCHMARK_GGA,
+} benchmark_kind_t;
+
+/* Path of gps_l96_extract_data_from_nmea_sentence(), minmea only for what the fast parser refuses */
+static benchmark_kind_t benchmark_parse_fast(const char *sentence, nmea_rmc_t *rmc, nmea_gga_t *gga) {
+
+    if (nmea_parse_rmc(sentence, rmc)) {
+        return BENCHMARK_RMC;
+    }
+    if (nmea_parse_gga(sentence, gga)) {
+        return BENCHMARK_GGA;
+    }
+
+    struct minmea_sentence_rmc rmc_frame;
+    struct minmea_sentence_gga gga_frame;
+    switch (minmea_sentence_id(sentence, false)) {
+        case MINMEA_SENTENCE_RMC:
+            if (minmea_parse_rmc(&rmc_frame, sentence)) {
+                nmea_rmc_from_minmea(&rmc_frame, rmc);
+                return BENCHMARK_RMC;
+            }
+            break;
+        case MINMEA_SENTENCE_GGA:
+            if (minmea_parse_gga(&gga_frame, sentence)) {
+                nmea_gga_from_minmea(&gga_frame, gga);
+                return BENCHMARK_GGA;
+            }
+            break;
+        default:
+            break;
+    }
+    return BENCHMARK_NONE;
+}
+
+/* The path before the fast parser, every sentence through minmea */
+static benchmark_kind_t benchmark_parse_minmea(const char *sentence, nmea_rmc_t *rmc, nmea_gga_t *gga) {
+
+    struct minmea_sentence_rmc rmc_frame;
+    struct minmea_sentence_gga gga_frame;
+    switch (minmea_sentence_id(sentence, false)) {
+        case MINMEA_SENTENCE_RMC:
+            if (minmea_parse_rmc(&rmc_frame, sentence)) {
+                nmea_rmc_from_minmea(&rmc_frame, rmc);
+                return BENCHMARK_RMC;
+            }
+            break;
+        case MINMEA_SENTENCE_GGA:
+            if (minmea_parse_gga(&gga_frame, sentence)) {
+                nmea_gga_from_minmea(&gga_frame, gga);
+                return BENCHMARK_GGA;
+            }
+            break;
+        default:
+            break;
+    }
+    return BENCHMARK_NONE;
+}
+
+static bool benchmark_time_equal(const struct minmea_time *a, const struct minmea_time *b) {
+    return a->hours == b->hours && a->minutes == b->minutes && a->seconds == b->seconds &&
+           a->microseconds == b->microseconds;
+}
+
+static bool benchmark_rmc_equal(const nmea_rmc_t *a, const nmea_rmc_t *b) {
+    return benchmark_time_equal(&a->time, &b->time) &&
+           a->date.day == b->date.day && a->date.month == b->date.month && a->date.year == b->date.year &&
+           a->latitude_e6 == b->latitude_e6 && a->longitude_e6 == b->longitude_e6 &&
+           a->speed_mm_s == b->speed_mm_s && a->course_cdeg == b->course_cdeg && a->valid == b->valid;
+}
+
+static bool benchmark_gga_equal(const nmea_gga_t *a, const nmea_gga_t *b) {
+    return benchmark_time_equal(&a->time, &b->time) &&
+           a->latitude_e6 == b->latitude_e6 && a->longitude_e6 == b->longitude_e6 &&
+           a->fix_quality == b->fix_quality && a->satellites == b->satellites &&
+           a->hdop_x100 == b->hdop_x100 && a->altitude_dm == b->altitude_dm;
+}
+
+esp_err_t nmea_benchmark_run(const char *const *sentences, size_t count, uint32_t rounds, nmea_benchmark_result_t *result) {
+
+    nmea_rmc_t fast_rmc, minmea_rmc;
+    nmea_gga_t fast_gga, minmea_gga;
+    volatile uint32_t parsed = 0; // Keeps the timed loops from being optimized away
+
+    if (sentences == NULL || count == 0 || rounds == 0 || result == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(result, 0, sizeof(*result));
+    result->sentences = count;
+
+    // 1) Same results on both paths
+    for (size_t i = 0; i < count; i++) {
+        if (nmea_parse_rmc(sentences[i], &fast_rmc) || nmea_parse_gga(sentences[i], &fast_gga)) {
+            result->fast_parsed++;
+        }
+        benchmark_kind_t fast = benchmark_parse_fast(sentences[i], &fast_rmc, &fast_gga);
+        benchmark_kind_t minmea = benchmark_parse_minmea(sentences[i], &minmea_rmc, &minmea_gga);
+        if (minmea != BENCHMARK_NONE) {
+            result->minmea_parsed++;
+        }
+        if (fast != minmea ||
+            (fast == BENCHMARK_RMC && !benchmark_rmc_equal(&fast_rmc, &minmea_rmc)) ||
+            (fast == BENCHMARK_GGA && !benchmark_gga_equal(&fast_gga, &minmea_gga))) {
+            ESP_LOGW(TAG, "Parsers disagree on %s", sentences[i]);
+            result->mismatches++;
+        }
+    }
+
+    // 2) Time per sentence
+    int64_t start_us = esp_timer_get_time();
+    for (uint32_t round = 0; round < rounds; round++) {
+        for (size_t i = 0; i < count; i++) {
+            parsed += benchmark_parse_fast(sentences[i], &fast_rmc, &fast_gga);
+        }
+    }
+    int64_t fast_us = esp_timer_get_time() - start_us;
+
+    start_us = esp_timer_get_time();
+    for (uint32_t round = 0; round < rounds; round++) {
+        for (size_t i = 0; i < count; i++) {
+            parsed += benchmark_parse_minmea(sentences[i], &minmea_rmc, &minmea_gga);
+        }
+    }
+    int64_t minmea_us = esp_timer_get_time() - start_us;
+
+    uint64_t total = (uint64_t)rounds * count;
+    result->fast_ns = (uint32_t)((uint64_t)fast_us * 1000 / total);
+    result->minmea_ns = (uint32_t)((uint64_t)minmea_us * 1000 / total);
+    return ESP_OK;
+}
+
+void nmea_benchmark_log(void) {
+
+    nmea_benchmark_result_t result;
+    size_t count = sizeof(benchmark_sentences) / sizeof(benchmark_sentences[0]);
+
+    if (nmea_benchmark_run(benchmark_sentences, count, NMEA_BENCHMARK_ROUNDS, &result) != ESP_OK) {
+        ESP_LOGE(TAG, "Benchmark failed");
+        return;
+    }
+    ESP_LOGI(TAG, "%lu sentences x %d: fast %lu ns, minmea %lu ns per sentence, %lu fast / %lu minmea parsed, %lu mismatches",
+             result.sentences, NMEA_BENCHMARK_ROUNDS, result.fast_ns, result.minmea_ns,
+             result.fast_parsed, result.minmea_parsed, result.mismatches);
+}
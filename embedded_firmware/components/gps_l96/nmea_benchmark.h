@@ -0,0 +1,56 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#ifndef NMEA_BENCHMARK_H
+#define NMEA_BENCHMARK_H
+
+/*
+ * NMEA parser benchmark
+ *
+ * Parses the same sentences with the fast parser (nmea_parser.h, minmea for what it refuses, as
+ * gps_l96_extract_data_from_nmea_sentence() does) and with minmea alone, compares the results field by field
+ * and measures the time per sentence of both. Nothing in the firmware calls it, so it is not in the firmware build:
+ * make bench in tests/test_afl_fuzz_host runs it on the fuzz inputs and on a generated hour of L96 output. To time
+ * it on the ESP32-C3, add it back to src/CMakeLists.txt and call nmea_benchmark_log().
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nmea_parser.h"
+
+#define NMEA_BENCHMARK_ROUNDS 1000 // Passes over the sample sentences in nmea_benchmark_log()
+
+typedef struct {
+    uint32_t sentences;         // Sentences per round
+    uint32_t fast_parsed;       // RMC/GGA the fast parser took
+    uint32_t minmea_parsed;     // RMC/GGA minmea took
+    uint32_t mismatches;        // Sentences where the two paths disagree (parsed or not, or any field)
+    uint32_t fast_ns;           // Time per sentence of the fast path
+    uint32_t minmea_ns;         // Time per sentence of minmea alone
+} nmea_benchmark_result_t;
+
+/**
+ * @brief Compares both parser paths on the given sentences and times them.
+ *
+ * @param sentences NULL terminated sentences starting with `$`, any type (GSA, GSV... count for the time only).
+ * @param count Number of sentences.
+ * @param rounds Passes over all sentences for the timing, more rounds for a finer time on the 1 us timer.
+ * @param result Output results.
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if there are no sentences or rounds.
+ */
+esp_err_t nmea_benchmark_run(const char *const *sentences, size_t count, uint32_t rounds, nmea_benchmark_result_t *result);
+
+/**
+ * @brief Runs nmea_benchmark_run() on built-in L96 epochs (with and without a fix) and logs the results.
+ */
+void nmea_benchmark_log(void);
+
+#endif // NMEA_BENCHMARK_H
@@ -31,10 +31,17 @@
 
 #define ONLY_GNRMC "$PMTK314,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0*29\r\n"
 
+// RMC, GGA and GSA every fix - the sentences the fix assembler (gps_epoch.h) groups into one fix
+#define GNSS_OUTPUT_RMC_GGA_GSA "$PMTK314,0,1,0,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0*29\r\n"
+
 #define GNSS_SET_UPDATE_RATE_1HZ "$PMTK220,1000*1F\r\n" // Set update rate to 1Hz
 
 #define GNSS_ENABLE_EASY  "$PMTK869,1,0*34\r\n" // Enable Easy mode - it stores the last position so on nexct gps start it gets fix faster
 
+#define GNSS_TEST "$PMTK000*32\r\n" // Test packet, only acked - used to find the baud rate the module talks at
+
+#define GNSS_SET_BAUD_115200 "$PMTK251,115200*1F\r\n" // Switch the NMEA port to 115200 baud, there is no ack at the old rate
+
 
 #endif // NMEA_COMMANDS_H
     
\ No newline at end of file
@@ -0,0 +1,182 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#include "nmea_framer.h"
+#include <string.h>
+#include <ctype.h>
+
+static int nmea_framer_hex_to_int(uint8_t ch) {
+    if (ch >= '0' && ch <= '9') return ch - '0';
+    if (ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
+    if (ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
+    return -1;
+}
+
+/* Starts a new sentence at buffer position, dropping any sentence in progress */
+static void nmea_framer_start_sentence(nmea_framer_t *framer) {
+    framer->state = NMEA_FRAMER_BODY;
+    framer->checksum = 0;
+    framer->expected_checksum = 0;
+    framer->sentence_len = 1; // `$`
+    framer->carry_len = 0;
+    framer->in_carry = false;
+}
+
+static void nmea_framer_drop_sentence(nmea_framer_t *framer, uint32_t *error_counter) {
+    (*error_counter)++;
+    framer->state = NMEA_FRAMER_IDLE;
+    framer->sentence_len = 0;
+    framer->carry_len = 0;
+    framer->in_carry = false;
+}
+
+/* Appends bytes of the current read to the carry buffer. Returns false on overflow. */
+static bool nmea_framer_carry(nmea_framer_t *framer, const uint8_t *data, size_t len) {
+    if (framer->carry_len + len > sizeof(framer->carry) - 1) {
+        return false;
+    }
+    memcpy(framer->carry + framer->carry_len, data, len);
+    framer->carry_len += len;
+    return true;
+}
+
+void nmea_framer_init(nmea_framer_t *framer, nmea_sentence_handler_t handler, void *ctx) {
+    memset(framer, 0, sizeof(*framer));
+    framer->handler = handler;
+    framer->handler_ctx = ctx;
+    framer->state = NMEA_FRAMER_IDLE;
+}
+
+void nmea_framer_reset(nmea_framer_t *framer) {
+    framer->state = NMEA_FRAMER_IDLE;
+    framer->sentence_len = 0;
+    framer->carry_len = 0;
+    framer->in_carry = false;
+}
+
+esp_err_t nmea_framer_feed(nmea_framer_t *framer, uint8_t *buffer, size_t len) {
+
+    if (framer == NULL || buffer == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Start of the sentence in progress inside this buffer (if it started in a previous read, it is at index 0)
+    size_t sentence_start = 0;
+
+    for (size_t i = 0; i < len; i++) {
+        uint8_t ch = buffer[i];
+
+        // 1. `$` always starts a new sentence, even if the previous one was not finished
+        if (ch == '$') {
+            if (framer->state != NMEA_FRAMER_IDLE) {
+                framer->stats.framing_errors++;
+            }
+            nmea_framer_start_sentence(framer);
+            sentence_start = i;
+            continue;
+        }
+
+        if (framer->state == NMEA_FRAMER_IDLE) {
+            continue; // Garbage between sentences
+        }
+
+        // 2. Guard against sentences without end
+        if (++framer->sentence_len > sizeof(framer->carry) - 1) {
+            nmea_framer_drop_sentence(framer, &framer->stats.overflows);
+            continue;
+        }
+
+        // 3. Check the sentence structure and calculate checksum in the same pass
+        switch (framer->state) {
+            case NMEA_FRAMER_BODY:
+                if (ch == '*') {
+                    framer->state = NMEA_FRAMER_CHECKSUM_HI;
+                } else if (isprint(ch)) {
+                    framer->checksum ^= ch;
+                } else {
+                    nmea_framer_drop_sentence(framer, &framer->stats.framing_errors);
+                }
+                break;
+
+            case NMEA_FRAMER_CHECKSUM_HI:
+            case NMEA_FRAMER_CHECKSUM_LO: {
+                int value = nmea_framer_hex_to_int(ch);
+                if (value < 0) {
+                    nmea_framer_drop_sentence(framer, &framer->stats.framing_errors);
+                    break;
+                }
+                framer->expected_checksum = (framer->expected_checksum << 4) | value;
+                framer->state = (framer->state == NMEA_FRAMER_CHECKSUM_HI) ? NMEA_FRAMER_CHECKSUM_LO : NMEA_FRAMER_CR;
+            } break;
+
+            case NMEA_FRAMER_CR:
+                if (ch == '\r') {
+                    framer->state = NMEA_FRAMER_LF;
+                } else {
+                    nmea_framer_drop_sentence(framer, &framer->stats.framing_errors);
+                }
+                break;
+
+            case NMEA_FRAMER_LF:
+                if (ch != '\n') {
+                    nmea_framer_drop_sentence(framer, &framer->stats.framing_errors);
+                    break;
+                }
+
+                if (framer->checksum != framer->expected_checksum) {
+                    nmea_framer_drop_sentence(framer, &framer->stats.checksum_errors);
+                    break;
+                }
+
+                // 4. Hand the complete sentence to the handler without "\r\n"
+                if (framer->in_carry) {
+                    // Sentence was split between reads - finish it in the carry buffer (the `\r` may be in either read)
+                    if (!nmea_framer_carry(framer, &buffer[sentence_start], i - sentence_start)) {
+                        nmea_framer_drop_sentence(framer, &framer->stats.overflows);
+                        break;
+                    }
+                    framer->carry[framer->carry_len - 1] = '\0'; // Replace `\r`
+                    framer->stats.sentences++;
+                    if (framer->handler) {
+                        framer->handler(framer->carry, framer->handler_ctx);
+                    }
+                } else {
+                    // Whole sentence is in this buffer - terminate it in place, no copy
+                    buffer[i - 1] = '\0';
+                    framer->stats.sentences++;
+                    if (framer->handler) {
+                        framer->handler((const char *)&buffer[sentence_start], framer->handler_ctx);
+                    }
+                    buffer[i - 1] = '\r';
+                }
+
+                framer->state = NMEA_FRAMER_IDLE;
+                framer->sentence_len = 0;
+                framer->carry_len = 0;
+                framer->in_carry = false;
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    // 5. Keep the unfinished sentence for the next read
+    if (framer->state != NMEA_FRAMER_IDLE) {
+        if (!nmea_framer_carry(framer, &buffer[sentence_start], len - sentence_start)) {
+            nmea_framer_drop_sentence(framer, &framer->stats.overflows);
+        } else {
+            framer->in_carry = true;
+        }
+    }
+
+    return ESP_OK;
+}
+
+void nmea_framer_get_stats(const nmea_framer_t *framer, nmea_framer_stats_t *stats) {
+    *stats = framer->stats;
+}
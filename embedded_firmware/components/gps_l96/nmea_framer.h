@@ -0,0 +1,100 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#ifndef NMEA_FRAMER_H
+#define NMEA_FRAMER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#define NMEA_FRAMER_CARRY_SIZE 1024 // Max length of a sentence that is split between two UART reads
+
+/**
+ * @brief Callback that receives one complete NMEA sentence.
+ *
+ * The sentence starts with `$`, ends with `*XX` and is NULL terminated (without `\r\n`).
+ * The checksum was already verified by the framer.
+ *
+ * @note The pointer is only valid during the callback - it points into the caller's UART buffer
+ *       or into the framer carry buffer, so copy the data if you need it later.
+ */
+typedef void (*nmea_sentence_handler_t)(const char *sentence, void *ctx);
+
+typedef struct {
+    uint32_t sentences;         // Complete sentences with valid checksum passed to the handler
+    uint32_t checksum_errors;   // Sentences dropped because of checksum mismatch
+    uint32_t framing_errors;    // Sentences dropped because of invalid characters or missing "*XX\r\n"
+    uint32_t overflows;         // Sentences dropped because they were longer than NMEA_FRAMER_CARRY_SIZE
+} nmea_framer_stats_t;
+
+typedef enum {
+    NMEA_FRAMER_IDLE,           // Waiting for `$`
+    NMEA_FRAMER_BODY,           // Between `$` and `*`, XOR-ing the checksum
+    NMEA_FRAMER_CHECKSUM_HI,    // First hex digit after `*`
+    NMEA_FRAMER_CHECKSUM_LO,    // Second hex digit after `*`
+    NMEA_FRAMER_CR,             // Expecting `\r`
+    NMEA_FRAMER_LF,             // Expecting `\n`
+} nmea_framer_state_t;
+
+typedef struct {
+    nmea_sentence_handler_t handler;
+    void *handler_ctx;
+
+    nmea_framer_state_t state;
+    uint8_t checksum;           // Running XOR of the sentence body
+    uint8_t expected_checksum;  // Checksum received after `*`
+    size_t sentence_len;        // Length of the sentence in progress (including `$`)
+
+    char carry[NMEA_FRAMER_CARRY_SIZE]; // Part of the sentence received in previous reads
+    size_t carry_len;
+    bool in_carry;              // True if the sentence in progress started in a previous read
+
+    nmea_framer_stats_t stats;
+} nmea_framer_t;
+
+/**
+ * @brief Initializes the NMEA framer.
+ *
+ * @param framer Pointer to the framer. It should be static, since it keeps state between reads.
+ * @param handler Function that is called for each complete sentence with valid checksum.
+ * @param ctx User context passed to the handler.
+ */
+void nmea_framer_init(nmea_framer_t *framer, nmea_sentence_handler_t handler, void *ctx);
+
+/**
+ * @brief Drops the sentence in progress (for example after UART FIFO overflow).
+ *
+ * @param framer Pointer to the framer.
+ */
+void nmea_framer_reset(nmea_framer_t *framer);
+
+/**
+ * @brief Feeds raw UART bytes into the framer.
+ *
+ * The framer scans the bytes once, checks the checksum inline and calls the handler for every complete sentence.
+ * Sentences that are completely inside the buffer are passed to the handler in place (no copy):
+ * the `\r` is temporarily replaced with `\0` and restored after the handler returns.
+ * Only the part of a sentence that is split across two reads is copied into the carry buffer.
+ *
+ * @param framer Pointer to the framer.
+ * @param buffer Raw data received from the GPS module. It is modified during the call, but restored before returning.
+ * @param len Number of bytes in the buffer.
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if arguments are invalid.
+ */
+esp_err_t nmea_framer_feed(nmea_framer_t *framer, uint8_t *buffer, size_t len);
+
+/**
+ * @brief Gets the framer statistics.
+ *
+ * @param framer Pointer to the framer.
+ * @param stats Pointer to the struct where statistics will be copied.
+ */
+void nmea_framer_get_stats(const nmea_framer_t *framer, nmea_framer_stats_t *stats);
+
+#endif // NMEA_FRAMER_H
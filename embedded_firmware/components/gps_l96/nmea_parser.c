@@ -0,0 +1,361 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#include "nmea_parser.h"
+
+/* Read position in the sentence and the XOR of everything read after `$` */
+typedef struct {
+    const char *p;
+    uint8_t checksum;
+} nmea_cursor_t;
+
+static inline void nmea_consume(nmea_cursor_t *cursor) {
+    cursor->checksum ^= (uint8_t)*cursor->p++;
+}
+
+/* A field ends with `,` (consumed) or `*` (left for the next field and the checksum), anything else is refused */
+static inline bool nmea_field_end(nmea_cursor_t *cursor) {
+    if (*cursor->p == ',') {
+        nmea_consume(cursor);
+        return true;
+    }
+    return *cursor->p == '*';
+}
+
+static inline bool nmea_is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+/* Two digits at p, the caller checked they are digits */
+static inline int nmea_two_digits(const char *p) {
+    return (p[0] - '0') * 10 + (p[1] - '0');
+}
+
+static inline bool nmea_field_empty(const nmea_cursor_t *cursor) {
+    return *cursor->p == ',' || *cursor->p == '*';
+}
+
+/* Reads [-]digits[.digits] as value / scale, scale 0 if the field is empty */
+static bool nmea_read_number(nmea_cursor_t *cursor, int64_t *value, int32_t *scale) {
+
+    int64_t v = 0;
+    int32_t s = 1;
+    int int_digits = 0;
+    int fraction_digits = 0;
+    bool negative = false;
+    bool fraction = false;
+
+    if (*cursor->p == '-') {
+        negative = true;
+        nmea_consume(cursor);
+    }
+    for (;;) {
+        char c = *cursor->p;
+        if (nmea_is_digit(c)) {
+            if (fraction) {
+                if (++fraction_digits > NMEA_PARSER_MAX_FRACTION_DIGITS) {
+                    return false;
+                }
+                s *= 10;
+            } else if (++int_digits > NMEA_PARSER_MAX_INT_DIGITS) {
+                return false;
+            }
+            v = v * 10 + (c - '0');
+        } else if (c == '.' && !fraction) {
+            fraction = true;
+        } else {
+            break;
+        }
+        nmea_consume(cursor);
+    }
+
+    if (int_digits + fraction_digits == 0) {
+        if (negative || fraction) {
+            return false;
+        }
+        s = 0;
+    }
+    if (v > INT32_MAX) {
+        return false; // minmea keeps int32 and drops the fraction digits past it, left to minmea so both paths agree
+    }
+    *value = negative ? -v : v;
+    *scale = s;
+    return nmea_field_end(cursor);
+}
+
+/* Reads a one character field, 0 if empty */
+static bool nmea_read_char(nmea_cursor_t *cursor, char *c) {
+    *c = 0;
+    if (!nmea_field_empty(cursor) && *cursor->p != '\0') {
+        *c = *cursor->p;
+        nmea_consume(cursor);
+    }
+    return nmea_field_end(cursor);
+}
+
+/* hhmmss[.f...], fraction digits after the sixth are ignored like in minmea */
+static bool nmea_read_time(nmea_cursor_t *cursor, struct minmea_time *time) {
+
+    if (nmea_field_empty(cursor)) {
+        time->hours = time->minutes = time->seconds = time->microseconds = -1;
+        return nmea_field_end(cursor);
+    }
+    const char *p = cursor->p;
+    for (int i = 0; i < 6; i++) {
+        if (!nmea_is_digit(p[i])) {
+            return false;
+        }
+    }
+    time->hours = nmea_two_digits(p);
+    time->minutes = nmea_two_digits(p + 2);
+    time->seconds = nmea_two_digits(p + 4);
+    time->microseconds = 0;
+    for (int i = 0; i < 6; i++) {
+        nmea_consume(cursor);
+    }
+
+    if (*cursor->p == '.') {
+        nmea_consume(cursor);
+        int32_t scale = 100000;
+        while (nmea_is_digit(*cursor->p)) {
+            time->microseconds += (*cursor->p - '0') * scale;
+            scale /= 10;
+            nmea_consume(cursor);
+        }
+    }
+    return nmea_field_end(cursor);
+}
+
+/* ddmmyy, year with the century */
+static bool nmea_read_date(nmea_cursor_t *cursor, struct minmea_date *date) {
+
+    if (nmea_field_empty(cursor)) {
+        date->day = date->month = date->year = -1;
+        return nmea_field_end(cursor);
+    }
+    const char *p = cursor->p;
+    for (int i = 0; i < 6; i++) {
+        if (!nmea_is_digit(p[i])) {
+            return false; // Always six digits
+        }
+    }
+    date->day = nmea_two_digits(p);
+    date->month = nmea_two_digits(p + 2);
+    date->year = 2000 + nmea_two_digits(p + 4);
+    for (int i = 0; i < 6; i++) {
+        nmea_consume(cursor);
+    }
+    return nmea_field_end(cursor);
+}
+
+/* Skips the fields that are not needed up to `*` */
+static void nmea_skip_rest(nmea_cursor_t *cursor) {
+    while (*cursor->p != '*' && *cursor->p != '\0') {
+        nmea_consume(cursor);
+    }
+}
+
+static int nmea_hex_digit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+/* Compares `*XX` with the XOR of the sentence, only `\r\n` may follow */
+static bool nmea_check_end(nmea_cursor_t *cursor) {
+
+    nmea_skip_rest(cursor);
+    if (*cursor->p != '*') {
+        return false;
+    }
+    int hi = nmea_hex_digit(cursor->p[1]);
+    int lo = hi < 0 ? -1 : nmea_hex_digit(cursor->p[2]);
+    if (lo < 0 || ((hi << 4) | lo) != cursor->checksum) {
+        return false;
+    }
+    const char *end = cursor->p + 3;
+    while (*end == '\r' || *end == '\n') {
+        end++;
+    }
+    return *end == '\0';
+}
+
+/* `$`, any two character talker, the sentence type and `,` */
+static bool nmea_read_header(nmea_cursor_t *cursor, const char *sentence, const char *type) {
+
+    cursor->p = sentence;
+    cursor->checksum = 0;
+    if (sentence[0] != '$' || sentence[1] == '\0' || sentence[2] == '\0' ||
+        sentence[3] != type[0] || sentence[4] != type[1] || sentence[5] != type[2] || sentence[6] != ',') {
+        return false;
+    }
+    cursor->p++; // `$` is not part of the checksum
+    for (int i = 0; i < 6; i++) {
+        nmea_consume(cursor);
+    }
+    return true;
+}
+
+/* value / scale * factor, truncated like (value * factor) / scale but without the overflow of value * factor.
+ * The integer part times factor must fit int64, it does with NMEA_PARSER_MAX_INT_DIGITS and minmea's int32. */
+static inline int64_t nmea_scale(int64_t value, int32_t scale, int32_t factor) {
+    return (value / scale) * factor + (value % scale) * factor / scale;
+}
+
+static inline int32_t nmea_clamp_i32(int64_t value) {
+    return value > INT32_MAX ? INT32_MAX : value < -INT32_MAX ? -INT32_MAX : (int32_t)value;
+}
+
+/* DDDMM.MMMM (value / scale) to microdegrees, out of range values are clamped (not a valid fix anyway) */
+static int32_t nmea_coord_to_e6(int64_t value, int32_t scale) {
+    if (scale <= 0) {
+        return 0;
+    }
+    int64_t degrees = value / ((int64_t)scale * 100);
+    int64_t minutes_scaled = value % ((int64_t)scale * 100); // Minutes * scale
+    return nmea_clamp_i32(degrees * 1000000 + (minutes_scaled * 1000000) / (60 * (int64_t)scale));
+}
+
+static uint32_t nmea_knots_to_mm_s(int64_t value, int32_t scale) {
+    if (scale <= 0 || value < 0) {
+        return 0;
+    }
+    int64_t speed_mm_s = nmea_scale(value, scale, 514444) / 1000; // 1 knot = 514.444 mm/s
+    return speed_mm_s > UINT32_MAX ? UINT32_MAX : (uint32_t)speed_mm_s;
+}
+
+static uint16_t nmea_degrees_to_cdeg(int64_t value, int32_t scale) {
+    if (scale <= 0 || value < 0) {
+        return 0;
+    }
+    return (uint16_t)(nmea_scale(value, scale, 100) % 36000);
+}
+
+static uint16_t nmea_hdop_x100(int64_t value, int32_t scale) {
+    if (scale <= 0 || value < 0) {
+        return GPS_FIX_HDOP_UNKNOWN;
+    }
+    int64_t hdop_x100 = nmea_scale(value, scale, 100);
+    return hdop_x100 >= GPS_FIX_HDOP_UNKNOWN ? GPS_FIX_HDOP_UNKNOWN - 1 : (uint16_t)hdop_x100;
+}
+
+static int32_t nmea_altitude_dm(int64_t value, int32_t scale) {
+    if (scale <= 0) {
+        return GPS_FIX_ALTITUDE_UNKNOWN;
+    }
+    return nmea_clamp_i32(nmea_scale(value, scale, 10)); // -INT32_MAX keeps clear of GPS_FIX_ALTITUDE_UNKNOWN
+}
+
+static uint8_t nmea_clamp_u8(int64_t count) {
+    return count < 0 ? 0 : count > UINT8_MAX ? UINT8_MAX : (uint8_t)count;
+}
+
+/* Same as minmea: N/E/S/W on either coordinate, no hemisphere is no position */
+static inline bool nmea_hemisphere_valid(char hemisphere) {
+    return hemisphere == 0 || hemisphere == 'N' || hemisphere == 'S' || hemisphere == 'E' || hemisphere == 'W';
+}
+
+static int32_t nmea_signed_coord(int64_t value, int32_t scale, char hemisphere) {
+    if (hemisphere == 0) {
+        return 0;
+    }
+    int32_t e6 = nmea_coord_to_e6(value, scale);
+    return (hemisphere == 'S' || hemisphere == 'W') ? -e6 : e6;
+}
+
+bool nmea_parse_rmc(const char *sentence, nmea_rmc_t *rmc) {
+
+    nmea_cursor_t cursor;
+    int64_t lat, lon, speed, course;
+    int32_t lat_scale, lon_scale, speed_scale, course_scale;
+    char status, ns, ew;
+
+    // $xxRMC,time,status,lat,N/S,lon,E/W,speed,course,date,...*XX
+    if (!nmea_read_header(&cursor, sentence, "RMC") ||
+        !nmea_read_time(&cursor, &rmc->time) ||
+        !nmea_read_char(&cursor, &status) ||
+        !nmea_read_number(&cursor, &lat, &lat_scale) ||
+        !nmea_read_char(&cursor, &ns) ||
+        !nmea_read_number(&cursor, &lon, &lon_scale) ||
+        !nmea_read_char(&cursor, &ew) ||
+        !nmea_read_number(&cursor, &speed, &speed_scale) ||
+        !nmea_read_number(&cursor, &course, &course_scale) ||
+        !nmea_read_date(&cursor, &rmc->date) ||
+        !nmea_check_end(&cursor) ||
+        !nmea_hemisphere_valid(ns) || !nmea_hemisphere_valid(ew)) {
+        return false;
+    }
+
+    rmc->valid = status == 'A';
+    rmc->latitude_e6 = nmea_signed_coord(lat, lat_scale, ns);
+    rmc->longitude_e6 = nmea_signed_coord(lon, lon_scale, ew);
+    rmc->speed_mm_s = nmea_knots_to_mm_s(speed, speed_scale);
+    rmc->course_cdeg = nmea_degrees_to_cdeg(course, course_scale);
+    return true;
+}
+
+bool nmea_parse_gga(const char *sentence, nmea_gga_t *gga) {
+
+    nmea_cursor_t cursor;
+    int64_t lat, lon, quality, satellites, hdop, altitude;
+    int32_t lat_scale, lon_scale, quality_scale, satellites_scale, hdop_scale, altitude_scale;
+    char ns, ew, altitude_units;
+
+    // $xxGGA,time,lat,N/S,lon,E/W,quality,satellites,hdop,altitude,M,...*XX
+    if (!nmea_read_header(&cursor, sentence, "GGA") ||
+        !nmea_read_time(&cursor, &gga->time) ||
+        !nmea_read_number(&cursor, &lat, &lat_scale) ||
+        !nmea_read_char(&cursor, &ns) ||
+        !nmea_read_number(&cursor, &lon, &lon_scale) ||
+        !nmea_read_char(&cursor, &ew) ||
+        !nmea_read_number(&cursor, &quality, &quality_scale) ||
+        !nmea_read_number(&cursor, &satellites, &satellites_scale) ||
+        !nmea_read_number(&cursor, &hdop, &hdop_scale) ||
+        !nmea_read_number(&cursor, &altitude, &altitude_scale) ||
+        !nmea_read_char(&cursor, &altitude_units) ||
+        !nmea_check_end(&cursor) ||
+        !nmea_hemisphere_valid(ns) || !nmea_hemisphere_valid(ew)) {
+        return false;
+    }
+    if (quality_scale > 1 || satellites_scale > 1) {
+        return false; // Integers
+    }
+
+    gga->latitude_e6 = nmea_signed_coord(lat, lat_scale, ns);
+    gga->longitude_e6 = nmea_signed_coord(lon, lon_scale, ew);
+    gga->fix_quality = nmea_clamp_u8(quality);
+    gga->satellites = nmea_clamp_u8(satellites);
+    gga->hdop_x100 = nmea_hdop_x100(hdop, hdop_scale);
+    gga->altitude_dm = altitude_units == 'M' || altitude_units == 0 ?
+                       nmea_altitude_dm(altitude, altitude_scale) : GPS_FIX_ALTITUDE_UNKNOWN;
+    return true;
+}
+
+void nmea_rmc_from_minmea(const struct minmea_sentence_rmc *frame, nmea_rmc_t *rmc) {
+    rmc->time = frame->time;
+    rmc->date = frame->date;
+    if (rmc->date.year >= 0) {
+        rmc->date.year += 2000; // RMC has a 2-digit year
+    }
+    rmc->latitude_e6 = nmea_coord_to_e6(frame->latitude.value, frame->latitude.scale);
+    rmc->longitude_e6 = nmea_coord_to_e6(frame->longitude.value, frame->longitude.scale);
+    rmc->speed_mm_s = nmea_knots_to_mm_s(frame->speed.value, frame->speed.scale);
+    rmc->course_cdeg = nmea_degrees_to_cdeg(frame->course.value, frame->course.scale);
+    rmc->valid = frame->valid;
+}
+
+void nmea_gga_from_minmea(const struct minmea_sentence_gga *frame, nmea_gga_t *gga) {
+    gga->time = frame->time;
+    gga->latitude_e6 = nmea_coord_to_e6(frame->latitude.value, frame->latitude.scale);
+    gga->longitude_e6 = nmea_coord_to_e6(frame->longitude.value, frame->longitude.scale);
+    gga->fix_quality = nmea_clamp_u8(frame->fix_quality);
+    gga->satellites = nmea_clamp_u8(frame->satellites_tracked);
+    gga->hdop_x100 = nmea_hdop_x100(frame->hdop.value, frame->hdop.scale);
+    gga->altitude_dm = frame->altitude_units == 'M' || frame->altitude_units == 0 ?
+                       nmea_altitude_dm(frame->altitude.value, frame->altitude.scale) : GPS_FIX_ALTITUDE_UNKNOWN;
+}
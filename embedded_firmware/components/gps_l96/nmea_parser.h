@@ -0,0 +1,79 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#ifndef NMEA_PARSER_H
+#define NMEA_PARSER_H
+
+/*
+ * Fast RMC/GGA parser
+ *
+ * The sentences the L96 sends every fix (RMC, GGA) are parsed in one pass over the sentence: fields are
+ * converted straight to the fixed point units of gps_fix_t while the checksum is XOR-ed, no floats, no varargs
+ * format interpreter and no allocations. A sentence the parser does not expect (other field layout, too many
+ * digits) is refused, the caller parses it with minmea and converts the result with nmea_*_from_minmea().
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "minmea.h"
+#include "gps_fix.h"
+
+// Digits before and after the point of one number, longer numbers are left to minmea. NMEA fields have at most
+// 5 integer and 4-6 fraction digits, with 9 + 9 the value fits int64, the scale int32 and the unit conversions
+// below do not overflow.
+#define NMEA_PARSER_MAX_INT_DIGITS      9
+#define NMEA_PARSER_MAX_FRACTION_DIGITS 9
+
+typedef struct {
+    struct minmea_time time;    // All -1 if the field is empty
+    struct minmea_date date;    // Full year, all -1 if the field is empty
+    int32_t latitude_e6;        // 0 if empty
+    int32_t longitude_e6;       // 0 if empty
+    uint32_t speed_mm_s;
+    uint16_t course_cdeg;
+    bool valid;                 // Status 'A'
+} nmea_rmc_t;
+
+typedef struct {
+    struct minmea_time time;    // All -1 if the field is empty
+    int32_t latitude_e6;
+    int32_t longitude_e6;
+    uint8_t fix_quality;        // 0 no fix, 1 GPS, 2 DGPS...
+    uint8_t satellites;         // Satellites used, 0 if empty
+    uint16_t hdop_x100;         // GPS_FIX_HDOP_UNKNOWN if empty
+    int32_t altitude_dm;        // GPS_FIX_ALTITUDE_UNKNOWN if empty
+} nmea_gga_t;
+
+/**
+ * @brief Parses an RMC sentence (any talker) and checks its checksum in the same pass.
+ *
+ * @param sentence NULL terminated sentence starting with `$`, with `*XX` and optional `\r\n`.
+ * @param rmc Output, only complete if the function returns true.
+ * @return true on success, false if the sentence is not an RMC the parser can read (try minmea).
+ */
+bool nmea_parse_rmc(const char *sentence, nmea_rmc_t *rmc);
+
+/**
+ * @brief Parses a GGA sentence (any talker) and checks its checksum in the same pass.
+ *
+ * @param sentence NULL terminated sentence starting with `$`, with `*XX` and optional `\r\n`.
+ * @param gga Output, only complete if the function returns true.
+ * @return true on success, false if the sentence is not a GGA the parser can read (try minmea).
+ */
+bool nmea_parse_gga(const char *sentence, nmea_gga_t *gga);
+
+/**
+ * @brief Converts an RMC parsed by minmea (2-digit year) to nmea_rmc_t.
+ */
+void nmea_rmc_from_minmea(const struct minmea_sentence_rmc *frame, nmea_rmc_t *rmc);
+
+/**
+ * @brief Converts a GGA parsed by minmea to nmea_gga_t.
+ */
+void nmea_gga_from_minmea(const struct minmea_sentence_gga *frame, nmea_gga_t *gga);
+
+#endif // NMEA_PARSER_H
@@ -0,0 +1,598 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+/*
+ * Fuzz target of the GPS NMEA path: nmea_framer -> fast parser (nmea_parser.c) and minmea -> gps_epoch
+ *
+ * Every input is fed to the framer in pieces, as UART reads split it, and every line of it goes straight to
+ * both parsers as well (minmea does not check the checksum, so mangled fields reach its field parsers).
+ * Whenever both parsers read a sentence they must agree on every field, otherwise the test aborts.
+ *
+ * AFL build (make):           one input from stdin per run, see README.md.
+ * gcc build (make INSTR=off): test_sim runs its own mutation loop over the inputs under ASan and UBSan:
+ *     ./test_sim [-n iterations] [-s seed] [-x dictionary] inputs...
+ *     ./test_sim -b inputs...  parser equivalence and throughput check on the inputs and on a generated hour of
+ *                              L96 output (make bench builds it without sanitizers)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include "nmea_framer.h"
+#include "nmea_parser.h"
+#include "nmea_benchmark.h"
+#include "gps_epoch.h"
+
+#define FUZZ_MAX_INPUT          8192    // Bytes of one input
+#define FUZZ_MAX_SEEDS          1024    // Input files
+#define FUZZ_MAX_TOKENS         256     // Dictionary entries
+#define FUZZ_MAX_LINES          4096    // Lines for the benchmark
+#define FUZZ_DEFAULT_ITERATIONS 2000000
+#define FUZZ_BENCH_ROUNDS       2000
+#define FUZZ_MAX_FAST_PERCENT   60      // Fast path time per sentence must stay under this share of minmea's
+#define FUZZ_LOG_EPOCHS         3600    // Epochs of the generated log, an hour at 1 Hz
+#define FUZZ_LOG_SENTENCES      10      // Sentences per epoch in the default L96 output
+#define FUZZ_LOG_ROUNDS         20
+
+static nmea_framer_t framer;
+static gps_epoch_t epoch;
+static uint64_t published_fixes;
+static uint64_t compared_sentences;
+
+/* Reads the published fix, so ASan and UBSan see every field */
+static void fuzz_publish(const gps_fix_t *fix, void *ctx) {
+    volatile int64_t sum = (int64_t)fix->latitude_e6 + fix->longitude_e6 + fix->altitude_dm + fix->speed_mm_s +
+                           fix->course_cdeg + fix->hdop_x100 + fix->satellites + fix->valid;
+    (void)sum;
+    published_fixes++;
+}
+
+static void fuzz_fail(const char *sentence, const char *field) {
+    fprintf(stderr, "Parsers disagree on %s: %s\n", field, sentence);
+    abort();
+}
+
+static void fuzz_compare_time(const char *sentence, const struct minmea_time *a, const struct minmea_time *b) {
+    if (a->hours != b->hours || a->minutes != b->minutes || a->seconds != b->seconds ||
+        a->microseconds != b->microseconds) {
+        fuzz_fail(sentence, "time");
+    }
+}
+
+static void fuzz_compare_rmc(const char *sentence, const nmea_rmc_t *fast) {
+    struct minmea_sentence_rmc frame;
+    nmea_rmc_t rmc;
+    if (!minmea_parse_rmc(&frame, sentence)) {
+        return; // minmea is stricter on some fields (int32 values)
+    }
+    nmea_rmc_from_minmea(&frame, &rmc);
+    compared_sentences++;
+    fuzz_compare_time(sentence, &fast->time, &rmc.time);
+    if (fast->date.day != rmc.date.day || fast->date.month != rmc.date.month || fast->date.year != rmc.date.year) {
+        fuzz_fail(sentence, "date");
+    }
+    if (fast->latitude_e6 != rmc.latitude_e6 || fast->longitude_e6 != rmc.longitude_e6) {
+        fuzz_fail(sentence, "position");
+    }
+    if (fast->speed_mm_s != rmc.speed_mm_s || fast->course_cdeg != rmc.course_cdeg) {
+        fuzz_fail(sentence, "speed/course");
+    }
+    if (fast->valid != rmc.valid) {
+        fuzz_fail(sentence, "status");
+    }
+}
+
+static void fuzz_compare_gga(const char *sentence, const nmea_gga_t *fast) {
+    struct minmea_sentence_gga frame;
+    nmea_gga_t gga;
+    if (!minmea_parse_gga(&frame, sentence)) {
+        return;
+    }
+    nmea_gga_from_minmea(&frame, &gga);
+    compared_sentences++;
+    fuzz_compare_time(sentence, &fast->time, &gga.time);
+    if (fast->latitude_e6 != gga.latitude_e6 || fast->longitude_e6 != gga.longitude_e6) {
+        fuzz_fail(sentence, "position");
+    }
+    if (fast->fix_quality != gga.fix_quality || fast->satellites != gga.satellites) {
+        fuzz_fail(sentence, "quality/satellites");
+    }
+    if (fast->hdop_x100 != gga.hdop_x100 || fast->altitude_dm != gga.altitude_dm) {
+        fuzz_fail(sentence, "hdop/altitude");
+    }
+}
+
+/* Every minmea parser on the sentence, the matching one feeds the epoch like gps_l96.c does */
+static void fuzz_minmea(const char *sentence) {
+    union {
+        struct minmea_sentence_rmc rmc;
+        struct minmea_sentence_gga gga;
+        struct minmea_sentence_gsa gsa;
+        struct minmea_sentence_gsv gsv;
+        struct minmea_sentence_vtg vtg;
+        struct minmea_sentence_gll gll;
+        struct minmea_sentence_gst gst;
+        struct minmea_sentence_zda zda;
+        struct minmea_sentence_gbs gbs;
+    } frame;
+    nmea_rmc_t rmc;
+    nmea_gga_t gga;
+
+    minmea_check(sentence, false);
+    switch (minmea_sentence_id(sentence, false)) {
+        case MINMEA_SENTENCE_RMC:
+            if (minmea_parse_rmc(&frame.rmc, sentence)) {
+                nmea_rmc_from_minmea(&frame.rmc, &rmc);
+                gps_epoch_add_rmc(&epoch, &rmc, 0);
+            }
+            break;
+        case MINMEA_SENTENCE_GGA:
+            if (minmea_parse_gga(&frame.gga, sentence)) {
+                nmea_gga_from_minmea(&frame.gga, &gga);
+                gps_epoch_add_gga(&epoch, &gga, 0);
+            }
+            break;
+        case MINMEA_SENTENCE_GSA:
+            if (minmea_parse_gsa(&frame.gsa, sentence)) {
+                gps_epoch_add_gsa(&epoch, &frame.gsa);
+            }
+            break;
+        default:
+            break;
+    }
+    minmea_parse_gsv(&frame.gsv, sentence);
+    minmea_parse_vtg(&frame.vtg, sentence);
+    minmea_parse_gll(&frame.gll, sentence);
+    minmea_parse_gst(&frame.gst, sentence);
+    minmea_parse_zda(&frame.zda, sentence);
+    minmea_parse_gbs(&frame.gbs, sentence);
+}
+
+static void fuzz_sentence(const char *sentence, void *ctx) {
+    nmea_rmc_t rmc;
+    nmea_gga_t gga;
+
+    if (nmea_parse_rmc(sentence, &rmc)) {
+        fuzz_compare_rmc(sentence, &rmc);
+        gps_epoch_add_rmc(&epoch, &rmc, 0);
+    } else if (nmea_parse_gga(sentence, &gga)) {
+        fuzz_compare_gga(sentence, &gga);
+        gps_epoch_add_gga(&epoch, &gga, 0);
+    }
+    fuzz_minmea(sentence);
+}
+
+/* Small PRNG (xorshift64), seeded from the input in AFL runs so a crash reproduces from the input alone */
+static uint64_t fuzz_random_state = 88172645463325252ULL;
+
+static uint32_t fuzz_random(void) {
+    fuzz_random_state ^= fuzz_random_state << 13;
+    fuzz_random_state ^= fuzz_random_state >> 7;
+    fuzz_random_state ^= fuzz_random_state << 17;
+    return (uint32_t)fuzz_random_state;
+}
+
+static void fuzz_run_input(const uint8_t *data, size_t len) {
+
+    // 1) Through the framer in random pieces, each piece its own heap block so ASan catches reads past it
+    size_t offset = 0;
+    while (offset < len) {
+        size_t piece_len = 1 + fuzz_random() % (len - offset);
+        uint8_t *piece = malloc(piece_len);
+        memcpy(piece, data + offset, piece_len);
+        nmea_framer_feed(&framer, piece, piece_len);
+        free(piece);
+        offset += piece_len;
+    }
+
+    // 2) Every line straight to the parsers, without the framer's checks
+    size_t start = 0;
+    for (size_t i = 0; i <= len; i++) {
+        if (i == len || data[i] == '\n') {
+            size_t line_len = i - start;
+            char *line = malloc(line_len + 1);
+            memcpy(line, data + start, line_len);
+            line[line_len] = '\0';
+            fuzz_sentence(line, NULL);
+            free(line);
+            start = i + 1;
+        }
+    }
+}
+
+static void fuzz_init(void) {
+    nmea_framer_init(&framer, fuzz_sentence, NULL);
+    gps_epoch_init(&epoch, fuzz_publish, NULL);
+}
+
+#ifndef INSTR_IS_OFF
+
+int main(void) {
+    static uint8_t input[FUZZ_MAX_INPUT];
+    size_t len = fread(input, 1, sizeof(input), stdin);
+
+    fuzz_init();
+    for (size_t i = 0; i < len; i++) {
+        fuzz_random_state = fuzz_random_state * 31 + input[i];
+    }
+    fuzz_run_input(input, len);
+    gps_epoch_flush(&epoch);
+    return 0;
+}
+
+#else // INSTR_IS_OFF
+
+typedef struct {
+    uint8_t *data;
+    size_t len;
+} fuzz_blob_t;
+
+static fuzz_blob_t seeds[FUZZ_MAX_SEEDS];
+static size_t seed_count;
+static fuzz_blob_t tokens[FUZZ_MAX_TOKENS];
+static size_t token_count;
+
+static bool fuzz_load_file(const char *path, fuzz_blob_t *blob) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return false;
+    }
+    blob->data = malloc(FUZZ_MAX_INPUT);
+    blob->len = fread(blob->data, 1, FUZZ_MAX_INPUT, file);
+    fclose(file);
+    return true;
+}
+
+static int fuzz_hex_digit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/* AFL dictionary: name="value" lines with \xNN escapes, # comments */
+static void fuzz_load_dictionary(const char *path) {
+    FILE *file = fopen(path, "r");
+    char line[256];
+    if (file == NULL) {
+        fprintf(stderr, "No dictionary %s\n", path);
+        return;
+    }
+    while (fgets(line, sizeof(line), file) != NULL && token_count < FUZZ_MAX_TOKENS) {
+        char *p = strchr(line, '"');
+        if (line[0] == '#' || p == NULL) {
+            continue;
+        }
+        fuzz_blob_t *token = &tokens[token_count];
+        token->data = malloc(strlen(p));
+        token->len = 0;
+        for (p++; *p != '"' && *p != '\0'; p++) {
+            if (p[0] == '\\' && p[1] == 'x' && fuzz_hex_digit(p[2]) >= 0 && fuzz_hex_digit(p[3]) >= 0) {
+                token->data[token->len++] = (uint8_t)(fuzz_hex_digit(p[2]) << 4 | fuzz_hex_digit(p[3]));
+                p += 3;
+            } else {
+                token->data[token->len++] = (uint8_t)*p;
+            }
+        }
+        token_count++;
+    }
+    fclose(file);
+}
+
+static size_t fuzz_insert(uint8_t *buffer, size_t len, size_t at, const uint8_t *data, size_t data_len) {
+    if (len + data_len > FUZZ_MAX_INPUT) {
+        return len;
+    }
+    memmove(buffer + at + data_len, buffer + at, len - at);
+    memcpy(buffer + at, data, data_len);
+    return len + data_len;
+}
+
+/* Recomputes `*XX` of the sentence the byte at `at` is in, so mutated fields get through the checksum checks */
+static void fuzz_fix_checksum(uint8_t *buffer, size_t len, size_t at) {
+    size_t start = at;
+    while (start > 0 && buffer[start] != '$') {
+        start--;
+    }
+    if (buffer[start] != '$') {
+        return;
+    }
+    uint8_t checksum = 0;
+    size_t p = start + 1;
+    while (p < len && buffer[p] != '*' && buffer[p] != '\n') {
+        checksum ^= buffer[p++];
+    }
+    if (p + 2 < len && buffer[p] == '*') {
+        static const char hex[] = "0123456789ABCDEF";
+        buffer[p + 1] = hex[checksum >> 4];
+        buffer[p + 2] = hex[checksum & 0x0F];
+    }
+}
+
+static size_t fuzz_mutate(uint8_t *buffer, size_t len) {
+
+    for (int mutations = 1 + fuzz_random() % 6; mutations > 0; mutations--) {
+        size_t at = len ? fuzz_random() % len : 0;
+        switch (fuzz_random() % 8) {
+            case 0:
+                if (len) buffer[at] ^= 1 << (fuzz_random() % 8);
+                break;
+            case 1:
+                if (len) buffer[at] = (uint8_t)fuzz_random();
+                break;
+            case 2:
+                if (token_count) {
+                    const fuzz_blob_t *token = &tokens[fuzz_random() % token_count];
+                    len = fuzz_insert(buffer, len, at, token->data, token->len);
+                }
+                break;
+            case 3: {
+                size_t cut = len - at ? 1 + fuzz_random() % (len - at) : 0;
+                memmove(buffer + at, buffer + at + cut, len - at - cut);
+                len -= cut;
+                break;
+            }
+            case 4: {
+                // Long runs of one character, longer than the framer carry buffer sometimes
+                static const char run_chars[] = "0123456789,.*$A-";
+                uint8_t run[1400];
+                size_t run_len = 1 + fuzz_random() % sizeof(run);
+                memset(run, run_chars[fuzz_random() % (sizeof(run_chars) - 1)], run_len);
+                len = fuzz_insert(buffer, len, at, run, run_len);
+                break;
+            }
+            case 5: {
+                const fuzz_blob_t *seed = &seeds[fuzz_random() % seed_count];
+                len = fuzz_insert(buffer, len, at, seed->data, seed->len);
+                break;
+            }
+            default:
+                // Twice as likely, most mutations are only interesting once the checksum matches again
+                if (len) fuzz_fix_checksum(buffer, len, at);
+                break;
+        }
+    }
+    return len;
+}
+
+static int fuzz_sim(uint64_t iterations) {
+
+    static uint8_t buffer[FUZZ_MAX_INPUT];
+
+    fuzz_init();
+    for (uint64_t i = 0; i < iterations; i++) {
+        const fuzz_blob_t *seed = &seeds[fuzz_random() % seed_count];
+        memcpy(buffer, seed->data, seed->len);
+        fuzz_run_input(buffer, fuzz_mutate(buffer, seed->len));
+        if (i % 500000 == 0) {
+            fprintf(stderr, "%llu inputs\n", (unsigned long long)i);
+        }
+    }
+    gps_epoch_flush(&epoch);
+
+    nmea_framer_stats_t stats;
+    nmea_framer_get_stats(&framer, &stats);
+    printf("%llu inputs: %lu sentences framed, %lu checksum errors, %lu framing errors, %lu overflows, "
+           "%llu compared with minmea, %llu fixes published\n",
+           (unsigned long long)iterations, stats.sentences, stats.checksum_errors, stats.framing_errors, stats.overflows,
+           (unsigned long long)compared_sentences, (unsigned long long)published_fixes);
+    return 0;
+}
+
+/* Adds one sentence with its checksum, body without '$' and '*' */
+static void fuzz_log_add(char **lines, size_t *count, const char *format, ...) {
+    char body[96];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(body, sizeof(body), format, args);
+    va_end(args);
+
+    uint8_t checksum = 0;
+    for (const char *p = body; *p; p++) {
+        checksum ^= (uint8_t)*p;
+    }
+    lines[*count] = malloc(strlen(body) + 7);
+    sprintf(lines[*count], "$%s*%02X\r\n", body, checksum);
+    (*count)++;
+}
+
+/* Coordinate in NMEA ddmm.mmmm with the given decimals of minutes */
+static void fuzz_log_coord(char *out, size_t size, int deg_digits, int64_t e6, int decimals) {
+    int64_t minutes_e6 = (e6 % 1000000) * 60;
+    int64_t scale = 1;
+    for (int i = decimals; i < 6; i++) {
+        scale *= 10;
+    }
+    snprintf(out, size, "%0*d%02d.%0*lld", deg_digits, (int)(e6 / 1000000), (int)(minutes_e6 / 1000000),
+             decimals, (long long)(minutes_e6 % 1000000 / scale));
+}
+
+/*
+ * An hour of L96 output at 1 Hz with the collar's output mask (RMC, GGA, GPGSA, GLGSA), or with the default one
+ * (also VTG, 3 GPGSV, GLGSV, GLL): a walk with random speed, course, HDOP, satellites and altitude, a quarter in
+ * each hemisphere, a negative altitude and a stretch without a fix every 10 minutes. The default output has
+ * 6 decimals of minutes in its second quarter, these RMC/GGA are over the int32 limit of the fast parser and go
+ * to minmea. Generated here, it is not a recording: there is no captured L96 log of that length in the repo.
+ */
+static size_t fuzz_log_generate(char **lines, bool default_output) {
+    size_t count = 0;
+    int64_t lat_e6 = 46051234, lon_e6 = 14507450;
+    int32_t altitude_dm = 2964;
+
+    for (uint32_t e = 0; e < FUZZ_LOG_EPOCHS; e++) {
+        uint32_t quarter = e * 4 / FUZZ_LOG_EPOCHS;
+        char ns = quarter & 1 ? 'S' : 'N', ew = quarter & 2 ? 'W' : 'E';
+        int decimals = default_output && quarter == 1 ? 6 : 4; // The collar keeps the default 4 decimals
+        bool fix = e % 600 >= 20;
+        char time[16], lat[24], lon[24];
+        snprintf(time, sizeof(time), "%02lu%02lu%02lu.000", 6 + e / 3600, e / 60 % 60, e % 60);
+
+        uint32_t speed_cm_s = fuzz_random() % 300;
+        uint32_t course_cdeg = fuzz_random() % 36000;
+        lat_e6 += speed_cm_s * 9 / 100;
+        lon_e6 += speed_cm_s * 13 / 100;
+        altitude_dm += (int32_t)(fuzz_random() % 5) - 2;
+        int32_t altitude = quarter == 3 ? -altitude_dm / 10 : altitude_dm; // Below sea level
+        uint32_t hdop = 60 + fuzz_random() % 240;
+        uint32_t satellites = 4 + fuzz_random() % 11;
+        uint32_t knots_x100 = speed_cm_s * 100 / 51;
+        fuzz_log_coord(lat, sizeof(lat), 2, lat_e6, decimals);
+        fuzz_log_coord(lon, sizeof(lon), 3, lon_e6, decimals);
+
+        if (fix) {
+            fuzz_log_add(lines, &count, "GNRMC,%s,A,%s,%c,%s,%c,%lu.%02lu,%lu.%02lu,120925,,,A", time, lat, ns, lon, ew,
+                         knots_x100 / 100, knots_x100 % 100, course_cdeg / 100, course_cdeg % 100);
+            if (default_output) {
+                fuzz_log_add(lines, &count, "GNVTG,%lu.%02lu,T,,M,%lu.%02lu,N,%lu.%02lu,K,A", course_cdeg / 100,
+                             course_cdeg % 100, knots_x100 / 100, knots_x100 % 100, speed_cm_s * 36 / 1000,
+                             speed_cm_s * 36 / 10 % 100);
+            }
+            fuzz_log_add(lines, &count, "GNGGA,%s,%s,%c,%s,%c,1,%02lu,%lu.%02lu,%s%ld.%ld,M,47.2,M,,", time, lat, ns,
+                         lon, ew, satellites, hdop / 100, hdop % 100, altitude < 0 ? "-" : "",
+                         labs(altitude) / 10, labs(altitude) % 10);
+            fuzz_log_add(lines, &count, "GPGSA,A,3,10,32,24,12,25,15,,,,,,,%lu.%02lu,%lu.%02lu,0.79",
+                         (hdop + 30) / 100, (hdop + 30) % 100, hdop / 100, hdop % 100);
+            fuzz_log_add(lines, &count, "GLGSA,A,3,81,79,88,,,,,,,,,,%lu.%02lu,%lu.%02lu,0.79",
+                         (hdop + 30) / 100, (hdop + 30) % 100, hdop / 100, hdop % 100);
+        } else {
+            fuzz_log_add(lines, &count, "GNRMC,%s,V,,,,,,,120925,,,N", time);
+            if (default_output) {
+                fuzz_log_add(lines, &count, "GNVTG,,T,,M,,N,,K,N");
+            }
+            fuzz_log_add(lines, &count, "GNGGA,%s,,,,,0,00,,,M,,M,,", time);
+            fuzz_log_add(lines, &count, "GPGSA,A,1,,,,,,,,,,,,,,,");
+            fuzz_log_add(lines, &count, "GLGSA,A,1,,,,,,,,,,,,,,,");
+        }
+        if (!default_output) {
+            continue;
+        }
+        fuzz_log_add(lines, &count, "GPGSV,3,1,10,10,63,137,%02lu,32,56,272,30,24,44,061,36,12,37,302,27",
+                     20 + fuzz_random() % 25);
+        fuzz_log_add(lines, &count, "GPGSV,3,2,10,25,31,215,25,15,22,049,31,18,12,316,,20,09,154,");
+        fuzz_log_add(lines, &count, "GPGSV,3,3,10,26,05,098,,29,03,004,");
+        fuzz_log_add(lines, &count, "GLGSV,1,1,03,81,58,041,29,79,34,323,24,88,20,102,30");
+        if (fix) {
+            fuzz_log_add(lines, &count, "GNGLL,%s,%c,%s,%c,%s,A,A", lat, ns, lon, ew, time);
+        } else {
+            fuzz_log_add(lines, &count, "GNGLL,,,,,%s,V,N", time);
+        }
+    }
+    return count;
+}
+
+static int fuzz_bench_check(const char *name, const nmea_benchmark_result_t *result, uint32_t rounds,
+                            uint32_t max_percent) {
+    printf("%s: %lu sentences x %lu: fast %lu ns, minmea %lu ns per sentence (%lu%%), %lu fast / %lu minmea parsed, "
+           "%lu mismatches\n", name, result->sentences, rounds, result->fast_ns, result->minmea_ns,
+           result->minmea_ns ? result->fast_ns * 100 / result->minmea_ns : 0,
+           result->fast_parsed, result->minmea_parsed, result->mismatches);
+
+    if (result->mismatches > 0) {
+        fprintf(stderr, "FAIL: the parsers disagree on %s\n", name);
+        return 1;
+    }
+    if ((uint64_t)result->fast_ns * 100 > (uint64_t)result->minmea_ns * max_percent) {
+        fprintf(stderr, "FAIL: fast path above %lu%% of minmea on %s\n", max_percent, name);
+        return 1;
+    }
+    return 0;
+}
+
+/*
+ * Lines of all inputs and the generated hour of L96 output through nmea_benchmark_run(), fails on a mismatch or
+ * if the fast path got slow. nmea_benchmark_log() logs its built-in epochs first, as it would on the collar.
+ */
+static int fuzz_bench(void) {
+
+    static const char *lines[FUZZ_MAX_LINES];
+    size_t line_count = 0;
+
+    for (size_t i = 0; i < seed_count; i++) {
+        char *text = (char *)seeds[i].data;
+        text[seeds[i].len < FUZZ_MAX_INPUT ? seeds[i].len : FUZZ_MAX_INPUT - 1] = '\0';
+        for (char *line = strtok(text, "\n"); line != NULL && line_count < FUZZ_MAX_LINES; line = strtok(NULL, "\n")) {
+            if (line[0] == '$') {
+                lines[line_count++] = line;
+            }
+        }
+    }
+
+    nmea_benchmark_log();
+    fflush(stderr);
+
+    nmea_benchmark_result_t result;
+    if (nmea_benchmark_run(lines, line_count, FUZZ_BENCH_ROUNDS, &result) != ESP_OK) {
+        fprintf(stderr, "No sentences\n");
+        return 1;
+    }
+    int failed = fuzz_bench_check("inputs", &result, FUZZ_BENCH_ROUNDS, FUZZ_MAX_FAST_PERCENT);
+
+    static const struct {
+        const char *name;
+        bool default_output;
+        uint32_t max_percent;
+    } logs[] = {
+        { "generated hour, collar mask",    false, FUZZ_MAX_FAST_PERCENT },
+        { "generated hour, default output", true,  100 }, // VTG, GSV and GLL cost the same on both paths
+    };
+    char **log = malloc(FUZZ_LOG_EPOCHS * FUZZ_LOG_SENTENCES * sizeof(char *));
+    for (size_t i = 0; i < sizeof(logs) / sizeof(logs[0]); i++) {
+        size_t log_count = fuzz_log_generate(log, logs[i].default_output);
+        if (nmea_benchmark_run((const char *const *)log, log_count, FUZZ_LOG_ROUNDS, &result) != ESP_OK) {
+            fprintf(stderr, "No sentences in %s\n", logs[i].name);
+            failed++;
+        } else {
+            failed += fuzz_bench_check(logs[i].name, &result, FUZZ_LOG_ROUNDS, logs[i].max_percent);
+        }
+        for (size_t j = 0; j < log_count; j++) {
+            free(log[j]);
+        }
+    }
+    free(log);
+    return failed ? 1 : 0;
+}
+
+int main(int argc, char **argv) {
+
+    uint64_t iterations = FUZZ_DEFAULT_ITERATIONS;
+    const char *dictionary = "nmea.dict";
+    bool bench = false;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:s:x:b")) != -1) {
+        switch (opt) {
+            case 'n': iterations = strtoull(optarg, NULL, 10); break;
+            case 's': fuzz_random_state ^= strtoull(optarg, NULL, 10) * 0x9E3779B97F4A7C15ULL; break; // Non-zero for any seed
+            case 'x': dictionary = optarg; break;
+            case 'b': bench = true; break;
+            default:
+                fprintf(stderr, "Usage: %s [-n iterations] [-s seed] [-x dictionary] [-b] inputs...\n", argv[0]);
+                return 2;
+        }
+    }
+    for (int i = optind; i < argc && seed_count < FUZZ_MAX_SEEDS; i++) {
+        if (!fuzz_load_file(argv[i], &seeds[seed_count])) {
+            fprintf(stderr, "Can not read %s\n", argv[i]);
+            return 2;
+        }
+        seed_count++;
+    }
+    if (seed_count == 0) {
+        fprintf(stderr, "No inputs\n");
+        return 2;
+    }
+    if (bench) {
+        return fuzz_bench();
+    }
+    fuzz_load_dictionary(dictionary);
+    return fuzz_sim(iterations);
+}
+
+#endif // INSTR_IS_OFF
@@ -0,0 +1,414 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+/*
+ * Host replay test of the fix assembler (gps_epoch.c). L96 epochs are fed line by line through
+ * gps_l96_extract_and_process_nmea_sentences(), the same path the GPS ingest task uses, and every fix must be
+ * published once, with the right fields, as soon as its epoch is complete:
+ *
+ * - recorded epochs with the edge cases: missing GSA, duplicate GSA, time change in the middle of an epoch
+ * - the L96 logs of the fuzz corpus, with the number of fixes each one has
+ * - substitute_walk.nmea: 12 epochs of a walk in the full default L96 output (VTG, GSV, GLL too) with lost GSA,
+ *   RMC after GGA and GSA, GSA before GGA, an RMC with a bit error and a GGA cut by lost bytes. It is generated,
+ *   not a capture from a collar: no L96 log is recorded in the repo yet, replace it with one when there is
+ * - parse throughput of a log replayed over and over
+ *
+ *     ./test_epoch [-n passes] [-d log_dir]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include "esp_timer.h"
+#include "gps_l96.h"
+
+#define TEST_SENTENCE_SIZE      96      // Longest sentence with "*XX\r\n"
+#define TEST_MAX_FIXES          16
+#define TEST_FLUSH              SIZE_MAX // Fix published by gps_l96_reset_nmea_framer() after the last sentence
+#define TEST_LATITUDE_E6        46052056 // 4603.1234,N
+#define TEST_LONGITUDE_E6       14509463 // 01430.5678,E
+#define TEST_SUBSTITUTE_LOG     "substitute_walk.nmea"
+
+#define RMC(t)      "$GNRMC," t ".000,A,4603.1234,N,01430.5678,E,1.20,45.52,170525,,,A"
+#define RMC_V(t)    "$GNRMC," t ".000,V,,,,,,,170525,,,N"
+#define GGA(t)      "$GNGGA," t ".000,4603.1234,N,01430.5678,E,1,09,0.92,296.4,M,47.2,M,,"
+#define GGA_0(t)    "$GNGGA," t ".000,,,,,0,00,,,M,,M,,"
+#define GPGSA       "$GPGSA,A,3,10,32,24,12,25,15,,,,,,,1.21,0.92,0.79"
+#define GLGSA       "$GLGSA,A,3,81,79,88,,,,,,,,,,1.21,0.92,0.79"
+#define GPGSA_2D    "$GPGSA,A,2,10,32,24,,,,,,,,,,1.50,1.21,0.88"
+#define GPGSA_NONE  "$GPGSA,A,1,,,,,,,,,,,,,,,"
+
+typedef struct {
+    uint32_t time;              // hhmmss
+    size_t after;               // Index of the sentence that publishes it, TEST_FLUSH for the flush
+    bool rmc;                   // Has the position of an RMC with a fix
+    int32_t altitude_dm;
+    uint16_t hdop_x100;
+    uint8_t satellites;
+} test_fix_t;
+
+typedef struct {
+    const char *name;
+    const char *const *sentences;
+    size_t count;
+    const test_fix_t *fixes;
+    size_t fix_count;
+    gps_epoch_stats_t stats;    // Complete, incomplete and dropped epochs
+} test_case_t;
+
+typedef struct {
+    const char *file;
+    uint32_t fixes;
+    gps_epoch_stats_t stats;
+} test_log_t;
+
+/* Fix of a log with a moving position: only checked to be valid and north-east of the one before */
+typedef struct {
+    uint32_t time;              // hhmmss
+    int32_t altitude_dm;
+    uint16_t hdop_x100;
+    uint8_t satellites;
+} test_walk_fix_t;
+
+/* GPIO expander of the collar, gps_l96.c only uses it to reset the module */
+uint8_t gpio_expander_get_output_state(void) {
+    return 0;
+}
+
+void gpio_expander_update_output_state(uint8_t state) {
+}
+
+esp_err_t gpio_read_inputs(uint8_t *input_state) {
+    *input_state = 0;
+    return ESP_OK;
+}
+
+static struct {
+    gps_fix_t fixes[TEST_MAX_FIXES];
+    size_t after[TEST_MAX_FIXES];
+    size_t count;
+    size_t sentence;            // Index of the sentence being fed
+    uint32_t total;             // All fixes, also past TEST_MAX_FIXES
+} published;
+
+static void test_fix_listener(const gps_fix_t *fix) {
+    if (published.count < TEST_MAX_FIXES) {
+        published.fixes[published.count] = *fix;
+        published.after[published.count] = published.sentence;
+        published.count++;
+    }
+    published.total++;
+}
+
+static size_t test_add_sentence(char *out, const char *body) {
+    uint8_t checksum = 0;
+    for (const char *p = body + 1; *p; p++) {
+        checksum ^= (uint8_t)*p;
+    }
+    return (size_t)sprintf(out, "%s*%02X\r\n", body, checksum);
+}
+
+/* The state machine takes the fixes, the queue never fills up */
+static void test_take_fixes(void) {
+    gps_fix_t fix;
+    while (gps_l96_get_next_fix(&fix)) {
+    }
+}
+
+/* One line per call, like the ingest task reads it after a '\n' pattern event */
+static void test_feed_line(const char *line, size_t len) {
+    uint8_t buffer[TEST_SENTENCE_SIZE * 2];
+    memcpy(buffer, line, len);
+    gps_l96_extract_and_process_nmea_sentences(buffer, len);
+    test_take_fixes();
+}
+
+/* Ends the replay like GPS stop does and returns the epoch stats since the last call */
+static void test_finish(gps_epoch_stats_t *stats) {
+    static gps_epoch_stats_t last;
+    gps_epoch_stats_t now;
+
+    gps_l96_reset_nmea_framer();
+    test_take_fixes();
+    gps_l96_get_epoch_stats(&now);
+    stats->complete = now.complete - last.complete;
+    stats->incomplete = now.incomplete - last.incomplete;
+    stats->dropped = now.dropped - last.dropped;
+    last = now;
+}
+
+static bool test_same_stats(const gps_epoch_stats_t *a, const gps_epoch_stats_t *b) {
+    return a->complete == b->complete && a->incomplete == b->incomplete && a->dropped == b->dropped;
+}
+
+static int test_check_fix(const test_case_t *tc, size_t i) {
+    const test_fix_t *want = &tc->fixes[i];
+    const gps_fix_t *got = &published.fixes[i];
+    uint32_t time = got->time.hours * 10000 + got->time.minutes * 100 + got->time.seconds;
+
+    if (time == want->time && published.after[i] == want->after && got->valid == want->rmc &&
+        got->latitude_e6 == (want->rmc ? TEST_LATITUDE_E6 : 0) &&
+        got->longitude_e6 == (want->rmc ? TEST_LONGITUDE_E6 : 0) &&
+        got->altitude_dm == want->altitude_dm && got->hdop_x100 == want->hdop_x100 &&
+        got->satellites == want->satellites) {
+        return 0;
+    }
+    fprintf(stderr, "%s: fix %zu is %06lu after %zd (valid %d, %ld/%ld, altitude %ld dm, hdop %u, %u satellites), "
+            "expected %06lu after %zd\n", tc->name, i, time, (ssize_t)published.after[i], got->valid,
+            got->latitude_e6, got->longitude_e6, got->altitude_dm, got->hdop_x100, got->satellites,
+            want->time, (ssize_t)want->after);
+    return 1;
+}
+
+static int test_run_case(const test_case_t *tc) {
+    char line[TEST_SENTENCE_SIZE];
+    gps_epoch_stats_t stats;
+
+    memset(&published, 0, sizeof(published));
+    for (size_t i = 0; i < tc->count; i++) {
+        published.sentence = i;
+        test_feed_line(line, test_add_sentence(line, tc->sentences[i]));
+    }
+    published.sentence = TEST_FLUSH;
+    test_finish(&stats);
+
+    int failed = 0;
+    if (published.count != tc->fix_count || !test_same_stats(&stats, &tc->stats)) {
+        fprintf(stderr, "%s: %zu fixes (%lu complete, %lu incomplete, %lu dropped), expected %zu (%lu, %lu, %lu)\n",
+                tc->name, published.count, stats.complete, stats.incomplete, stats.dropped,
+                tc->fix_count, tc->stats.complete, tc->stats.incomplete, tc->stats.dropped);
+        failed = 1;
+    }
+    for (size_t i = 0; i < published.count && i < tc->fix_count; i++) {
+        failed |= test_check_fix(tc, i);
+    }
+    printf("%-28s %2zu sentences, %zu fixes (%lu complete, %lu incomplete, %lu dropped) %s\n", tc->name,
+           tc->count, published.count, stats.complete, stats.incomplete, stats.dropped, failed ? "FAILED" : "ok");
+    return failed;
+}
+
+static char *test_read_log(const char *dir, const char *file, size_t *len) {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/%s", dir, file);
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char *data = malloc(size + 1);
+    *len = fread(data, 1, size, f);
+    data[*len] = '\0';
+    fclose(f);
+    return data;
+}
+
+/* Feeds a log line by line, returns the number of lines */
+static uint32_t test_replay(const char *data, size_t len) {
+    uint32_t lines = 0;
+    for (size_t offset = 0; offset < len; lines++) {
+        const char *end = memchr(data + offset, '\n', len - offset);
+        size_t line_len = end ? (size_t)(end - data - offset) + 1 : len - offset;
+        if (line_len > TEST_SENTENCE_SIZE * 2) {
+            line_len = TEST_SENTENCE_SIZE * 2;
+        }
+        test_feed_line(data + offset, line_len);
+        offset += line_len;
+    }
+    return lines;
+}
+
+static int test_run_log(const char *dir, const test_log_t *log) {
+    size_t len;
+    gps_epoch_stats_t stats;
+    char *data = test_read_log(dir, log->file, &len);
+    if (data == NULL) {
+        fprintf(stderr, "%s/%s: cannot read\n", dir, log->file);
+        return 1;
+    }
+
+    memset(&published, 0, sizeof(published));
+    uint32_t lines = test_replay(data, len);
+    test_finish(&stats);
+    free(data);
+
+    int failed = published.total != log->fixes || !test_same_stats(&stats, &log->stats);
+    printf("%-28s %2lu lines,     %lu fixes (%lu complete, %lu incomplete, %lu dropped) %s\n", log->file, lines,
+           published.total, stats.complete, stats.incomplete, stats.dropped, failed ? "FAILED" : "ok");
+    return failed;
+}
+
+static int test_run_walk(const char *dir, const test_log_t *log, const test_walk_fix_t *fixes) {
+    int failed = test_run_log(dir, log);
+
+    for (size_t i = 0; i < published.count && i < log->fixes; i++) {
+        const gps_fix_t *got = &published.fixes[i];
+        const test_walk_fix_t *want = &fixes[i];
+        uint32_t time = got->time.hours * 10000 + got->time.minutes * 100 + got->time.seconds;
+        bool moved = i == 0 || (got->latitude_e6 > published.fixes[i - 1].latitude_e6 &&
+                                got->longitude_e6 > published.fixes[i - 1].longitude_e6);
+
+        if (time != want->time || !got->valid || !moved || got->altitude_dm != want->altitude_dm ||
+            got->hdop_x100 != want->hdop_x100 || got->satellites != want->satellites) {
+            fprintf(stderr, "%s: fix %zu is %06lu (valid %d, %ld/%ld, altitude %ld dm, hdop %u, %u satellites), "
+                    "expected %06lu (altitude %ld dm, hdop %u, %u satellites)\n", log->file, i, time, got->valid,
+                    got->latitude_e6, got->longitude_e6, got->altitude_dm, got->hdop_x100, got->satellites,
+                    want->time, want->altitude_dm, want->hdop_x100, want->satellites);
+            failed = 1;
+        }
+    }
+    return failed;
+}
+
+/* The log with the collar's output mask, replayed passes times, every pass starts a new epoch */
+static int test_throughput(const char *dir, const char *file, uint32_t passes, uint32_t fixes_per_pass) {
+    size_t len;
+    gps_epoch_stats_t stats;
+    char *data = test_read_log(dir, file, &len);
+    if (data == NULL) {
+        fprintf(stderr, "%s/%s: cannot read\n", dir, file);
+        return 1;
+    }
+
+    memset(&published, 0, sizeof(published));
+    uint64_t lines = 0;
+    int64_t start_us = esp_timer_get_time();
+    for (uint32_t pass = 0; pass < passes; pass++) {
+        lines += test_replay(data, len);
+    }
+    int64_t elapsed_us = esp_timer_get_time() - start_us;
+    test_finish(&stats);
+    free(data);
+
+    double seconds = elapsed_us > 0 ? elapsed_us / 1e6 : 1e-6;
+    printf("%-28s %llu sentences, %lu fixes, %.0f sentences/s, %.0f fixes/s, %.0f ns/sentence\n", "throughput",
+           (unsigned long long)lines, published.total, lines / seconds, published.total / seconds,
+           elapsed_us * 1000.0 / lines);
+
+    if (published.total != passes * fixes_per_pass || stats.complete != published.total) {
+        fprintf(stderr, "throughput: %lu fixes (%lu complete), expected %lu\n", published.total, stats.complete,
+                passes * fixes_per_pass);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    uint32_t passes = 20000;
+    const char *log_dir = "../test_afl_fuzz_host/in";
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:d:")) != -1) {
+        switch (opt) {
+            case 'n': passes = strtoul(optarg, NULL, 10); break;
+            case 'd': log_dir = optarg; break;
+            default:
+                fprintf(stderr, "Usage: %s [-n passes] [-d log_dir]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    static const char *const complete[] = { RMC("101500"), GGA("101500"), GPGSA, GLGSA,
+                                            RMC("101501"), GGA("101501"), GPGSA, GLGSA };
+    static const test_fix_t complete_fixes[] = {
+        { 101500, 2, true, 2964, 92, 9 },
+        { 101501, 6, true, 2964, 92, 9 },
+    };
+    static const char *const missing_gsa[] = { RMC("101500"), GGA("101500"),
+                                               RMC("101501"), GGA("101501"), GPGSA, GLGSA,
+                                               RMC("101502"), GGA("101502") };
+    static const test_fix_t missing_gsa_fixes[] = {
+        { 101500, 2, true, 2964, 92, 9 },           // When the next epoch starts
+        { 101501, 4, true, 2964, 92, 9 },
+        { 101502, TEST_FLUSH, true, 2964, 92, 9 },  // Last one when the GPS stops
+    };
+    static const char *const duplicate_gsa[] = { RMC("101500"), GGA("101500"), GPGSA, GPGSA, GLGSA, GPGSA_2D,
+                                                 RMC("101500"), GGA("101500"), GPGSA };
+    static const test_fix_t duplicate_gsa_fixes[] = {
+        { 101500, 2, true, 2964, 92, 9 },           // Once, the 2D GSA and the repeated epoch change nothing
+    };
+    static const char *const time_change[] = { RMC("101500"), GGA("101501"), GPGSA,
+                                               RMC("101502"), GGA("101502"), GPGSA,
+                                               RMC("101503"), GPGSA, GGA("101504"), GPGSA, RMC("101504") };
+    static const test_fix_t time_change_fixes[] = {
+        { 101500, 1, true, GPS_FIX_ALTITUDE_UNKNOWN, GPS_FIX_HDOP_UNKNOWN, 0 }, // RMC only, GGA of the next epoch
+        { 101502, 5, true, 2964, 92, 9 },           // GGA and GSA of 101501 without RMC are dropped
+        { 101503, 8, true, GPS_FIX_ALTITUDE_UNKNOWN, 92, 0 }, // RMC and GSA, HDOP from GSA
+        { 101504, 10, true, 2964, 92, 9 },          // RMC after GGA and GSA of the same epoch
+    };
+    static const char *const mid_epoch_start[] = { GPGSA, GLGSA, GGA("101500"), GPGSA,
+                                                   RMC("101501"), GGA("101501"), GPGSA };
+    static const test_fix_t mid_epoch_start_fixes[] = {
+        { 101501, 6, true, 2964, 92, 9 },           // GSA without an epoch is ignored, GGA without RMC dropped
+    };
+    static const char *const fix_2d[] = { RMC("101500"), GGA("101500"), GPGSA_2D };
+    static const test_fix_t fix_2d_fixes[] = {
+        { 101500, 2, true, GPS_FIX_ALTITUDE_UNKNOWN, 92, 9 }, // Altitude of a 2D fix is not measured
+    };
+    static const char *const no_fix[] = { RMC_V("101500"), GGA_0("101500"), GPGSA_NONE };
+    static const test_fix_t no_fix_fixes[] = {
+        { 101500, 2, false, GPS_FIX_ALTITUDE_UNKNOWN, GPS_FIX_HDOP_UNKNOWN, 0 },
+    };
+
+#define TEST_CASE(name, s, f, c, i, d) { name, s, sizeof(s) / sizeof(s[0]), f, sizeof(f) / sizeof(f[0]), { c, i, d } }
+    static const test_case_t cases[] = {
+        TEST_CASE("complete epochs",            complete,           complete_fixes,         2, 0, 0),
+        TEST_CASE("missing GSA",                missing_gsa,        missing_gsa_fixes,      1, 2, 0),
+        TEST_CASE("duplicate GSA",              duplicate_gsa,      duplicate_gsa_fixes,    1, 0, 0),
+        TEST_CASE("time change mid-epoch",      time_change,        time_change_fixes,      2, 2, 1),
+        TEST_CASE("start in the middle",        mid_epoch_start,    mid_epoch_start_fixes,  1, 0, 1),
+        TEST_CASE("2D fix",                     fix_2d,             fix_2d_fixes,           1, 0, 0),
+        TEST_CASE("no fix yet",                 no_fix,             no_fix_fixes,           1, 0, 0),
+    };
+#undef TEST_CASE
+
+    static const test_log_t logs[] = {
+        { "boot.nmea",                  1, { 1, 0, 0 } },
+        { "baud_probe.nmea",            0, { 0, 0, 0 } },
+        { "cold_start.nmea",            2, { 2, 0, 0 } },
+        { "fix.nmea",                   3, { 3, 0, 0 } },
+        { "fix_default_output.nmea",    1, { 1, 0, 0 } },
+        { "southwest.nmea",             1, { 1, 0, 0 } },
+        { "stationary.nmea",            2, { 0, 2, 0 } }, // Output mask without GSA
+    };
+
+    static const test_log_t walk = { TEST_SUBSTITUTE_LOG, 11, { 8, 3, 1 } };
+    static const test_walk_fix_t walk_fixes[] = {
+        { 72010, 3012, 80, 10 },
+        { 72011, 3013, 81, 10 },
+        { 72012, 3014, 82, 10 },
+        { 72013, 3015, 83, 10 },                    // GSA lost, published when the next epoch starts
+        { 72014, 3016, 84, 10 },                    // RMC after GGA and GSA
+        { 72015, 3017, 85, 10 },                    // GSA before GGA
+                                                    // 072016: RMC checksum error, GGA and GSA dropped
+        { 72017, GPS_FIX_ALTITUDE_UNKNOWN, 87, 0 }, // GGA cut, HDOP from GSA
+        { 72018, GPS_FIX_ALTITUDE_UNKNOWN, 88, 10 },// 2D fix
+        { 72019, 3021, 89, 10 },                    // Only GLGSA
+        { 72020, 3022, 90, 10 },
+        { 72021, 3023, 91, 10 },                    // Log ends before the GSA
+    };
+
+    gps_l96_set_fix_listener(test_fix_listener);
+    int failed = 0;
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        failed += test_run_case(&cases[i]);
+    }
+    for (size_t i = 0; i < sizeof(logs) / sizeof(logs[0]); i++) {
+        failed += test_run_log(log_dir, &logs[i]);
+    }
+    failed += test_run_walk(".", &walk, walk_fixes);
+    failed += test_throughput(log_dir, "fix.nmea", passes, 3);
+    gps_l96_set_fix_listener(NULL);
+
+    if (failed) {
+        fprintf(stderr, "%d epoch cases failed\n", failed);
+        return 1;
+    }
+    return 0;
+}
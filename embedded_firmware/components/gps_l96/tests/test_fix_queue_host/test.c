@@ -0,0 +1,287 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+/*
+ * Host test of gps_fix_queue.c, the lock-free queue from the GPS ingest task (producer) to the state machine
+ * (consumer). A producer and a consumer thread pass numbered fixes through it:
+ *
+ * - a consumer that keeps up, for the push to pop latency
+ * - a consumer slower than the producer, every fix that does not fit must be counted in dropped
+ *
+ * Every popped fix must be whole (all fields from the same push) and newer than the one before. Single thread
+ * cases check the full queue and the wrap of the head and tail counters.
+ *
+ *     ./test_fix_queue [-n fixes]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <limits.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include "gps_fix_queue.h"
+
+#define TEST_PUSH_INTERVAL_US       100     // Producer, 10 kHz instead of the 1 Hz of the L96
+#define TEST_SLOW_POP_INTERVAL_US   2000    // Slow consumer, 20 pushes per pop
+#define TEST_MAX_KEEP_UP_DROPS_PCT  1       // Consumer that keeps up may only lose fixes when the machine is loaded
+
+typedef struct {
+    const char *name;
+    uint32_t pop_interval_us;   // Consumer sleep between pops, 0 to yield only when the queue is empty
+} test_case_t;
+
+typedef struct {
+    gps_fix_queue_t queue;
+    uint32_t fixes;
+    uint32_t pop_interval_us;
+    atomic_bool done;           // Producer pushed the last fix
+
+    // Producer
+    uint32_t push_failed;
+
+    // Consumer
+    uint32_t popped;
+    uint32_t torn;              // Fields of different pushes in one fix
+    uint32_t out_of_order;
+    int64_t *latency_ns;        // Push to pop of every popped fix
+} test_run_t;
+
+static int64_t test_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void test_sleep_us(uint32_t us) {
+    struct timespec ts = { .tv_sec = us / 1000000, .tv_nsec = (us % 1000000) * 1000L };
+    nanosleep(&ts, NULL);
+}
+
+/* All fields come from the sequence number, so a fix copied while it was written is caught */
+static void test_make_fix(gps_fix_t *fix, uint32_t seq) {
+    memset(fix, 0, sizeof(*fix));
+    fix->latitude_e6 = (int32_t)seq;
+    fix->longitude_e6 = -(int32_t)seq;
+    fix->speed_mm_s = seq * 7;
+    fix->altitude_dm = (int32_t)(seq ^ 0x5A5A5A5A);
+    fix->satellites = (uint8_t)seq;
+    fix->time.seconds = seq % 60;
+    fix->rx_time_us = test_now_ns(); // Push time in ns, for the latency
+}
+
+static bool test_fix_whole(const gps_fix_t *fix) {
+    uint32_t seq = (uint32_t)fix->latitude_e6;
+    return fix->longitude_e6 == -(int32_t)seq && fix->speed_mm_s == seq * 7 &&
+           fix->altitude_dm == (int32_t)(seq ^ 0x5A5A5A5A) && fix->satellites == (uint8_t)seq &&
+           fix->time.seconds == (int)(seq % 60);
+}
+
+static void *test_producer(void *arg) {
+    test_run_t *run = arg;
+    gps_fix_t fix;
+
+    for (uint32_t seq = 1; seq <= run->fixes; seq++) {
+        test_make_fix(&fix, seq);
+        if (!gps_fix_queue_push(&run->queue, &fix)) {
+            run->push_failed++;
+        }
+        test_sleep_us(TEST_PUSH_INTERVAL_US);
+    }
+    atomic_store(&run->done, true);
+    return NULL;
+}
+
+static void *test_consumer(void *arg) {
+    test_run_t *run = arg;
+    uint32_t last = 0;
+    gps_fix_t fix;
+
+    while (true) {
+        bool done = atomic_load(&run->done); // Before the pop, a fix pushed before done is never missed
+        if (!gps_fix_queue_pop(&run->queue, &fix)) {
+            if (done) {
+                break;
+            }
+            if (run->pop_interval_us == 0) {
+                sched_yield();
+            } else {
+                test_sleep_us(run->pop_interval_us);
+            }
+            continue;
+        }
+        run->latency_ns[run->popped++] = test_now_ns() - fix.rx_time_us;
+
+        uint32_t seq = (uint32_t)fix.latitude_e6;
+        if (!test_fix_whole(&fix)) {
+            run->torn++;
+        }
+        if (seq <= last) {
+            run->out_of_order++;
+        }
+        last = seq;
+        if (run->pop_interval_us > 0) {
+            test_sleep_us(run->pop_interval_us);
+        }
+    }
+    return NULL;
+}
+
+static int test_compare_ns(const void *a, const void *b) {
+    int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static int test_run_case(const test_case_t *tc, uint32_t fixes) {
+    static test_run_t run;
+    pthread_t producer, consumer;
+
+    memset(&run, 0, sizeof(run));
+    gps_fix_queue_init(&run.queue);
+    run.fixes = fixes;
+    run.pop_interval_us = tc->pop_interval_us;
+    run.latency_ns = calloc(fixes, sizeof(run.latency_ns[0]));
+    atomic_init(&run.done, false);
+
+    pthread_create(&consumer, NULL, test_consumer, &run);
+    pthread_create(&producer, NULL, test_producer, &run);
+    pthread_join(producer, NULL);
+    pthread_join(consumer, NULL);
+
+    uint32_t dropped = run.queue.dropped;
+    int failed = 0;
+    printf("%-22s %6lu pushed, %6lu popped, %6lu dropped, %lu torn, %lu out of order\n", tc->name,
+           fixes, run.popped, dropped, run.torn, run.out_of_order);
+    if (run.popped > 0) {
+        qsort(run.latency_ns, run.popped, sizeof(run.latency_ns[0]), test_compare_ns);
+        printf("%-22s push to pop min %6lld ns, median %6lld ns, p99 %8lld ns, max %8lld ns\n", "",
+               run.latency_ns[0], run.latency_ns[run.popped / 2], run.latency_ns[run.popped * 99 / 100],
+               run.latency_ns[run.popped - 1]);
+    }
+
+    if (run.popped + dropped != fixes || dropped != run.push_failed || run.torn != 0 || run.out_of_order != 0) {
+        fprintf(stderr, "%s: %lu popped + %lu dropped of %lu pushes, %lu failed pushes\n", tc->name, run.popped,
+                dropped, fixes, run.push_failed);
+        failed = 1;
+    }
+    if (tc->pop_interval_us == 0 && dropped * 100 > (uint64_t)fixes * TEST_MAX_KEEP_UP_DROPS_PCT) {
+        fprintf(stderr, "%s: %lu fixes dropped by a consumer that keeps up\n", tc->name, dropped);
+        failed = 1;
+    }
+    if (tc->pop_interval_us > 0 && dropped == 0) {
+        fprintf(stderr, "%s: slow consumer, but no fix dropped\n", tc->name);
+        failed = 1;
+    }
+    free(run.latency_ns);
+    return failed;
+}
+
+/* Full queue drops the newest fix and keeps the ones in it, in order */
+static int test_full(void) {
+    static gps_fix_queue_t queue;
+    gps_fix_t fix;
+    uint32_t seq = 1;
+
+    gps_fix_queue_init(&queue);
+    for (; seq <= GPS_FIX_QUEUE_SIZE; seq++) {
+        test_make_fix(&fix, seq);
+        if (!gps_fix_queue_push(&queue, &fix)) {
+            fprintf(stderr, "full: push %lu of %d failed\n", seq, GPS_FIX_QUEUE_SIZE);
+            return 1;
+        }
+    }
+    test_make_fix(&fix, seq);
+    if (gps_fix_queue_push(&queue, &fix) || queue.dropped != 1) {
+        fprintf(stderr, "full: push into a full queue, %lu dropped\n", queue.dropped);
+        return 1;
+    }
+    for (uint32_t expected = 1; expected <= GPS_FIX_QUEUE_SIZE; expected++) {
+        if (!gps_fix_queue_pop(&queue, &fix) || (uint32_t)fix.latitude_e6 != expected || !test_fix_whole(&fix)) {
+            fprintf(stderr, "full: pop %lu\n", expected);
+            return 1;
+        }
+    }
+    if (gps_fix_queue_pop(&queue, &fix)) {
+        fprintf(stderr, "full: pop from an empty queue\n");
+        return 1;
+    }
+    printf("%-22s push %d fails, %d in order, then empty\n", "full queue", GPS_FIX_QUEUE_SIZE + 1,
+           GPS_FIX_QUEUE_SIZE);
+    return 0;
+}
+
+/* Head and tail are free running counters, they must keep working when they wrap */
+static int test_wrap(void) {
+    static gps_fix_queue_t queue;
+    gps_fix_t fix;
+    uint32_t next_pop = 1;
+
+    gps_fix_queue_init(&queue);
+    atomic_store(&queue.head, UINT_MAX - 2);
+    atomic_store(&queue.tail, UINT_MAX - 2);
+    // Rounds of 1 to GPS_FIX_QUEUE_SIZE pushes, then pops until empty, so empty and full are checked across the wrap
+    uint32_t seq = 1;
+    for (uint32_t round = 0; seq <= 4 * GPS_FIX_QUEUE_SIZE; round++) {
+        for (uint32_t i = 0; i <= round % GPS_FIX_QUEUE_SIZE; i++, seq++) {
+            test_make_fix(&fix, seq);
+            if (!gps_fix_queue_push(&queue, &fix)) {
+                fprintf(stderr, "wrap: push %lu failed\n", seq);
+                return 1;
+            }
+        }
+        while (gps_fix_queue_pop(&queue, &fix)) {
+            if ((uint32_t)fix.latitude_e6 != next_pop++ || !test_fix_whole(&fix)) {
+                fprintf(stderr, "wrap: pop %lu\n", next_pop - 1);
+                return 1;
+            }
+        }
+    }
+    if (next_pop != seq || queue.dropped != 0 || atomic_load(&queue.head) >= seq) {
+        fprintf(stderr, "wrap: %lu of %lu fixes popped\n", next_pop - 1, seq - 1);
+        return 1;
+    }
+    printf("%-22s head and tail wrapped, %lu fixes in order\n", "counter wrap", seq - 1);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    uint32_t fixes = 10000;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        switch (opt) {
+            case 'n': fixes = strtoul(optarg, NULL, 10); break;
+            default:
+                fprintf(stderr, "Usage: %s [-n fixes]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (fixes == 0) {
+        fprintf(stderr, "At least 1 fix\n");
+        return 2;
+    }
+
+    static const test_case_t cases[] = {
+        { "consumer keeps up",  0 },
+        { "slow consumer",      TEST_SLOW_POP_INTERVAL_US },
+    };
+
+    int failed = test_full();
+    failed += test_wrap();
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        failed += test_run_case(&cases[i], fixes);
+    }
+
+    if (failed) {
+        fprintf(stderr, "%d fix queue cases failed\n", failed);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,299 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+/*
+ * Host test of nmea_framer.c: L96 epochs (RMC, GGA, GSA) are fed in random pieces, like UART reads split them,
+ * and every sentence must come out once, unchanged and in order. Each case reports sentences per second and
+ * the drop rate.
+ *
+ *     ./test_framer [-n epochs] [-s seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include "esp_timer.h"
+#include "nmea_framer.h"
+
+#define TEST_SENTENCES_PER_EPOCH    3
+#define TEST_SENTENCE_SIZE          96      // Longest generated sentence with "\r\n"
+
+typedef struct {
+    const char *name;
+    size_t max_piece;           // Longest UART read, 0 for the whole stream at once
+    uint32_t corrupt_every;     // Every n-th sentence gets a wrong checksum, 0 for none
+    uint32_t noise_every;       // Line noise (bytes without `$`) before every n-th sentence, 0 for none
+    uint32_t truncate_every;    // Every n-th sentence is cut before `*` and followed by the next one, 0 for none
+} test_case_t;
+
+typedef struct {
+    char **sentences;           // Expected sentences without "\r\n"
+    uint32_t count;
+    uint32_t next;              // Next expected sentence
+    uint32_t mismatches;
+} test_expect_t;
+
+static uint64_t test_random_state = 88172645463325252ULL;
+
+static uint32_t test_random(void) {
+    test_random_state ^= test_random_state << 13;
+    test_random_state ^= test_random_state >> 7;
+    test_random_state ^= test_random_state << 17;
+    return (uint32_t)test_random_state;
+}
+
+static size_t test_add_sentence(char *out, const char *body) {
+    uint8_t checksum = 0;
+    for (const char *p = body + 1; *p; p++) {
+        checksum ^= (uint8_t)*p;
+    }
+    return (size_t)sprintf(out, "%s*%02X\r\n", body, checksum);
+}
+
+/* One L96 epoch with the collar's output mask */
+static size_t test_epoch(char *out, uint32_t epoch) {
+    char body[TEST_SENTENCE_SIZE];
+    uint32_t s = epoch % 86400;
+    int32_t lat = 46031234 + (int32_t)(test_random() % 20000);
+    int32_t lon = 14305678 + (int32_t)(test_random() % 20000);
+    size_t len = 0;
+
+    snprintf(body, sizeof(body), "$GNRMC,%02lu%02lu%02lu.000,A,%04ld.%04ld,N,%05ld.%04ld,E,%lu.%02lu,%lu.%02lu,170525,,,A",
+             s / 3600, s / 60 % 60, s % 60, lat / 10000, lat % 10000, lon / 10000, lon % 10000,
+             test_random() % 9, test_random() % 100, test_random() % 360, test_random() % 100);
+    len += test_add_sentence(out + len, body);
+    snprintf(body, sizeof(body), "$GNGGA,%02lu%02lu%02lu.000,%04ld.%04ld,N,%05ld.%04ld,E,1,%02lu,0.%02lu,%lu.%lu,M,47.2,M,,",
+             s / 3600, s / 60 % 60, s % 60, lat / 10000, lat % 10000, lon / 10000, lon % 10000,
+             4 + test_random() % 12, 50 + test_random() % 50, 250 + test_random() % 100, test_random() % 10);
+    len += test_add_sentence(out + len, body);
+    len += test_add_sentence(out + len, "$GPGSA,A,3,10,32,24,12,25,15,,,,,,,1.21,0.92,0.79");
+    return len;
+}
+
+static void test_handler(const char *sentence, void *ctx) {
+    test_expect_t *expect = ctx;
+
+    // Sentences dropped on purpose are skipped in the expected list (their slot is NULL)
+    while (expect->next < expect->count && expect->sentences[expect->next] == NULL) {
+        expect->next++;
+    }
+    if (expect->next >= expect->count || strcmp(sentence, expect->sentences[expect->next]) != 0) {
+        if (expect->mismatches++ < 5) {
+            fprintf(stderr, "Unexpected sentence %s\n", sentence);
+        }
+        return;
+    }
+    expect->next++;
+}
+
+/* Builds the stream of a case, returns its length, the expected sentences and how many must be dropped */
+static size_t test_build_stream(const test_case_t *tc, uint32_t epochs, char *stream, test_expect_t *expect,
+                                uint32_t *corrupted, uint32_t *truncated) {
+    char epoch_text[TEST_SENTENCES_PER_EPOCH * TEST_SENTENCE_SIZE];
+    size_t len = 0;
+
+    *corrupted = 0;
+    *truncated = 0;
+    expect->count = 0;
+    for (uint32_t e = 0; e < epochs; e++) {
+        test_epoch(epoch_text, e);
+        char *line = epoch_text;
+        for (int i = 0; i < TEST_SENTENCES_PER_EPOCH; i++) {
+            char *end = strstr(line, "\r\n");
+            size_t line_len = (size_t)(end - line) + 2;
+            uint32_t n = expect->count + 1;
+
+            if (tc->noise_every && n % tc->noise_every == 0) {
+                static const char noise[] = "\xff\x80 garbage*1F\r\n\x00\r";
+                memcpy(stream + len, noise, sizeof(noise) - 1);
+                len += sizeof(noise) - 1;
+            }
+
+            expect->sentences[expect->count] = strndup(line, line_len - 2);
+            if (tc->corrupt_every && n % tc->corrupt_every == 0) {
+                memcpy(stream + len, line, line_len);
+                stream[len + 7] ^= 0x01; // First digit of the time, still a digit
+                len += line_len;
+                free(expect->sentences[expect->count]);
+                expect->sentences[expect->count] = NULL;
+                (*corrupted)++;
+            } else if (tc->truncate_every && n % tc->truncate_every == 0) {
+                size_t cut = 1 + test_random() % (line_len - 6); // Somewhere before `*`
+                memcpy(stream + len, line, cut);
+                len += cut;
+                free(expect->sentences[expect->count]);
+                expect->sentences[expect->count] = NULL;
+                (*truncated)++;
+            } else {
+                memcpy(stream + len, line, line_len);
+                len += line_len;
+            }
+            expect->count++;
+            line = end + 2;
+        }
+    }
+    return len;
+}
+
+static int test_run_case(const test_case_t *tc, uint32_t epochs) {
+    uint32_t total = epochs * TEST_SENTENCES_PER_EPOCH;
+    char *stream = malloc((size_t)epochs * TEST_SENTENCES_PER_EPOCH * (TEST_SENTENCE_SIZE + 32));
+    test_expect_t expect = { .sentences = calloc(total, sizeof(char *)) };
+    uint32_t corrupted, truncated;
+    static nmea_framer_t framer;
+
+    size_t len = test_build_stream(tc, epochs, stream, &expect, &corrupted, &truncated);
+    nmea_framer_init(&framer, test_handler, &expect);
+
+    // Each read in its own heap block, so AddressSanitizer catches reads past it
+    uint32_t reads = 0;
+    int64_t framer_us = 0;
+    for (size_t offset = 0; offset < len; reads++) {
+        size_t piece = tc->max_piece ? 1 + test_random() % tc->max_piece : len;
+        if (piece > len - offset) {
+            piece = len - offset;
+        }
+        uint8_t *read = malloc(piece);
+        memcpy(read, stream + offset, piece);
+
+        int64_t start_us = esp_timer_get_time();
+        nmea_framer_feed(&framer, read, piece);
+        framer_us += esp_timer_get_time() - start_us;
+
+        if (memcmp(read, stream + offset, piece) != 0) {
+            fprintf(stderr, "%s: framer did not restore the read buffer\n", tc->name);
+            return 1;
+        }
+        free(read);
+        offset += piece;
+    }
+
+    nmea_framer_stats_t stats;
+    nmea_framer_get_stats(&framer, &stats);
+    uint32_t expected = total - corrupted - truncated;
+    uint32_t dropped = expected - (stats.sentences < expected ? stats.sentences : expected);
+    double rate = framer_us ? stats.sentences * 1e6 / framer_us : 0;
+
+    printf("%-22s %7lu reads, %7lu sentences, %.0f sentences/s, drop rate %.4f %% "
+           "(%lu checksum, %lu framing, %lu overflow)\n",
+           tc->name, reads, stats.sentences, rate, 100.0 * dropped / expected,
+           stats.checksum_errors, stats.framing_errors, stats.overflows);
+
+    int ret = 0;
+    if (stats.sentences != expected || expect.mismatches != 0 || stats.checksum_errors != corrupted ||
+        stats.framing_errors < truncated || stats.overflows != 0) {
+        fprintf(stderr, "%s: expected %lu sentences and %lu checksum errors, got %lu sentences (%lu mismatched)\n",
+                tc->name, expected, corrupted, stats.sentences, expect.mismatches);
+        ret = 1;
+    }
+
+    for (uint32_t i = 0; i < total; i++) {
+        free(expect.sentences[i]);
+    }
+    free(expect.sentences);
+    free(stream);
+    return ret;
+}
+
+/* A sentence longer than the carry buffer split over reads is dropped, the next one still comes out */
+static int test_overflow(void) {
+    static nmea_framer_t framer;
+    test_expect_t expect = { 0 };
+    char line[TEST_SENTENCE_SIZE];
+    char next[TEST_SENTENCE_SIZE];
+    char *expected = next;
+    uint8_t chunk[100];
+
+    size_t len = test_add_sentence(line, "$GPGSA,A,3,10,32,24,12,25,15,,,,,,,1.21,0.92,0.79");
+    snprintf(next, sizeof(next), "%.*s", (int)len - 2, line);
+    expect.sentences = &expected;
+    expect.count = 1;
+    nmea_framer_init(&framer, test_handler, &expect);
+
+    chunk[0] = '$';
+    memset(chunk + 1, 'A', sizeof(chunk) - 1);
+    nmea_framer_feed(&framer, chunk, sizeof(chunk));
+    memset(chunk, 'A', sizeof(chunk));
+    for (int i = 0; i < NMEA_FRAMER_CARRY_SIZE / sizeof(chunk) + 1; i++) {
+        nmea_framer_feed(&framer, chunk, sizeof(chunk));
+    }
+    nmea_framer_feed(&framer, (uint8_t *)line, len);
+
+    if (framer.stats.overflows != 1 || framer.stats.sentences != 1 || expect.mismatches != 0) {
+        fprintf(stderr, "overflow: %lu overflows, %lu sentences\n", framer.stats.overflows, framer.stats.sentences);
+        return 1;
+    }
+    printf("%-22s long sentence dropped, next one kept\n", "overflow");
+    return 0;
+}
+
+/* After nmea_framer_reset() (UART FIFO overflow) the rest of the cut sentence must not come out */
+static int test_reset(void) {
+    static nmea_framer_t framer;
+    test_expect_t expect = { 0 };
+    char line[TEST_SENTENCE_SIZE];
+    char next[TEST_SENTENCE_SIZE];
+    char *expected = next;
+
+    size_t len = test_add_sentence(line, "$GPGSA,A,3,10,32,24,12,25,15,,,,,,,1.21,0.92,0.79");
+    snprintf(next, sizeof(next), "%.*s", (int)len - 2, line);
+    expect.sentences = &expected;
+    expect.count = 1;
+    nmea_framer_init(&framer, test_handler, &expect);
+
+    nmea_framer_feed(&framer, (uint8_t *)line, len / 2);
+    nmea_framer_reset(&framer);
+    nmea_framer_feed(&framer, (uint8_t *)line + len / 2, len - len / 2);
+    nmea_framer_feed(&framer, (uint8_t *)line, len);
+
+    if (framer.stats.sentences != 1 || expect.mismatches != 0) {
+        fprintf(stderr, "reset: %lu sentences\n", framer.stats.sentences);
+        return 1;
+    }
+    printf("%-22s tail of the cut sentence dropped\n", "reset");
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    uint32_t epochs = 20000;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:s:")) != -1) {
+        switch (opt) {
+            case 'n': epochs = strtoul(optarg, NULL, 10); break;
+            case 's': test_random_state ^= strtoull(optarg, NULL, 10) * 0x9E3779B97F4A7C15ULL; break;
+            default:
+                fprintf(stderr, "Usage: %s [-n epochs] [-s seed]\n", argv[0]);
+                return 2;
+        }
+    }
+
+    static const test_case_t cases[] = {
+        { "whole stream",           0,   0,  0,  0 },
+        { "reads of 1-8 bytes",     8,   0,  0,  0 },
+        { "reads of 1-120 bytes",   120, 0,  0,  0 }, // UART RX FIFO full threshold
+        { "reads of 1-1024 bytes",  1024, 0, 0,  0 },
+        { "checksum errors",        120, 17, 0,  0 },
+        { "line noise",             120, 0,  5,  0 },
+        { "cut sentences",          120, 0,  0,  13 },
+        { "all errors",             16,  17, 5,  13 },
+    };
+
+    int failed = 0;
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        failed += test_run_case(&cases[i], epochs);
+    }
+    failed += test_overflow();
+    failed += test_reset();
+
+    if (failed) {
+        fprintf(stderr, "%d framer cases failed\n", failed);
+        return 1;
+    }
+    return 0;
+}
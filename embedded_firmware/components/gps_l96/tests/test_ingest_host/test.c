@@ -0,0 +1,271 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+/*
+ * Host test of the GPS input path: uart.c, gps_ingest.c, gps_l96.c, gps_pmtk.c and the parsers run unchanged on
+ * the simulated UART of host_mock, a simulated L96 at the other end acks the PMTK commands, boots after the reset
+ * and sends RMC, GGA and GSA epochs. Measures the time from the `\n` of the last sentence of an epoch to the fix
+ * being published (gps_l96_set_fix_listener(), right after the fix queue). Then fixes are not taken for a while,
+ * as in GPS_READY and GPS_PAUSED: after gps_l96_discard_fixes() the next fix taken must be a new one.
+ *
+ *     ./test_ingest [-n epochs]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <pthread.h>
+#include "esp_timer.h"
+#include "gps_l96.h"
+
+#define TEST_EPOCH_INTERVAL_MS      5       // 200 Hz instead of 1 Hz, the latency does not depend on it
+#define TEST_SENTENCE_GAP_MS        1
+#define TEST_MAX_P99_US             20000   // With sanitizers on a loaded machine, the 100 ms poll it replaced is 50 ms on average
+#define TEST_MAX_EPOCHS             10000
+#define TEST_POLL_INTERVAL_MS       100     // UART_RX_WAIT_TIME_MS poll of the state machine before the ingest task
+#define TEST_PAUSED_EPOCHS          (GPS_FIX_QUEUE_SIZE * 2) // Epochs sent while fixes are not taken (GPS_READY, GPS_PAUSED)
+#define TEST_RESUMED_EPOCHS         3
+
+/* ---------------- Simulated L96 ---------------- */
+
+static struct {
+    pthread_mutex_t lock;
+    uint32_t baud_rate;         // Module side, 9600 after a reset
+    bool output;                // Sends epochs once the output mask is set, not in standby
+    uint32_t commands;          // Commands received at the right baud rate
+} sim_gps = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .baud_rate = UART_BAUD_RATE,
+};
+
+static uint8_t gpio_output_state = 0;
+
+static size_t sim_sentence(char *out, size_t size, const char *body) {
+    uint8_t checksum = 0;
+    for (const char *p = body + 1; *p; p++) {
+        checksum ^= (uint8_t)*p;
+    }
+    return (size_t)snprintf(out, size, "%s*%02X\r\n", body, checksum);
+}
+
+static void sim_send(const char *body) {
+    char line[128];
+    size_t len = sim_sentence(line, sizeof(line), body);
+    pthread_mutex_lock(&sim_gps.lock);
+    uint32_t baud_rate = sim_gps.baud_rate;
+    pthread_mutex_unlock(&sim_gps.lock);
+    host_mock_uart_receive((const uint8_t *)line, len, baud_rate);
+}
+
+static void sim_reset(void) {
+    pthread_mutex_lock(&sim_gps.lock);
+    sim_gps.baud_rate = UART_BAUD_RATE;
+    sim_gps.output = false;
+    pthread_mutex_unlock(&sim_gps.lock);
+    sim_send("$PMTK010,001"); // Boot message
+}
+
+/* Commands from the collar - acked like the L96 does, PMTK251 switches the rate without an ack */
+static void sim_gps_receive(const uint8_t *data, size_t len, uint32_t baud_rate, void *ctx) {
+    char ack[32];
+    int command;
+
+    pthread_mutex_lock(&sim_gps.lock);
+    bool heard = baud_rate == sim_gps.baud_rate;
+    if (!heard || len < 8 || sscanf((const char *)data, "$PMTK%3d", &command) != 1) {
+        pthread_mutex_unlock(&sim_gps.lock);
+        return;
+    }
+    sim_gps.commands++;
+    if (command == 251) {
+        sim_gps.baud_rate = UART_BAUD_RATE_FAST;
+        pthread_mutex_unlock(&sim_gps.lock);
+        return;
+    }
+    if (command == 314) {
+        sim_gps.output = true;
+    } else if (command == 161 || command == 225) {
+        sim_gps.output = false;
+    }
+    pthread_mutex_unlock(&sim_gps.lock);
+
+    snprintf(ack, sizeof(ack), "$PMTK001,%d,3", command);
+    sim_send(ack);
+}
+
+/* GPIO expander of the collar, only the GPS reset line matters */
+uint8_t gpio_expander_get_output_state(void) {
+    return gpio_output_state;
+}
+
+void gpio_expander_update_output_state(uint8_t state) {
+    bool released = !(gpio_output_state & GPS_RESET) && (state & GPS_RESET);
+    gpio_output_state = state;
+    if (released) {
+        sim_reset();
+    }
+}
+
+esp_err_t gpio_read_inputs(uint8_t *input_state) {
+    *input_state = 0;
+    return ESP_OK;
+}
+
+/* ---------------- Latency ---------------- */
+
+static int64_t sent_us[TEST_MAX_EPOCHS];        // `\n` of the GSA that completes the epoch
+static int64_t published_us[TEST_MAX_EPOCHS];
+static uint32_t epochs = 300;
+
+static void test_fix_listener(const gps_fix_t *fix) {
+    uint32_t epoch = fix->time.hours * 3600 + fix->time.minutes * 60 + fix->time.seconds;
+    if (epoch < epochs && published_us[epoch] == 0) {
+        published_us[epoch] = esp_timer_get_time();
+    }
+}
+
+static void test_send_epoch(uint32_t epoch) {
+    char body[128];
+    uint32_t s = epoch;
+
+    snprintf(body, sizeof(body), "$GNRMC,%02lu%02lu%02lu.000,A,4603.%04lu,N,01430.5678,E,1.20,45.52,170525,,,A",
+             s / 3600, s / 60 % 60, s % 60, epoch % 10000);
+    sim_send(body);
+    vTaskDelay(pdMS_TO_TICKS(TEST_SENTENCE_GAP_MS));
+    snprintf(body, sizeof(body), "$GNGGA,%02lu%02lu%02lu.000,4603.%04lu,N,01430.5678,E,1,09,0.92,296.4,M,47.2,M,,",
+             s / 3600, s / 60 % 60, s % 60, epoch % 10000);
+    sim_send(body);
+    vTaskDelay(pdMS_TO_TICKS(TEST_SENTENCE_GAP_MS));
+    sent_us[epoch] = esp_timer_get_time();
+    sim_send("$GPGSA,A,3,10,32,24,12,25,15,,,,,,,1.21,0.92,0.79");
+}
+
+static int test_compare_us(const void *a, const void *b) {
+    int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void test_print_latency(const char *name, int64_t *us, uint32_t count) {
+    qsort(us, count, sizeof(us[0]), test_compare_us);
+    printf("%-24s min %5lld us, median %5lld us, p99 %5lld us, max %5lld us\n", name,
+           us[0], us[count / 2], us[count * 99 / 100], us[count - 1]);
+}
+
+int main(int argc, char **argv) {
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        switch (opt) {
+            case 'n': epochs = strtoul(optarg, NULL, 10); break;
+            default:
+                fprintf(stderr, "Usage: %s [-n epochs]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (epochs == 0 || epochs > TEST_MAX_EPOCHS) {
+        fprintf(stderr, "1 to %d epochs\n", TEST_MAX_EPOCHS);
+        return 2;
+    }
+
+    // 1) Startup as on the collar: reset, boot message, baud rate switch, recording commands
+    host_mock_uart_set_tx_handler(sim_gps_receive, NULL);
+    int64_t start_us = esp_timer_get_time();
+    if (gps_l96_init() != ESP_OK) {
+        fprintf(stderr, "gps_l96_init() failed\n");
+        return 1;
+    }
+    if (uart_get_baud_rate() != UART_BAUD_RATE_FAST || sim_gps.baud_rate != UART_BAUD_RATE_FAST || !sim_gps.output) {
+        fprintf(stderr, "GPS not set up: UART %lu bps, module %lu bps, output %d\n",
+                uart_get_baud_rate(), sim_gps.baud_rate, sim_gps.output);
+        return 1;
+    }
+    printf("Startup: %lu commands acknowledged, %lu bps, %lld ms\n", sim_gps.commands, uart_get_baud_rate(),
+           (esp_timer_get_time() - start_us) / 1000);
+
+    // 2) Epochs, the consumer takes the fixes like the state machine does
+    gps_l96_set_fix_listener(test_fix_listener);
+    gps_fix_t fix;
+    uint32_t taken = 0;
+    for (uint32_t epoch = 0; epoch < epochs; epoch++) {
+        test_send_epoch(epoch);
+        vTaskDelay(pdMS_TO_TICKS(TEST_EPOCH_INTERVAL_MS));
+        while (gps_l96_get_next_fix(&fix)) {
+            taken++;
+        }
+    }
+    vTaskDelay(pdMS_TO_TICKS(50));
+    while (gps_l96_get_next_fix(&fix)) {
+        taken++;
+    }
+    gps_l96_set_fix_listener(NULL);
+
+    // 3) Results
+    static int64_t total[TEST_MAX_EPOCHS];
+    uint32_t published = 0;
+    for (uint32_t i = 0; i < epochs; i++) {
+        if (published_us[i] == 0) {
+            continue;
+        }
+        total[published] = published_us[i] - sent_us[i];
+        published++;
+    }
+
+    gps_epoch_stats_t epoch_stats;
+    nmea_framer_stats_t nmea_stats;
+    gps_l96_get_epoch_stats(&epoch_stats);
+    gps_l96_get_nmea_stats(&nmea_stats);
+    printf("%lu epochs: %lu fixes published (%lu complete), %lu taken, %lu dropped, %lu checksum / %lu framing errors\n",
+           epochs, published, epoch_stats.complete, taken, gps_l96_get_dropped_fix_count(),
+           nmea_stats.checksum_errors, nmea_stats.framing_errors);
+    if (published == 0) {
+        fprintf(stderr, "No fixes published\n");
+        return 1;
+    }
+    test_print_latency("`\\n` to fix published", total, published);
+    printf("%-24s mean %5d us (%d ms poll)\n", "Polling before", TEST_POLL_INTERVAL_MS * 1000 / 2, TEST_POLL_INTERVAL_MS);
+
+    if (published != epochs || epoch_stats.complete != epochs || taken != epochs ||
+        nmea_stats.checksum_errors != 0 || nmea_stats.framing_errors != 0) {
+        fprintf(stderr, "Fixes lost or incomplete\n");
+        return 1;
+    }
+    if (total[published * 99 / 100] > TEST_MAX_P99_US) {
+        fprintf(stderr, "p99 latency over %d us\n", TEST_MAX_P99_US);
+        return 1;
+    }
+
+    // 4) Paused: the queue overflows while nobody takes fixes, the state machine discards them before tracking resumes
+    uint32_t dropped = gps_l96_get_dropped_fix_count();
+    for (uint32_t epoch = epochs; epoch < epochs + TEST_PAUSED_EPOCHS; epoch++) {
+        test_send_epoch(epoch);
+        vTaskDelay(pdMS_TO_TICKS(TEST_EPOCH_INTERVAL_MS));
+    }
+    vTaskDelay(pdMS_TO_TICKS(50));
+    uint32_t discarded = gps_l96_discard_fixes();
+    dropped = gps_l96_get_dropped_fix_count() - dropped;
+    for (uint32_t epoch = epochs + TEST_PAUSED_EPOCHS; epoch < epochs + TEST_PAUSED_EPOCHS + TEST_RESUMED_EPOCHS; epoch++) {
+        test_send_epoch(epoch);
+        vTaskDelay(pdMS_TO_TICKS(TEST_EPOCH_INTERVAL_MS));
+    }
+    vTaskDelay(pdMS_TO_TICKS(50));
+    uint32_t first_epoch = UINT32_MAX;
+    uint32_t resumed = 0;
+    while (gps_l96_get_next_fix(&fix)) {
+        if (resumed++ == 0) {
+            first_epoch = fix.time.hours * 3600 + fix.time.minutes * 60 + fix.time.seconds;
+        }
+    }
+    printf("Paused %d epochs: %lu discarded, %lu dropped, resumed with epoch %lu, %lu taken\n",
+           TEST_PAUSED_EPOCHS, discarded, dropped, first_epoch, resumed);
+    if (discarded != GPS_FIX_QUEUE_SIZE || discarded + dropped != TEST_PAUSED_EPOCHS ||
+        first_epoch != epochs + TEST_PAUSED_EPOCHS || resumed != TEST_RESUMED_EPOCHS) {
+        fprintf(stderr, "Old fixes taken after the pause\n");
+        return 1;
+    }
+    return 0;
+}
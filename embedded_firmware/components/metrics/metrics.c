@@ -0,0 +1,207 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#include "metrics.h"
+
+static const char *TAG = "METRICS";
+
+typedef struct {
+    const char *name;
+    const char *help;
+    bool microseconds;          // Value is in us, written out in seconds
+} metrics_counter_info_t;
+
+typedef struct {
+    const char *name;
+    const char *help;
+    uint32_t bounds_us[METRICS_HISTOGRAM_BUCKETS]; // Upper bounds, ascending
+} metrics_histogram_info_t;
+
+static const metrics_counter_info_t counter_info[METRICS_COUNTER_COUNT] = {
+    [METRICS_NMEA_SENTENCES]       = { "collar_nmea_sentences_total", "NMEA sentences with a valid checksum", false },
+    [METRICS_NMEA_CHECKSUM_ERRORS] = { "collar_nmea_checksum_errors_total", "NMEA sentences dropped for a checksum mismatch", false },
+    [METRICS_NMEA_FRAMING_ERRORS]  = { "collar_nmea_framing_errors_total", "NMEA sentences dropped for invalid framing", false },
+    [METRICS_NMEA_OVERFLOWS]       = { "collar_nmea_overflows_total", "NMEA sentences dropped for not fitting the buffer", false },
+    [METRICS_FLASH_PROGRAMS]       = { "collar_flash_programs_total", "External flash page program commands", false },
+    [METRICS_FLASH_ERASES]         = { "collar_flash_erases_total", "External flash erase commands", false },
+    [METRICS_FLASH_BUSY_WAIT_US]   = { "collar_flash_busy_wait_seconds_total", "Time spent waiting for the external flash", true },
+    [METRICS_I2C_ERRORS]           = { "collar_i2c_errors_total", "I2C transactions that failed after the retries", false },
+    [METRICS_I2C_RETRIES]          = { "collar_i2c_retries_total", "I2C commands run again after a NACK or bus timeout", false },
+    [METRICS_I2C_MUTEX_TIMEOUTS]   = { "collar_i2c_mutex_timeouts_total", "I2C transactions not started because the bus was busy", false },
+    [METRICS_WIFI_CONNECT_RETRIES] = { "collar_wifi_connect_retries_total", "Wi-Fi reconnects after a disconnect", false },
+    [METRICS_GPS_COMMAND_RETRIES]  = { "collar_gps_command_retries_total", "GPS PMTK commands sent again after a missing or failed ack", false },
+};
+
+static const metrics_histogram_info_t histogram_info[METRICS_HISTOGRAM_COUNT] = {
+    [METRICS_LFS_APPEND_US] = { "collar_lfs_append_seconds", "Track record append to LittleFS",
+        { 50, 100, 250, 500, 1000, 2500, 5000, 10000, 50000, 250000 } },
+    [METRICS_WIFI_CONNECT_US] = { "collar_wifi_connect_seconds", "Wi-Fi start to IP address",
+        { 250000, 500000, 1000000, 1500000, 2000000, 3000000, 5000000, 8000000, 15000000, 30000000 } },
+};
+
+static atomic_uint counters[METRICS_COUNTER_COUNT];
+static atomic_uint histogram_buckets[METRICS_HISTOGRAM_COUNT][METRICS_HISTOGRAM_BUCKETS + 1]; // Not cumulative, last is +Inf
+static atomic_uint histogram_sum_us[METRICS_HISTOGRAM_COUNT];
+
+/* Time per state - written by the state machine task only */
+static atomic_uint state_time_ms[METRICS_MAX_STATES];
+static atomic_uint state_entries[METRICS_MAX_STATES];
+static const char *volatile state_names[METRICS_MAX_STATES]; // Set before the first update of the state
+static uint32_t last_state = METRICS_MAX_STATES;
+static int64_t last_tick_us = 0;
+static int64_t unaccounted_us = 0; // Below 1 ms, carried to the next tick
+
+void metrics_inc(metrics_counter_t counter) {
+    atomic_fetch_add_explicit(&counters[counter], 1, memory_order_relaxed);
+}
+
+void metrics_add(metrics_counter_t counter, uint32_t value) {
+    atomic_fetch_add_explicit(&counters[counter], value, memory_order_relaxed);
+}
+
+void metrics_observe(metrics_histogram_t histogram, uint32_t value_us) {
+
+    const uint32_t *bounds = histogram_info[histogram].bounds_us;
+    int bucket = 0;
+    while (bucket < METRICS_HISTOGRAM_BUCKETS && value_us > bounds[bucket]) {
+        bucket++;
+    }
+    atomic_fetch_add_explicit(&histogram_buckets[histogram][bucket], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&histogram_sum_us[histogram], value_us, memory_order_relaxed);
+}
+
+void metrics_state_tick(uint32_t state, const char *name) {
+
+    int64_t now = esp_timer_get_time();
+    if (state >= METRICS_MAX_STATES) {
+        return;
+    }
+
+    if (last_state < METRICS_MAX_STATES) {
+        unaccounted_us += now - last_tick_us;
+        atomic_fetch_add_explicit(&state_time_ms[last_state], (uint32_t)(unaccounted_us / 1000), memory_order_relaxed);
+        unaccounted_us %= 1000;
+    }
+    if (state != last_state) {
+        state_names[state] = name;
+        atomic_fetch_add_explicit(&state_entries[state], 1, memory_order_relaxed);
+    }
+    last_state = state;
+    last_tick_us = now;
+}
+
+/* Formats one line and hands it to write */
+static esp_err_t metrics_write_line(metrics_write_t write, void *ctx, const char *format, ...) {
+
+    char line[METRICS_LINE_SIZE];
+    va_list args;
+
+    va_start(args, format);
+    int len = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    if (len < 0) {
+        return ESP_FAIL;
+    }
+    if (len >= (int)sizeof(line)) {
+        len = sizeof(line) - 1;
+        line[len - 1] = '\n'; // Cut off, keep the line ending
+    }
+    return write(line, len, ctx);
+}
+
+static esp_err_t metrics_write_header(metrics_write_t write, void *ctx, const char *name, const char *help,
+                                      const char *type) {
+    ESP_RETURN_ON_ERROR(metrics_write_line(write, ctx, "# HELP %s %s\n", name, help), TAG, "Failed to write help");
+    return metrics_write_line(write, ctx, "# TYPE %s %s\n", name, type);
+}
+
+static esp_err_t metrics_write_histogram(metrics_write_t write, void *ctx, metrics_histogram_t histogram) {
+
+    const metrics_histogram_info_t *info = &histogram_info[histogram];
+    uint32_t count = 0;
+
+    ESP_RETURN_ON_ERROR(metrics_write_header(write, ctx, info->name, info->help, "histogram"),
+                        TAG, "Failed to write header");
+    for (int i = 0; i < METRICS_HISTOGRAM_BUCKETS; i++) {
+        count += atomic_load_explicit(&histogram_buckets[histogram][i], memory_order_relaxed);
+        uint32_t bound = info->bounds_us[i];
+        ESP_RETURN_ON_ERROR(metrics_write_line(write, ctx, "%s_bucket{le=\"%lu.%06lu\"} %lu\n", info->name,
+                                               bound / 1000000, bound % 1000000, count),
+                            TAG, "Failed to write bucket");
+    }
+    count += atomic_load_explicit(&histogram_buckets[histogram][METRICS_HISTOGRAM_BUCKETS], memory_order_relaxed);
+    uint32_t sum_us = atomic_load_explicit(&histogram_sum_us[histogram], memory_order_relaxed);
+
+    ESP_RETURN_ON_ERROR(metrics_write_line(write, ctx, "%s_bucket{le=\"+Inf\"} %lu\n", info->name, count),
+                        TAG, "Failed to write bucket");
+    ESP_RETURN_ON_ERROR(metrics_write_line(write, ctx, "%s_sum %lu.%06lu\n", info->name,
+                                           sum_us / 1000000, sum_us % 1000000),
+                        TAG, "Failed to write sum");
+    return metrics_write_line(write, ctx, "%s_count %lu\n", info->name, count);
+}
+
+static esp_err_t metrics_write_states(metrics_write_t write, void *ctx) {
+
+    ESP_RETURN_ON_ERROR(metrics_write_header(write, ctx, "collar_state_seconds_total",
+                                             "Time spent in each state machine state", "counter"),
+                        TAG, "Failed to write header");
+    for (int i = 0; i < METRICS_MAX_STATES; i++) {
+        const char *name = state_names[i];
+        if (name == NULL) {
+            continue; // Not entered since boot
+        }
+        uint32_t ms = atomic_load_explicit(&state_time_ms[i], memory_order_relaxed);
+        ESP_RETURN_ON_ERROR(metrics_write_line(write, ctx, "collar_state_seconds_total{state=\"%s\"} %lu.%03lu\n",
+                                               name, ms / 1000, ms % 1000),
+                            TAG, "Failed to write state time");
+    }
+
+    ESP_RETURN_ON_ERROR(metrics_write_header(write, ctx, "collar_state_entries_total",
+                                             "Transitions into each state machine state", "counter"),
+                        TAG, "Failed to write header");
+    for (int i = 0; i < METRICS_MAX_STATES; i++) {
+        const char *name = state_names[i];
+        if (name == NULL) {
+            continue;
+        }
+        ESP_RETURN_ON_ERROR(metrics_write_line(write, ctx, "collar_state_entries_total{state=\"%s\"} %lu\n", name,
+                                               (uint32_t)atomic_load_explicit(&state_entries[i], memory_order_relaxed)),
+                            TAG, "Failed to write state entries");
+    }
+    return ESP_OK;
+}
+
+esp_err_t metrics_write(metrics_write_t write, void *ctx) {
+
+    int64_t uptime_ms = esp_timer_get_time() / 1000;
+    ESP_RETURN_ON_ERROR(metrics_write_header(write, ctx, "collar_uptime_seconds", "Time since boot or wake-up", "gauge"),
+                        TAG, "Failed to write header");
+    ESP_RETURN_ON_ERROR(metrics_write_line(write, ctx, "collar_uptime_seconds %lld.%03lld\n",
+                                           uptime_ms / 1000, uptime_ms % 1000),
+                        TAG, "Failed to write uptime");
+
+    for (int i = 0; i < METRICS_COUNTER_COUNT; i++) {
+        const metrics_counter_info_t *info = &counter_info[i];
+        uint32_t value = atomic_load_explicit(&counters[i], memory_order_relaxed);
+        ESP_RETURN_ON_ERROR(metrics_write_header(write, ctx, info->name, info->help, "counter"),
+                            TAG, "Failed to write header");
+        if (info->microseconds) {
+            ESP_RETURN_ON_ERROR(metrics_write_line(write, ctx, "%s %lu.%06lu\n", info->name,
+                                                   value / 1000000, value % 1000000),
+                                TAG, "Failed to write counter");
+        } else {
+            ESP_RETURN_ON_ERROR(metrics_write_line(write, ctx, "%s %lu\n", info->name, value),
+                                TAG, "Failed to write counter");
+        }
+    }
+
+    for (int i = 0; i < METRICS_HISTOGRAM_COUNT; i++) {
+        ESP_RETURN_ON_ERROR(metrics_write_histogram(write, ctx, i), TAG, "Failed to write histogram");
+    }
+
+    return metrics_write_states(write, ctx);
+}
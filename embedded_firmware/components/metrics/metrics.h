@@ -0,0 +1,97 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+/*
+ * Runtime metrics (Prometheus text format on GET /metrics)
+ *
+ * Every metric is a slot in static storage, known at compile time: counters and histograms are listed in
+ * the enums below and described in metrics.c. Updates are single atomic adds, so any task (and the
+ * GPS ingest hot path) can update them without a lock or an allocation. Values live in RAM, they start
+ * from 0 after every reset and every deep sleep.
+ *
+ * Time is stored in microseconds (state time in milliseconds) and written out in seconds.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include "esp_err.h"
+#include "esp_check.h"
+#include "esp_timer.h"
+
+#define METRICS_HISTOGRAM_BUCKETS   10  // Bucket bounds per histogram, +Inf is added on top
+#define METRICS_MAX_STATES          16  // State slots for the time per state-machine state
+#define METRICS_LINE_SIZE           160 // One line of the text output
+
+typedef enum {
+    METRICS_NMEA_SENTENCES,         // Sentences with a valid checksum handed to the parser
+    METRICS_NMEA_CHECKSUM_ERRORS,
+    METRICS_NMEA_FRAMING_ERRORS,
+    METRICS_NMEA_OVERFLOWS,
+    METRICS_FLASH_PROGRAMS,         // Page program commands
+    METRICS_FLASH_ERASES,           // Sector and chip erase commands
+    METRICS_FLASH_BUSY_WAIT_US,     // Time spent waiting for the flash BUSY bit
+    METRICS_I2C_ERRORS,             // I2C transactions that failed after I2C_RETRIES
+    METRICS_I2C_RETRIES,            // I2C commands run again after a NACK or bus timeout
+    METRICS_I2C_MUTEX_TIMEOUTS,
+    METRICS_WIFI_CONNECT_RETRIES,   // Reconnects after a disconnect
+    METRICS_GPS_COMMAND_RETRIES,    // PMTK commands sent again after a missing or failed ack
+    METRICS_COUNTER_COUNT
+} metrics_counter_t;
+
+typedef enum {
+    METRICS_LFS_APPEND_US,          // track_writer_append(), including the LittleFS write/sync it triggers
+    METRICS_WIFI_CONNECT_US,        // From Wi-Fi start to an IP address
+    METRICS_HISTOGRAM_COUNT
+} metrics_histogram_t;
+
+typedef esp_err_t (*metrics_write_t)(const char *data, size_t len, void *ctx);
+
+/**
+ * @brief Adds 1 to a counter.
+ */
+void metrics_inc(metrics_counter_t counter);
+
+/**
+ * @brief Adds a value to a counter.
+ */
+void metrics_add(metrics_counter_t counter, uint32_t value);
+
+/**
+ * @brief Records one observation in a histogram.
+ *
+ * @param histogram Histogram to update.
+ * @param value_us Observed duration in microseconds.
+ */
+void metrics_observe(metrics_histogram_t histogram, uint32_t value_us);
+
+/**
+ * @brief Accounts the time since the previous call to the state of the previous call.
+ *
+ * Call it from the state machine task only, once per state machine run.
+ *
+ * @param state State that runs now, below METRICS_MAX_STATES.
+ * @param name State name for the `state` label, must stay valid (string literal).
+ */
+void metrics_state_tick(uint32_t state, const char *name);
+
+/**
+ * @brief Writes all metrics in the Prometheus text exposition format.
+ *
+ * @param write Called for every line.
+ * @param ctx Passed to write.
+ * @return ESP_OK on success, or the first error returned by write.
+ */
+esp_err_t metrics_write(metrics_write_t write, void *ctx);
+
+#endif // METRICS_H
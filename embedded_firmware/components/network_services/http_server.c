@@ -17,12 +17,33 @@ static esp_err_t download_file_get_handler(httpd_req_t *req);
 static esp_err_t init_status_get_handler(httpd_req_t *req);
 static esp_err_t battery_data_get_handler(httpd_req_t *req);
 static esp_err_t delete_file_handler(httpd_req_t *req);
+static esp_err_t manifest_get_handler(httpd_req_t *req);
+static esp_err_t export_get_handler(httpd_req_t *req);
+static esp_err_t ack_post_handler(httpd_req_t *req);
+static esp_err_t metrics_get_handler(httpd_req_t *req);
+
+static bool first_client_logged = false;
+
+/* Logs how long after the start of Wi-Fi the first client connected, the figure fast reconnect is meant to cut */
+static esp_err_t http_server_on_open(httpd_handle_t hd, int sockfd) {
+    sync_session_note_activity(0);
+    if (!first_client_logged) {
+        first_client_logged = true;
+        int64_t now = esp_timer_get_time();
+        ESP_LOGI(TAG, "First client connected %lld ms after Wi-Fi start (%lld ms after boot)",
+                 (now - wifi_manager_get_connect_start_us()) / 1000, now / 1000);
+    }
+    return ESP_OK;
+}
 
 esp_err_t http_server_start(void) {
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
     config.server_port = HTTP_SERVER_PORT_NUM;
+    config.max_uri_handlers = HTTP_SERVER_MAX_URI_HANDLERS;
+    config.open_fn = http_server_on_open;
     
     server = NULL;
+    first_client_logged = false;
 
     // root URI handler
     if (httpd_start(&server, &config) == ESP_OK) {
@@ -79,6 +100,45 @@ esp_err_t http_server_start(void) {
         };
         httpd_register_uri_handler(server, &delete_file_uri);
 
+        /* JSON list of files changed since a sync cursor */
+        httpd_uri_t manifest_uri = {
+            .uri        = "/manifest", // /manifest?since=<cursor>, since is optional
+            .method     = HTTP_GET,
+            .handler    = manifest_get_handler,
+            .user_ctx   = NULL
+        };
+        httpd_register_uri_handler(server, &manifest_uri);
+
+        /* All files changed since a sync cursor in one archive */
+        httpd_uri_t export_uri = {
+            .uri        = "/export", // /export?since=<cursor>, since is optional
+            .method     = HTTP_GET,
+            .handler    = export_get_handler,
+            .user_ctx   = NULL
+        };
+        httpd_register_uri_handler(server, &export_uri);
+
+        /* Sync client acknowledges the files it has stored, the sync session ends early once nothing is pending */
+        httpd_uri_t ack_uri = {
+            .uri        = "/ack", // /ack?cursor=<cursor>
+            .method     = HTTP_POST,
+            .handler    = ack_post_handler,
+            .user_ctx   = NULL
+        };
+        httpd_register_uri_handler(server, &ack_uri);
+
+        /* Counters and histograms in Prometheus text format */
+        httpd_uri_t metrics_uri = {
+            .uri        = "/metrics",
+            .method     = HTTP_GET,
+            .handler    = metrics_get_handler,
+            .user_ctx   = NULL
+        };
+        httpd_register_uri_handler(server, &metrics_uri);
+
+        /* Live GPS fixes over WebSocket, the HTTP server works without it */
+        live_stream_start(server);
+
         ESP_LOGI(TAG, "HTTP server started on port %d", config.server_port);
         return ESP_OK;
     } 
@@ -137,69 +197,522 @@ static esp_err_t list_files_get_handler(httpd_req_t *req) {
     return ESP_OK;
 }
 
-static esp_err_t download_file_get_handler(httpd_req_t *req) {
+/* Collects small writes into CHUNK_BUFFER_SIZE chunks before sending them */
+typedef struct {
+    httpd_req_t *req;
+    char buffer[CHUNK_BUFFER_SIZE];
+    size_t len;
+    uint16_t num_off_chunks;
+    uint32_t bytes;             // Sent so far
+} http_chunk_writer_t;
+
+static http_chunk_writer_t chunk_writer; // Static - too big for the httpd task stack, and httpd handles one request at a time
+
+static esp_err_t http_chunk_writer_flush(http_chunk_writer_t *writer) {
+    if (writer->len == 0) {
+        return ESP_OK;
+    }
+    ESP_RETURN_ON_ERROR(httpd_resp_send_chunk(writer->req, writer->buffer, writer->len),
+                        TAG, "Failed to send file chunk");
+    sync_session_note_activity(writer->len);
+    writer->num_off_chunks++;
+    writer->bytes += writer->len;
+    writer->len = 0;
+    return ESP_OK;
+}
+
+static esp_err_t http_chunk_writer_write(const char *data, size_t len, void *ctx) {
+    http_chunk_writer_t *writer = (http_chunk_writer_t *)ctx;
+
+    if (writer->len + len > sizeof(writer->buffer)) {
+        ESP_RETURN_ON_ERROR(http_chunk_writer_flush(writer), TAG, "Failed to flush chunk");
+    }
+    if (len > sizeof(writer->buffer)) {
+        writer->bytes += len;
+        sync_session_note_activity(len);
+        return httpd_resp_send_chunk(writer->req, data, len); // Does not fit into the buffer, send as is
+    }
+    memcpy(writer->buffer + writer->len, data, len);
+    writer->len += len;
+    return ESP_OK;
+}
+
+/* True if Accept-Encoding lists gzip without q=0 */
+static bool http_accepts_gzip(httpd_req_t *req) {
+
+    char accept_encoding[HTTP_ACCEPT_ENCODING_SIZE];
+    char *save_ptr;
+
+    esp_err_t err = httpd_req_get_hdr_value_str(req, "Accept-Encoding", accept_encoding, sizeof(accept_encoding));
+    if (err != ESP_OK && err != ESP_ERR_HTTPD_RESULT_TRUNC) {
+        return false;
+    }
+    for (char *token = strtok_r(accept_encoding, ",", &save_ptr); token != NULL; token = strtok_r(NULL, ",", &save_ptr)) {
+        while (*token == ' ') {
+            token++;
+        }
+        if (strncasecmp(token, "gzip", 4) != 0 || (token[4] != '\0' && token[4] != ';' && token[4] != ' ')) {
+            continue;
+        }
+        const char *q = strstr(token, "q=");
+        return q == NULL || strtof(q + 2, NULL) > 0.0f;
+    }
+    return false;
+}
+
+/* Converts a binary track file to CSV/GPX while sending it */
+static esp_err_t download_track_file_as_text(httpd_req_t *req, const char *filename, track_export_format_t format) {
+
+    http_chunk_writer_t *writer = &chunk_writer;
+    char content_disposition[LFS_NAME_MAX + 64];
+    struct lfs_info info;
+    const char *extension = (format == TRACK_EXPORT_GPX) ? ".gpx" : ".csv";
+
+    if (lfs_stat(&lfs, filename, &info) < 0) {
+        ESP_LOGE(TAG, "Track file %s not found", filename);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "File not found or cannot be opened");
+        return ESP_FAIL;
+    }
+
+    // Download as dog_run_<date>.csv/.gpx instead of .trk
+    int name_len = (int)(strlen(filename) - strlen(TRACK_FILE_SUFFIX));
+    snprintf(content_disposition, sizeof(content_disposition), "attachment; filename=\"%.*s%s\"", name_len, filename, extension);
+    httpd_resp_set_hdr(req, "Content-Disposition", content_disposition);
+    httpd_resp_set_type(req, (format == TRACK_EXPORT_GPX) ? "application/gpx+xml" : "text/csv");
+
+    writer->req = req;
+    writer->len = 0;
+    writer->num_off_chunks = 1;
+    writer->bytes = 0;
+    int64_t start_us = esp_timer_get_time();
+
+    // CSV/GPX repeats most of every line, compress it if the client can take it (and the stream pool is free)
+    gzip_stream_t *gzip = http_accepts_gzip(req) ? gzip_stream_begin(http_chunk_writer_write, writer) : NULL;
+    gzip_stream_stats_t gzip_stats = {0};
+    if (gzip != NULL) {
+        httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+    }
+    httpd_resp_set_hdr(req, "Vary", "Accept-Encoding");
+
+    esp_err_t err;
+    if (gzip != NULL) {
+        err = track_file_export(filename, format, gzip_stream_write, gzip);
+        if (err == ESP_OK) {
+            err = gzip_stream_finish(gzip, &gzip_stats);
+        } else {
+            gzip_stream_abort(gzip);
+        }
+    } else {
+        err = track_file_export(filename, format, http_chunk_writer_write, writer);
+    }
+    if (err == ESP_OK) {
+        err = http_chunk_writer_flush(writer);
+    }
+    if (err != ESP_OK) {
+        // Part of the response may already be sent, so only the connection can be closed
+        ESP_LOGE(TAG, "Failed to convert %s: %s", filename, esp_err_to_name(err));
+        return ESP_FAIL;
+    }
+
+    httpd_resp_send_chunk(req, NULL, 0); // This signals end of data for chunked transfer
+    int64_t elapsed_us = esp_timer_get_time() - start_us;
+    ESP_LOGI(TAG, "File %s sent as %s: %lu bytes in %lld ms (%llu B/s)", filename, extension,
+             writer->bytes, elapsed_us / 1000, elapsed_us > 0 ? (uint64_t)writer->bytes * 1000000 / elapsed_us : 0);
+    if (gzip != NULL) {
+        ESP_LOGI(TAG, "gzip %lu -> %lu bytes", gzip_stats.in_bytes, gzip_stats.out_bytes);
+    }
+    return ESP_OK;
+}
+
+/* Sends all bytes over the request socket, httpd_send() may send less than asked */
+static esp_err_t http_send_all(httpd_req_t *req, const char *data, size_t len) {
+
+    while (len > 0) {
+        int sent = httpd_send(req, data, len);
+        if (sent <= 0) {
+            ESP_LOGE(TAG, "Failed to send %u bytes (%d)", (unsigned)len, sent);
+            return ESP_FAIL;
+        }
+        data += sent;
+        len -= sent;
+        sync_session_note_activity(sent);
+    }
+    return ESP_OK;
+}
+
+/* httpd_resp_send_chunk() can only send chunked responses. To stream a file with Content-Length
+ * the status line and headers are written to the socket here, and the body with http_send_all(). */
+static esp_err_t http_send_raw_headers(httpd_req_t *req, const char *status, const char *filename, const char *etag,
+                                       uint32_t content_length, const char *content_range) {
+
+    static char headers[HTTP_RAW_HEADER_SIZE]; // Static - httpd handles one request at a time
+
+    int len = snprintf(headers, sizeof(headers),
+                       "HTTP/1.1 %s\r\n"
+                       "Content-Type: application/octet-stream\r\n"
+                       "Content-Length: %lu\r\n"
+                       "Content-Disposition: attachment; filename=\"%s\"\r\n"
+                       "Accept-Ranges: bytes\r\n"
+                       "ETag: %s\r\n"
+                       "%s%s%s"
+                       "\r\n",
+                       status, content_length, filename, etag,
+                       content_range ? "Content-Range: " : "", content_range ? content_range : "", content_range ? "\r\n" : "");
+    if (len < 0 || len >= (int)sizeof(headers)) {
+        ESP_LOGE(TAG, "Response headers for %s do not fit into %d bytes", filename, (int)sizeof(headers));
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to send file");
+        return ESP_FAIL;
+    }
+    return http_send_all(req, headers, len);
+}
+
+/* Parses a single "bytes=a-b", "bytes=a-" or "bytes=-n" range. End is inclusive and clamped to the file size.
+ * Returns ESP_ERR_NOT_SUPPORTED for ranges that are answered with the whole file (multiple ranges, bad syntax)
+ * and ESP_ERR_INVALID_SIZE if the range starts past the end of the file. */
+static esp_err_t http_parse_byte_range(const char *value, uint32_t size, uint32_t *start, uint32_t *end) {
+
+    char *parse_end;
 
-    char read_buffer[CHUNK_BUFFER_SIZE]; // TODO: Have DOWLOAD_BUFFER_SIZE be 4096, , and then send that in chunks off 1460
-    lfs_ssize_t bytes_read = 0;
-    uint16_t num_off_chunks = 1;
+    if (strncmp(value, "bytes=", 6) != 0 || strchr(value, ',') != NULL) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    const char *spec = value + 6;
+
+    // Suffix range: last n bytes
+    if (spec[0] == '-') {
+        if (!isdigit((unsigned char)spec[1])) {
+            return ESP_ERR_NOT_SUPPORTED;
+        }
+        unsigned long suffix = strtoul(spec + 1, &parse_end, 10);
+        if (*parse_end != '\0') {
+            return ESP_ERR_NOT_SUPPORTED;
+        }
+        if (suffix == 0 || size == 0) {
+            return ESP_ERR_INVALID_SIZE;
+        }
+        *start = (suffix < size) ? size - suffix : 0;
+        *end = size - 1;
+        return ESP_OK;
+    }
+
+    if (!isdigit((unsigned char)spec[0])) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    unsigned long first = strtoul(spec, &parse_end, 10);
+    if (*parse_end != '-') {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    const char *last_spec = parse_end + 1;
+    unsigned long last = ULONG_MAX; // "a-" means to the end of the file
+    if (*last_spec != '\0') {
+        if (!isdigit((unsigned char)*last_spec)) {
+            return ESP_ERR_NOT_SUPPORTED;
+        }
+        last = strtoul(last_spec, &parse_end, 10);
+        if (*parse_end != '\0' || last < first) {
+            return ESP_ERR_NOT_SUPPORTED;
+        }
+    }
+
+    if (first >= size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    *start = first;
+    *end = (last < size) ? last : size - 1;
+    return ESP_OK;
+}
+
+/* A range request with If-Range is only served as a range if the file did not change since the client got its part */
+static bool http_if_range_matches(httpd_req_t *req, const char *etag) {
+
+    char if_range[LFS_ETAG_SIZE + 8];
+    esp_err_t err = httpd_req_get_hdr_value_str(req, "If-Range", if_range, sizeof(if_range));
+    if (err == ESP_ERR_NOT_FOUND) {
+        return true;
+    }
+    return err == ESP_OK && strcmp(if_range, etag) == 0; // Dates are not supported, they never match
+}
+
+/* Raw file being streamed by the pipeline */
+typedef struct {
     lfs_file_t file;
+    uint32_t remaining;         // Bytes still to send, the file may have grown since the headers were sent
+} http_file_reader_t;
+
+static int32_t http_file_fill(uint8_t *buffer, size_t size, void *ctx) {
+
+    http_file_reader_t *reader = (http_file_reader_t *)ctx;
+
+    if (reader->remaining == 0) {
+        return 0;
+    }
+    lfs_size_t chunk = reader->remaining < size ? reader->remaining : size;
+    lfs_ssize_t bytes_read = lfs_file_read(&lfs, &reader->file, buffer, chunk);
+    if (bytes_read <= 0) {
+        ESP_LOGE(TAG, "Failed to read file (%d), %lu bytes not sent", (int)bytes_read, reader->remaining);
+        return bytes_read < 0 ? bytes_read : LFS_ERR_CORRUPT;
+    }
+    reader->remaining -= bytes_read;
+    return bytes_read;
+}
+
+static esp_err_t http_raw_drain(const uint8_t *data, size_t len, void *ctx) {
+    return http_send_all((httpd_req_t *)ctx, (const char *)data, len);
+}
+
+static void http_log_stream_stats(const char *what, const stream_pipeline_stats_t *stats) {
+    ESP_LOGI(TAG, "%s sent: %llu bytes in %lld ms (%llu B/s, waited %lld ms for flash)",
+             what, stats->bytes, stats->elapsed_us / 1000,
+             stats->elapsed_us > 0 ? stats->bytes * 1000000 / stats->elapsed_us : 0, stats->drain_wait_us / 1000);
+}
+
+static esp_err_t download_file_get_handler(httpd_req_t *req) {
+
+    static http_file_reader_t reader; // Static - lfs_file_t is big for the httpd task stack, and httpd handles one request at a time
+    stream_pipeline_stats_t stats = {0};
+    char query_string[LFS_NAME_MAX + 32];
+    char filename[LFS_NAME_MAX + 1];
+    char format[8] = "";
  
-    // Check if the request URI contains the 'file' parameter
-    // URI will look like /download?file=your_filename.csv
-    char *query_string = strchr(req->uri, '?');
-    if (query_string == NULL) {
-        ESP_LOGE(TAG, "No query string found in URI");
+    // URI will look like /download?file=your_filename.trk&format=csv (format is optional: csv, gpx or raw)
+    if (httpd_req_get_url_query_str(req, query_string, sizeof(query_string)) != ESP_OK ||
+        httpd_query_key_value(query_string, "file", filename, sizeof(filename)) != ESP_OK) {
+        ESP_LOGE(TAG, "No file parameter found in URI");
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing 'file' parameter");
         return ESP_FAIL;
     }
-    query_string++; // Move pointer past the '?' character
-    ESP_LOGI(TAG, "Query string found: %s", query_string);
+    httpd_query_key_value(query_string, "format", format, sizeof(format));
 
+    ESP_LOGI(TAG, "Filename extracted: %s, format: %s", filename, format[0] ? format : "default");
 
-    query_string = query_string + 5; // Skip "file=" part
+    // Track files are converted to CSV (default) or GPX on the fly, unless raw data is requested
+    if (track_file_is_track(filename) && strcmp(format, "raw") != 0) {
+        if (format[0] == '\0' || strcmp(format, "csv") == 0) {
+            return download_track_file_as_text(req, filename, TRACK_EXPORT_CSV);
+        }
+        if (strcmp(format, "gpx") == 0) {
+            return download_track_file_as_text(req, filename, TRACK_EXPORT_GPX);
+        }
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Unknown 'format', use csv, gpx or raw");
+        return ESP_FAIL;
+    }
 
-    ESP_LOGI(TAG, "Filename extracted: %s", query_string);
+    // Raw file. ETag + single byte range let an interrupted download continue where it stopped
+    char etag[LFS_ETAG_SIZE];
+    uint32_t file_size = 0;
+    if (lfs_get_file_etag(filename, etag, sizeof(etag), &file_size) != ESP_OK) {
+        ESP_LOGE(TAG, "File %s not found", filename);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "File not found or cannot be opened");
+        return ESP_FAIL;
+    }
+
+    uint32_t range_start = 0;
+    uint32_t range_end = file_size ? file_size - 1 : 0; // Inclusive
+    bool partial = false;
+    char range_header[HTTP_RANGE_HEADER_SIZE];
+    char content_range[HTTP_RANGE_HEADER_SIZE];
+
+    if (httpd_req_get_hdr_value_str(req, "Range", range_header, sizeof(range_header)) == ESP_OK &&
+        http_if_range_matches(req, etag)) {
+
+        esp_err_t range_err = http_parse_byte_range(range_header, file_size, &range_start, &range_end);
+        if (range_err == ESP_ERR_INVALID_SIZE) {
+            ESP_LOGW(TAG, "Range '%s' not satisfiable for %s (%lu bytes)", range_header, filename, file_size);
+            snprintf(content_range, sizeof(content_range), "bytes */%lu", file_size);
+            httpd_resp_set_status(req, "416 Range Not Satisfiable");
+            httpd_resp_set_hdr(req, "Content-Range", content_range);
+            httpd_resp_set_hdr(req, "Accept-Ranges", "bytes");
+            httpd_resp_set_hdr(req, "ETag", etag);
+            return httpd_resp_send(req, NULL, 0);
+        }
+        partial = (range_err == ESP_OK);
+        if (!partial) { // Unsupported range (e.g. multiple ranges) - send the whole file
+            range_start = 0;
+            range_end = file_size ? file_size - 1 : 0;
+        }
+    }
 
     // Read file (read only mode)
-    esp_err_t err = lfs_file_open(&lfs, &file, query_string, LFS_O_RDONLY); //lfs is global extern variable from file_system_littlefs.c
+    esp_err_t err = lfs_file_open(&lfs, &reader.file, filename, LFS_O_RDONLY); //lfs is global extern variable from file_system_littlefs.c
     if (err) {
-        ESP_LOGE(TAG, "Failed to open file %s for reading (%d)", query_string, err);
+        ESP_LOGE(TAG, "Failed to open file %s for reading (%d)", filename, err);
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "File not found or cannot be opened");
         return ESP_FAIL;
     }
+    if (range_start > 0 && lfs_file_seek(&lfs, &reader.file, range_start, LFS_SEEK_SET) < 0) {
+        ESP_LOGE(TAG, "Failed to seek %s to %lu", filename, range_start);
+        lfs_file_close(&lfs, &reader.file);
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to read file");
+        return ESP_FAIL;
+    }
 
-    // Set content disposition to download the file directly
-    char content_disposition[LFS_NAME_MAX + 64]; // Add extra space for disposition header
-    snprintf(content_disposition, sizeof(content_disposition), "attachment; filename=\"%s\"", query_string);
-    httpd_resp_set_hdr(req, "Content-Disposition", content_disposition);
+    // Send only the bytes that were there when the ETag was made, the file may grow while we send it
+    uint32_t content_length = file_size ? range_end - range_start + 1 : 0;
+    reader.remaining = content_length;
 
-    // Loop to read and send file in chunks
-    do {
-        bytes_read = lfs_file_read(&lfs, &file, read_buffer, sizeof(read_buffer));
-        if (bytes_read < 0) {
+    if (partial) {
+        snprintf(content_range, sizeof(content_range), "bytes %lu-%lu/%lu", range_start, range_end, file_size);
+        ESP_LOGI(TAG, "Sending %s bytes %s", filename, content_range);
+    }
+    esp_err_t ret = http_send_raw_headers(req, partial ? "206 Partial Content" : "200 OK", filename, etag,
+                                          content_length, partial ? content_range : NULL);
 
-            ESP_LOGE(TAG, "Failed to read from file %s (%d)", query_string, (int)bytes_read);
-            lfs_file_close(&lfs, &file);
-            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to read file");
-            return ESP_FAIL;
+    // Flash reads run in the pipeline task while this task sends the previous buffer
+    if (ret == ESP_OK) {
+        ret = stream_pipeline_run(http_file_fill, &reader, http_raw_drain, req, &stats);
+    }
+
+    lfs_file_close(&lfs, &reader.file);
+    if (ret != ESP_OK) {
+        // Headers with Content-Length are already sent, closing the connection tells the client the body is short
+        ESP_LOGE(TAG, "Failed to send %s after %llu bytes: %s", filename, stats.bytes, esp_err_to_name(ret));
+        return ESP_FAIL;
+    }
+
+    http_log_stream_stats(filename, &stats);
+    return ESP_OK;
+}
+
+/* Reads an optional unsigned query parameter, value is not changed if the parameter is missing */
+static esp_err_t http_get_query_u32(httpd_req_t *req, const char *key, uint32_t *value) {
+
+    char query_string[64];
+    char value_string[12];
+    char *parse_end;
+
+    if (httpd_req_get_url_query_str(req, query_string, sizeof(query_string)) != ESP_OK ||
+        httpd_query_key_value(query_string, key, value_string, sizeof(value_string)) != ESP_OK) {
+        return ESP_OK;
+    }
+    unsigned long parsed = strtoul(value_string, &parse_end, 10);
+    if (parse_end == value_string || *parse_end != '\0') {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *value = parsed;
+    return ESP_OK;
+}
+
+static esp_err_t manifest_get_handler(httpd_req_t *req) {
+
+    uint32_t since = 0;
+
+    // URI will look like /manifest?since=42 (since is optional, lists all files if missing)
+    if (http_get_query_u32(req, "since", &since) != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid 'since' parameter");
+        return ESP_FAIL;
+    }
 
-        } else if (bytes_read > 0) {
-            // Send the chunk
-            if (httpd_resp_send_chunk(req, read_buffer, bytes_read) != ESP_OK) {
-                ESP_LOGE(TAG, "Failed to send file chunk");
-                lfs_file_close(&lfs, &file);
-                httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to send file chunk");
-                return ESP_FAIL; // Client disconnected or error
-            }
-            ESP_LOGI(TAG, "Sent chunk %d of %s (%d bytes)", num_off_chunks++, query_string, (int)bytes_read);
+    httpd_resp_set_type(req, "application/json");
+    chunk_writer.req = req;
+    chunk_writer.len = 0;
+    chunk_writer.num_off_chunks = 1;
+    chunk_writer.bytes = 0;
+
+    esp_err_t err = lfs_manifest_write(since, http_chunk_writer_write, &chunk_writer);
+    if (err == ESP_OK) {
+        err = http_chunk_writer_flush(&chunk_writer);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to send manifest: %s", esp_err_to_name(err));
+        if (chunk_writer.num_off_chunks == 1) {
+            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to list files");
         }
-    } while (bytes_read > 0);
+        return ESP_FAIL;
+    }
 
-    // After sending all data, send an empty chunk to signify end of transfer
     httpd_resp_send_chunk(req, NULL, 0); // This signals end of data for chunked transfer
+    return ESP_OK;
+}
+
+static int32_t http_archive_fill(uint8_t *buffer, size_t size, void *ctx) {
+    return lfs_archive_read((lfs_archive_t *)ctx, buffer, size);
+}
+
+static esp_err_t http_chunk_drain(const uint8_t *data, size_t len, void *ctx) {
+    sync_session_note_activity(len);
+    return httpd_resp_send_chunk((httpd_req_t *)ctx, (const char *)data, len);
+}
+
+static esp_err_t export_get_handler(httpd_req_t *req) {
+
+    static lfs_archive_t archive; // Static - too big for the httpd task stack, and httpd handles one request at a time
+    stream_pipeline_stats_t stats = {0};
+    uint32_t since = 0;
+
+    // URI will look like /export?since=42 (since is optional, exports all files if missing)
+    if (http_get_query_u32(req, "since", &since) != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid 'since' parameter");
+        return ESP_FAIL;
+    }
+
+    if (lfs_archive_begin(&archive, since) != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to list files");
+        return ESP_FAIL;
+    }
+
+    httpd_resp_set_type(req, "application/octet-stream");
+    httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=\"dogcollar_export.dca\"");
+
+    // Flash reads run in the pipeline task while this task sends the previous buffer
+    esp_err_t err = stream_pipeline_run(http_archive_fill, &archive, http_chunk_drain, req, &stats);
+    lfs_archive_end(&archive);
+    if (err != ESP_OK) {
+        // Part of the archive may already be sent, closing the connection leaves it without the end entry
+        ESP_LOGE(TAG, "Export failed after %llu bytes: %s", stats.bytes, esp_err_to_name(err));
+        return ESP_FAIL;
+    }
 
-    lfs_file_close(&lfs, &file);
-    ESP_LOGI(TAG, "File %s sent successfully", query_string);
+    httpd_resp_send_chunk(req, NULL, 0); // This signals end of data for chunked transfer
+    http_log_stream_stats("Export", &stats);
+    return ESP_OK;
+}
+
+static esp_err_t ack_post_handler(httpd_req_t *req) {
+
+    char response[128];
+    uint32_t cursor = UINT32_MAX;
+    sync_session_pending_t pending;
+
+    // URI will look like /ack?cursor=42
+    if (http_get_query_u32(req, "cursor", &cursor) != ESP_OK || cursor == UINT32_MAX) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing or invalid 'cursor' parameter");
+        return ESP_FAIL;
+    }
+
+    esp_err_t err = sync_session_ack(cursor, &pending);
+    if (err == ESP_ERR_INVALID_ARG) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Unknown cursor");
+        return ESP_FAIL;
+    }
+    if (err != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Failed to store cursor");
+        return ESP_FAIL;
+    }
+
+    int len = snprintf(response, sizeof(response), "{\"acked\":%lu,\"pending_files\":%lu,\"pending_bytes\":%lu}\n",
+                       pending.acked_cursor, pending.pending_files, pending.pending_bytes);
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_send(req, response, len);
+}
+
+static esp_err_t metrics_get_handler(httpd_req_t *req) {
+
+    httpd_resp_set_type(req, "text/plain; version=0.0.4");
+    chunk_writer.req = req;
+    chunk_writer.len = 0;
+    chunk_writer.num_off_chunks = 1;
+    chunk_writer.bytes = 0;
+
+    esp_err_t err = metrics_write(http_chunk_writer_write, &chunk_writer);
+    if (err == ESP_OK) {
+        err = http_chunk_writer_flush(&chunk_writer);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to send metrics: %s", esp_err_to_name(err));
+        return ESP_FAIL;
+    }
+
+    httpd_resp_send_chunk(req, NULL, 0); // This signals end of data for chunked transfer
     return ESP_OK;
 }
 
@@ -269,6 +782,7 @@ static esp_err_t delete_file_handler(httpd_req_t *req) {
 esp_err_t http_server_stop(void) {
     if (server != NULL) {
         ESP_LOGI(TAG, "Stopping HTTP server");
+        live_stream_stop();
         esp_err_t err = httpd_stop(server);
         if (err == ESP_OK) {
             server = NULL;  // Clear the server handle
@@ -8,16 +8,33 @@
 #ifndef HTTP_SERVER_H
 #define HTTP_SERVER_H
 
+#include <stdlib.h>
+#include <ctype.h>
+#include <limits.h>
+#include <strings.h>
 #include "esp_http_server.h"
 #include "esp_log.h"
 #include "esp_err.h"
 
 #include "file_system_littlefs/file_system_littlefs.h"
+#include "file_system_littlefs/lfs_manifest.h"
+#include "file_system_littlefs/lfs_archive.h"
+#include "stream_pipeline.h"
+#include "sync_session.h"
+#include "live_stream.h"
+#include "metrics/metrics.h"
+#include "compression/gzip_stream.h"
+#include "track_format/track_file.h"
+#include "network_services/wifi_manager.h"
 #include "../../dog_collar/dog_collar_state_machine/components_init/components_init.h"
 
 #define RESPONSE_BUFFER_SIZE 4096
 #define HTTP_SERVER_PORT_NUM 80
+#define HTTP_SERVER_MAX_URI_HANDLERS 16 // HTTPD_DEFAULT_CONFIG() allows only 8
 #define CHUNK_BUFFER_SIZE 1460 // TCP MSS (Maximum Segment Size) for ESP32
+#define HTTP_RANGE_HEADER_SIZE 64 // Range / Content-Range header values
+#define HTTP_RAW_HEADER_SIZE (LFS_NAME_MAX + 256) // Status line and headers of a raw file download
+#define HTTP_ACCEPT_ENCODING_SIZE 64 // Accept-Encoding header value, longer values are cut off
 
 
 /**
@@ -26,10 +43,20 @@
  * It initializes the HTTP server and registers URI handlers:
  * - `/` for a simple hello page
  * - `/files` to list files in the filesystem
- * - `/download` to download files from the filesystem - note: call /download?file="filename" to download a specific file
+ * - `/download` to download files from the filesystem - note: call /download?file="filename" to download a specific file,
+ *   track files (.trk) are converted to CSV, add &format=gpx for GPX or &format=raw for the binary file.
+ *   CSV/GPX is sent gzip compressed if the client sends Accept-Encoding: gzip.
+ *   Raw downloads send an ETag and accept a single `Range: bytes=...` (with optional `If-Range`) to resume a download
  * - `/status` to get the initialization status of ESP32 components
  * - `/battery` to get the battery data
  * - `/delete` to delete a file from the filesystem - note: call /delete?file="filename" to delete a specific file
+ * - `/manifest` JSON list of files with size, mtime, CRC32 and sync cursor - note: call /manifest?since=<cursor>
+ *   to list only files changed since an earlier manifest
+ * - `/export` all files changed since a sync cursor as one archive (lfs_archive.h) - note: call /export?since=<cursor>
+ * - `/ack` (POST) sync client acknowledges the files it has stored - note: call /ack?cursor=<cursor>
+ * - `/live` WebSocket with a binary frame for every GPS fix (live_stream.h), only fixes of the sync window or
+ *   charging, the server does not run while tracking
+ * - `/metrics` counters and histograms in Prometheus text format (metrics.h)
  * 
  * @return ESP_OK on success, or an error code on failure.
  */
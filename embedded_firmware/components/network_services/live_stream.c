@@ -0,0 +1,217 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#include "live_stream.h"
+
+static const char *TAG = "LIVE_STREAM";
+
+#ifdef CONFIG_HTTPD_WS_SUPPORT
+
+static portMUX_TYPE live_lock = portMUX_INITIALIZER_UNLOCKED; // Slot is written by the GPS ingest task, read by the httpd task
+
+static httpd_handle_t live_server = NULL;
+static int clients[LIVE_STREAM_MAX_CLIENTS];    // Socket fds, -1 if free - only the httpd task changes them
+static int client_count = 0;
+
+static gps_fix_t slot;                          // Newest fix not sent yet
+static bool slot_full = false;
+static bool send_queued = false;                // A send is queued on the httpd task
+static uint32_t seq = 0;
+static uint16_t dropped = 0;                    // Fixes overwritten in the slot since the last frame
+
+static uint32_t frames_sent = 0;
+static uint32_t fixes_dropped = 0;
+static uint32_t max_age_us = 0;
+
+static void live_stream_remove_client(int index) {
+    ESP_LOGI(TAG, "Client %d disconnected", clients[index]);
+    clients[index] = -1;
+    portENTER_CRITICAL(&live_lock);
+    client_count--;
+    portEXIT_CRITICAL(&live_lock);
+}
+
+static void live_stream_fill_frame(live_stream_frame_t *frame, const gps_fix_t *fix) {
+    frame->version = LIVE_STREAM_FRAME_VERSION;
+    frame->flags = fix->valid ? LIVE_STREAM_FLAG_VALID : 0;
+    frame->date = (uint32_t)fix->date.year * 10000 + fix->date.month * 100 + fix->date.day;
+    frame->time_ms = ((uint32_t)(fix->time.hours * 60 + fix->time.minutes) * 60 + fix->time.seconds) * 1000 +
+                     fix->time.microseconds / 1000;
+    frame->latitude_e6 = fix->latitude_e6;
+    frame->longitude_e6 = fix->longitude_e6;
+    frame->speed_mm_s = fix->speed_mm_s;
+    frame->course_cdeg = fix->course_cdeg;
+    frame->hdop_x100 = fix->hdop_x100;
+    frame->altitude_dm = fix->altitude_dm;
+}
+
+/* Runs on the httpd task, sends the newest fix to every client */
+static void live_stream_send_work(void *arg) {
+
+    live_stream_frame_t frame;
+    gps_fix_t fix;
+    bool full;
+
+    portENTER_CRITICAL(&live_lock);
+    send_queued = false;
+    full = slot_full;
+    slot_full = false;
+    fix = slot;
+    frame.seq = seq;
+    frame.dropped = dropped;
+    dropped = 0;
+    portEXIT_CRITICAL(&live_lock);
+
+    if (!full || live_server == NULL) {
+        return;
+    }
+    live_stream_fill_frame(&frame, &fix);
+    frame.age_us = (uint32_t)(esp_timer_get_time() - fix.rx_time_us);
+
+    httpd_ws_frame_t packet = {
+        .final = true,
+        .type = HTTPD_WS_TYPE_BINARY,
+        .payload = (uint8_t *)&frame,
+        .len = sizeof(frame),
+    };
+    for (int i = 0; i < LIVE_STREAM_MAX_CLIENTS; i++) {
+        if (clients[i] < 0) {
+            continue;
+        }
+        if (httpd_ws_get_fd_info(live_server, clients[i]) != HTTPD_WS_CLIENT_WEBSOCKET ||
+            httpd_ws_send_frame_async(live_server, clients[i], &packet) != ESP_OK) {
+            live_stream_remove_client(i);
+        }
+    }
+
+    frames_sent++;
+    fixes_dropped += frame.dropped;
+    if (frame.age_us > max_age_us) {
+        max_age_us = frame.age_us;
+    }
+}
+
+static esp_err_t live_ws_handler(httpd_req_t *req) {
+
+    // Handshake, the client is added and gets the next fix
+    if (req->method == HTTP_GET) {
+        int fd = httpd_req_to_sockfd(req);
+        for (int i = 0; i < LIVE_STREAM_MAX_CLIENTS; i++) {
+            if (clients[i] == fd) {
+                live_stream_remove_client(i); // Socket of a closed client reused, not sent to since
+            }
+        }
+        for (int i = 0; i < LIVE_STREAM_MAX_CLIENTS; i++) {
+            if (clients[i] < 0) {
+                clients[i] = fd;
+                portENTER_CRITICAL(&live_lock);
+                client_count++;
+                portEXIT_CRITICAL(&live_lock);
+                ESP_LOGI(TAG, "Client %d connected", fd);
+                return ESP_OK;
+            }
+        }
+        ESP_LOGW(TAG, "Too many live clients, closing %d", fd);
+        return ESP_FAIL;
+    }
+
+    // Clients have nothing to say, read the frame and drop it (PING/CLOSE are handled by httpd)
+    uint8_t payload[16];
+    httpd_ws_frame_t frame = {0};
+    ESP_RETURN_ON_ERROR(httpd_ws_recv_frame(req, &frame, 0), TAG, "Failed to read frame length");
+    if (frame.len > sizeof(payload)) {
+        ESP_LOGW(TAG, "Unexpected %d byte frame from client, closing", (int)frame.len);
+        return ESP_FAIL;
+    }
+    frame.payload = payload;
+    return frame.len > 0 ? httpd_ws_recv_frame(req, &frame, frame.len) : ESP_OK;
+}
+
+esp_err_t live_stream_start(httpd_handle_t server) {
+
+    httpd_uri_t live_uri = {
+        .uri          = "/live",
+        .method       = HTTP_GET,
+        .handler      = live_ws_handler,
+        .user_ctx     = NULL,
+        .is_websocket = true
+    };
+    ESP_RETURN_ON_ERROR(httpd_register_uri_handler(server, &live_uri), TAG, "Failed to register /live");
+
+    for (int i = 0; i < LIVE_STREAM_MAX_CLIENTS; i++) {
+        clients[i] = -1;
+    }
+    portENTER_CRITICAL(&live_lock);
+    live_server = server;
+    client_count = 0;
+    slot_full = false;
+    send_queued = false;
+    seq = 0;
+    dropped = 0;
+    portEXIT_CRITICAL(&live_lock);
+    frames_sent = 0;
+    fixes_dropped = 0;
+    max_age_us = 0;
+
+    gps_l96_set_fix_listener(live_stream_publish);
+    return ESP_OK;
+}
+
+void live_stream_stop(void) {
+
+    gps_l96_set_fix_listener(NULL);
+    portENTER_CRITICAL(&live_lock);
+    live_server = NULL;
+    client_count = 0;
+    portEXIT_CRITICAL(&live_lock);
+
+    if (frames_sent > 0) {
+        ESP_LOGI(TAG, "Sent %lu frames, %lu fixes dropped, max age %lu us", frames_sent, fixes_dropped, max_age_us);
+    }
+}
+
+void live_stream_publish(const gps_fix_t *fix) {
+
+    httpd_handle_t queue_on = NULL;
+
+    portENTER_CRITICAL(&live_lock);
+    if (client_count > 0 && live_server != NULL) {
+        if (slot_full && dropped < UINT16_MAX) {
+            dropped++; // Previous fix was not sent yet, the client gets the newer one
+        }
+        slot = *fix;
+        slot_full = true;
+        seq++;
+        if (!send_queued) {
+            send_queued = true;
+            queue_on = live_server;
+        }
+    }
+    portEXIT_CRITICAL(&live_lock);
+
+    // httpd_queue_work() only writes to the httpd control socket, the send itself runs on the httpd task
+    if (queue_on != NULL && httpd_queue_work(queue_on, live_stream_send_work, NULL) != ESP_OK) {
+        portENTER_CRITICAL(&live_lock);
+        send_queued = false; // Next fix tries again
+        portEXIT_CRITICAL(&live_lock);
+    }
+}
+
+#else
+
+esp_err_t live_stream_start(httpd_handle_t server) {
+    ESP_LOGW(TAG, "/live needs CONFIG_HTTPD_WS_SUPPORT");
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+void live_stream_stop(void) {
+}
+
+void live_stream_publish(const gps_fix_t *fix) {
+}
+
+#endif // CONFIG_HTTPD_WS_SUPPORT
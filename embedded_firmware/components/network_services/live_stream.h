@@ -0,0 +1,83 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#ifndef LIVE_STREAM_H
+#define LIVE_STREAM_H
+
+/*
+ * Live position stream (WebSocket /live)
+ *
+ * Every fix from the GPS ingest task is sent to the connected WebSocket clients as one binary frame
+ * (live_stream_frame_t) while the HTTP server runs. The GPS side only copies the fix into a single slot
+ * and queues a send on the httpd task, it never waits for the network. A fix that is still in the slot when
+ * the next one arrives is overwritten: a slow client gets fewer, but always the newest, fixes. The frame
+ * counts the fixes dropped before it.
+ *
+ * The HTTP server only runs while Wi-Fi is up, in the WIFI_SYNC window and while charging. Wi-Fi is off while
+ * tracking, so /live is not a live view of a walk: it streams the fixes the L96 delivers while the collar is in
+ * one of those states, e.g. to check the fix from a phone before a walk.
+ *
+ * Needs CONFIG_HTTPD_WS_SUPPORT, without it /live is not registered.
+ *
+ * tests/test_live_stream_host checks the slot, the dropped count and the publish to send latency on a fake httpd.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "esp_err.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_http_server.h"
+#include "gps_l96/gps_l96.h"
+
+#define LIVE_STREAM_MAX_CLIENTS     2
+#define LIVE_STREAM_FRAME_VERSION   1
+#define LIVE_STREAM_FLAG_VALID      0x01    // RMC status 'A'
+
+/* Binary WebSocket frame, all fields little-endian */
+typedef struct __attribute__((packed)) {
+    uint8_t version;            // LIVE_STREAM_FRAME_VERSION
+    uint8_t flags;              // LIVE_STREAM_FLAG_*
+    uint16_t dropped;           // Fixes overwritten since the previous frame (saturates)
+    uint32_t seq;               // Fix number since the stream started, counts dropped fixes too
+    uint32_t date;              // UTC date as YYYYMMDD
+    uint32_t time_ms;           // UTC time of day in ms
+    int32_t latitude_e6;
+    int32_t longitude_e6;
+    uint32_t speed_mm_s;
+    uint16_t course_cdeg;
+    uint16_t hdop_x100;         // GPS_FIX_HDOP_UNKNOWN if not known
+    int32_t altitude_dm;        // GPS_FIX_ALTITUDE_UNKNOWN if not known
+    uint32_t age_us;            // From the end of the NMEA line on UART to the send of this frame
+} live_stream_frame_t;
+
+_Static_assert(sizeof(live_stream_frame_t) == 40, "live_stream_frame_t layout changed");
+
+/**
+ * @brief Starts streaming on a running HTTP server: registers /live and the GPS fix listener.
+ *
+ * @param server Handle of the running HTTP server.
+ * @return ESP_OK on success, ESP_ERR_NOT_SUPPORTED without CONFIG_HTTPD_WS_SUPPORT, or the registration error.
+ */
+esp_err_t live_stream_start(httpd_handle_t server);
+
+/**
+ * @brief Stops streaming, call it before the HTTP server is stopped.
+ */
+void live_stream_stop(void);
+
+/**
+ * @brief GPS fix listener, copies the fix into the slot and queues a send. Never blocks.
+ *
+ * @param fix Fix published by the GPS ingest task.
+ */
+void live_stream_publish(const gps_fix_t *fix);
+
+#endif // LIVE_STREAM_H
@@ -9,23 +9,123 @@
 
 const char *TAG = "MDNS_SERVICE";
 
+// Service and sync state: set by the state machine and httpd (/ack) tasks, advertised from the Wi-Fi event task
+static SemaphoreHandle_t mdns_mutex = NULL;
+static bool service_added = false;
+static uint32_t txt_pending_files = 0;
+static uint32_t txt_pending_bytes = 0;
+static uint32_t txt_cursor = 0;
+
+/* Takes mdns_mutex, does nothing before mdns_service_init() when the state machine is the only caller */
+static void mdns_service_lock(void) {
+    if (mdns_mutex != NULL) {
+        xSemaphoreTake(mdns_mutex, portMAX_DELAY);
+    }
+}
+
+static void mdns_service_unlock(void) {
+    if (mdns_mutex != NULL) {
+        xSemaphoreGive(mdns_mutex);
+    }
+}
+
+/* Sets all TXT records at once, the responder sends one announcement for the change. Call with mdns_mutex held. */
+static esp_err_t mdns_service_publish_txt(void) {
+
+    char pending[MDNS_TXT_VALUE_SIZE];
+    char bytes[MDNS_TXT_VALUE_SIZE];
+    char cursor[MDNS_TXT_VALUE_SIZE];
+    char soc[MDNS_TXT_VALUE_SIZE];
+    char fmt[MDNS_TXT_VALUE_SIZE];
+
+    snprintf(pending, sizeof(pending), "%lu", txt_pending_files);
+    snprintf(bytes, sizeof(bytes), "%lu", txt_pending_bytes);
+    snprintf(cursor, sizeof(cursor), "%lu", txt_cursor);
+    snprintf(soc, sizeof(soc), "%d", (int)battery_data.soc); // Last value read by the state machine
+    snprintf(fmt, sizeof(fmt), "%d", TRACK_FILE_VERSION);
+
+    mdns_txt_item_t txt[] = {
+        { "pending", pending },
+        { "bytes",   bytes },
+        { "cursor",  cursor },
+        { "soc",     soc },
+        { "fw",      esp_app_get_description()->version },
+        { "fmt",     fmt },
+    };
+    return mdns_service_txt_set(MDNS_SERVICE_TYPE, MDNS_SERVICE_PROTO, txt, sizeof(txt) / sizeof(txt[0]));
+}
+
+esp_err_t mdns_service_init(void) {
+
+    if (mdns_mutex != NULL) {
+        return ESP_OK;
+    }
+
+    mdns_mutex = xSemaphoreCreateMutex();
+    if (mdns_mutex == NULL) {
+        ESP_LOGE(TAG, "Failed to create mDNS mutex");
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
 esp_err_t mdns_service_start(void) {
 
     // Initialize mDNS service
     ESP_RETURN_ON_ERROR(mdns_init(),
                         TAG,
                         "Failed to initialize mDNS service");
-    
+
     // Set hostname
     ESP_RETURN_ON_ERROR(mdns_hostname_set(MDNS_HOST_NAME),
                         TAG,
                         "Failed to set mDNS hostname");
-    
+
     // Set instance name
     ESP_RETURN_ON_ERROR(mdns_instance_name_set("Dog Collar GPS Device"),
                         TAG,
                         "Failed to set mDNS instance name");
 
-    ESP_LOGI(TAG, "mDNS responder started - hostname: %s", MDNS_HOST_NAME);
+    // Advertise the sync service, TXT records are set right after
+    mdns_service_lock();
+    esp_err_t err = mdns_service_add(NULL, MDNS_SERVICE_TYPE, MDNS_SERVICE_PROTO, MDNS_SERVICE_PORT, NULL, 0);
+    if (err != ESP_OK) {
+        mdns_service_unlock();
+        ESP_LOGE(TAG, "Failed to add mDNS sync service");
+        return err;
+    }
+    service_added = true;
+    err = mdns_service_publish_txt();
+    uint32_t pending_files = txt_pending_files;
+    mdns_service_unlock();
+    ESP_RETURN_ON_ERROR(err, TAG, "Failed to set mDNS TXT records");
+
+    ESP_LOGI(TAG, "mDNS responder started - hostname: %s, service %s.%s, %lu files pending",
+             MDNS_HOST_NAME, MDNS_SERVICE_TYPE, MDNS_SERVICE_PROTO, pending_files);
+    return ESP_OK;
+}
+
+void mdns_service_stop(void) {
+    mdns_service_lock();
+    service_added = false;
+    mdns_free(); //No return values
+    mdns_service_unlock();
+}
+
+esp_err_t mdns_service_set_sync_state(uint32_t pending_files, uint32_t pending_bytes, uint32_t cursor) {
+
+    mdns_service_lock();
+    txt_pending_files = pending_files;
+    txt_pending_bytes = pending_bytes;
+    txt_cursor = cursor;
+
+    if (!service_added) {
+        mdns_service_unlock();
+        return ESP_OK; // Advertised by mdns_service_start()
+    }
+    esp_err_t err = mdns_service_publish_txt();
+    mdns_service_unlock();
+    ESP_RETURN_ON_ERROR(err, TAG, "Failed to update mDNS TXT records");
+    ESP_LOGI(TAG, "Advertising %lu files (%lu bytes) pending, cursor %lu", pending_files, pending_bytes, cursor);
     return ESP_OK;
-}
\ No newline at end of file
+}
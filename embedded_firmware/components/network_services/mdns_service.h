@@ -8,25 +8,62 @@
 #ifndef MDNS_SERVICE_H
 #define MDNS_SERVICE_H
 
+#include <stdio.h>
 #include "esp_err.h"
 #include "mdns.h"
 #include "esp_event.h"
 #include "esp_log.h"
-#include "esp_err.h" 
+#include "esp_err.h"
 #include "esp_check.h"
 #include "esp_log.h"
+#include "esp_app_desc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "battery_monitor/battery_monitor.h"
+#include "track_format/track_format.h"
+
+
+#define MDNS_HOST_NAME "dogcollar"
 
+/*
+ * Sync service, browsed by the sync client instead of polling http://dogcollar.local/
+ * TXT records: pending=<files> bytes=<bytes> cursor=<sync cursor> soc=<%> fw=<app version> fmt=<track file version>
+ */
+#define MDNS_SERVICE_TYPE       "_dogcollar"
+#define MDNS_SERVICE_PROTO      "_tcp"
+#define MDNS_SERVICE_PORT       80
+#define MDNS_TXT_VALUE_SIZE     12      // Longest value is a uint32 number
 
-#define MDNS_HOST_NAME "dogcollar" 
+/** Create the lock of the advertised state.
+ * Call before the tasks that use the service start (Wi-Fi event, httpd), calling it again does nothing.
+ * The sync state, the TXT records and the service itself can then be changed from any task.
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if the mutex can not be created.
+ */
+esp_err_t mdns_service_init(void);
 
 /** Start the mDNS service.
  *
- * This function initializes and starts the mDNS service.
+ * This function initializes and starts the mDNS service and advertises the sync service
+ * with the last state set by mdns_service_set_sync_state().
  *
  * @return ESP_OK on success, or an error code on failure.
  */
 esp_err_t mdns_service_start(void);
 
+/** Stop the mDNS service.
+ */
+void mdns_service_stop(void);
+
+/** Update the sync state advertised in the TXT records.
+ *
+ * Can be called before mdns_service_start(), the values are advertised once the service starts.
+ *
+ * @param pending_files Files the sync client has not acknowledged.
+ * @param pending_bytes Size of those files.
+ * @param cursor Latest sync cursor on the collar.
+ * @return ESP_OK on success, or an error code if the TXT records can not be updated.
+ */
+esp_err_t mdns_service_set_sync_state(uint32_t pending_files, uint32_t pending_bytes, uint32_t cursor);
 
 
 #endif // MDNS_SERVICE_H
\ No newline at end of file
@@ -0,0 +1,257 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#include "push_upload.h"
+
+static const char *TAG = "PUSH_UPLOAD";
+
+static char base_url[32];                           // "http://255.255.255.255:65535"
+static char collar_id[PUSH_UPLOAD_COLLAR_ID_SIZE];
+static uint8_t buffer[PUSH_UPLOAD_BUFFER_SIZE];     // Flash reads and collector responses
+
+/* One file being uploaded */
+typedef struct {
+    char url[PUSH_UPLOAD_URL_SIZE];
+    char etag[LFS_ETAG_SIZE];
+    uint32_t size;              // Bytes to upload, the file size when the ETag was made
+    lfs_file_t file;
+} push_upload_file_t;
+
+/* Looks up the first collector with an IPv4 address */
+static esp_err_t push_upload_find_collector(void) {
+
+    mdns_result_t *results = NULL;
+    esp_err_t ret = ESP_ERR_NOT_FOUND;
+
+    esp_err_t err = mdns_query_ptr(PUSH_UPLOAD_SERVICE_TYPE, PUSH_UPLOAD_SERVICE_PROTO, PUSH_UPLOAD_QUERY_TIMEOUT_MS, 1, &results);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "mDNS query for a collector failed: %s", esp_err_to_name(err));
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    for (mdns_result_t *result = results; result != NULL && ret != ESP_OK; result = result->next) {
+        for (mdns_ip_addr_t *addr = result->addr; addr != NULL; addr = addr->next) {
+            if (addr->addr.type == ESP_IPADDR_TYPE_V4) {
+                snprintf(base_url, sizeof(base_url), "http://" IPSTR ":%u", IP2STR(&addr->addr.u_addr.ip4), result->port);
+                ESP_LOGI(TAG, "Collector %s at %s", result->instance_name ? result->instance_name : result->hostname, base_url);
+                ret = ESP_OK;
+                break;
+            }
+        }
+    }
+    mdns_query_results_free(results);
+    return ret;
+}
+
+/* Sends len file bytes from offset (0 only asks) and reads the offset the collector has after it */
+static esp_err_t push_upload_send(esp_http_client_handle_t client, push_upload_file_t *upload,
+                                  uint32_t offset, uint32_t len, uint32_t *collector_offset) {
+
+    char value[12];
+
+    esp_http_client_set_url(client, upload->url);
+    esp_http_client_set_method(client, len > 0 ? HTTP_METHOD_POST : HTTP_METHOD_GET);
+    esp_http_client_set_header(client, "Upload-Etag", upload->etag);
+    snprintf(value, sizeof(value), "%lu", upload->size);
+    esp_http_client_set_header(client, "Upload-Length", value);
+    snprintf(value, sizeof(value), "%lu", offset);
+    esp_http_client_set_header(client, "Upload-Offset", value);
+
+    ESP_RETURN_ON_ERROR(esp_http_client_open(client, len), TAG, "Failed to connect to the collector");
+
+    if (len > 0 && lfs_file_seek(&lfs, &upload->file, offset, LFS_SEEK_SET) < 0) {
+        ESP_LOGE(TAG, "Failed to seek to %lu", offset);
+        return ESP_FAIL;
+    }
+    for (uint32_t remaining = len; remaining > 0;) {
+        lfs_ssize_t n = lfs_file_read(&lfs, &upload->file, buffer, remaining < sizeof(buffer) ? remaining : sizeof(buffer));
+        if (n <= 0) {
+            ESP_LOGE(TAG, "Failed to read file (%ld)", (long)n);
+            return ESP_FAIL;
+        }
+        for (int sent = 0; sent < n;) {
+            int written = esp_http_client_write(client, (const char *)buffer + sent, n - sent);
+            if (written <= 0) {
+                ESP_LOGW(TAG, "Upload interrupted at %lu", offset + len - remaining + sent);
+                return ESP_FAIL;
+            }
+            sent += written;
+        }
+        remaining -= n;
+        sync_session_note_activity(n);
+    }
+
+    if (esp_http_client_fetch_headers(client) < 0) {
+        ESP_LOGW(TAG, "No response from the collector");
+        return ESP_FAIL;
+    }
+    int status = esp_http_client_get_status_code(client);
+    int body_len = esp_http_client_read_response(client, (char *)buffer, sizeof(buffer) - 1);
+    buffer[body_len > 0 ? body_len : 0] = '\0';
+
+    // 409: the collector expects another offset, continue from the one it has
+    if (status != 200 && status != 409) {
+        ESP_LOGE(TAG, "Collector answered %d: %s", status, (char *)buffer);
+        return ESP_FAIL;
+    }
+    char *end;
+    *collector_offset = strtoul((char *)buffer, &end, 10);
+    if (end == (char *)buffer) {
+        ESP_LOGE(TAG, "Invalid offset from the collector: %s", (char *)buffer);
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    return ESP_OK;
+}
+
+static esp_err_t push_upload_file(esp_http_client_handle_t client, const char *filename, push_upload_stats_t *stats) {
+
+    static push_upload_file_t upload;   // Static, lfs_file_t is large
+    uint32_t offset = 0;
+    bool offset_known = false;          // Collector told us what it has
+    uint8_t failures = 0;
+
+    ESP_RETURN_ON_ERROR(lfs_get_file_etag(filename, upload.etag, sizeof(upload.etag), &upload.size),
+                        TAG, "Failed to get ETag of %s", filename);
+    snprintf(upload.url, sizeof(upload.url), "%s/upload?collar=%s&file=%s", base_url, collar_id, filename);
+
+    int err = lfs_file_open(&lfs, &upload.file, filename, LFS_O_RDONLY);
+    if (err < 0) {
+        ESP_LOGE(TAG, "Failed to open %s (%d)", filename, err);
+        return ESP_FAIL;
+    }
+
+    while (!offset_known || offset < upload.size) {
+
+        uint32_t len = 0;   // First ask where to start
+        if (offset_known) {
+            len = upload.size - offset < PUSH_UPLOAD_PIECE_SIZE ? upload.size - offset : PUSH_UPLOAD_PIECE_SIZE;
+        }
+
+        uint32_t collector_offset;
+        if (push_upload_send(client, &upload, offset, len, &collector_offset) != ESP_OK) {
+            esp_http_client_close(client); // Reconnects with the next request
+            offset_known = false;
+        } else if (len > 0 && collector_offset != offset + len) {
+            ESP_LOGW(TAG, "%s: collector has %lu bytes, expected %lu", filename, collector_offset, offset + len);
+            offset = collector_offset;
+        } else {
+            stats->bytes += len;
+            offset = collector_offset;
+            offset_known = true;
+            continue;
+        }
+        if (++failures >= PUSH_UPLOAD_RETRIES) {
+            break;
+        }
+    }
+    lfs_file_close(&lfs, &upload.file);
+
+    if (!offset_known || offset < upload.size) {
+        ESP_LOGE(TAG, "Failed to upload %s, collector has %lu of %lu bytes", filename, offset, upload.size);
+        return ESP_FAIL;
+    }
+    stats->files++;
+    ESP_LOGI(TAG, "Uploaded %s (%lu bytes)", filename, upload.size);
+    return ESP_OK;
+}
+
+/* Tells the collector all files up to cursor are there */
+static esp_err_t push_upload_done(esp_http_client_handle_t client, uint32_t cursor) {
+
+    char url[PUSH_UPLOAD_URL_SIZE];
+
+    snprintf(url, sizeof(url), "%s/upload/done?collar=%s&cursor=%lu", base_url, collar_id, cursor);
+    esp_http_client_set_url(client, url);
+    esp_http_client_set_method(client, HTTP_METHOD_POST);
+    esp_http_client_delete_header(client, "Upload-Etag");
+    esp_http_client_delete_header(client, "Upload-Length");
+    esp_http_client_delete_header(client, "Upload-Offset");
+
+    ESP_RETURN_ON_ERROR(esp_http_client_open(client, 0), TAG, "Failed to connect to the collector");
+    if (esp_http_client_fetch_headers(client) < 0) {
+        ESP_LOGW(TAG, "No response from the collector");
+        return ESP_FAIL;
+    }
+    int status = esp_http_client_get_status_code(client);
+    esp_http_client_read_response(client, (char *)buffer, sizeof(buffer));
+    if (status != 200) {
+        ESP_LOGE(TAG, "Collector answered %d to upload done", status);
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t push_upload_run(push_upload_stats_t *stats) {
+
+    push_upload_stats_t result = {0};
+    lfs_dir_t dir;
+    struct lfs_info info;
+    lfs_file_sync_attr_t sync;
+    uint8_t mac[6];
+    esp_err_t err = ESP_OK;
+
+    int64_t start_us = esp_timer_get_time();
+    uint32_t acked = sync_session_get_acked_cursor();
+    uint32_t cursor = lfs_get_sync_cursor(); // Before listing, files changed during the upload are uploaded next time
+    if (cursor == acked) {
+        ESP_LOGI(TAG, "Nothing to upload, cursor %lu is acknowledged", cursor);
+        result.cursor = cursor;
+        if (stats != NULL) {
+            *stats = result;
+        }
+        return ESP_OK;
+    }
+
+    err = push_upload_find_collector();
+    if (err != ESP_OK) {
+        ESP_LOGI(TAG, "No collector found, waiting for a sync client");
+        return err;
+    }
+    ESP_RETURN_ON_ERROR(esp_read_mac(mac, ESP_MAC_WIFI_STA), TAG, "Failed to read MAC address");
+    snprintf(collar_id, sizeof(collar_id), "dc-%02x%02x%02x%02x%02x%02x", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+
+    esp_http_client_config_t config = {
+        .url = base_url,
+        .timeout_ms = PUSH_UPLOAD_TIMEOUT_MS,
+    };
+    esp_http_client_handle_t client = esp_http_client_init(&config);
+    if (client == NULL) {
+        ESP_LOGE(TAG, "Failed to create HTTP client");
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (lfs_dir_open(&lfs, &dir, "/") < 0) {
+        ESP_LOGE(TAG, "Failed to open directory /");
+        esp_http_client_cleanup(client);
+        return ESP_FAIL;
+    }
+    while (err == ESP_OK && lfs_dir_read(&lfs, &dir, &info) > 0) {
+        if (info.type == LFS_TYPE_REG &&
+            lfs_get_file_sync_attr(info.name, &sync) == ESP_OK &&
+            sync.cursor > acked) {
+            err = push_upload_file(client, info.name, &result);
+        }
+    }
+    lfs_dir_close(&lfs, &dir);
+
+    if (err == ESP_OK) {
+        err = push_upload_done(client, cursor);
+    }
+    esp_http_client_cleanup(client);
+    ESP_RETURN_ON_ERROR(err, TAG, "Upload failed after %lu files", result.files);
+
+    // The collector has everything up to cursor, same as an acknowledgement from a sync client
+    ESP_RETURN_ON_ERROR(sync_session_ack(cursor, NULL), TAG, "Failed to acknowledge cursor %lu", cursor);
+    result.cursor = cursor;
+    result.duration_us = esp_timer_get_time() - start_us;
+    ESP_LOGI(TAG, "Uploaded %lu files, %llu bytes in %lld ms, cursor %lu",
+             result.files, result.bytes, result.duration_us / 1000, cursor);
+    if (stats != NULL) {
+        *stats = result;
+    }
+    return ESP_OK;
+}
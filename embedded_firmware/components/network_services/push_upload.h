@@ -0,0 +1,74 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#ifndef PUSH_UPLOAD_H
+#define PUSH_UPLOAD_H
+
+/*
+ * Push upload to a collector
+ *
+ * Instead of waiting for a sync client to poll the HTTP server, the collar looks for a collector
+ * (mDNS service _dogcollector._tcp) and uploads the files it has not acknowledged yet:
+ *
+ *   GET  /upload?collar=<id>&file=<name>                       -> bytes the collector has (decimal body)
+ *   POST /upload?collar=<id>&file=<name>  one piece of the file -> bytes the collector has after it
+ *   POST /upload/done?collar=<id>&cursor=<cursor>              -> all files up to cursor are uploaded
+ *
+ * Every request carries Upload-Etag (same value as the /download ETag) and Upload-Length (file size), POST
+ * pieces also Upload-Offset. A collector that has a partial file with another ETag starts over at 0, one that
+ * expects another offset answers 409 with the offset it has. So an interrupted upload continues where it
+ * stopped, also in the next sync. After /upload/done the cursor is acknowledged like a POST /ack from a client.
+ *
+ * <id> is "dc-" and the Wi-Fi MAC address, file names are used as they are (no URL encoding needed).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_err.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_mac.h"
+#include "esp_timer.h"
+#include "esp_netif.h"
+#include "esp_http_client.h"
+#include "mdns.h"
+#include "file_system_littlefs/file_system_littlefs.h"
+#include "sync_session.h"
+
+#define PUSH_UPLOAD_ENABLED             true    // Upload to a collector if one is found, the HTTP server runs anyway
+                                                // and the sync window ends early only if files were uploaded
+#define PUSH_UPLOAD_SERVICE_TYPE        "_dogcollector"
+#define PUSH_UPLOAD_SERVICE_PROTO       "_tcp"
+#define PUSH_UPLOAD_QUERY_TIMEOUT_MS    1500    // mDNS query, the radio is on this much longer without a collector
+#define PUSH_UPLOAD_PIECE_SIZE          (32 * 1024) // File bytes per POST, at most this much is sent again after a drop
+#define PUSH_UPLOAD_BUFFER_SIZE         2048    // Flash read buffer
+#define PUSH_UPLOAD_TIMEOUT_MS          10000   // Per request
+#define PUSH_UPLOAD_RETRIES             3       // Failed requests per file before the upload gives up
+#define PUSH_UPLOAD_URL_SIZE            (LFS_MAX_FILE_NAME_SIZE + 96)
+#define PUSH_UPLOAD_COLLAR_ID_SIZE      16      // "dc-" + 12 hex digits + terminator
+
+typedef struct {
+    uint32_t files;             // Files uploaded completely
+    uint64_t bytes;             // File bytes sent (without the ones the collector already had)
+    uint32_t cursor;            // Acknowledged sync cursor
+    int64_t duration_us;
+} push_upload_stats_t;
+
+/**
+ * @brief Finds a collector over mDNS and uploads all files changed after the acknowledged cursor.
+ *
+ * Call it during WIFI_SYNC after sync_session_start(), with Wi-Fi connected.
+ *
+ * @param stats Output upload statistics, can be NULL.
+ * @return ESP_OK if every pending file was uploaded and the cursor acknowledged (stats->files is 0 if nothing was pending),
+ *         ESP_ERR_NOT_FOUND if there is no collector on the network, or another error if the upload failed
+ *         (what was uploaded is kept by the collector, the next sync continues from there).
+ */
+esp_err_t push_upload_run(push_upload_stats_t *stats);
+
+#endif // PUSH_UPLOAD_H
@@ -0,0 +1,128 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#include "stream_pipeline.h"
+
+static const char *TAG = "STREAM_PIPELINE";
+
+typedef struct {
+    uint8_t *data;
+    int32_t len;                // Filled bytes, 0 at the end, negative on error
+} stream_pipeline_block_t;
+
+// Word aligned so SPI DMA reads straight into them (all internal RAM of the ESP32-C3 is DMA capable)
+static DMA_ATTR uint8_t buffers[STREAM_PIPELINE_BUFFER_COUNT][STREAM_PIPELINE_BUFFER_SIZE];
+
+static QueueHandle_t free_queue = NULL;     // Empty buffers, to the producer
+static QueueHandle_t filled_queue = NULL;   // Filled buffers, to the consumer
+static SemaphoreHandle_t stream_mutex = NULL;
+static TaskHandle_t producer_task_handle = NULL;
+
+// Current stream, set before the producer is notified
+static stream_pipeline_fill_t stream_fill = NULL;
+static void *stream_fill_ctx = NULL;
+static volatile bool stream_abort = false;
+
+static void stream_pipeline_producer_task(void *pvParameters) {
+
+    stream_pipeline_block_t block;
+
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY); // Wait for a stream
+
+        do {
+            xQueueReceive(free_queue, &block, portMAX_DELAY);
+            block.len = stream_abort ? -1 : stream_fill(block.data, STREAM_PIPELINE_BUFFER_SIZE, stream_fill_ctx);
+            xQueueSend(filled_queue, &block, portMAX_DELAY);
+        } while (block.len > 0);
+    }
+}
+
+static esp_err_t stream_pipeline_init(void) {
+
+    if (producer_task_handle != NULL) {
+        return ESP_OK;
+    }
+
+    free_queue = xQueueCreate(STREAM_PIPELINE_BUFFER_COUNT, sizeof(stream_pipeline_block_t));
+    filled_queue = xQueueCreate(STREAM_PIPELINE_BUFFER_COUNT, sizeof(stream_pipeline_block_t));
+    stream_mutex = xSemaphoreCreateMutex();
+    if (free_queue == NULL || filled_queue == NULL || stream_mutex == NULL) {
+        ESP_LOGE(TAG, "Failed to create queues");
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (xTaskCreate(stream_pipeline_producer_task, "stream_producer", STREAM_PIPELINE_TASK_STACK_SIZE,
+                    NULL, STREAM_PIPELINE_TASK_PRIORITY, &producer_task_handle) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create producer task");
+        producer_task_handle = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+esp_err_t stream_pipeline_run(stream_pipeline_fill_t fill, void *fill_ctx,
+                              stream_pipeline_drain_t drain, void *drain_ctx,
+                              stream_pipeline_stats_t *stats) {
+
+    stream_pipeline_stats_t run_stats = {0};
+    stream_pipeline_block_t block;
+    esp_err_t ret = ESP_OK;
+
+    ESP_RETURN_ON_ERROR(stream_pipeline_init(), TAG, "Failed to start the pipeline");
+    xSemaphoreTake(stream_mutex, portMAX_DELAY);
+
+    // 1) Hand all buffers to the producer and start it
+    xQueueReset(free_queue);
+    xQueueReset(filled_queue);
+    for (int i = 0; i < STREAM_PIPELINE_BUFFER_COUNT; i++) {
+        block.data = buffers[i];
+        block.len = 0;
+        xQueueSend(free_queue, &block, 0);
+    }
+    stream_fill = fill;
+    stream_fill_ctx = fill_ctx;
+    stream_abort = false;
+
+    int64_t start_us = esp_timer_get_time();
+    xTaskNotifyGive(producer_task_handle);
+
+    // 2) Drain buffers in order until the producer reports the end. After an error the producer is stopped,
+    //    but we keep returning buffers until it has finished, so it never runs into the next stream
+    while (true) {
+        int64_t wait_start_us = esp_timer_get_time();
+        xQueueReceive(filled_queue, &block, portMAX_DELAY);
+        run_stats.drain_wait_us += esp_timer_get_time() - wait_start_us;
+
+        if (block.len <= 0) {
+            if (block.len < 0 && ret == ESP_OK) {
+                ESP_LOGE(TAG, "Producer failed (%ld)", block.len);
+                ret = ESP_FAIL;
+            }
+            break;
+        }
+
+        if (ret == ESP_OK) {
+            ret = drain(block.data, block.len, drain_ctx);
+            if (ret != ESP_OK) {
+                stream_abort = true;
+            } else {
+                run_stats.bytes += block.len;
+                run_stats.buffers++;
+            }
+        }
+        xQueueSend(free_queue, &block, portMAX_DELAY);
+    }
+
+    run_stats.elapsed_us = esp_timer_get_time() - start_us;
+    xSemaphoreGive(stream_mutex);
+
+    if (stats != NULL) {
+        *stats = run_stats;
+    }
+    return ret;
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#ifndef STREAM_PIPELINE_H
+#define STREAM_PIPELINE_H
+
+/*
+ * Double buffered producer/consumer stream
+ *
+ * A producer task fills one buffer (e.g. reads flash over SPI) while the calling task drains the other
+ * (e.g. sends it to a socket), so flash reads and TCP sends overlap instead of taking turns.
+ * One stream runs at a time, the buffers are static so no memory is allocated per stream.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "esp_err.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+
+// One lwIP send buffer (4 x MSS) per buffer: each drain hands the socket a full send window,
+// while the producer reads the next one from flash
+#define STREAM_PIPELINE_BUFFER_SIZE     CONFIG_LWIP_TCP_SND_BUF_DEFAULT
+#define STREAM_PIPELINE_BUFFER_COUNT    2
+#define STREAM_PIPELINE_TASK_STACK_SIZE 4096    // LittleFS reads run on this stack
+#define STREAM_PIPELINE_TASK_PRIORITY   5       // Same as the httpd task, so neither starves the other
+
+/* Fills a buffer. Returns the number of bytes (0 at the end of the stream) or a negative value on error. */
+typedef int32_t (*stream_pipeline_fill_t)(uint8_t *buffer, size_t size, void *ctx);
+
+/* Consumes filled bytes. Returning an error stops the stream. */
+typedef esp_err_t (*stream_pipeline_drain_t)(const uint8_t *data, size_t len, void *ctx);
+
+typedef struct {
+    uint64_t bytes;             // Bytes drained
+    uint32_t buffers;           // Buffers drained
+    int64_t elapsed_us;         // Time of the whole stream
+    int64_t drain_wait_us;      // Time the consumer waited for the producer (the stream was producer bound)
+} stream_pipeline_stats_t;
+
+/**
+ * @brief Streams data from fill to drain, with fill running in the producer task.
+ *
+ * Blocks until fill returned 0 (end), fill returned an error or drain returned an error.
+ * The fill context is only used by the producer task until this function returns.
+ *
+ * @param fill Producer function, called in the producer task.
+ * @param fill_ctx Context for fill.
+ * @param drain Consumer function, called in the calling task in stream order.
+ * @param drain_ctx Context for drain.
+ * @param stats Output statistics, can be NULL.
+ * @return ESP_OK if the stream ended, ESP_FAIL if fill failed, the drain error, or ESP_ERR_NO_MEM if the task can not be created.
+ */
+esp_err_t stream_pipeline_run(stream_pipeline_fill_t fill, void *fill_ctx,
+                              stream_pipeline_drain_t drain, void *drain_ctx,
+                              stream_pipeline_stats_t *stats);
+
+#endif // STREAM_PIPELINE_H
@@ -0,0 +1,193 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#include "sync_session.h"
+
+static const char *TAG = "SYNC_SESSION";
+
+static portMUX_TYPE session_lock = portMUX_INITIALIZER_UNLOCKED; // Activity comes from the httpd task
+
+static int64_t start_us = 0;
+static int64_t last_activity_us = 0;    // Last request or sent data
+static int64_t last_progress_us = 0;    // Last sent data
+static uint64_t bytes_sent = 0;
+static uint32_t window_s = 0;
+static uint32_t extension_s = 0;
+static sync_session_pending_t pending = {0};
+
+/* Counts the files changed after the acknowledged cursor */
+static esp_err_t sync_session_count_pending(sync_session_pending_t *state) {
+
+    lfs_dir_t dir;
+    struct lfs_info info;
+    lfs_file_sync_attr_t sync;
+
+    state->pending_files = 0;
+    state->pending_bytes = 0;
+
+    int err = lfs_dir_open(&lfs, &dir, "/");
+    if (err < 0) {
+        ESP_LOGE(TAG, "Failed to open directory / (%d)", err);
+        return ESP_FAIL;
+    }
+    while (lfs_dir_read(&lfs, &dir, &info) > 0) {
+        if (info.type == LFS_TYPE_REG &&
+            lfs_get_file_sync_attr(info.name, &sync) == ESP_OK &&
+            sync.cursor > state->acked_cursor) {
+            state->pending_files++;
+            state->pending_bytes += info.size;
+        }
+    }
+    lfs_dir_close(&lfs, &dir);
+    return ESP_OK;
+}
+
+/* Extension shrinks linearly from SYNC_SESSION_MAX_EXTENSION_S at 100 % to 0 at SYNC_SESSION_MIN_SOC */
+static uint32_t sync_session_extension_s(void) {
+
+    if (battery_monitor_update_battery_data() != ESP_OK || battery_data.soc <= SYNC_SESSION_MIN_SOC) {
+        return 0; // Unknown or low battery: the radio stays on only for the normal window
+    }
+    float soc = battery_data.soc > 100.0f ? 100.0f : battery_data.soc;
+    return (uint32_t)(SYNC_SESSION_MAX_EXTENSION_S * (soc - SYNC_SESSION_MIN_SOC) / (100 - SYNC_SESSION_MIN_SOC));
+}
+
+esp_err_t sync_session_start(uint32_t base_window_s) {
+
+    sync_session_pending_t state = {0};
+    uint32_t extension = sync_session_extension_s();
+
+    // Cursor read, count and store as one step, an /ack from the httpd task could land in between otherwise
+    lfs_lock_filesystem();
+    if (lfs_getattr(&lfs, "/", LFS_ATTR_ACK_CURSOR, &state.acked_cursor, sizeof(state.acked_cursor)) != sizeof(state.acked_cursor)) {
+        state.acked_cursor = 0; // Never acknowledged, everything is pending
+    }
+    esp_err_t err = sync_session_count_pending(&state);
+
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&session_lock);
+    start_us = now;
+    last_activity_us = now;
+    last_progress_us = 0;
+    bytes_sent = 0;
+    window_s = base_window_s;
+    extension_s = extension;
+    pending = state;
+    portEXIT_CRITICAL(&session_lock);
+    lfs_unlock_filesystem();
+    mdns_service_set_sync_state(state.pending_files, state.pending_bytes, lfs_get_sync_cursor());
+
+    ESP_LOGI(TAG, "Sync session started: %lu files (%lu bytes) pending after cursor %lu, window %lu s + up to %lu s",
+             state.pending_files, state.pending_bytes, state.acked_cursor, base_window_s, extension);
+    return err;
+}
+
+void sync_session_note_activity(uint32_t sent) {
+
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&session_lock);
+    last_activity_us = now;
+    if (sent > 0) {
+        last_progress_us = now;
+        bytes_sent += sent;
+    }
+    portEXIT_CRITICAL(&session_lock);
+}
+
+esp_err_t sync_session_ack(uint32_t cursor, sync_session_pending_t *result) {
+
+    sync_session_pending_t state = { .acked_cursor = cursor };
+    uint32_t highest;
+
+    // Same lock as sync_session_start(), the walk there must not see half of an ack
+    lfs_lock_filesystem();
+    highest = lfs_get_sync_cursor();
+    if (cursor > highest) {
+        lfs_unlock_filesystem();
+        ESP_LOGW(TAG, "Ack of unknown cursor %lu (highest is %lu)", cursor, highest);
+        return ESP_ERR_INVALID_ARG;
+    }
+    int err = lfs_setattr(&lfs, "/", LFS_ATTR_ACK_CURSOR, &cursor, sizeof(cursor));
+    if (err < 0) {
+        lfs_unlock_filesystem();
+        ESP_LOGE(TAG, "Failed to store acknowledged cursor %lu (%d)", cursor, err);
+        return ESP_FAIL;
+    }
+    if (sync_session_count_pending(&state) != ESP_OK) {
+        lfs_unlock_filesystem();
+        ESP_LOGE(TAG, "Failed to count pending files");
+        return ESP_FAIL;
+    }
+
+    portENTER_CRITICAL(&session_lock);
+    pending = state;
+    last_activity_us = esp_timer_get_time();
+    portEXIT_CRITICAL(&session_lock);
+    lfs_unlock_filesystem();
+    mdns_service_set_sync_state(state.pending_files, state.pending_bytes, lfs_get_sync_cursor());
+
+    ESP_LOGI(TAG, "Client acknowledged cursor %lu, %lu files (%lu bytes) pending",
+             cursor, state.pending_files, state.pending_bytes);
+    if (result != NULL) {
+        *result = state;
+    }
+    return ESP_OK;
+}
+
+uint32_t sync_session_get_acked_cursor(void) {
+
+    portENTER_CRITICAL(&session_lock);
+    uint32_t cursor = pending.acked_cursor;
+    portEXIT_CRITICAL(&session_lock);
+    return cursor;
+}
+
+sync_session_state_t sync_session_check(void) {
+
+    sync_session_state_t state = SYNC_SESSION_ACTIVE;
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&session_lock);
+    int64_t elapsed_us = now - start_us;
+    int64_t idle_us = now - last_activity_us;
+    bool progressing = last_progress_us != 0 && now - last_progress_us < SYNC_SESSION_PROGRESS_S * 1000000LL;
+    bool nothing_pending = pending.pending_files == 0;
+    uint64_t sent = bytes_sent;
+    portEXIT_CRITICAL(&session_lock);
+
+    if (nothing_pending && idle_us >= SYNC_SESSION_DONE_LINGER_S * 1000000LL) {
+        state = SYNC_SESSION_DONE;
+    } else if (idle_us >= SYNC_SESSION_IDLE_TIMEOUT_S * 1000000LL) {
+        state = SYNC_SESSION_IDLE;
+    } else if (elapsed_us >= (int64_t)window_s * 1000000LL) {
+        // Past the window only a running transfer keeps the radio on, and only as long as the battery allows
+        if (!progressing || elapsed_us >= (int64_t)(window_s + extension_s) * 1000000LL) {
+            state = SYNC_SESSION_TIMEOUT;
+        }
+    }
+
+    if (state != SYNC_SESSION_ACTIVE) {
+        ESP_LOGI(TAG, "Sync session over (%s) after %lld s: %llu bytes sent, %lu files pending",
+                 sync_session_state_to_string(state), elapsed_us / 1000000, sent, pending.pending_files);
+    }
+    return state;
+}
+
+const char *sync_session_state_to_string(sync_session_state_t state) {
+    switch (state) {
+        case SYNC_SESSION_ACTIVE:
+            return "active";
+        case SYNC_SESSION_DONE:
+            return "done";
+        case SYNC_SESSION_IDLE:
+            return "idle";
+        case SYNC_SESSION_TIMEOUT:
+            return "timeout";
+        default:
+            return "unknown";
+    }
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#ifndef SYNC_SESSION_H
+#define SYNC_SESSION_H
+
+/*
+ * Wi-Fi sync session
+ *
+ * Decides how long the radio stays on during WIFI_SYNC. The sync client acknowledges the sync cursor it
+ * has stored (POST /ack?cursor=N), files with a higher cursor are pending. The session ends:
+ *  - SYNC_SESSION_DONE: nothing is pending and the client went quiet for SYNC_SESSION_DONE_LINGER_S,
+ *  - SYNC_SESSION_IDLE: no client activity for SYNC_SESSION_IDLE_TIMEOUT_S,
+ *  - SYNC_SESSION_TIMEOUT: the window is over. A transfer that is still progressing extends the window,
+ *    by up to SYNC_SESSION_MAX_EXTENSION_S at full battery and not at all below SYNC_SESSION_MIN_SOC.
+ *
+ * The acknowledged cursor is stored on the filesystem (LFS_ATTR_ACK_CURSOR of "/"), so it survives deep sleep.
+ * The pending state is advertised in the mDNS TXT records, so the client only connects when there is something new.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "freertos/FreeRTOS.h"
+#include "esp_err.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "file_system_littlefs/file_system_littlefs.h"
+#include "battery_monitor/battery_monitor.h"
+#include "mdns_service.h"
+
+#define SYNC_SESSION_DONE_LINGER_S      5       // Quiet time after everything is acknowledged (lets a browser finish)
+#define SYNC_SESSION_IDLE_TIMEOUT_S     20      // No request or sent data for this long ends the session
+#define SYNC_SESSION_PROGRESS_S         5       // Data sent within this time counts as an active transfer
+#define SYNC_SESSION_MAX_EXTENSION_S    120     // Window extension for an active transfer at 100 % SoC
+#define SYNC_SESSION_MIN_SOC            20      // No extension at or below this SoC (%)
+
+typedef enum {
+    SYNC_SESSION_ACTIVE,        // Keep the radio on
+    SYNC_SESSION_DONE,          // Client acknowledged everything
+    SYNC_SESSION_IDLE,          // Client went quiet with files still pending
+    SYNC_SESSION_TIMEOUT,       // Window (and extension) is over
+} sync_session_state_t;
+
+typedef struct {
+    uint32_t acked_cursor;      // Sync cursor the client has
+    uint32_t pending_files;     // Files changed after acked_cursor
+    uint32_t pending_bytes;
+} sync_session_pending_t;
+
+/**
+ * @brief Starts a session: loads the acknowledged cursor, counts pending files and sizes the window extension.
+ *
+ * @param window_s Window without extension (WIFI_SYNC_TIME_S).
+ * @return ESP_OK on success, or an error if the pending files can not be counted (the session still runs).
+ */
+esp_err_t sync_session_start(uint32_t window_s);
+
+/**
+ * @brief Records client activity, call it for every request and for sent data.
+ *
+ * @param bytes_sent Response bytes sent, 0 for a request without data.
+ */
+void sync_session_note_activity(uint32_t bytes_sent);
+
+/**
+ * @brief Stores the cursor the client acknowledged and counts the files still pending.
+ *
+ * @param cursor Sync cursor from /manifest or /export that the client has stored.
+ * @param pending Output pending state after the ack, can be NULL.
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if the cursor was never handed out (e.g. from before a format).
+ */
+esp_err_t sync_session_ack(uint32_t cursor, sync_session_pending_t *pending);
+
+/**
+ * @brief Returns the cursor the client acknowledged, as loaded by sync_session_start() or set by sync_session_ack().
+ */
+uint32_t sync_session_get_acked_cursor(void);
+
+/**
+ * @brief Checks whether the session should end. Call it periodically from the WIFI_SYNC state.
+ *
+ * @return SYNC_SESSION_ACTIVE while the radio should stay on, otherwise why the session is over.
+ */
+sync_session_state_t sync_session_check(void);
+
+/**
+ * @brief Returns the name of a session state for logs.
+ */
+const char *sync_session_state_to_string(sync_session_state_t state);
+
+#endif // SYNC_SESSION_H
@@ -0,0 +1,377 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+/*
+ * Host test of the /live WebSocket stream (live_stream.c) on the fake httpd of host_mock_httpd.c: the httpd task is
+ * a thread with the work queue of httpd_queue_work(), the WebSocket clients are senders that record every frame.
+ * The main thread is the GPS ingest task and calls live_stream_publish() for numbered fixes:
+ *
+ * - a client that keeps up, for the publish to send latency (age_us of the frames)
+ * - a client slower than the fixes: live_stream_publish() must not wait for it, the overwritten fixes must be
+ *   counted in the dropped field and the newest fix must be the last frame
+ * - two clients, both must get the same frames
+ * - httpd_queue_work() fails: the fixes stay in the slot and the next publish queues the send again
+ * - a client that closed its socket is removed, the other one keeps streaming and its place can be taken
+ *
+ * Every frame must carry one whole fix, seq must grow and dropped must be the gap to the previous frame.
+ *
+ *     ./test_live_stream [-n fixes]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <getopt.h>
+#include <pthread.h>
+#include "esp_http_server.h"
+#include "live_stream.h"
+
+#define TEST_PUBLISH_INTERVAL_US    1000    // GPS ingest, 1 kHz instead of the 1 Hz of the L96
+#define TEST_SLOW_SEND_US           10000   // Slow client, 10 fixes per frame
+#define TEST_MAX_KEEP_UP_DROPS_PCT  1       // Client that keeps up may only lose fixes when the machine is loaded
+#define TEST_QUEUE_SIZE             8       // Work items of the httpd control socket
+#define TEST_QUEUE_FAILS            3
+#define TEST_MAX_FRAMES             100000
+
+typedef struct {
+    int fd;
+    live_stream_frame_t *frames;
+    uint32_t count;
+    uint32_t send_us;           // Time the send takes, a slow client
+} test_client_t;
+
+typedef struct {
+    const char *name;
+    uint32_t clients;
+    uint32_t send_us;
+} test_case_t;
+
+static test_client_t test_clients[LIVE_STREAM_MAX_CLIENTS + 1];
+static pthread_mutex_t test_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* gps_l96.c is not linked, the test calls live_stream_publish() itself */
+void gps_l96_set_fix_listener(gps_fix_listener_t listener) {
+}
+
+static void test_sleep_us(uint32_t us) {
+    struct timespec delay = { .tv_sec = us / 1000000, .tv_nsec = (long)(us % 1000000) * 1000 };
+    nanosleep(&delay, NULL);
+}
+
+static int64_t test_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static int test_compare_u32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+/* WebSocket client, runs on the httpd task */
+static esp_err_t test_sender(int fd, const uint8_t *payload, size_t len, void *ctx) {
+    test_client_t *client = NULL;
+
+    pthread_mutex_lock(&test_lock);
+    for (size_t i = 0; i < sizeof(test_clients) / sizeof(test_clients[0]); i++) {
+        if (test_clients[i].fd == fd) {
+            client = &test_clients[i];
+        }
+    }
+    if (client != NULL && len == sizeof(live_stream_frame_t) && client->count < TEST_MAX_FRAMES) {
+        memcpy(&client->frames[client->count++], payload, len);
+    }
+    uint32_t send_us = client != NULL ? client->send_us : 0;
+    pthread_mutex_unlock(&test_lock);
+
+    if (send_us > 0) {
+        test_sleep_us(send_us);
+    }
+    return client != NULL && len == sizeof(live_stream_frame_t) ? ESP_OK : ESP_FAIL;
+}
+
+/* Fix number n: every field is derived from n, so a frame with fields of two fixes is found */
+static void test_make_fix(gps_fix_t *fix, uint32_t n) {
+    memset(fix, 0, sizeof(*fix));
+    fix->date.year = 2025;
+    fix->date.month = 6;
+    fix->date.day = 1;
+    fix->time.hours = (n / 3600) % 24;
+    fix->time.minutes = (n / 60) % 60;
+    fix->time.seconds = n % 60;
+    fix->latitude_e6 = 46050000 + (int32_t)n;
+    fix->longitude_e6 = 14500000 - (int32_t)n;
+    fix->speed_mm_s = n;
+    fix->altitude_dm = GPS_FIX_ALTITUDE_UNKNOWN;
+    fix->hdop_x100 = GPS_FIX_HDOP_UNKNOWN;
+    fix->valid = true;
+}
+
+static uint32_t test_publish(uint32_t n) {
+    gps_fix_t fix;
+    test_make_fix(&fix, n);
+    fix.rx_time_us = esp_timer_get_time(); // age_us of the frame is then the publish to send latency
+    int64_t start_ns = test_now_ns();
+    live_stream_publish(&fix);
+    return (uint32_t)((test_now_ns() - start_ns) / 1000);
+}
+
+/* Frames of fixes 1..published (seq starts at 1 with live_stream_start()): whole, in order, gaps counted */
+static int test_check_frames(const char *name, const test_client_t *client, uint32_t published, uint32_t *dropped) {
+    uint32_t prev_seq = 0;
+    uint32_t gaps = 0;
+
+    *dropped = 0;
+    for (uint32_t i = 0; i < client->count; i++) {
+        const live_stream_frame_t *frame = &client->frames[i];
+        uint32_t n = frame->seq - 1; // Fix numbers of the test start at 0
+        if (frame->version != LIVE_STREAM_FRAME_VERSION || frame->flags != LIVE_STREAM_FLAG_VALID ||
+            frame->latitude_e6 != 46050000 + (int32_t)n || frame->longitude_e6 != 14500000 - (int32_t)n ||
+            frame->speed_mm_s != n || frame->time_ms != (n % 86400) * 1000) {
+            fprintf(stderr, "%s: client %d frame %lu (seq %lu) is not one whole fix\n", name, client->fd, i, frame->seq);
+            return 1;
+        }
+        if (frame->seq <= prev_seq || frame->dropped != frame->seq - prev_seq - 1) {
+            fprintf(stderr, "%s: client %d frame %lu has seq %lu and %u dropped after seq %lu\n", name, client->fd, i,
+                    frame->seq, frame->dropped, prev_seq);
+            return 1;
+        }
+        gaps += frame->seq - prev_seq - 1;
+        *dropped += frame->dropped;
+        prev_seq = frame->seq;
+    }
+    if (client->count + *dropped != published || gaps != *dropped) {
+        fprintf(stderr, "%s: client %d got %lu frames and %lu dropped of %lu fixes\n", name, client->fd,
+                client->count, *dropped, published);
+        return 1;
+    }
+    if (published > 0 && prev_seq != published) {
+        fprintf(stderr, "%s: client %d last frame is seq %lu, newest fix is %lu\n", name, client->fd, prev_seq, published);
+        return 1;
+    }
+    return 0;
+}
+
+static void test_latency(const test_client_t *client, uint32_t *p50, uint32_t *p99, uint32_t *max) {
+    uint32_t *age = malloc(client->count * sizeof(uint32_t));
+    *p50 = *p99 = *max = 0;
+    if (age == NULL || client->count == 0) {
+        free(age);
+        return;
+    }
+    for (uint32_t i = 0; i < client->count; i++) {
+        age[i] = client->frames[i].age_us;
+    }
+    qsort(age, client->count, sizeof(uint32_t), test_compare_u32);
+    *p50 = age[client->count / 2];
+    *p99 = age[(uint64_t)client->count * 99 / 100];
+    *max = age[client->count - 1];
+    free(age);
+}
+
+static esp_err_t test_begin(httpd_handle_t *server, uint32_t clients, uint32_t send_us) {
+    pthread_mutex_lock(&test_lock);
+    for (uint32_t i = 0; i < sizeof(test_clients) / sizeof(test_clients[0]); i++) {
+        test_clients[i].fd = i < clients ? 3 + (int)i : -1;
+        test_clients[i].count = 0;
+        test_clients[i].send_us = send_us;
+    }
+    pthread_mutex_unlock(&test_lock);
+
+    host_mock_httpd_set_sender(test_sender, NULL);
+    ESP_RETURN_ON_ERROR(host_mock_httpd_start(server, TEST_QUEUE_SIZE), "TEST", "Failed to start httpd");
+    ESP_RETURN_ON_ERROR(live_stream_start(*server), "TEST", "Failed to start /live");
+    for (uint32_t i = 0; i < clients; i++) {
+        ESP_RETURN_ON_ERROR(host_mock_httpd_ws_connect(*server, "/live", test_clients[i].fd), "TEST", "Handshake failed");
+    }
+    return ESP_OK;
+}
+
+static void test_end(httpd_handle_t server) {
+    host_mock_httpd_wait_idle(server);
+    live_stream_stop();
+    host_mock_httpd_stop(server);
+}
+
+/* Streaming cases: fixes published at TEST_PUBLISH_INTERVAL_US to every client */
+static int test_stream(const test_case_t *tc, uint32_t fixes) {
+    httpd_handle_t server;
+    uint32_t max_publish_us = 0;
+    int failed = 0;
+
+    if (test_begin(&server, tc->clients, tc->send_us) != ESP_OK) {
+        fprintf(stderr, "%s: setup failed\n", tc->name);
+        test_end(server);
+        return 1;
+    }
+    for (uint32_t n = 0; n < fixes; n++) {
+        uint32_t publish_us = test_publish(n);
+        max_publish_us = publish_us > max_publish_us ? publish_us : max_publish_us;
+        test_sleep_us(TEST_PUBLISH_INTERVAL_US);
+    }
+    test_end(server);
+
+    for (uint32_t i = 0; i < tc->clients; i++) {
+        uint32_t dropped, p50, p99, max;
+        failed += test_check_frames(tc->name, &test_clients[i], fixes, &dropped);
+        test_latency(&test_clients[i], &p50, &p99, &max);
+        printf("%-18s client %d: %6lu frames, %6lu dropped (%5.1f %%) | publish to send p50 %6lu us, p99 %6lu us, "
+               "max %6lu us | publish max %lu us\n", tc->name, test_clients[i].fd, test_clients[i].count, dropped,
+               100.0 * dropped / fixes, p50, p99, max, max_publish_us);
+
+        if (tc->send_us == 0 && dropped * 100 > (uint64_t)fixes * TEST_MAX_KEEP_UP_DROPS_PCT) {
+            fprintf(stderr, "%s: client that keeps up lost %lu of %lu fixes\n", tc->name, dropped, fixes);
+            failed++;
+        }
+        if (tc->send_us > 0 && dropped == 0) {
+            fprintf(stderr, "%s: a client slower than the fixes lost none\n", tc->name);
+            failed++;
+        }
+        if (i > 0 && (test_clients[i].count != test_clients[0].count ||
+                      memcmp(test_clients[i].frames, test_clients[0].frames,
+                             test_clients[0].count * sizeof(live_stream_frame_t)) != 0)) {
+            fprintf(stderr, "%s: clients %d and %d got different frames\n", tc->name, test_clients[0].fd,
+                    test_clients[i].fd);
+            failed++;
+        }
+    }
+    // The ingest task copies the fix and queues the send, it must never wait for a slow client
+    if (tc->send_us > 0 && max_publish_us >= tc->send_us / 2) {
+        fprintf(stderr, "%s: live_stream_publish() took %lu us, the client takes %lu us per frame\n", tc->name,
+                max_publish_us, tc->send_us);
+        failed++;
+    }
+    return failed;
+}
+
+/* httpd_queue_work() fails for the first fixes: nothing is sent, the next publish queues the newest fix */
+static int test_queue_work_fails(void) {
+    httpd_handle_t server;
+    uint32_t dropped;
+    int failed = 0;
+
+    if (test_begin(&server, 1, 0) != ESP_OK) {
+        fprintf(stderr, "queue work fails: setup failed\n");
+        test_end(server);
+        return 1;
+    }
+    host_mock_httpd_fail_queue_work(TEST_QUEUE_FAILS);
+    for (uint32_t n = 0; n < TEST_QUEUE_FAILS; n++) {
+        test_publish(n);
+    }
+    host_mock_httpd_wait_idle(server);
+    uint32_t frames_while_failing = test_clients[0].count;
+    test_publish(TEST_QUEUE_FAILS);
+    test_end(server);
+
+    failed += test_check_frames("queue work fails", &test_clients[0], TEST_QUEUE_FAILS + 1, &dropped);
+    if (frames_while_failing != 0 || test_clients[0].count != 1 || dropped != TEST_QUEUE_FAILS) {
+        fprintf(stderr, "queue work fails: %lu frames while httpd_queue_work() failed, then %lu frames with %lu dropped\n",
+                frames_while_failing, test_clients[0].count, dropped);
+        failed++;
+    }
+    printf("queue work fails   httpd_queue_work() failed %d times, the next fix was sent with %lu dropped\n", TEST_QUEUE_FAILS, dropped);
+    return failed;
+}
+
+/* A client goes away: the send to it fails and it is removed, the other client keeps streaming */
+static int test_client_closes(void) {
+    httpd_handle_t server;
+    int failed = 0;
+
+    if (test_begin(&server, LIVE_STREAM_MAX_CLIENTS, 0) != ESP_OK) {
+        fprintf(stderr, "client closes: setup failed\n");
+        test_end(server);
+        return 1;
+    }
+    int extra_fd = 3 + LIVE_STREAM_MAX_CLIENTS;
+    pthread_mutex_lock(&test_lock);
+    test_clients[LIVE_STREAM_MAX_CLIENTS].fd = extra_fd;
+    pthread_mutex_unlock(&test_lock);
+    if (host_mock_httpd_ws_connect(server, "/live", extra_fd) == ESP_OK) {
+        fprintf(stderr, "client closes: client %d accepted over LIVE_STREAM_MAX_CLIENTS\n", extra_fd);
+        failed++;
+    }
+
+    test_publish(0);
+    host_mock_httpd_wait_idle(server);
+    host_mock_httpd_ws_close(server, test_clients[0].fd);
+    test_publish(1);
+    host_mock_httpd_wait_idle(server);
+    uint32_t closed_frames = test_clients[0].count;
+
+    // The place of the closed client is free again
+    esp_err_t reconnect = host_mock_httpd_ws_connect(server, "/live", extra_fd);
+    test_publish(2);
+    test_end(server);
+
+    uint32_t dropped;
+    failed += test_check_frames("client closes", &test_clients[1], 3, &dropped);
+    if (closed_frames != 1 || test_clients[0].count != 1) {
+        fprintf(stderr, "client closes: closed client got %lu frames, expected 1\n", test_clients[0].count);
+        failed++;
+    }
+    if (reconnect != ESP_OK || test_clients[LIVE_STREAM_MAX_CLIENTS].count != 1 ||
+        test_clients[LIVE_STREAM_MAX_CLIENTS].frames[0].seq != 3) {
+        fprintf(stderr, "client closes: new client %s, got %lu frames\n", reconnect == ESP_OK ? "connected" : "refused",
+                test_clients[LIVE_STREAM_MAX_CLIENTS].count);
+        failed++;
+    }
+    printf("client closes      removed after a failed send, the other client got %lu of 3 frames, new client took its place\n",
+           test_clients[1].count);
+    return failed;
+}
+
+int main(int argc, char **argv) {
+    uint32_t fixes = 2000;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        switch (opt) {
+            case 'n': fixes = strtoul(optarg, NULL, 10); break;
+            default:
+                fprintf(stderr, "Usage: %s [-n fixes]\n", argv[0]);
+                return 2;
+        }
+    }
+    if (fixes == 0 || fixes > TEST_MAX_FRAMES) {
+        fprintf(stderr, "1 to %d fixes\n", TEST_MAX_FRAMES);
+        return 2;
+    }
+
+    for (size_t i = 0; i < sizeof(test_clients) / sizeof(test_clients[0]); i++) {
+        test_clients[i].frames = malloc(TEST_MAX_FRAMES * sizeof(live_stream_frame_t));
+        if (test_clients[i].frames == NULL) {
+            fprintf(stderr, "Out of memory\n");
+            return 1;
+        }
+    }
+
+    static const test_case_t cases[] = {
+        { "client keeps up",  1,                       0 },
+        { "slow client",      1,                       TEST_SLOW_SEND_US },
+        { "two clients",      LIVE_STREAM_MAX_CLIENTS, 0 },
+    };
+
+    int failed = 0;
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        failed += test_stream(&cases[i], fixes);
+    }
+    failed += test_queue_work_fails();
+    failed += test_client_closes();
+
+    for (size_t i = 0; i < sizeof(test_clients) / sizeof(test_clients[0]); i++) {
+        free(test_clients[i].frames);
+    }
+    if (failed) {
+        fprintf(stderr, "%d live stream cases failed\n", failed);
+        return 1;
+    }
+    return 0;
+}
@@ -24,6 +24,105 @@ static EventGroupHandle_t s_wifi_event_group;
 
 static int s_retry_num = 0;
 
+/*
+ * Fast reconnect
+ *
+ * A normal connect scans all channels, associates and then waits for DHCP. After deep sleep we are
+ * almost always at the same AP, so the AP of the last connection is kept in RTC memory and the next
+ * connect goes straight to its BSSID on its channel. The DHCP address is reused as static IP, so the
+ * DHCP round trips are skipped too. If the directed connect fails the cache is dropped and the normal
+ * scan + DHCP connect follows.
+ */
+#define WIFI_FAST_CONNECT_MAGIC 0x57464331 // "WFC1"
+
+typedef struct {
+    uint32_t magic;
+    uint8_t bssid[6];
+    uint8_t channel;
+    esp_netif_ip_info_t ip_info;        // Address, netmask and gateway from the last DHCP lease
+    time_t lease_time;                  // When DHCP gave us ip_info (system time keeps running over deep sleep)
+    uint32_t crc;                       // esp_rom_crc32_le of all fields above
+} wifi_fast_connect_cache_t;
+
+static RTC_DATA_ATTR wifi_fast_connect_cache_t fast_connect_cache;
+
+static bool fast_connect_active = false;    // Current connection attempt uses the cache
+static bool static_ip_active = false;       // DHCP client is stopped, the cached address is set
+static int64_t connect_start_us = 0;
+
+static uint32_t wifi_fast_connect_crc(const wifi_fast_connect_cache_t *cache) {
+    return esp_rom_crc32_le(0, (const uint8_t *)cache, offsetof(wifi_fast_connect_cache_t, crc));
+}
+
+static bool wifi_fast_connect_cache_valid(void) {
+    return fast_connect_cache.magic == WIFI_FAST_CONNECT_MAGIC &&
+           fast_connect_cache.crc == wifi_fast_connect_crc(&fast_connect_cache);
+}
+
+/* Remembers the AP and address we are connected to */
+static void wifi_fast_connect_save(const esp_netif_ip_info_t *ip_info) {
+
+    wifi_ap_record_t ap_info;
+    wifi_fast_connect_cache_t cache;
+
+    if (esp_wifi_sta_get_ap_info(&ap_info) != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to get AP info, fast reconnect cache not updated");
+        return;
+    }
+
+    memset(&cache, 0, sizeof(cache)); // Padding is part of the CRC
+    cache.magic = WIFI_FAST_CONNECT_MAGIC;
+    memcpy(cache.bssid, ap_info.bssid, sizeof(cache.bssid));
+    cache.channel = ap_info.primary;
+    cache.ip_info = *ip_info;
+    // A reused static address keeps the time of the original lease, so it is not reused forever
+    cache.lease_time = static_ip_active ? fast_connect_cache.lease_time : time(NULL);
+    cache.crc = wifi_fast_connect_crc(&cache);
+    fast_connect_cache = cache;
+}
+
+/* Sets the cached address as static IP if the lease is recent enough. Returns true if it was set. */
+static bool wifi_fast_connect_set_static_ip(void) {
+
+    time_t now = time(NULL);
+    if (!WIFI_REUSE_STATIC_IP || now < fast_connect_cache.lease_time ||
+        now - fast_connect_cache.lease_time > WIFI_STATIC_IP_MAX_AGE_S) {
+        return false;
+    }
+
+    esp_err_t err = esp_netif_dhcpc_stop(sta_netif);
+    if (err != ESP_OK && err != ESP_ERR_ESP_NETIF_DHCP_ALREADY_STOPPED) {
+        ESP_LOGW(TAG, "Failed to stop DHCP client: %s", esp_err_to_name(err));
+        return false;
+    }
+    if (esp_netif_set_ip_info(sta_netif, &fast_connect_cache.ip_info) != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to set static IP, using DHCP");
+        esp_netif_dhcpc_start(sta_netif);
+        return false;
+    }
+    return true;
+}
+
+/* The cached AP did not answer - forget it and connect the normal way */
+static void wifi_fast_connect_fallback(void) {
+
+    wifi_config_t wifi_config;
+
+    ESP_LOGW(TAG, "Fast reconnect to cached AP failed, scanning for SSID:%s", ssid);
+    fast_connect_active = false;
+    fast_connect_cache.magic = 0;
+
+    if (esp_wifi_get_config(WIFI_IF_STA, &wifi_config) == ESP_OK) {
+        wifi_config.sta.bssid_set = false;
+        wifi_config.sta.channel = 0;
+        esp_wifi_set_config(WIFI_IF_STA, &wifi_config);
+    }
+    if (static_ip_active) {
+        esp_netif_dhcpc_start(sta_netif);
+        static_ip_active = false;
+    }
+}
+
 
 esp_err_t wifi_init(void) {
     if (wifi_initialized) {
@@ -35,6 +134,11 @@ esp_err_t wifi_init(void) {
                         TAG, "Failed to initialize NVS"
     );
 
+    // Before the event handler starts mDNS, the httpd task updates it on /ack
+    ESP_RETURN_ON_ERROR(mdns_service_init(),
+                        TAG, "Failed to initialize mDNS service"
+    );
+
     ESP_RETURN_ON_ERROR(wifi_connect_and_start_services(),
                         TAG, "Failed to connect to Wi-Fi network"
     );
@@ -56,8 +160,12 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,
                 break;
 
             case WIFI_EVENT_STA_DISCONNECTED:
-                esp_wifi_connect();
                 s_retry_num++;
+                metrics_inc(METRICS_WIFI_CONNECT_RETRIES);
+                if (fast_connect_active && s_retry_num >= WIFI_FAST_CONNECT_ATTEMPTS) {
+                    wifi_fast_connect_fallback();
+                }
+                esp_wifi_connect();
                 ESP_LOGI(TAG, "Retrying to connect to SSID:%s, attempt %d", ssid, s_retry_num);
                 break;
 
@@ -66,17 +174,21 @@ static void wifi_event_handler(void* arg, esp_event_base_t event_base,
         }
     } else if (event_base == IP_EVENT && event_id == IP_EVENT_STA_GOT_IP) {
         ip_event_got_ip_t* event = (ip_event_got_ip_t*) event_data;
-        ESP_LOGI(TAG, "Got IP address: " IPSTR, IP2STR(&event->ip_info.ip));
+        metrics_observe(METRICS_WIFI_CONNECT_US, (uint32_t)(esp_timer_get_time() - connect_start_us));
+        ESP_LOGI(TAG, "Got IP address: " IPSTR " %lld ms after Wi-Fi start (%s)", IP2STR(&event->ip_info.ip),
+                 (esp_timer_get_time() - connect_start_us) / 1000,
+                 !fast_connect_active ? "scan, DHCP" : static_ip_active ? "cached AP, static IP" : "cached AP, DHCP");
+        wifi_fast_connect_save(&event->ip_info);
         s_retry_num = 0;
-        xEventGroupSetBits(s_wifi_event_group, WIFI_CONNECTED_BIT);
 
-        
-        mdns_service_start(); 
-        http_server_start();  
+        mdns_service_start();
+        http_server_start();
+        xEventGroupSetBits(s_wifi_event_group, WIFI_CONNECTED_BIT); // After the services, push upload queries mDNS right away
     }
 }
 
 esp_err_t wifi_connect_and_start_services(void) { //TODO HANDLE ERRORS - return error
+    connect_start_us = esp_timer_get_time();
     s_wifi_event_group = xEventGroupCreate();
 
     // Initialize TCP/IP stack
@@ -130,6 +242,18 @@ esp_err_t wifi_connect_and_start_services(void) { //TODO HANDLE ERRORS - return
     strncpy((char*)wifi_config.sta.ssid, ssid, sizeof(wifi_config.sta.ssid) - 1);
     strncpy((char*)wifi_config.sta.password, password, sizeof(wifi_config.sta.password) - 1);
 
+    /* After deep sleep go straight to the AP of the last connection, no scan */
+    fast_connect_active = wifi_fast_connect_cache_valid();
+    static_ip_active = false;
+    if (fast_connect_active) {
+        memcpy(wifi_config.sta.bssid, fast_connect_cache.bssid, sizeof(wifi_config.sta.bssid));
+        wifi_config.sta.bssid_set = true;
+        wifi_config.sta.channel = fast_connect_cache.channel;
+        static_ip_active = wifi_fast_connect_set_static_ip();
+        ESP_LOGI(TAG, "Fast reconnect to cached AP on channel %d%s", fast_connect_cache.channel,
+                 static_ip_active ? " with static IP" : "");
+    }
+
     ESP_RETURN_ON_ERROR(esp_wifi_set_mode(WIFI_MODE_STA),
                         TAG,
                         "Failed to set Wi-Fi mode");
@@ -183,7 +307,7 @@ esp_err_t wifi_stop_all_services(void) {
         any_errors = true;
     }
 
-    mdns_free(); //No return values
+    mdns_service_stop();
     ESP_LOGI(TAG, "mDNS service stopped");
 
     // 3. Disconnect from network
@@ -281,4 +405,8 @@ bool wifi_manager_is_initialized_and_connected(void) {
     }
     ESP_LOGI(TAG, "WiFi is not connected");
     return false;
-}
\ No newline at end of file
+}
+
+int64_t wifi_manager_get_connect_start_us(void) {
+    return connect_start_us;
+}
@@ -21,12 +21,23 @@
 #include "esp_check.h"
 #include "esp_log.h"
 #include "nvs_flash.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "esp_rom_crc.h"
+#include <stddef.h>
+#include <time.h>
 #include "file_system_littlefs/file_system_littlefs.h"
 #include "mdns_service.h"
+#include "metrics/metrics.h"
 #include "network_services/http_server.h"
 
 #define WIFI_MAX_CONNECTION_TIMEOUT_MS 1 * 60 * 1000 // 1 minute
 
+/* Fast reconnect: channel, BSSID and DHCP lease of the last connection are kept in RTC memory over deep sleep */
+#define WIFI_FAST_CONNECT_ATTEMPTS 2 // Directed connects to the cached AP before falling back to a full scan
+#define WIFI_REUSE_STATIC_IP true // Reuse the cached DHCP address as static IP (skips DHCP)
+#define WIFI_STATIC_IP_MAX_AGE_S (12 * 60 * 60) // Only reuse the address this long after DHCP gave it to us
+
 /**
  * @brief Initializes all modules for WI-FI connectivity 
  *
@@ -87,6 +98,13 @@ esp_err_t wifi_manager_reconnect(void);
  */
 bool wifi_manager_is_initialized_and_connected(void);
 
+/**
+ * @brief Returns the esp_timer time when the last Wi-Fi connection was started, used to log time-to-first-request.
+ *
+ * @return Time in microseconds since boot, 0 if Wi-Fi was not started yet.
+ */
+int64_t wifi_manager_get_connect_start_us(void);
+
 
 
 #endif // WIFI_MANAGER_H
\ No newline at end of file
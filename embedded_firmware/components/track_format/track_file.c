@@ -0,0 +1,140 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#include "track_file.h"
+
+static const char *TAG = "TRACK_FILE";
+
+static track_cursor_t encoder_cursor = {0}; // Last record written to the open track
+
+esp_err_t track_file_create(char *filename, size_t filename_size) {
+
+    gps_fix_t fix;
+    track_file_header_t header;
+
+    gps_l96_get_current_fix(&fix);
+    uint32_t start_time = track_format_fix_to_unix_time(&fix);
+    track_format_init_header(&header, start_time);
+
+    ESP_RETURN_ON_ERROR(lfs_create_new_file(TRACK_FILE_PREFIX, TRACK_FILE_SUFFIX, &header, sizeof(header), filename, filename_size),
+                        TAG, "Failed to create track file");
+    ESP_RETURN_ON_ERROR(lfs_set_file_mtime(filename, start_time), TAG, "Failed to set track file mtime");
+
+    track_format_init_cursor(&encoder_cursor, start_time);
+    return ESP_OK;
+}
+
+esp_err_t track_file_resume(const char *filename) {
+
+    lfs_file_t file;
+    track_file_header_t header;
+    track_record_t record;
+    uint32_t records = 0;
+    esp_err_t ret = ESP_OK;
+
+    int err = lfs_file_open(&lfs, &file, filename, LFS_O_RDWR);
+    if (err < 0) {
+        ESP_LOGE(TAG, "Failed to open %s (%d)", filename, err);
+        return ESP_FAIL;
+    }
+
+    // 1) Header - we can only continue files written in the current record layout
+    if (lfs_file_read(&lfs, &file, &header, sizeof(header)) != sizeof(header)) {
+        ESP_LOGE(TAG, "Track file %s has no header", filename);
+        lfs_file_close(&lfs, &file);
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    ret = track_format_check_header(&header);
+    if (ret == ESP_OK && header.record_size != sizeof(track_record_t)) {
+        ret = ESP_ERR_INVALID_VERSION;
+    }
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Track file %s has unsupported header: %s", filename, esp_err_to_name(ret));
+        lfs_file_close(&lfs, &file);
+        return ret;
+    }
+
+    // 2) Replay records (reads are served from the LittleFS cache)
+    track_format_init_cursor(&encoder_cursor, header.start_time);
+    lfs_ssize_t bytes_read;
+    while ((bytes_read = lfs_file_read(&lfs, &file, &record, sizeof(record))) == sizeof(record)) {
+        track_format_decode_record(&encoder_cursor, &record, NULL);
+        records++;
+    }
+
+    // 3) Cut off a partially written record, so new records stay aligned
+    if (bytes_read > 0) {
+        ESP_LOGW(TAG, "Removing %d byte partial record from %s", (int)bytes_read, filename);
+        err = lfs_file_truncate(&lfs, &file, sizeof(header) + records * sizeof(record));
+        if (err < 0) {
+            ESP_LOGE(TAG, "Failed to truncate %s (%d)", filename, err);
+            ret = ESP_FAIL;
+        }
+    } else if (bytes_read < 0) {
+        ESP_LOGE(TAG, "Failed to read %s (%d)", filename, (int)bytes_read);
+        ret = ESP_FAIL;
+    }
+
+    lfs_file_close(&lfs, &file);
+    ESP_LOGI(TAG, "Resumed %s after %lu records", filename, records);
+    return ret;
+}
+
+esp_err_t track_file_append_fix(const gps_fix_t *fix) {
+
+    track_record_t records[2];
+    size_t count = track_format_encode_fix(&encoder_cursor, fix, records);
+
+    track_writer_set_mtime(encoder_cursor.time);
+    return track_writer_append(records, count * sizeof(track_record_t));
+}
+
+esp_err_t track_file_export(const char *filename, track_export_format_t format, track_export_write_t write, void *ctx) {
+
+    lfs_file_t file;
+    track_export_t exporter;
+    uint8_t read_buffer[TRACK_FILE_READ_CHUNK];
+    lfs_ssize_t bytes_read;
+    esp_err_t ret;
+
+    int err = lfs_file_open(&lfs, &file, filename, LFS_O_RDONLY);
+    if (err < 0) {
+        ESP_LOGE(TAG, "Failed to open %s for export (%d)", filename, err);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    ret = track_export_begin(&exporter, format, write, ctx);
+
+    while (ret == ESP_OK && (bytes_read = lfs_file_read(&lfs, &file, read_buffer, sizeof(read_buffer))) != 0) {
+        if (bytes_read < 0) {
+            ESP_LOGE(TAG, "Failed to read %s (%d)", filename, (int)bytes_read);
+            ret = ESP_FAIL;
+            break;
+        }
+        ret = track_export_feed(&exporter, read_buffer, bytes_read);
+    }
+
+    if (ret == ESP_OK) {
+        ret = track_export_end(&exporter);
+    }
+
+    lfs_file_close(&lfs, &file);
+
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Export of %s failed: %s", filename, esp_err_to_name(ret));
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "Exported %lu points from %s", exporter.points, filename);
+    return ESP_OK;
+}
+
+bool track_file_is_track(const char *filename) {
+    size_t len = strlen(filename);
+    size_t suffix_len = strlen(TRACK_FILE_SUFFIX);
+    return len > suffix_len && strcmp(filename + len - suffix_len, TRACK_FILE_SUFFIX) == 0;
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#ifndef TRACK_FILE_H
+#define TRACK_FILE_H
+
+#include <stdbool.h>
+#include "esp_err.h"
+#include "track_format.h"
+#include "../file_system_littlefs/file_system_littlefs.h"
+#include "../file_system_littlefs/track_writer.h"
+
+#define TRACK_FILE_PREFIX       "dog_run"
+#define TRACK_FILE_READ_CHUNK   LFS_READ_SIZE   // Bytes read from flash at once when replaying/exporting a track
+
+/**
+ * @brief Creates a new track file (dog_run_<date>.trk) with the header and resets the encoder.
+ *
+ * The track start time is taken from the current GPS fix, so call it only when there is a fix.
+ *
+ * @param filename Buffer where the new file name will be stored (at least LFS_MAX_FILE_NAME_SIZE bytes).
+ * @param filename_size Size of the filename buffer.
+ * @return ESP_OK on success, or an error code on failure.
+ */
+esp_err_t track_file_create(char *filename, size_t filename_size);
+
+/**
+ * @brief Restores the encoder from an existing track file, so tracking can continue after a reset.
+ *
+ * Replays all records to get the last position and time. A partially written record at the end is cut off.
+ *
+ * @param filename Name of the track file.
+ * @return ESP_OK on success, ESP_ERR_INVALID_RESPONSE/ESP_ERR_INVALID_VERSION if it is not a valid track file.
+ */
+esp_err_t track_file_resume(const char *filename);
+
+/**
+ * @brief Encodes a GPS fix and appends it with the track writer.
+ *
+ * @param fix Valid GPS fix.
+ * @return ESP_OK on success, or an error code from the track writer.
+ */
+esp_err_t track_file_append_fix(const gps_fix_t *fix);
+
+/**
+ * @brief Streams a track file as CSV or GPX.
+ *
+ * The file is read in TRACK_FILE_READ_CHUNK chunks and rendered on the fly, so the whole
+ * converted file never has to be in RAM.
+ *
+ * @param filename Name of the track file.
+ * @param format Output format.
+ * @param write Function that receives the rendered text.
+ * @param ctx User context passed to the write function.
+ * @return ESP_OK on success, or an error code on failure.
+ */
+esp_err_t track_file_export(const char *filename, track_export_format_t format, track_export_write_t write, void *ctx);
+
+/**
+ * @brief Checks if a file name is a track file (ends with TRACK_FILE_SUFFIX).
+ */
+bool track_file_is_track(const char *filename);
+
+#endif // TRACK_FILE_H
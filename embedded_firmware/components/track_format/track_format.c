@@ -0,0 +1,291 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#include "track_format.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Days since 1970-01-01 for a proleptic Gregorian date (http://howardhinnant.github.io/date_algorithms.html) */
+static int32_t track_format_days_from_civil(int32_t year, uint32_t month, uint32_t day) {
+    year -= month <= 2;
+    const int32_t era = (year >= 0 ? year : year - 399) / 400;
+    const uint32_t yoe = (uint32_t)(year - era * 400);
+    const uint32_t doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    const uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int32_t)doe - 719468;
+}
+
+static void track_format_civil_from_days(int32_t days, int32_t *year, uint32_t *month, uint32_t *day) {
+    days += 719468;
+    const int32_t era = (days >= 0 ? days : days - 146096) / 146097;
+    const uint32_t doe = (uint32_t)(days - era * 146097);
+    const uint32_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const uint32_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const uint32_t mp = (5 * doy + 2) / 153;
+    *day = doy - (153 * mp + 2) / 5 + 1;
+    *month = mp < 10 ? mp + 3 : mp - 9;
+    *year = (int32_t)yoe + era * 400 + (*month <= 2);
+}
+
+uint32_t track_format_fix_to_unix_time(const gps_fix_t *fix) {
+    int32_t days = track_format_days_from_civil(fix->date.year, fix->date.month, fix->date.day);
+    return (uint32_t)days * 86400 + fix->time.hours * 3600 + fix->time.minutes * 60 + fix->time.seconds;
+}
+
+void track_format_init_header(track_file_header_t *header, uint32_t start_time) {
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, TRACK_FILE_MAGIC, sizeof(header->magic));
+    header->version = TRACK_FILE_VERSION;
+    header->header_size = sizeof(track_file_header_t);
+    header->record_size = sizeof(track_record_t);
+    header->start_time = start_time;
+}
+
+esp_err_t track_format_check_header(const track_file_header_t *header) {
+    if (memcmp(header->magic, TRACK_FILE_MAGIC, sizeof(header->magic)) != 0) {
+        return ESP_ERR_INVALID_RESPONSE;
+    }
+    if (header->version != TRACK_FILE_VERSION ||
+        header->header_size != sizeof(track_file_header_t) ||
+        header->record_size < sizeof(track_record_t) ||
+        header->record_size > TRACK_RECORD_MAX_SIZE) {
+        return ESP_ERR_INVALID_VERSION;
+    }
+    return ESP_OK;
+}
+
+void track_format_init_cursor(track_cursor_t *cursor, uint32_t start_time) {
+    cursor->latitude_e6 = 0;
+    cursor->longitude_e6 = 0;
+    cursor->time = start_time;
+}
+
+size_t track_format_encode_fix(track_cursor_t *cursor, const gps_fix_t *fix, track_record_t records[2]) {
+
+    size_t count = 0;
+    uint32_t time = track_format_fix_to_unix_time(fix);
+    uint32_t dt = time > cursor->time ? time - cursor->time : 0; // Never go back in time
+
+    // 1) Gap does not fit into dt_s - store it in its own record
+    if (dt >= TRACK_RECORD_TIME_JUMP) {
+        memset(&records[count], 0, sizeof(track_record_t));
+        records[count].dlat_e6 = (int32_t)dt;
+        records[count].dt_s = TRACK_RECORD_TIME_JUMP;
+        records[count].hdop_x10 = TRACK_RECORD_HDOP_UNKNOWN;
+        records[count].altitude_m = TRACK_RECORD_ALT_UNKNOWN;
+        count++;
+        cursor->time += dt;
+        dt = 0;
+    }
+
+    // 2) Position as delta to the previous record, the rest quantized
+    track_record_t *record = &records[count++];
+    record->dlat_e6 = fix->latitude_e6 - cursor->latitude_e6;
+    record->dlon_e6 = fix->longitude_e6 - cursor->longitude_e6;
+    record->dt_s = (uint16_t)dt;
+
+    uint32_t speed_cm_s = (fix->speed_mm_s + 5) / 10;
+    record->speed_cm_s = speed_cm_s > UINT16_MAX ? UINT16_MAX : (uint16_t)speed_cm_s;
+    record->course = (uint8_t)((((uint32_t)fix->course_cdeg * 256 + 18000) / 36000) & 0xFF);
+
+    if (fix->hdop_x100 == GPS_FIX_HDOP_UNKNOWN) {
+        record->hdop_x10 = TRACK_RECORD_HDOP_UNKNOWN;
+    } else {
+        uint32_t hdop_x10 = (fix->hdop_x100 + 5) / 10;
+        record->hdop_x10 = hdop_x10 >= TRACK_RECORD_HDOP_UNKNOWN ? TRACK_RECORD_HDOP_UNKNOWN - 1 : (uint8_t)hdop_x10;
+    }
+
+    if (fix->altitude_dm == GPS_FIX_ALTITUDE_UNKNOWN) {
+        record->altitude_m = TRACK_RECORD_ALT_UNKNOWN;
+    } else {
+        int32_t altitude_m = (fix->altitude_dm + (fix->altitude_dm >= 0 ? 5 : -5)) / 10;
+        if (altitude_m > INT16_MAX) altitude_m = INT16_MAX;
+        if (altitude_m <= TRACK_RECORD_ALT_UNKNOWN) altitude_m = TRACK_RECORD_ALT_UNKNOWN + 1;
+        record->altitude_m = (int16_t)altitude_m;
+    }
+
+    cursor->latitude_e6 = fix->latitude_e6;
+    cursor->longitude_e6 = fix->longitude_e6;
+    cursor->time += dt;
+
+    return count;
+}
+
+bool track_format_decode_record(track_cursor_t *cursor, const track_record_t *record, track_point_t *point) {
+
+    if (record->dt_s == TRACK_RECORD_TIME_JUMP) {
+        cursor->time += (uint32_t)record->dlat_e6;
+        return false;
+    }
+
+    cursor->latitude_e6 += record->dlat_e6;
+    cursor->longitude_e6 += record->dlon_e6;
+    cursor->time += record->dt_s;
+
+    if (point != NULL) {
+        point->time = cursor->time;
+        point->latitude_e6 = cursor->latitude_e6;
+        point->longitude_e6 = cursor->longitude_e6;
+        point->speed_cm_s = record->speed_cm_s;
+        point->course_cdeg = (uint16_t)(((uint32_t)record->course * 36000) / 256);
+        point->hdop_x10 = record->hdop_x10;
+        point->altitude_m = record->altitude_m;
+    }
+    return true;
+}
+
+// ----------------------------- Streaming export ------------------------------
+
+/* Formats microdegrees as decimal degrees, e.g. -12345678 -> "-12.345678" */
+static void track_format_e6_to_string(char *buffer, size_t buffer_size, int32_t value_e6) {
+    uint32_t abs_value = value_e6 < 0 ? (uint32_t)0 - (uint32_t)value_e6 : (uint32_t)value_e6;
+    snprintf(buffer, buffer_size, "%s%lu.%06lu", value_e6 < 0 ? "-" : "",
+             (unsigned long)(abs_value / 1000000), (unsigned long)(abs_value % 1000000));
+}
+
+static void track_format_time_to_string(char *buffer, size_t buffer_size, uint32_t unix_time) {
+    int32_t year;
+    uint32_t month, day;
+    uint32_t seconds_of_day = unix_time % 86400;
+    track_format_civil_from_days((int32_t)(unix_time / 86400), &year, &month, &day);
+    snprintf(buffer, buffer_size, "%04ld-%02lu-%02luT%02lu:%02lu:%02luZ",
+             (long)year, (unsigned long)month, (unsigned long)day,
+             (unsigned long)(seconds_of_day / 3600), (unsigned long)(seconds_of_day / 60 % 60), (unsigned long)(seconds_of_day % 60));
+}
+
+static esp_err_t track_export_write_string(track_export_t *exporter, const char *text) {
+    return exporter->write(text, strlen(text), exporter->write_ctx);
+}
+
+static esp_err_t track_export_render_point(track_export_t *exporter, const track_point_t *point) {
+
+    char line[TRACK_EXPORT_LINE_SIZE];
+    char time[24], lat[16], lon[16], altitude[8] = "", hdop[8] = "";
+    int len;
+
+    track_format_time_to_string(time, sizeof(time), point->time);
+    track_format_e6_to_string(lat, sizeof(lat), point->latitude_e6);
+    track_format_e6_to_string(lon, sizeof(lon), point->longitude_e6);
+    if (point->altitude_m != TRACK_RECORD_ALT_UNKNOWN) {
+        snprintf(altitude, sizeof(altitude), "%d", point->altitude_m);
+    }
+    if (point->hdop_x10 != TRACK_RECORD_HDOP_UNKNOWN) {
+        snprintf(hdop, sizeof(hdop), "%u.%u", point->hdop_x10 / 10, point->hdop_x10 % 10);
+    }
+
+    if (exporter->format == TRACK_EXPORT_CSV) {
+        // timestamp,latitude,longitude,altitude,speed,course,hdop (altitude in m, speed in m/s, course in degrees)
+        len = snprintf(line, sizeof(line), "%s,%s,%s,%s,%u.%02u,%u,%s\n",
+                       time, lat, lon, altitude,
+                       point->speed_cm_s / 100, point->speed_cm_s % 100,
+                       (point->course_cdeg + 50) / 100 % 360,
+                       hdop);
+    } else {
+        len = snprintf(line, sizeof(line), "      <trkpt lat=\"%s\" lon=\"%s\">", lat, lon);
+        if (altitude[0] != '\0') {
+            len += snprintf(line + len, sizeof(line) - len, "<ele>%s</ele>", altitude);
+        }
+        len += snprintf(line + len, sizeof(line) - len, "<time>%s</time>", time);
+        if (hdop[0] != '\0') {
+            len += snprintf(line + len, sizeof(line) - len, "<hdop>%s</hdop>", hdop);
+        }
+        len += snprintf(line + len, sizeof(line) - len, "</trkpt>\n");
+    }
+
+    if (len < 0 || (size_t)len >= sizeof(line)) {
+        return ESP_ERR_NO_MEM;
+    }
+    exporter->points++;
+    return exporter->write(line, len, exporter->write_ctx);
+}
+
+/* Handles one complete header or record */
+static esp_err_t track_export_process(track_export_t *exporter, const uint8_t *data) {
+
+    if (!exporter->header_parsed) {
+        memcpy(&exporter->header, data, sizeof(exporter->header));
+        esp_err_t err = track_format_check_header(&exporter->header);
+        if (err != ESP_OK) {
+            return err;
+        }
+        track_format_init_cursor(&exporter->cursor, exporter->header.start_time);
+        exporter->header_parsed = true;
+        return ESP_OK;
+    }
+
+    track_record_t record;
+    track_point_t point;
+    memcpy(&record, data, sizeof(record)); // Newer versions may have longer records - extra fields are ignored
+    if (track_format_decode_record(&exporter->cursor, &record, &point)) {
+        return track_export_render_point(exporter, &point);
+    }
+    return ESP_OK;
+}
+
+esp_err_t track_export_begin(track_export_t *exporter, track_export_format_t format, track_export_write_t write, void *ctx) {
+
+    memset(exporter, 0, sizeof(*exporter));
+    exporter->format = format;
+    exporter->write = write;
+    exporter->write_ctx = ctx;
+
+    if (format == TRACK_EXPORT_CSV) {
+        return track_export_write_string(exporter, "timestamp,latitude,longitude,altitude,speed,course,hdop\n");
+    }
+    return track_export_write_string(exporter,
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<gpx version=\"1.1\" creator=\"Dog Collar GPS\" xmlns=\"http://www.topografix.com/GPX/1/1\">\n"
+        "  <trk>\n"
+        "    <trkseg>\n");
+}
+
+esp_err_t track_export_feed(track_export_t *exporter, const uint8_t *data, size_t len) {
+
+    while (len > 0) {
+        size_t unit_size = exporter->header_parsed ? exporter->header.record_size : sizeof(track_file_header_t);
+        esp_err_t err;
+
+        if (exporter->pending_len > 0 || len < unit_size) {
+            // Collect a header/record split between feed calls
+            size_t take = unit_size - exporter->pending_len;
+            if (take > len) {
+                take = len;
+            }
+            memcpy(exporter->pending + exporter->pending_len, data, take);
+            exporter->pending_len += take;
+            data += take;
+            len -= take;
+
+            if (exporter->pending_len < unit_size) {
+                break; // Wait for more data
+            }
+            exporter->pending_len = 0;
+            err = track_export_process(exporter, exporter->pending);
+        } else {
+            // Complete header/record in the caller's buffer - no copy
+            err = track_export_process(exporter, data);
+            data += unit_size;
+            len -= unit_size;
+        }
+
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t track_export_end(track_export_t *exporter) {
+
+    if (exporter->format == TRACK_EXPORT_GPX) {
+        return track_export_write_string(exporter,
+            "    </trkseg>\n"
+            "  </trk>\n"
+            "</gpx>\n");
+    }
+    return ESP_OK;
+}
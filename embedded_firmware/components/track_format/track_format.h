@@ -0,0 +1,184 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#ifndef TRACK_FORMAT_H
+#define TRACK_FORMAT_H
+
+/*
+ * Binary GPS track file (.trk)
+ *
+ * File = track_file_header_t + N * track_record_t, all little-endian.
+ * Every record stores the position as a delta to the previous record (the first one to 0,0, so it is absolute)
+ * and the time as seconds since the previous record (the first one since header.start_time).
+ * Gaps longer than TRACK_RECORD_TIME_JUMP - 1 seconds are stored as a separate time jump record.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "../gps_l96/gps_fix.h"
+
+#define TRACK_FILE_MAGIC            "DCGT"
+#define TRACK_FILE_VERSION          1
+#define TRACK_FILE_SUFFIX           ".trk"
+
+#define TRACK_RECORD_TIME_JUMP      0xFFFF      // dt_s value of a time jump record, the jump (in s) is stored in dlat_e6
+#define TRACK_RECORD_HDOP_UNKNOWN   0xFF
+#define TRACK_RECORD_ALT_UNKNOWN    INT16_MIN
+#define TRACK_RECORD_MAX_SIZE       64          // Max record size a reader accepts (newer versions may append fields)
+
+#define TRACK_EXPORT_LINE_SIZE      256         // Max length of one rendered CSV/GPX line
+
+typedef struct __attribute__((packed)) {
+    char magic[4];              // TRACK_FILE_MAGIC
+    uint8_t version;            // TRACK_FILE_VERSION
+    uint8_t header_size;        // sizeof(track_file_header_t)
+    uint8_t record_size;        // sizeof(track_record_t)
+    uint8_t flags;              // Reserved, 0
+    uint32_t start_time;        // Unix time (UTC) the track was started
+    uint8_t reserved[4];
+} track_file_header_t;
+
+typedef struct __attribute__((packed)) {
+    int32_t dlat_e6;            // Latitude change since the previous record in microdegrees
+    int32_t dlon_e6;            // Longitude change since the previous record in microdegrees
+    uint16_t dt_s;              // Seconds since the previous record, TRACK_RECORD_TIME_JUMP for a time jump record
+    uint16_t speed_cm_s;        // Speed over ground in cm/s
+    uint8_t course;             // Course over ground in 360/256 degree steps
+    uint8_t hdop_x10;           // HDOP * 10, TRACK_RECORD_HDOP_UNKNOWN if not known
+    int16_t altitude_m;         // Altitude above mean sea level in m, TRACK_RECORD_ALT_UNKNOWN if not known
+} track_record_t;
+
+_Static_assert(sizeof(track_file_header_t) == 16, "track_file_header_t layout changed");
+_Static_assert(sizeof(track_record_t) == 16, "track_record_t layout changed");
+
+/* Position and time of the last record, shared by the encoder and the decoder */
+typedef struct {
+    int32_t latitude_e6;
+    int32_t longitude_e6;
+    uint32_t time;              // Unix time
+} track_cursor_t;
+
+/* One decoded track point */
+typedef struct {
+    uint32_t time;              // Unix time (UTC)
+    int32_t latitude_e6;
+    int32_t longitude_e6;
+    uint16_t speed_cm_s;
+    uint16_t course_cdeg;
+    uint8_t hdop_x10;           // TRACK_RECORD_HDOP_UNKNOWN if not known
+    int16_t altitude_m;         // TRACK_RECORD_ALT_UNKNOWN if not known
+} track_point_t;
+
+typedef enum {
+    TRACK_EXPORT_CSV,
+    TRACK_EXPORT_GPX,
+} track_export_format_t;
+
+/* Called by the exporter with rendered text. Returning an error stops the export. */
+typedef esp_err_t (*track_export_write_t)(const char *data, size_t len, void *ctx);
+
+typedef struct {
+    track_export_format_t format;
+    track_export_write_t write;
+    void *write_ctx;
+
+    track_file_header_t header;
+    bool header_parsed;
+    uint8_t pending[TRACK_RECORD_MAX_SIZE]; // Header or record split between two feed calls
+    size_t pending_len;
+
+    track_cursor_t cursor;
+    uint32_t points;            // Points rendered so far
+} track_export_t;
+
+/**
+ * @brief Converts the date and time of a GPS fix to Unix time (integer math only).
+ *
+ * @param fix GPS fix with full year (e.g. 2025).
+ * @return Seconds since 1970-01-01T00:00:00Z.
+ */
+uint32_t track_format_fix_to_unix_time(const gps_fix_t *fix);
+
+/**
+ * @brief Fills a track file header.
+ *
+ * @param header Pointer to the header to fill.
+ * @param start_time Unix time the track was started.
+ */
+void track_format_init_header(track_file_header_t *header, uint32_t start_time);
+
+/**
+ * @brief Checks that the header is a track file header this firmware can read.
+ *
+ * @param header Pointer to the header.
+ * @return ESP_OK if valid, ESP_ERR_INVALID_RESPONSE if it is not a track file, ESP_ERR_INVALID_VERSION if the version is not supported.
+ */
+esp_err_t track_format_check_header(const track_file_header_t *header);
+
+/**
+ * @brief Sets the cursor to the start of a track.
+ *
+ * @param cursor Pointer to the cursor.
+ * @param start_time Unix time from the file header.
+ */
+void track_format_init_cursor(track_cursor_t *cursor, uint32_t start_time);
+
+/**
+ * @brief Encodes a GPS fix into one or two records (two if a time jump record is needed) and advances the cursor.
+ *
+ * @param cursor Encoder cursor.
+ * @param fix Valid GPS fix.
+ * @param records Output, space for 2 records.
+ * @return Number of records written (1 or 2).
+ */
+size_t track_format_encode_fix(track_cursor_t *cursor, const gps_fix_t *fix, track_record_t records[2]);
+
+/**
+ * @brief Decodes a record and advances the cursor.
+ *
+ * @param cursor Decoder cursor.
+ * @param record Record to decode.
+ * @param point Output point, can be NULL if only the cursor is needed.
+ * @return true if the record is a point, false if it was a time jump record.
+ */
+bool track_format_decode_record(track_cursor_t *cursor, const track_record_t *record, track_point_t *point);
+
+/**
+ * @brief Starts a streaming CSV/GPX export and writes the document header.
+ *
+ * @param exporter Exporter state.
+ * @param format Output format.
+ * @param write Function that receives the rendered text.
+ * @param ctx User context passed to the write function.
+ * @return ESP_OK on success, or the error returned by the write function.
+ */
+esp_err_t track_export_begin(track_export_t *exporter, track_export_format_t format, track_export_write_t write, void *ctx);
+
+/**
+ * @brief Feeds raw track file bytes to the exporter.
+ *
+ * Bytes can be fed in chunks of any size (e.g. as they are read from the file); headers and records
+ * split between two calls are kept in the exporter.
+ *
+ * @param exporter Exporter state.
+ * @param data Raw track file bytes.
+ * @param len Number of bytes.
+ * @return ESP_OK on success, error if the file header is invalid or the write function failed.
+ */
+esp_err_t track_export_feed(track_export_t *exporter, const uint8_t *data, size_t len);
+
+/**
+ * @brief Finishes the export and writes the document footer.
+ *
+ * @param exporter Exporter state.
+ * @return ESP_OK on success, or the error returned by the write function.
+ */
+esp_err_t track_export_end(track_export_t *exporter);
+
+#endif // TRACK_FORMAT_H
@@ -9,9 +9,12 @@
 
 static const char *TAG = "DOG_COLLAR_STATE_MACHINE";
 
+_Static_assert(DOG_COLLAR_STATE_ERROR < METRICS_MAX_STATES, "Not enough state slots for metrics");
+
 /* Function Prototypes */
 static char *get_current_state_string(dog_collar_state_t state);
 static esp_err_t gps_tracking_task(char *gps_file_name);
+static bool state_takes_gps_fixes(dog_collar_state_t state);
 
 /* Global variables for dog collar state machine */
 static dog_collar_state_t current_state = DOG_COLLAR_STATE_INITIALIZING;
@@ -30,6 +33,8 @@ void state_machine_task(void *pvParameters) {
 
 dog_collar_state_t dog_collar_state_machine_run(void) {
 
+    metrics_state_tick(current_state, get_current_state_string(current_state));
+
     // Track state entry time
     if (current_state != previous_state) {
         state_entry_time = xTaskGetTickCount();
@@ -39,6 +44,15 @@ dog_collar_state_t dog_collar_state_machine_run(void) {
         previous_state = current_state;
     }
 
+    /* The GPS ingest task publishes fixes in every state. Where they are not taken, drop them every tick,
+     * so the queue does not overflow and tracking never starts or resumes with old fixes */
+    if (!state_takes_gps_fixes(current_state)) {
+        uint32_t discarded = gps_l96_discard_fixes();
+        if (discarded > 0) {
+            ESP_LOGD(TAG, "Discarded %lu GPS fixes in %s", discarded, get_current_state_string(current_state));
+        }
+    }
+
     switch (current_state) {
         case DOG_COLLAR_STATE_INITIALIZING:
             current_state = handle_initializing_state();
@@ -160,8 +174,15 @@ dog_collar_state_t handle_normal_state(void) {
                                 TAG, "Failed to check GPS recovery needed");
 
         if (gps_recovery_needed) {
-            gps_l96_start_activity_tracking(gps_file_name);
-            return DOG_COLLAR_STATE_GPS_TRACKING;
+            if (track_file_resume(gps_file_name) != ESP_OK) {
+                ESP_LOGW(TAG, "Can not continue GPS file %s, tracking not recovered", gps_file_name);
+                gps_l96_stop_activity_tracking();
+            } else {
+                gps_l96_start_activity_tracking(gps_file_name);
+                ERROR_STATE_ON_FAILURE(track_writer_open(gps_file_name),
+                                        TAG, "Failed to reopen GPS file");
+                return DOG_COLLAR_STATE_GPS_TRACKING;
+            }
         }
     }
 
@@ -179,11 +200,18 @@ dog_collar_state_t handle_normal_state(void) {
 
 dog_collar_state_t handle_low_battery_state(void) {
 
+    /* Make sure buffered GPS data is on flash before the battery runs out */
+    ERROR_STATE_ON_FAILURE(track_writer_flush(),
+                            TAG, "Failed to flush GPS file");
+
     return DOG_COLLAR_STATE_LOW_BATTERY;
 }
 
 dog_collar_state_t handle_critical_low_battery_state(void) {
 
+    ERROR_STATE_ON_FAILURE(track_writer_close(),
+                            TAG, "Failed to close GPS file");
+
     return DOG_COLLAR_STATE_CRITICAL_LOW_BATTERY;
 }
 
@@ -247,12 +275,15 @@ dog_collar_state_t handle_gps_ready_state(void) {
 
 dog_collar_state_t handle_gps_file_creation_state(void) {
 
-    ERROR_STATE_ON_FAILURE(lfs_create_new_csv_file(gps_file_name, sizeof(gps_file_name)),
+    ERROR_STATE_ON_FAILURE(track_file_create(gps_file_name, sizeof(gps_file_name)),
                             TAG, "Failed to create GPS file");
 
     ERROR_STATE_ON_FAILURE(gps_l96_start_activity_tracking(gps_file_name),
                             TAG, "Failed to start GPS activity tracking");
 
+    ERROR_STATE_ON_FAILURE(track_writer_open(gps_file_name),
+                            TAG, "Failed to open GPS file");
+
     return DOG_COLLAR_STATE_GPS_TRACKING;
 }
 
@@ -277,6 +308,8 @@ dog_collar_state_t handle_waiting_for_gps_fix_state(void) {
 dog_collar_state_t handle_gps_tracking_state(void) {
 
     if (is_button_short_pressed()) { 
+        ERROR_STATE_ON_FAILURE(track_writer_flush(),
+                                TAG, "Failed to flush GPS file");
         return DOG_COLLAR_STATE_GPS_PAUSED; 
     }
 
@@ -294,6 +327,8 @@ dog_collar_state_t handle_gps_paused_state(void) {
         return DOG_COLLAR_STATE_GPS_TRACKING; 
     }
     if (is_button_long_pressed()) {
+        ERROR_STATE_ON_FAILURE(track_writer_close(),
+                                TAG, "Failed to close GPS file");
         gps_l96_stop_activity_tracking();
         return DOG_COLLAR_STATE_NORMAL; 
     }
@@ -307,8 +342,6 @@ dog_collar_state_t handle_gps_paused_state(void) {
 dog_collar_state_t handle_wifi_sync_state(void) {
     
     static bool sync_started = false;
-    static int64_t sync_start_time_us = 0;
-    int64_t now = esp_timer_get_time();
 
     /* Start WIFI sync and set the start time */
     if (sync_started == false) {
@@ -321,8 +354,21 @@ dog_collar_state_t handle_wifi_sync_state(void) {
             ERROR_STATE_ON_FAILURE(ret, TAG, "Failed to reconnect to WiFi");
         }
 
-        sync_start_time_us = now;
         sync_started = true;
+        sync_session_start(WIFI_SYNC_TIME_S); // Counts the files the sync client has not acknowledged yet
+
+        /* Push mode: a collector on the network took the files, no need to wait for a sync client.
+           With nothing to upload the window stays open as without push, a client may still want /status or /live */
+        push_upload_stats_t push_stats = {0};
+        if (PUSH_UPLOAD_ENABLED && wifi_manager_is_initialized_and_connected() &&
+            push_upload_run(&push_stats) == ESP_OK && push_stats.files > 0) {
+
+            sync_started = false;
+            ERROR_STATE_ON_FAILURE(wifi_stop_all_services(),
+                                    TAG, "Failed to stop all WiFi services");
+
+            return DOG_COLLAR_STATE_DEEP_SLEEP;
+        }
         clear_button_press_states(); // For some reason we need to clear button press states here
     }
 
@@ -336,8 +382,8 @@ dog_collar_state_t handle_wifi_sync_state(void) {
         return DOG_COLLAR_STATE_GPS_ACQUIRING;
     }
 
-    /* If time is up go deep sleep*/
-    if ((now - sync_start_time_us) >= WIFI_SYNC_TIME_S * 1000 * 1000) {
+    /* Go deep sleep once the client has everything, went quiet or the (extended) window is over */
+    if (sync_session_check() != SYNC_SESSION_ACTIVE) {
 
         sync_started = false;
         ERROR_STATE_ON_FAILURE(wifi_stop_all_services(),
@@ -372,6 +418,8 @@ esp_err_t go_to_light_sleep(void){
 dog_collar_state_t handle_deep_sleep_state(void) {
     
     gpio_turn_off_leds(LED_RED | LED_YELLOW | LED_GREEN);
+    track_writer_close();
+    lfs_unmount_filesystem(); // Keeps the allocator checkpoint in RTC memory for a fast first write after wake-up
     gps_l96_go_to_back_up_mode();
 
     // timer wakeup for periodic wake-ups
@@ -388,7 +436,8 @@ dog_collar_state_t handle_deep_sleep_state(void) {
 
 dog_collar_state_t handle_error_state(void) {
 
-    /* Wait 10 seconds then restart the device*/
+    /* Save what we can, wait 10 seconds then restart the device*/
+    track_writer_close();
     vTaskDelay(pdMS_TO_TICKS(10000)); 
     esp_restart();
 
@@ -451,42 +500,47 @@ static char *get_current_state_string(dog_collar_state_t state) {
     }
 }
 
+static bool state_takes_gps_fixes(dog_collar_state_t state) {
+    return state == DOG_COLLAR_STATE_GPS_ACQUIRING ||
+           state == DOG_COLLAR_STATE_WAITING_FOR_GPS_FIX ||
+           state == DOG_COLLAR_STATE_GPS_TRACKING;
+}
+
 esp_err_t gps_tracking_task(char* gps_file_name) { 
 
-    static char NMEA_sentence[NMEA_SENTENCE_BUF_SIZE] = {0};
-    static uint8_t rx_buffer[UART_RX_BUF_SIZE] = {0};
-    size_t read_len = 0;
+    gps_fix_t fix;
+    bool new_fix = false;
 
-    esp_err_t ret = uart_receive_cmd(rx_buffer, sizeof(rx_buffer), &read_len);
+    /* Take all fixes the GPS ingest task published since the last state machine tick */
+    while (gps_l96_get_next_fix(&fix)) {
+        new_fix = true;
+        ESP_LOGD(TAG, "GPS fix delivered %lld us after UART line end", esp_timer_get_time() - fix.rx_time_us);
 
-    if( ret == ESP_ERR_TIMEOUT) {
-        ESP_LOGW(TAG, "UART read timed out, no data received. GPS module probably not turned on");
-        return ret; // No data to process, just return
-    }
+        if (!fix.valid) {
+            continue; // Nothing to log without a fix
+        }
 
-    if (ret != ESP_OK || read_len == 0) {
-        ESP_LOGE(TAG, "UART read failed: %s", esp_err_to_name(ret));
-        return ret;
+        if( gps_file_name == NULL || strlen(gps_file_name) == 0) { // Add NULL for gps_file_name to just check if we have GPS fix
+            continue;
+        }
+
+        ESP_RETURN_ON_ERROR(track_file_append_fix(&fix), 
+                            TAG, "Failed to append GPS data to file");
     }
 
-    ESP_RETURN_ON_ERROR(gps_l96_extract_and_process_nmea_sentences(rx_buffer, read_len),
-                    TAG, "Failed to extract and process NMEA sentences");
+    /* The max-age commit must also run when no valid fix comes in, e.g. after the fix is lost */
+    ESP_RETURN_ON_ERROR(track_writer_poll(),
+                        TAG, "Failed to commit GPS file");
+
+    if (!new_fix) {
+        ESP_LOGW(TAG, "No new GPS data received. GPS module probably not turned on");
+        return ESP_ERR_TIMEOUT;
+    }
 
     if (gps_l96_has_fix() == false) {
         ESP_LOGW(TAG, "No valid GPS fix, not logging data.");
         return ESP_FAIL;
     }
 
-    if( gps_file_name == NULL || strlen(gps_file_name) == 0) { // Add NULL for gps_file_name to just check if we have GPS fix
-        ESP_LOGE(TAG, "GPS file name is not set");
-        return ESP_ERR_INVALID_ARG;
-    }
-
-    ESP_RETURN_ON_ERROR(gps_l96_format_csv_line_from_data(NMEA_sentence, sizeof(NMEA_sentence)),
-                        TAG, "Failed to format GPS data");
-
-    ESP_RETURN_ON_ERROR(lfs_append_to_file(NMEA_sentence, gps_file_name), 
-                        TAG, "Failed to append GPS data to file");
-
-    return ret;
-} 
+    return ESP_OK;
+}
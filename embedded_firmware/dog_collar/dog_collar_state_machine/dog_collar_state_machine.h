@@ -42,6 +42,9 @@ typedef enum {
 #include "../components/battery_monitor/battery_monitor.h"
 #include "../components/button_interupt/button_interrupt.h"
 #include "../components/file_system_littlefs/file_system_littlefs.h"
+#include "../components/track_format/track_file.h"
+#include "../components/network_services/push_upload.h"
+#include "../components/metrics/metrics.h"
 #include "led_management/led_management.h" // Have to include this here to avoid circular dependency
 
 /* Macro to return error state on failure - to avoid code duplication */
@@ -60,7 +63,7 @@ typedef enum {
 #define BATTERY_CHECK_INTERVAL_MS_HIGH       5000 //300000 // 5 minutes -for testing 5s
 #define BATTERY_CHECK_INTERVAL_MS_LOW        5000 //60000  // 1 minute -for testing 5s
 
-#define WIFI_SYNC_TIME_S 60             //Time for one sync in seconds
+#define WIFI_SYNC_TIME_S 60             //Time for one sync in seconds, ends earlier or is extended by the sync session (sync_session.h)
 
 #define LIGHT_SLEEP_MAX_COUNT 15        // After LIGHT_SLEEP_MAX_COUNT light sleeps, we will go for longer deep sleep.
 
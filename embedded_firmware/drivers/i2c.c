@@ -14,6 +14,18 @@ static bool i2c_initialized = false;
 
 #define I2C_PORT I2C_NUM_0
 
+/* Runs a command link, again up to I2C_RETRIES times after a NACK or a bus timeout. The link is not
+ * consumed by a run, the read buffers are written again. Other errors are not retried. */
+static esp_err_t i2c_cmd_begin_retry(i2c_cmd_handle_t cmd) {
+    esp_err_t err = i2c_master_cmd_begin(I2C_PORT, cmd, WAIT_TIME);
+    for (uint32_t retry = 0; retry < I2C_RETRIES && (err == ESP_FAIL || err == ESP_ERR_TIMEOUT); retry++) {
+        metrics_inc(METRICS_I2C_RETRIES);
+        vTaskDelay(pdMS_TO_TICKS(I2C_RETRY_DELAY_MS));
+        err = i2c_master_cmd_begin(I2C_PORT, cmd, WAIT_TIME);
+    }
+    return err;
+}
+
 esp_err_t i2c_init(void) {
 
     if(i2c_initialized) {
@@ -67,7 +79,7 @@ esp_err_t i2c_write_byte(uint8_t dev_addr, int8_t write_register, uint8_t data)
         RETURN_ON_ERROR_I2C(i2c_master_write_byte(cmd, data, true), TAG, "Write data failed", cmd);
         RETURN_ON_ERROR_I2C(i2c_master_stop(cmd), TAG, "Stop failed", cmd);
 
-        RETURN_ON_ERROR_I2C(i2c_master_cmd_begin(I2C_PORT, cmd, WAIT_TIME), TAG, "Command failed", cmd);
+        RETURN_ON_ERROR_I2C(i2c_cmd_begin_retry(cmd), TAG, "Command failed", cmd);
         i2c_cmd_link_delete(cmd);
 
         /* Release I2C mutex */
@@ -75,6 +87,7 @@ esp_err_t i2c_write_byte(uint8_t dev_addr, int8_t write_register, uint8_t data)
         return ESP_OK;
     } else {
         ESP_LOGE(TAG, "Failed to take I2C mutex");
+        metrics_inc(METRICS_I2C_MUTEX_TIMEOUTS);
         return ESP_ERR_TIMEOUT;
     }   
 }
@@ -98,7 +111,7 @@ esp_err_t i2c_read_16bit(uint8_t dev_addr, int8_t reg_addr, uint16_t *data) {
         RETURN_ON_ERROR_I2C(i2c_master_read_byte(cmd, &buffer[1], I2C_MASTER_NACK), TAG, "Read byte 2 failed", cmd);
         
         RETURN_ON_ERROR_I2C(i2c_master_stop(cmd), TAG, "Stop failed", cmd);
-        RETURN_ON_ERROR_I2C(i2c_master_cmd_begin(I2C_PORT, cmd, WAIT_TIME), TAG, "Command failed", cmd);
+        RETURN_ON_ERROR_I2C(i2c_cmd_begin_retry(cmd), TAG, "Command failed", cmd);
 
         i2c_cmd_link_delete(cmd);
 
@@ -108,6 +121,7 @@ esp_err_t i2c_read_16bit(uint8_t dev_addr, int8_t reg_addr, uint16_t *data) {
         return ESP_OK;
     } else {
         ESP_LOGE(TAG, "Failed to take I2C mutex for reading 16-bit data");
+        metrics_inc(METRICS_I2C_MUTEX_TIMEOUTS);
         return ESP_ERR_TIMEOUT;
     }
 }
@@ -128,13 +142,14 @@ esp_err_t i2c_read_8bit(uint8_t dev_addr, int8_t reg_addr, uint8_t *data) {
         RETURN_ON_ERROR_I2C(i2c_master_read_byte(cmd, data, I2C_MASTER_NACK), TAG, "Read byte failed", cmd);
 
         RETURN_ON_ERROR_I2C(i2c_master_stop(cmd), TAG, "Stop failed", cmd);
-        RETURN_ON_ERROR_I2C(i2c_master_cmd_begin(I2C_PORT, cmd, WAIT_TIME), TAG, "Command failed", cmd);
+        RETURN_ON_ERROR_I2C(i2c_cmd_begin_retry(cmd), TAG, "Command failed", cmd);
 
         i2c_cmd_link_delete(cmd);
         xSemaphoreGive(i2c_mutex);
         return ESP_OK;
     } else {
         ESP_LOGE(TAG, "Failed to take I2C mutex for reading 8-bit");
+        metrics_inc(METRICS_I2C_MUTEX_TIMEOUTS);
         return ESP_ERR_TIMEOUT;
     }
 }
@@ -15,12 +15,15 @@
 #include "esp_log.h"
 #include "esp_err.h"
 #include "esp_check.h"
+#include "metrics/metrics.h"
 
 // Pin configuration
 #define I2C_SDA  GPIO_NUM_6
 #define I2C_SCL  GPIO_NUM_7
 
 #define I2C_MUTEX_TIMEOUT_MS 200
+#define I2C_RETRIES          2   // Runs of a command again after a NACK or bus timeout
+#define I2C_RETRY_DELAY_MS   2
 
 #define REG_ADDR_NOT_USED -1
 
@@ -33,6 +36,7 @@
     do { \
         if ((err) != ESP_OK) { \
             ESP_LOGE(tag, "%s: %s", msg, esp_err_to_name(err));\
+            metrics_inc(METRICS_I2C_ERRORS);\
             i2c_cmd_link_delete(cmd);\
             xSemaphoreGive(i2c_mutex);\
             return err; \
@@ -9,6 +9,8 @@
 
 static const char *TAG = "UART";
 static bool uart_initialized = false;
+static QueueHandle_t uart_event_queue = NULL;
+static uint32_t uart_baud_rate = UART_BAUD_RATE;
 
 esp_err_t uart_init(void)
 {
@@ -25,15 +27,36 @@ esp_err_t uart_init(void)
         .flow_ctrl  = UART_HW_FLOWCTRL_DISABLE,
     };
 
-    ESP_RETURN_ON_ERROR(uart_driver_install(UART_PORT_NUM, UART_RX_BUF_SIZE, 0, 0, NULL, 0), TAG, "driver install fail");
+    ESP_RETURN_ON_ERROR(uart_driver_install(UART_PORT_NUM, UART_RX_BUF_SIZE, 0, UART_EVENT_QUEUE_SIZE, &uart_event_queue, 0), TAG, "driver install fail");
     ESP_RETURN_ON_ERROR(uart_param_config(UART_PORT_NUM, &cfg), TAG, "config fail");
     ESP_RETURN_ON_ERROR(uart_set_pin(UART_PORT_NUM, UART_TX_PIN, UART_RX_PIN, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE), TAG, "pin map fail");
+
+    /* Generate UART_PATTERN_DET event on every line end, so the reader does not have to poll */
+    ESP_RETURN_ON_ERROR(uart_enable_pattern_det_baud_intr(UART_PORT_NUM, UART_PATTERN_CHR, UART_PATTERN_CHR_NUM, UART_PATTERN_CHR_TOUT, 0, 0), 
+                        TAG, "pattern detection fail");
+    ESP_RETURN_ON_ERROR(uart_pattern_queue_reset(UART_PORT_NUM, UART_PATTERN_QUEUE_SIZE), TAG, "pattern queue fail");
     ESP_LOGI(TAG, "UART%d ready @ %d bps", UART_PORT_NUM, UART_BAUD_RATE);
 
     uart_initialized = true;
     return ESP_OK;
 }
 
+esp_err_t uart_set_baud_rate(uint32_t baud_rate) {
+
+    ESP_RETURN_ON_ERROR(uart_wait_tx_done(UART_PORT_NUM, pdMS_TO_TICKS(UART_TX_WAIT_TIME_MS)), TAG, "TX not done");
+    ESP_RETURN_ON_ERROR(uart_set_baudrate(UART_PORT_NUM, baud_rate), TAG, "baud rate fail");
+    uart_baud_rate = baud_rate;
+
+    // Bytes received during the switch are garbage at the new rate
+    ESP_RETURN_ON_ERROR(uart_reset_rx(), TAG, "RX reset fail");
+    ESP_LOGI(TAG, "UART%d now @ %lu bps", UART_PORT_NUM, baud_rate);
+    return ESP_OK;
+}
+
+uint32_t uart_get_baud_rate(void) {
+    return uart_baud_rate;
+}
+
 
 esp_err_t uart_send_cmd(const void *nmea_sentence, size_t len){ 
 
@@ -59,3 +82,43 @@ esp_err_t uart_receive_cmd(uint8_t *buffer, size_t buffer_size, size_t *out_read
     return ESP_OK;
 }
 
+QueueHandle_t uart_get_event_queue(void) {
+    return uart_event_queue;
+}
+
+esp_err_t uart_read_line(uint8_t *buffer, size_t buffer_size, size_t *out_read_len) {
+
+    size_t read_size = 0;
+    int pattern_pos = uart_pattern_pop_pos(UART_PORT_NUM);
+
+    if (pattern_pos >= 0) {
+        read_size = pattern_pos + 1; // Include the '\n'
+    } else {
+        // Pattern position was lost - read everything that is buffered, framer will sort it out
+        ESP_RETURN_ON_ERROR(uart_get_buffered_data_len(UART_PORT_NUM, &read_size), TAG, "Failed to get buffered data length");
+    }
+
+    if (read_size == 0) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (read_size > buffer_size) {
+        read_size = buffer_size;
+    }
+
+    // Data is already in the driver ring buffer, so this does not block
+    int read_len = uart_read_bytes(UART_PORT_NUM, buffer, read_size, pdMS_TO_TICKS(UART_RX_WAIT_TIME_MS));
+    if (read_len < 0) {
+        ESP_LOGE(TAG, "Error reading line from UART");
+        return ESP_FAIL;
+    }
+    *out_read_len = read_len;
+    return ESP_OK;
+}
+
+esp_err_t uart_reset_rx(void) {
+    ESP_RETURN_ON_ERROR(uart_flush_input(UART_PORT_NUM), TAG, "Failed to flush UART input");
+    if (uart_event_queue != NULL) {
+        xQueueReset(uart_event_queue);
+    }
+    return uart_pattern_queue_reset(UART_PORT_NUM, UART_PATTERN_QUEUE_SIZE);
+}
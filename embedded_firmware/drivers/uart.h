@@ -25,11 +25,19 @@
 #define UART_TX_PIN GPIO_NUM_5  
 #define UART_RX_PIN GPIO_NUM_4  
 #define UART_RX_BUF_SIZE 1024
-#define UART_BAUD_RATE (9600)
+#define UART_BAUD_RATE (9600)        // L96 default after power on, the GPS is switched to UART_BAUD_RATE_FAST at startup
+#define UART_BAUD_RATE_FAST (115200)
 #define UART_PORT_NUM UART_NUM_0 
 #define UART_RX_WAIT_TIME_MS 100
 #define UART_TX_WAIT_TIME_MS 100
 
+// UART event queue with pattern detection - an event is sent when a full NMEA line ('\n') is received
+#define UART_EVENT_QUEUE_SIZE   20
+#define UART_PATTERN_CHR        '\n'
+#define UART_PATTERN_CHR_NUM    1   // Number of consecutive pattern characters
+#define UART_PATTERN_CHR_TOUT   9   // Max gap between pattern characters (in baud cycles)
+#define UART_PATTERN_QUEUE_SIZE 16  // Number of line end positions the driver can remember
+
 
 
 
@@ -46,6 +54,19 @@
  */
 esp_err_t uart_init(void);
 
+/**
+ * @brief Changes the UART baud rate and drops the data received at the old one.
+ *
+ * @param baud_rate New baud rate.
+ * @return ESP_OK on success, or an error code on failure.
+ */
+esp_err_t uart_set_baud_rate(uint32_t baud_rate);
+
+/**
+ * @return Current UART baud rate.
+ */
+uint32_t uart_get_baud_rate(void);
+
 /**
  * @brief Sends a command (nmea sentence) via UART.
  *
@@ -65,6 +86,36 @@ esp_err_t uart_send_cmd(const void *nmea_sentence, size_t len);
  */
 esp_err_t uart_receive_cmd(uint8_t *buffer, size_t buffer_size, size_t *out_read_len);
 
+/**
+ * @brief Gets the UART event queue.
+ *
+ * The queue receives UART_PATTERN_DET event for every received '\n', so a task can sleep on it
+ * and wake up only when a complete NMEA line is ready.
+ *
+ * @return Queue handle or NULL if UART is not initialized.
+ */
+QueueHandle_t uart_get_event_queue(void);
+
+/**
+ * @brief Reads one line (up to and including '\n') after UART_PATTERN_DET event.
+ *
+ * If the driver lost the pattern position (pattern queue overflow), all buffered data is read instead,
+ * so no bytes are skipped.
+ *
+ * @param buffer Pointer to the buffer where received raw data will be stored.
+ * @param buffer_size Size of the buffer.
+ * @param out_read_len Pointer to a variable that will hold the number of bytes read.
+ * @return ESP_OK on success, ESP_ERR_NOT_FOUND if there is no data to read, or an error code if reading fails.
+ */
+esp_err_t uart_read_line(uint8_t *buffer, size_t buffer_size, size_t *out_read_len);
+
+/**
+ * @brief Drops all received data and pattern positions (used after FIFO or ring buffer overflow).
+ *
+ * @return ESP_OK on success, or an error code on failure.
+ */
+esp_err_t uart_reset_rx(void);
+
 
 
 
@@ -0,0 +1,17 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#ifndef HOST_MOCK_DRIVER_I2C_H
+#define HOST_MOCK_DRIVER_I2C_H
+
+/* Only for the include chain of i2c.h (GPIO expander), the host tests replace the expander functions */
+
+#include "freertos/semphr.h"
+
+typedef void *i2c_cmd_handle_t;
+
+#endif // HOST_MOCK_DRIVER_I2C_H
@@ -0,0 +1,15 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#ifndef HOST_MOCK_DRIVER_SPI_MASTER_H
+#define HOST_MOCK_DRIVER_SPI_MASTER_H
+
+/* Only for the include chain of ext_flash.h, the host tests use block_device_emu instead of the SPI flash */
+
+#include "driver/gpio.h"
+
+#endif // HOST_MOCK_DRIVER_SPI_MASTER_H
@@ -0,0 +1,101 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#ifndef HOST_MOCK_DRIVER_UART_H
+#define HOST_MOCK_DRIVER_UART_H
+
+/*
+ * UART driver on the host: one simulated port with the RX ring buffer, line end (pattern) positions and the event
+ * queue of the ESP-IDF driver. The test plays the other end with host_mock_uart_receive() and
+ * host_mock_uart_set_tx_handler().
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+typedef int uart_port_t;
+#define UART_NUM_0          0
+#define UART_NUM_1          1
+#define UART_PIN_NO_CHANGE  (-1)
+
+typedef enum {
+    UART_DATA,
+    UART_BREAK,
+    UART_BUFFER_FULL,
+    UART_FIFO_OVF,
+    UART_FRAME_ERR,
+    UART_PARITY_ERR,
+    UART_DATA_BREAK,
+    UART_PATTERN_DET,
+    UART_EVENT_MAX,
+} uart_event_type_t;
+
+typedef struct {
+    uart_event_type_t type;
+    size_t size;
+    bool timeout_flag;
+} uart_event_t;
+
+typedef enum { UART_DATA_5_BITS, UART_DATA_6_BITS, UART_DATA_7_BITS, UART_DATA_8_BITS } uart_word_length_t;
+typedef enum { UART_PARITY_DISABLE, UART_PARITY_EVEN = 2, UART_PARITY_ODD } uart_parity_t;
+typedef enum { UART_STOP_BITS_1 = 1, UART_STOP_BITS_1_5, UART_STOP_BITS_2 } uart_stop_bits_t;
+typedef enum { UART_HW_FLOWCTRL_DISABLE } uart_hw_flowcontrol_t;
+
+typedef struct {
+    int baud_rate;
+    uart_word_length_t data_bits;
+    uart_parity_t parity;
+    uart_stop_bits_t stop_bits;
+    uart_hw_flowcontrol_t flow_ctrl;
+} uart_config_t;
+
+esp_err_t uart_driver_install(uart_port_t port, int rx_buffer_size, int tx_buffer_size, int queue_size,
+                              QueueHandle_t *queue, int intr_alloc_flags);
+esp_err_t uart_param_config(uart_port_t port, const uart_config_t *config);
+esp_err_t uart_set_pin(uart_port_t port, int tx, int rx, int rts, int cts);
+esp_err_t uart_enable_pattern_det_baud_intr(uart_port_t port, char pattern_chr, uint8_t chr_num, int chr_tout,
+                                            int post_idle, int pre_idle);
+esp_err_t uart_pattern_queue_reset(uart_port_t port, int queue_length);
+int uart_pattern_pop_pos(uart_port_t port);
+esp_err_t uart_set_baudrate(uart_port_t port, uint32_t baud_rate);
+esp_err_t uart_get_buffered_data_len(uart_port_t port, size_t *size);
+int uart_read_bytes(uart_port_t port, void *buf, uint32_t length, TickType_t ticks_to_wait);
+int uart_write_bytes(uart_port_t port, const void *src, size_t size);
+esp_err_t uart_wait_tx_done(uart_port_t port, TickType_t ticks_to_wait);
+esp_err_t uart_flush_input(uart_port_t port);
+
+/* ---------------- Host side of the simulated port ---------------- */
+
+/**
+ * @brief Called with every uart_write_bytes(), with the baud rate the UART sends at.
+ */
+typedef void (*host_mock_uart_tx_handler_t)(const uint8_t *data, size_t len, uint32_t baud_rate, void *ctx);
+
+/**
+ * @brief Sets the receiver of the bytes the firmware sends (the simulated device).
+ */
+void host_mock_uart_set_tx_handler(host_mock_uart_tx_handler_t handler, void *ctx);
+
+/**
+ * @brief Bytes arriving on RX, sent by the device at baud_rate.
+ *
+ * At a baud rate other than the UART's the bytes arrive as garbage. Every '\n' (pattern character) queues its
+ * position and a UART_PATTERN_DET event, the bytes after the last one a UART_DATA event. Bytes that do not fit the
+ * RX ring buffer are dropped with a UART_BUFFER_FULL event, events that do not fit the queue are lost.
+ */
+void host_mock_uart_receive(const uint8_t *data, size_t len, uint32_t baud_rate);
+
+/**
+ * @brief Baud rate set by the firmware (uart_set_baudrate()).
+ */
+uint32_t host_mock_uart_get_baud_rate(void);
+
+#endif // HOST_MOCK_DRIVER_UART_H
@@ -0,0 +1,18 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#ifndef HOST_MOCK_ESP_ATTR_H
+#define HOST_MOCK_ESP_ATTR_H
+
+/* Placement attributes mean nothing on the host, RTC memory is ordinary memory */
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
+
+#endif // HOST_MOCK_ESP_ATTR_H
@@ -0,0 +1,121 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#ifndef HOST_MOCK_ESP_HTTP_SERVER_H
+#define HOST_MOCK_ESP_HTTP_SERVER_H
+
+/*
+ * esp_http_server on the host (host_mock_httpd.c): no sockets, one server whose httpd task is a thread that runs
+ * the work of httpd_queue_work() in order, from a queue of a fixed size as the control socket of httpd.
+ * WebSocket clients are socket numbers the test connects and closes, httpd_ws_send_frame_async() hands every
+ * frame to the sender of the test on the httpd task. Only the calls the firmware uses.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+typedef void *httpd_handle_t;
+typedef void (*httpd_work_fn_t)(void *arg);
+
+typedef enum {
+    HTTP_GET = 1,
+    HTTP_POST = 3,
+} httpd_method_t;
+
+typedef struct httpd_req {
+    httpd_handle_t handle;
+    int method;
+    const char *uri;
+    void *user_ctx;
+    int fd;                     // Host mock only, httpd_req_to_sockfd()
+} httpd_req_t;
+
+typedef struct {
+    const char *uri;
+    httpd_method_t method;
+    esp_err_t (*handler)(httpd_req_t *req);
+    void *user_ctx;
+    bool is_websocket;
+} httpd_uri_t;
+
+typedef enum {
+    HTTPD_WS_TYPE_CONTINUE = 0x0,
+    HTTPD_WS_TYPE_TEXT = 0x1,
+    HTTPD_WS_TYPE_BINARY = 0x2,
+    HTTPD_WS_TYPE_CLOSE = 0x8,
+    HTTPD_WS_TYPE_PING = 0x9,
+    HTTPD_WS_TYPE_PONG = 0xA,
+} httpd_ws_type_t;
+
+typedef struct {
+    bool final;
+    bool fragmented;
+    httpd_ws_type_t type;
+    uint8_t *payload;
+    size_t len;
+} httpd_ws_frame_t;
+
+typedef enum {
+    HTTPD_WS_CLIENT_INVALID = 0x0,
+    HTTPD_WS_CLIENT_HTTP = 0x1,
+    HTTPD_WS_CLIENT_WEBSOCKET = 0x2,
+} httpd_ws_client_info_t;
+
+esp_err_t httpd_register_uri_handler(httpd_handle_t handle, const httpd_uri_t *uri_handler);
+esp_err_t httpd_queue_work(httpd_handle_t handle, httpd_work_fn_t work, void *arg);
+httpd_ws_client_info_t httpd_ws_get_fd_info(httpd_handle_t handle, int fd);
+esp_err_t httpd_ws_send_frame_async(httpd_handle_t handle, int fd, httpd_ws_frame_t *frame);
+esp_err_t httpd_ws_recv_frame(httpd_req_t *req, httpd_ws_frame_t *frame, size_t max_len);
+int httpd_req_to_sockfd(httpd_req_t *req);
+
+/* Receives a frame sent to a client, on the httpd task. Returning an error fails the send (client gone). */
+typedef esp_err_t (*host_mock_httpd_sender_t)(int fd, const uint8_t *payload, size_t len, void *ctx);
+
+/**
+ * @brief Starts the server and its httpd task.
+ *
+ * @param handle Output server handle.
+ * @param queue_size Work items httpd_queue_work() can queue before it fails.
+ * @return ESP_OK, ESP_ERR_INVALID_STATE if the server runs, ESP_ERR_NO_MEM if the task can not be started.
+ */
+esp_err_t host_mock_httpd_start(httpd_handle_t *handle, size_t queue_size);
+
+/**
+ * @brief Runs the queued work, then stops the httpd task and forgets the URI handlers and clients.
+ */
+void host_mock_httpd_stop(httpd_handle_t handle);
+
+/**
+ * @brief Opens a WebSocket on a URI: the handshake (GET) runs on the httpd task, this waits for it.
+ *
+ * @return What the URI handler returned, ESP_ERR_NOT_FOUND if no WebSocket handler is registered for the URI.
+ */
+esp_err_t host_mock_httpd_ws_connect(httpd_handle_t handle, const char *uri, int fd);
+
+/**
+ * @brief Closes a client socket, httpd_ws_get_fd_info() returns HTTPD_WS_CLIENT_INVALID for it from now on.
+ */
+void host_mock_httpd_ws_close(httpd_handle_t handle, int fd);
+
+/**
+ * @brief Sets the function that receives the frames of httpd_ws_send_frame_async(), NULL drops them.
+ */
+void host_mock_httpd_set_sender(host_mock_httpd_sender_t sender, void *ctx);
+
+/**
+ * @brief The next count calls of httpd_queue_work() fail, as when the control socket of httpd can not be written.
+ */
+void host_mock_httpd_fail_queue_work(uint32_t count);
+
+/**
+ * @brief Waits until the httpd task has run all queued work.
+ */
+void host_mock_httpd_wait_idle(httpd_handle_t handle);
+
+#endif // HOST_MOCK_ESP_HTTP_SERVER_H
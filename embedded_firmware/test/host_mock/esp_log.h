@@ -0,0 +1,46 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#ifndef HOST_MOCK_ESP_LOG_H
+#define HOST_MOCK_ESP_LOG_H
+
+/*
+ * esp_log.h for host tests, to stderr. HOST_MOCK_LOG_LEVEL 0 none, 1 errors, 2 + warnings, 3 + info (default 2)
+ * is the highest level built in, esp_log_level_set() lowers it at runtime for all tags ("*") or one tag.
+ */
+
+#include <stdio.h>
+
+#ifndef HOST_MOCK_LOG_LEVEL
+#define HOST_MOCK_LOG_LEVEL 2
+#endif
+
+typedef enum {
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE,
+} esp_log_level_t;
+
+void esp_log_level_set(const char *tag, esp_log_level_t level);
+int host_mock_log_enabled(const char *tag, esp_log_level_t level);
+
+#define HOST_MOCK_LOG(level, letter, tag, format, ...) do {                         \
+        if (HOST_MOCK_LOG_LEVEL >= (level) && host_mock_log_enabled(tag, level)) {  \
+            fprintf(stderr, letter " (%s) " format "\n", tag, ##__VA_ARGS__);       \
+        }                                                                           \
+    } while (0)
+
+#define ESP_LOGE(tag, format, ...) HOST_MOCK_LOG(1, "E", tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) HOST_MOCK_LOG(2, "W", tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) HOST_MOCK_LOG(3, "I", tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) HOST_MOCK_LOG(4, "D", tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) HOST_MOCK_LOG(5, "V", tag, format, ##__VA_ARGS__)
+
+#endif // HOST_MOCK_ESP_LOG_H
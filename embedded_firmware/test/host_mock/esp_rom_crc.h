@@ -0,0 +1,18 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#ifndef HOST_MOCK_ESP_ROM_CRC_H
+#define HOST_MOCK_ESP_ROM_CRC_H
+
+#include <stdint.h>
+
+/**
+ * @brief CRC-32 (IEEE 802.3, reflected) as in the ESP32-C3 ROM: pass 0 to start, the result to continue.
+ */
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len);
+
+#endif // HOST_MOCK_ESP_ROM_CRC_H
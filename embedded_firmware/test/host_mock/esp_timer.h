@@ -0,0 +1,20 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#ifndef HOST_MOCK_ESP_TIMER_H
+#define HOST_MOCK_ESP_TIMER_H
+
+/* esp_timer_get_time() on the host monotonic clock */
+
+#include <stdint.h>
+
+/**
+ * @brief Microseconds since the test started (CLOCK_MONOTONIC).
+ */
+int64_t esp_timer_get_time(void);
+
+#endif // HOST_MOCK_ESP_TIMER_H
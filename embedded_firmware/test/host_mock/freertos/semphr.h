@@ -0,0 +1,29 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#ifndef HOST_MOCK_FREERTOS_SEMPHR_H
+#define HOST_MOCK_FREERTOS_SEMPHR_H
+
+/* Semaphores are queues without items, as in FreeRTOS */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+typedef QueueHandle_t SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void);
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void);
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks);
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore);
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t mutex, TickType_t ticks);
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t mutex);
+
+#define vSemaphoreDelete(semaphore)             vQueueDelete(semaphore)
+#define xSemaphoreGiveFromISR(semaphore, woken) xSemaphoreGive(semaphore)
+
+#endif // HOST_MOCK_FREERTOS_SEMPHR_H
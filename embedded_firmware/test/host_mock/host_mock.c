@@ -0,0 +1,104 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_rom_sys.h"
+#include "esp_rom_crc.h"
+
+const char *esp_err_to_name(esp_err_t code) {
+    switch (code) {
+        case ESP_OK:                    return "ESP_OK";
+        case ESP_FAIL:                  return "ESP_FAIL";
+        case ESP_ERR_NO_MEM:            return "ESP_ERR_NO_MEM";
+        case ESP_ERR_INVALID_ARG:       return "ESP_ERR_INVALID_ARG";
+        case ESP_ERR_INVALID_STATE:     return "ESP_ERR_INVALID_STATE";
+        case ESP_ERR_INVALID_SIZE:      return "ESP_ERR_INVALID_SIZE";
+        case ESP_ERR_NOT_FOUND:         return "ESP_ERR_NOT_FOUND";
+        case ESP_ERR_NOT_SUPPORTED:     return "ESP_ERR_NOT_SUPPORTED";
+        case ESP_ERR_TIMEOUT:           return "ESP_ERR_TIMEOUT";
+        case ESP_ERR_INVALID_RESPONSE:  return "ESP_ERR_INVALID_RESPONSE";
+        case ESP_ERR_INVALID_CRC:       return "ESP_ERR_INVALID_CRC";
+        case ESP_ERR_INVALID_VERSION:   return "ESP_ERR_INVALID_VERSION";
+        case ESP_ERR_INVALID_MAC:       return "ESP_ERR_INVALID_MAC";
+        case ESP_ERR_NOT_FINISHED:      return "ESP_ERR_NOT_FINISHED";
+        case ESP_ERR_NOT_ALLOWED:       return "ESP_ERR_NOT_ALLOWED";
+        case ESP_ERR_NVS_NOT_FOUND:     return "ESP_ERR_NVS_NOT_FOUND";
+        case ESP_ERR_NVS_INVALID_LENGTH: return "ESP_ERR_NVS_INVALID_LENGTH";
+        default:                        return "UNKNOWN ERROR";
+    }
+}
+
+void host_mock_abort(const char *file, int line, const char *expression, esp_err_t err) {
+    fprintf(stderr, "ESP_ERROR_CHECK failed: %s (0x%x) at %s:%d\n%s\n", esp_err_to_name(err), err, file, line, expression);
+    abort();
+}
+
+int64_t esp_timer_get_time(void) {
+    static int64_t start_us = -1;
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    int64_t now_us = (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+    if (start_us < 0) {
+        start_us = now_us;
+    }
+    return now_us - start_us;
+}
+
+void esp_rom_delay_us(uint32_t us) {
+    struct timespec delay = { .tv_sec = us / 1000000, .tv_nsec = (long)(us % 1000000) * 1000 };
+    nanosleep(&delay, NULL);
+}
+
+uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len) {
+    crc = ~crc;
+    while (len--) {
+        crc ^= *buf++;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+/* Runtime log levels, set before the tasks start (not locked) */
+#define HOST_MOCK_LOG_TAGS 8
+
+static esp_log_level_t log_default_level = ESP_LOG_VERBOSE;
+static struct {
+    const char *tag;
+    esp_log_level_t level;
+} log_tags[HOST_MOCK_LOG_TAGS];
+
+void esp_log_level_set(const char *tag, esp_log_level_t level) {
+    if (strcmp(tag, "*") == 0) {
+        log_default_level = level;
+        return;
+    }
+    for (int i = 0; i < HOST_MOCK_LOG_TAGS; i++) {
+        if (log_tags[i].tag == NULL || strcmp(log_tags[i].tag, tag) == 0) {
+            log_tags[i].tag = tag;
+            log_tags[i].level = level;
+            return;
+        }
+    }
+    fprintf(stderr, "esp_log_level_set: more than %d tags\n", HOST_MOCK_LOG_TAGS);
+}
+
+int host_mock_log_enabled(const char *tag, esp_log_level_t level) {
+    for (int i = 0; i < HOST_MOCK_LOG_TAGS && log_tags[i].tag != NULL; i++) {
+        if (strcmp(log_tags[i].tag, tag) == 0) {
+            return level <= log_tags[i].level;
+        }
+    }
+    return level <= log_default_level;
+}
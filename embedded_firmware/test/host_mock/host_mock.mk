@@ -0,0 +1,29 @@
+# Shared settings of the host test targets (components/*/tests/test_*_host)
+#
+# Include it from a test Makefile after setting FIRMWARE_DIR (embedded_firmware/, relative to the test directory).
+#
+# INSTR=off builds with gcc and AddressSanitizer + UndefinedBehaviorSanitizer, every report aborts the test.
+# SANITIZE=off builds without sanitizers at -O2, for timing.
+# SANITIZE=thread builds with ThreadSanitizer, for the tests with more than one thread.
+
+HOST_MOCK_DIR = $(FIRMWARE_DIR)/test/host_mock
+COMPONENTS_DIR = $(FIRMWARE_DIR)/components
+DRIVERS_DIR = $(FIRMWARE_DIR)/drivers
+
+CC ?= gcc
+HOST_CFLAGS = -g -std=gnu11 -Wall -Wextra -Wno-unused-parameter -Wno-format -Wno-sign-compare \
+              -I. -I$(HOST_MOCK_DIR) -I$(COMPONENTS_DIR) -I$(DRIVERS_DIR) -DLFS_THREADSAFE -D_GNU_SOURCE
+HOST_LDLIBS = -lpthread -lm
+
+ifeq ($(SANITIZE),off)
+    HOST_CFLAGS += -O2
+else ifeq ($(SANITIZE),thread)
+    HOST_CFLAGS += -O1 -fno-omit-frame-pointer -fsanitize=thread
+    HOST_LDFLAGS += -fsanitize=thread
+else
+    HOST_CFLAGS += -O1 -fno-omit-frame-pointer -fsanitize=address,undefined -fno-sanitize-recover=all
+    HOST_LDFLAGS += -fsanitize=address,undefined
+endif
+
+HOST_MOCK_SOURCES = $(HOST_MOCK_DIR)/host_mock.c $(HOST_MOCK_DIR)/host_mock_freertos.c \
+                    $(HOST_MOCK_DIR)/host_mock_uart.c $(HOST_MOCK_DIR)/host_mock_nvs.c
@@ -0,0 +1,359 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include "esp_timer.h"
+
+typedef enum {
+    HOST_QUEUE,
+    HOST_SEMAPHORE,
+    HOST_MUTEX,
+    HOST_RECURSIVE_MUTEX,
+} host_queue_kind_t;
+
+struct host_queue {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    host_queue_kind_t kind;
+    size_t length;
+    size_t item_size;
+    size_t count;
+    size_t head;
+    uint8_t *items;
+    pthread_t owner;            // Recursive mutex only
+    uint32_t depth;
+};
+
+struct host_task {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    uint32_t notify;
+    TaskFunction_t function;
+    void *parameters;
+};
+
+struct host_event_group {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    EventBits_t bits;
+};
+
+static __thread struct host_task *current_task;
+
+static void host_sync_init(pthread_mutex_t *lock, pthread_cond_t *changed) {
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(changed, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_mutex_init(lock, NULL);
+}
+
+static struct timespec host_deadline(TickType_t ticks) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    uint64_t ns = (uint64_t)ticks * portTICK_PERIOD_MS * 1000000ULL + deadline.tv_nsec;
+    deadline.tv_sec += ns / 1000000000ULL;
+    deadline.tv_nsec = ns % 1000000000ULL;
+    return deadline;
+}
+
+/* Waits for a change with the lock held, false once the ticks have passed (portMAX_DELAY waits forever) */
+static bool host_wait(pthread_mutex_t *lock, pthread_cond_t *changed, TickType_t ticks, const struct timespec *deadline) {
+    if (ticks == 0) {
+        return false;
+    }
+    if (ticks == portMAX_DELAY) {
+        pthread_cond_wait(changed, lock);
+        return true;
+    }
+    return pthread_cond_timedwait(changed, lock, deadline) != ETIMEDOUT;
+}
+
+static QueueHandle_t host_queue_create(host_queue_kind_t kind, size_t length, size_t item_size, size_t count) {
+    QueueHandle_t queue = calloc(1, sizeof(*queue));
+    if (queue == NULL) {
+        return NULL;
+    }
+    queue->items = item_size ? calloc(length, item_size) : NULL;
+    if (item_size && queue->items == NULL) {
+        free(queue);
+        return NULL;
+    }
+    host_sync_init(&queue->lock, &queue->changed);
+    queue->kind = kind;
+    queue->length = length;
+    queue->item_size = item_size;
+    queue->count = count;
+    return queue;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size) {
+    return length ? host_queue_create(HOST_QUEUE, length, item_size, 0) : NULL;
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+    if (queue == NULL) {
+        return;
+    }
+    pthread_cond_destroy(&queue->changed);
+    pthread_mutex_destroy(&queue->lock);
+    free(queue->items);
+    free(queue);
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks) {
+    struct timespec deadline = host_deadline(ticks);
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == queue->length) {
+        if (!host_wait(&queue->lock, &queue->changed, ticks, &deadline)) {
+            pthread_mutex_unlock(&queue->lock);
+            return pdFALSE;
+        }
+    }
+    if (queue->item_size) {
+        memcpy(queue->items + ((queue->head + queue->count) % queue->length) * queue->item_size, item, queue->item_size);
+    }
+    queue->count++;
+    pthread_cond_broadcast(&queue->changed);
+    pthread_mutex_unlock(&queue->lock);
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks) {
+    struct timespec deadline = host_deadline(ticks);
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == 0) {
+        if (!host_wait(&queue->lock, &queue->changed, ticks, &deadline)) {
+            pthread_mutex_unlock(&queue->lock);
+            return pdFALSE;
+        }
+    }
+    if (queue->item_size) {
+        memcpy(item, queue->items + queue->head * queue->item_size, queue->item_size);
+        queue->head = (queue->head + 1) % queue->length;
+    }
+    queue->count--;
+    pthread_cond_broadcast(&queue->changed);
+    pthread_mutex_unlock(&queue->lock);
+    return pdTRUE;
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue) {
+    pthread_mutex_lock(&queue->lock);
+    queue->count = 0;
+    queue->head = 0;
+    pthread_cond_broadcast(&queue->changed);
+    pthread_mutex_unlock(&queue->lock);
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    pthread_mutex_lock(&queue->lock);
+    UBaseType_t count = queue->count;
+    pthread_mutex_unlock(&queue->lock);
+    return count;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) {
+    return host_queue_create(HOST_SEMAPHORE, 1, 0, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    return host_queue_create(HOST_MUTEX, 1, 0, 1);
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void) {
+    return host_queue_create(HOST_RECURSIVE_MUTEX, 1, 0, 1);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks) {
+    return xQueueReceive(semaphore, NULL, ticks);
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    return xQueueSend(semaphore, NULL, 0);
+}
+
+BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t mutex, TickType_t ticks) {
+    pthread_mutex_lock(&mutex->lock);
+    if (mutex->depth > 0 && pthread_equal(mutex->owner, pthread_self())) {
+        mutex->depth++;
+        pthread_mutex_unlock(&mutex->lock);
+        return pdTRUE;
+    }
+    pthread_mutex_unlock(&mutex->lock);
+
+    if (xQueueReceive(mutex, NULL, ticks) != pdTRUE) {
+        return pdFALSE;
+    }
+    pthread_mutex_lock(&mutex->lock);
+    mutex->owner = pthread_self();
+    mutex->depth = 1;
+    pthread_mutex_unlock(&mutex->lock);
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t mutex) {
+    pthread_mutex_lock(&mutex->lock);
+    if (mutex->depth == 0 || !pthread_equal(mutex->owner, pthread_self())) {
+        pthread_mutex_unlock(&mutex->lock);
+        return pdFALSE;
+    }
+    bool last = --mutex->depth == 0;
+    pthread_mutex_unlock(&mutex->lock);
+    return last ? xQueueSend(mutex, NULL, 0) : pdTRUE;
+}
+
+static struct host_task *host_task_create(TaskFunction_t function, void *parameters) {
+    struct host_task *task = calloc(1, sizeof(*task));
+    if (task != NULL) {
+        host_sync_init(&task->lock, &task->changed);
+        task->function = function;
+        task->parameters = parameters;
+    }
+    return task;
+}
+
+static void *host_task_main(void *arg) {
+    current_task = arg;
+    current_task->function(current_task->parameters);
+    return NULL;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char *name, uint32_t stack_depth, void *parameters,
+                       UBaseType_t priority, TaskHandle_t *handle) {
+    struct host_task *task = host_task_create(function, parameters);
+    pthread_t thread;
+    if (task == NULL || pthread_create(&thread, NULL, host_task_main, task) != 0) {
+        free(task);
+        return pdFAIL;
+    }
+    pthread_detach(thread);
+    if (handle != NULL) {
+        *handle = task;
+    }
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    if (task == NULL || task == current_task) {
+        pthread_exit(NULL); // The handle stays allocated, notifications to it are still safe
+    }
+}
+
+void vTaskDelay(TickType_t ticks) {
+    struct timespec delay = {
+        .tv_sec = ticks * portTICK_PERIOD_MS / 1000,
+        .tv_nsec = (long)(ticks * portTICK_PERIOD_MS % 1000) * 1000000L,
+    };
+    while (nanosleep(&delay, &delay) != 0 && errno == EINTR) {
+    }
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return (TickType_t)(esp_timer_get_time() / (1000 * portTICK_PERIOD_MS));
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    if (current_task == NULL) {
+        current_task = host_task_create(NULL, NULL); // Test main thread
+    }
+    return current_task;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    pthread_mutex_lock(&task->lock);
+    task->notify++;
+    pthread_cond_broadcast(&task->changed);
+    pthread_mutex_unlock(&task->lock);
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks) {
+    struct host_task *task = xTaskGetCurrentTaskHandle();
+    struct timespec deadline = host_deadline(ticks);
+    pthread_mutex_lock(&task->lock);
+    while (task->notify == 0 && host_wait(&task->lock, &task->changed, ticks, &deadline)) {
+    }
+    uint32_t value = task->notify;
+    if (value > 0) {
+        task->notify = clear_on_exit ? 0 : value - 1;
+    }
+    pthread_mutex_unlock(&task->lock);
+    return value;
+}
+
+EventGroupHandle_t xEventGroupCreate(void) {
+    EventGroupHandle_t group = calloc(1, sizeof(*group));
+    if (group != NULL) {
+        host_sync_init(&group->lock, &group->changed);
+    }
+    return group;
+}
+
+void vEventGroupDelete(EventGroupHandle_t group) {
+    if (group == NULL) {
+        return;
+    }
+    pthread_cond_destroy(&group->changed);
+    pthread_mutex_destroy(&group->lock);
+    free(group);
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits) {
+    pthread_mutex_lock(&group->lock);
+    group->bits |= bits;
+    EventBits_t value = group->bits;
+    pthread_cond_broadcast(&group->changed);
+    pthread_mutex_unlock(&group->lock);
+    return value;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits) {
+    pthread_mutex_lock(&group->lock);
+    EventBits_t value = group->bits;
+    group->bits &= ~bits;
+    pthread_mutex_unlock(&group->lock);
+    return value;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group) {
+    pthread_mutex_lock(&group->lock);
+    EventBits_t value = group->bits;
+    pthread_mutex_unlock(&group->lock);
+    return value;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clear_on_exit,
+                                BaseType_t wait_for_all, TickType_t ticks) {
+    struct timespec deadline = host_deadline(ticks);
+    pthread_mutex_lock(&group->lock);
+    for (;;) {
+        EventBits_t set = group->bits & bits;
+        if (wait_for_all ? set == bits : set != 0) {
+            break;
+        }
+        if (!host_wait(&group->lock, &group->changed, ticks, &deadline)) {
+            break;
+        }
+    }
+    EventBits_t value = group->bits;
+    if (clear_on_exit && (wait_for_all ? (value & bits) == bits : (value & bits) != 0)) {
+        group->bits &= ~bits;
+    }
+    pthread_mutex_unlock(&group->lock);
+    return value;
+}
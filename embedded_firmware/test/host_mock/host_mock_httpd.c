@@ -0,0 +1,261 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "esp_http_server.h"
+
+#define HOST_HTTPD_MAX_URIS     8
+#define HOST_HTTPD_MAX_FDS      16
+
+typedef struct {
+    httpd_work_fn_t work;
+    void *arg;
+} host_httpd_work_t;
+
+/* Handshake of host_mock_httpd_ws_connect(), run as work on the httpd task */
+typedef struct {
+    httpd_uri_t uri;
+    int fd;
+    esp_err_t result;
+    bool done;
+} host_httpd_connect_t;
+
+/* One server, the handle is its address */
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    bool running;
+    pthread_t task;
+    host_httpd_work_t *queue;
+    size_t queue_size;
+    size_t queue_head;
+    size_t queue_count;
+    bool busy;                  // The httpd task runs a work item
+    httpd_uri_t uris[HOST_HTTPD_MAX_URIS];
+    size_t uri_count;
+    bool ws_open[HOST_HTTPD_MAX_FDS];
+    uint32_t fail_queue_work;
+    host_mock_httpd_sender_t sender;
+    void *sender_ctx;
+} host_httpd = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .changed = PTHREAD_COND_INITIALIZER,
+};
+
+static void *host_httpd_task(void *arg) {
+    pthread_mutex_lock(&host_httpd.lock);
+    while (host_httpd.running || host_httpd.queue_count > 0) {
+        if (host_httpd.queue_count == 0) {
+            pthread_cond_wait(&host_httpd.changed, &host_httpd.lock);
+            continue;
+        }
+        host_httpd_work_t item = host_httpd.queue[host_httpd.queue_head];
+        host_httpd.queue_head = (host_httpd.queue_head + 1) % host_httpd.queue_size;
+        host_httpd.queue_count--;
+        host_httpd.busy = true;
+        pthread_mutex_unlock(&host_httpd.lock);
+
+        item.work(item.arg);
+
+        pthread_mutex_lock(&host_httpd.lock);
+        host_httpd.busy = false;
+        pthread_cond_broadcast(&host_httpd.changed);
+    }
+    pthread_mutex_unlock(&host_httpd.lock);
+    return NULL;
+}
+
+esp_err_t host_mock_httpd_start(httpd_handle_t *handle, size_t queue_size) {
+    pthread_mutex_lock(&host_httpd.lock);
+    if (host_httpd.running) {
+        pthread_mutex_unlock(&host_httpd.lock);
+        return ESP_ERR_INVALID_STATE;
+    }
+    host_httpd.queue = calloc(queue_size, sizeof(host_httpd_work_t));
+    host_httpd.queue_size = queue_size;
+    host_httpd.queue_head = 0;
+    host_httpd.queue_count = 0;
+    host_httpd.uri_count = 0;
+    host_httpd.fail_queue_work = 0;
+    memset(host_httpd.ws_open, 0, sizeof(host_httpd.ws_open));
+    host_httpd.running = host_httpd.queue != NULL &&
+                         pthread_create(&host_httpd.task, NULL, host_httpd_task, NULL) == 0;
+    if (!host_httpd.running) {
+        free(host_httpd.queue);
+        host_httpd.queue = NULL;
+    }
+    pthread_mutex_unlock(&host_httpd.lock);
+    *handle = host_httpd.running ? &host_httpd : NULL;
+    return *handle != NULL ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+void host_mock_httpd_stop(httpd_handle_t handle) {
+    pthread_mutex_lock(&host_httpd.lock);
+    if (!host_httpd.running) {
+        pthread_mutex_unlock(&host_httpd.lock);
+        return;
+    }
+    host_httpd.running = false;
+    pthread_cond_broadcast(&host_httpd.changed);
+    pthread_mutex_unlock(&host_httpd.lock);
+
+    pthread_join(host_httpd.task, NULL);
+    free(host_httpd.queue);
+    host_httpd.queue = NULL;
+    host_httpd.uri_count = 0;
+}
+
+esp_err_t httpd_register_uri_handler(httpd_handle_t handle, const httpd_uri_t *uri_handler) {
+    esp_err_t err = ESP_OK;
+    pthread_mutex_lock(&host_httpd.lock);
+    if (handle != &host_httpd || host_httpd.uri_count == HOST_HTTPD_MAX_URIS) {
+        err = handle != &host_httpd ? ESP_ERR_INVALID_ARG : ESP_ERR_NO_MEM;
+    } else {
+        host_httpd.uris[host_httpd.uri_count++] = *uri_handler;
+    }
+    pthread_mutex_unlock(&host_httpd.lock);
+    return err;
+}
+
+esp_err_t httpd_queue_work(httpd_handle_t handle, httpd_work_fn_t work, void *arg) {
+    esp_err_t err = ESP_OK;
+    pthread_mutex_lock(&host_httpd.lock);
+    if (handle != &host_httpd || !host_httpd.running) {
+        err = ESP_ERR_INVALID_ARG;
+    } else if (host_httpd.fail_queue_work > 0) {
+        host_httpd.fail_queue_work--;
+        err = ESP_FAIL;
+    } else if (host_httpd.queue_count == host_httpd.queue_size) {
+        err = ESP_FAIL;
+    } else {
+        size_t tail = (host_httpd.queue_head + host_httpd.queue_count) % host_httpd.queue_size;
+        host_httpd.queue[tail] = (host_httpd_work_t){ .work = work, .arg = arg };
+        host_httpd.queue_count++;
+        pthread_cond_broadcast(&host_httpd.changed);
+    }
+    pthread_mutex_unlock(&host_httpd.lock);
+    return err;
+}
+
+httpd_ws_client_info_t httpd_ws_get_fd_info(httpd_handle_t handle, int fd) {
+    pthread_mutex_lock(&host_httpd.lock);
+    bool open = fd >= 0 && fd < HOST_HTTPD_MAX_FDS && host_httpd.ws_open[fd];
+    pthread_mutex_unlock(&host_httpd.lock);
+    return open ? HTTPD_WS_CLIENT_WEBSOCKET : HTTPD_WS_CLIENT_INVALID;
+}
+
+esp_err_t httpd_ws_send_frame_async(httpd_handle_t handle, int fd, httpd_ws_frame_t *frame) {
+    if (httpd_ws_get_fd_info(handle, fd) != HTTPD_WS_CLIENT_WEBSOCKET) {
+        return ESP_FAIL;
+    }
+    pthread_mutex_lock(&host_httpd.lock);
+    host_mock_httpd_sender_t sender = host_httpd.sender;
+    void *ctx = host_httpd.sender_ctx;
+    pthread_mutex_unlock(&host_httpd.lock);
+    return sender != NULL ? sender(fd, frame->payload, frame->len, ctx) : ESP_OK;
+}
+
+esp_err_t httpd_ws_recv_frame(httpd_req_t *req, httpd_ws_frame_t *frame, size_t max_len) {
+    frame->len = 0; // Clients of the host tests never send
+    return ESP_OK;
+}
+
+int httpd_req_to_sockfd(httpd_req_t *req) {
+    return req->fd;
+}
+
+static void host_httpd_connect_work(void *arg) {
+    host_httpd_connect_t *connect = (host_httpd_connect_t *)arg;
+    httpd_req_t req = {
+        .handle = &host_httpd,
+        .method = HTTP_GET,
+        .uri = connect->uri.uri,
+        .user_ctx = connect->uri.user_ctx,
+        .fd = connect->fd,
+    };
+
+    pthread_mutex_lock(&host_httpd.lock);
+    host_httpd.ws_open[connect->fd] = true;
+    pthread_mutex_unlock(&host_httpd.lock);
+
+    esp_err_t result = connect->uri.handler(&req);
+
+    pthread_mutex_lock(&host_httpd.lock);
+    if (result != ESP_OK) {
+        host_httpd.ws_open[connect->fd] = false; // httpd closes the socket when the handler fails
+    }
+    connect->result = result;
+    connect->done = true;
+    pthread_cond_broadcast(&host_httpd.changed);
+    pthread_mutex_unlock(&host_httpd.lock);
+}
+
+esp_err_t host_mock_httpd_ws_connect(httpd_handle_t handle, const char *uri, int fd) {
+    host_httpd_connect_t connect = { .fd = fd };
+    bool found = false;
+
+    if (fd < 0 || fd >= HOST_HTTPD_MAX_FDS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&host_httpd.lock);
+    for (size_t i = 0; i < host_httpd.uri_count && !found; i++) {
+        if (host_httpd.uris[i].is_websocket && strcmp(host_httpd.uris[i].uri, uri) == 0) {
+            connect.uri = host_httpd.uris[i];
+            found = true;
+        }
+    }
+    pthread_mutex_unlock(&host_httpd.lock);
+    if (!found) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    // Retried until it is queued, a handshake is not lost as work can be
+    esp_err_t err;
+    while ((err = httpd_queue_work(handle, host_httpd_connect_work, &connect)) == ESP_FAIL) {
+        host_mock_httpd_wait_idle(handle);
+    }
+    if (err != ESP_OK) {
+        return err;
+    }
+    pthread_mutex_lock(&host_httpd.lock);
+    while (!connect.done) {
+        pthread_cond_wait(&host_httpd.changed, &host_httpd.lock);
+    }
+    pthread_mutex_unlock(&host_httpd.lock);
+    return connect.result;
+}
+
+void host_mock_httpd_ws_close(httpd_handle_t handle, int fd) {
+    pthread_mutex_lock(&host_httpd.lock);
+    if (fd >= 0 && fd < HOST_HTTPD_MAX_FDS) {
+        host_httpd.ws_open[fd] = false;
+    }
+    pthread_mutex_unlock(&host_httpd.lock);
+}
+
+void host_mock_httpd_set_sender(host_mock_httpd_sender_t sender, void *ctx) {
+    pthread_mutex_lock(&host_httpd.lock);
+    host_httpd.sender = sender;
+    host_httpd.sender_ctx = ctx;
+    pthread_mutex_unlock(&host_httpd.lock);
+}
+
+void host_mock_httpd_fail_queue_work(uint32_t count) {
+    pthread_mutex_lock(&host_httpd.lock);
+    host_httpd.fail_queue_work = count;
+    pthread_mutex_unlock(&host_httpd.lock);
+}
+
+void host_mock_httpd_wait_idle(httpd_handle_t handle) {
+    pthread_mutex_lock(&host_httpd.lock);
+    while (host_httpd.queue_count > 0 || host_httpd.busy) {
+        pthread_cond_wait(&host_httpd.changed, &host_httpd.lock);
+    }
+    pthread_mutex_unlock(&host_httpd.lock);
+}
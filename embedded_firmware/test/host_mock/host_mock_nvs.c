@@ -0,0 +1,116 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "nvs.h"
+#include "nvs_flash.h"
+
+#define HOST_NVS_MAX_NAMESPACES 8
+#define HOST_NVS_MAX_ENTRIES    32
+#define HOST_NVS_KEY_SIZE       16      // NVS_KEY_NAME_MAX_SIZE
+
+typedef struct {
+    nvs_handle_t handle;        // Namespace, 0 if the entry is free
+    char key[HOST_NVS_KEY_SIZE];
+    void *value;
+    size_t length;
+} host_nvs_entry_t;
+
+static pthread_mutex_t host_nvs_lock = PTHREAD_MUTEX_INITIALIZER;
+static char host_nvs_namespaces[HOST_NVS_MAX_NAMESPACES][HOST_NVS_KEY_SIZE];
+static host_nvs_entry_t host_nvs_entries[HOST_NVS_MAX_ENTRIES];
+
+static host_nvs_entry_t *host_nvs_find(nvs_handle_t handle, const char *key) {
+    for (int i = 0; i < HOST_NVS_MAX_ENTRIES; i++) {
+        if (host_nvs_entries[i].handle == handle && strcmp(host_nvs_entries[i].key, key) == 0) {
+            return &host_nvs_entries[i];
+        }
+    }
+    return NULL;
+}
+
+esp_err_t nvs_flash_init(void) {
+    return ESP_OK;
+}
+
+esp_err_t nvs_open(const char *name, nvs_open_mode_t open_mode, nvs_handle_t *out_handle) {
+    if (name == NULL || strlen(name) >= HOST_NVS_KEY_SIZE || out_handle == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&host_nvs_lock);
+    for (int i = 0; i < HOST_NVS_MAX_NAMESPACES; i++) {
+        if (host_nvs_namespaces[i][0] == '\0') {
+            strcpy(host_nvs_namespaces[i], name);
+        }
+        if (strcmp(host_nvs_namespaces[i], name) == 0) {
+            *out_handle = i + 1;
+            pthread_mutex_unlock(&host_nvs_lock);
+            return ESP_OK;
+        }
+    }
+    pthread_mutex_unlock(&host_nvs_lock);
+    return ESP_ERR_NO_MEM;
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char *key, const void *value, size_t length) {
+    if (handle == 0 || key == NULL || strlen(key) >= HOST_NVS_KEY_SIZE || (value == NULL && length > 0)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    void *copy = malloc(length ? length : 1);
+    if (copy == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    memcpy(copy, value, length);
+
+    pthread_mutex_lock(&host_nvs_lock);
+    host_nvs_entry_t *entry = host_nvs_find(handle, key);
+    if (entry == NULL) {
+        entry = host_nvs_find(0, "");
+    }
+    if (entry == NULL) {
+        pthread_mutex_unlock(&host_nvs_lock);
+        free(copy);
+        return ESP_ERR_NO_MEM;
+    }
+    free(entry->value);
+    entry->handle = handle;
+    strcpy(entry->key, key);
+    entry->value = copy;
+    entry->length = length;
+    pthread_mutex_unlock(&host_nvs_lock);
+    return ESP_OK;
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char *key, void *out_value, size_t *length) {
+    if (handle == 0 || key == NULL || length == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&host_nvs_lock);
+    host_nvs_entry_t *entry = host_nvs_find(handle, key);
+    esp_err_t ret = ESP_OK;
+    if (entry == NULL) {
+        ret = ESP_ERR_NVS_NOT_FOUND;
+    } else if (out_value != NULL && *length < entry->length) {
+        ret = ESP_ERR_NVS_INVALID_LENGTH;
+    } else {
+        if (out_value != NULL) {
+            memcpy(out_value, entry->value, entry->length);
+        }
+        *length = entry->length; // Only the length when out_value is NULL, as in ESP-IDF
+    }
+    pthread_mutex_unlock(&host_nvs_lock);
+    return ret;
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle) {
+    return handle ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+void nvs_close(nvs_handle_t handle) {
+}
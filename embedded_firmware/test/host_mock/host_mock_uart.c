@@ -0,0 +1,230 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "driver/uart.h"
+
+#define HOST_UART_PATTERN_QUEUE_MAX 64
+
+/* One port, positions are counted in bytes since install so they stay valid while the ring buffer wraps */
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    bool installed;
+    QueueHandle_t events;
+    uint8_t *rx;
+    size_t rx_size;
+    uint64_t rx_written;        // Bytes put into the ring buffer
+    uint64_t rx_read;           // Bytes taken out of it
+    char pattern_chr;
+    uint64_t patterns[HOST_UART_PATTERN_QUEUE_MAX];
+    size_t pattern_count;
+    size_t pattern_queue_length;
+    uint32_t baud_rate;
+    uint64_t garbage_state;
+    host_mock_uart_tx_handler_t tx_handler;
+    void *tx_ctx;
+} host_uart = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .changed = PTHREAD_COND_INITIALIZER,
+    .garbage_state = 88172645463325252ULL,
+};
+
+static void host_uart_post(uart_event_type_t type, size_t size) {
+    uart_event_t event = { .type = type, .size = size };
+    if (host_uart.events != NULL) {
+        xQueueSend(host_uart.events, &event, 0); // The driver drops events when the queue is full too
+    }
+}
+
+esp_err_t uart_driver_install(uart_port_t port, int rx_buffer_size, int tx_buffer_size, int queue_size,
+                              QueueHandle_t *queue, int intr_alloc_flags) {
+    pthread_mutex_lock(&host_uart.lock);
+    if (host_uart.installed) {
+        pthread_mutex_unlock(&host_uart.lock);
+        return ESP_FAIL;
+    }
+    host_uart.rx = malloc(rx_buffer_size);
+    host_uart.rx_size = rx_buffer_size;
+    host_uart.events = queue_size > 0 ? xQueueCreate(queue_size, sizeof(uart_event_t)) : NULL;
+    if (queue != NULL) {
+        *queue = host_uart.events;
+    }
+    host_uart.installed = host_uart.rx != NULL;
+    pthread_mutex_unlock(&host_uart.lock);
+    return host_uart.installed ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+esp_err_t uart_param_config(uart_port_t port, const uart_config_t *config) {
+    pthread_mutex_lock(&host_uart.lock);
+    host_uart.baud_rate = config->baud_rate;
+    pthread_mutex_unlock(&host_uart.lock);
+    return ESP_OK;
+}
+
+esp_err_t uart_set_pin(uart_port_t port, int tx, int rx, int rts, int cts) {
+    return ESP_OK;
+}
+
+esp_err_t uart_enable_pattern_det_baud_intr(uart_port_t port, char pattern_chr, uint8_t chr_num, int chr_tout,
+                                            int post_idle, int pre_idle) {
+    pthread_mutex_lock(&host_uart.lock);
+    host_uart.pattern_chr = pattern_chr;
+    pthread_mutex_unlock(&host_uart.lock);
+    return ESP_OK;
+}
+
+esp_err_t uart_pattern_queue_reset(uart_port_t port, int queue_length) {
+    if (queue_length <= 0 || queue_length > HOST_UART_PATTERN_QUEUE_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    pthread_mutex_lock(&host_uart.lock);
+    host_uart.pattern_queue_length = queue_length;
+    host_uart.pattern_count = 0;
+    pthread_mutex_unlock(&host_uart.lock);
+    return ESP_OK;
+}
+
+int uart_pattern_pop_pos(uart_port_t port) {
+    int pos = -1;
+    pthread_mutex_lock(&host_uart.lock);
+    while (host_uart.pattern_count > 0 && pos < 0) {
+        uint64_t at = host_uart.patterns[0];
+        memmove(host_uart.patterns, host_uart.patterns + 1, --host_uart.pattern_count * sizeof(host_uart.patterns[0]));
+        if (at >= host_uart.rx_read) {
+            pos = (int)(at - host_uart.rx_read); // Relative to the next byte uart_read_bytes() returns
+        }
+    }
+    pthread_mutex_unlock(&host_uart.lock);
+    return pos;
+}
+
+esp_err_t uart_set_baudrate(uart_port_t port, uint32_t baud_rate) {
+    pthread_mutex_lock(&host_uart.lock);
+    host_uart.baud_rate = baud_rate;
+    pthread_mutex_unlock(&host_uart.lock);
+    return ESP_OK;
+}
+
+esp_err_t uart_get_buffered_data_len(uart_port_t port, size_t *size) {
+    pthread_mutex_lock(&host_uart.lock);
+    *size = (size_t)(host_uart.rx_written - host_uart.rx_read);
+    pthread_mutex_unlock(&host_uart.lock);
+    return ESP_OK;
+}
+
+int uart_read_bytes(uart_port_t port, void *buf, uint32_t length, TickType_t ticks_to_wait) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    uint64_t ns = (uint64_t)ticks_to_wait * portTICK_PERIOD_MS * 1000000ULL + deadline.tv_nsec;
+    deadline.tv_sec += ns / 1000000000ULL;
+    deadline.tv_nsec = ns % 1000000000ULL;
+
+    pthread_mutex_lock(&host_uart.lock);
+    while (host_uart.rx_written - host_uart.rx_read < length && ticks_to_wait > 0) {
+        if (pthread_cond_timedwait(&host_uart.changed, &host_uart.lock, &deadline) != 0) {
+            break;
+        }
+    }
+    size_t available = (size_t)(host_uart.rx_written - host_uart.rx_read);
+    size_t count = available < length ? available : length;
+    for (size_t i = 0; i < count; i++) {
+        ((uint8_t *)buf)[i] = host_uart.rx[(host_uart.rx_read + i) % host_uart.rx_size];
+    }
+    host_uart.rx_read += count;
+    pthread_mutex_unlock(&host_uart.lock);
+    return (int)count;
+}
+
+int uart_write_bytes(uart_port_t port, const void *src, size_t size) {
+    pthread_mutex_lock(&host_uart.lock);
+    host_mock_uart_tx_handler_t handler = host_uart.tx_handler;
+    void *ctx = host_uart.tx_ctx;
+    uint32_t baud_rate = host_uart.baud_rate;
+    pthread_mutex_unlock(&host_uart.lock);
+
+    if (handler != NULL) {
+        handler(src, size, baud_rate, ctx); // Outside the lock, the device may answer right away
+    }
+    return (int)size;
+}
+
+esp_err_t uart_wait_tx_done(uart_port_t port, TickType_t ticks_to_wait) {
+    return ESP_OK; // Sent in uart_write_bytes() already
+}
+
+esp_err_t uart_flush_input(uart_port_t port) {
+    pthread_mutex_lock(&host_uart.lock);
+    host_uart.rx_read = host_uart.rx_written;
+    host_uart.pattern_count = 0;
+    pthread_mutex_unlock(&host_uart.lock);
+    return ESP_OK;
+}
+
+void host_mock_uart_set_tx_handler(host_mock_uart_tx_handler_t handler, void *ctx) {
+    pthread_mutex_lock(&host_uart.lock);
+    host_uart.tx_handler = handler;
+    host_uart.tx_ctx = ctx;
+    pthread_mutex_unlock(&host_uart.lock);
+}
+
+void host_mock_uart_receive(const uint8_t *data, size_t len, uint32_t baud_rate) {
+    size_t patterns = 0;
+    size_t since_pattern = 0;
+    bool full = false;
+
+    pthread_mutex_lock(&host_uart.lock);
+    if (!host_uart.installed) {
+        pthread_mutex_unlock(&host_uart.lock);
+        return;
+    }
+    for (size_t i = 0; i < len; i++) {
+        uint8_t ch = data[i];
+        if (baud_rate != host_uart.baud_rate) {
+            host_uart.garbage_state ^= host_uart.garbage_state << 13;
+            host_uart.garbage_state ^= host_uart.garbage_state >> 7;
+            host_uart.garbage_state ^= host_uart.garbage_state << 17;
+            ch = (uint8_t)host_uart.garbage_state; // Wrong rate, the bits are sampled at the wrong places
+        }
+        if (host_uart.rx_written - host_uart.rx_read >= host_uart.rx_size) {
+            full = true;
+            break;
+        }
+        host_uart.rx[host_uart.rx_written % host_uart.rx_size] = ch;
+        if (ch == (uint8_t)host_uart.pattern_chr) {
+            if (host_uart.pattern_count < host_uart.pattern_queue_length) {
+                host_uart.patterns[host_uart.pattern_count++] = host_uart.rx_written; // Lost when the queue is full
+            }
+            patterns++;
+            since_pattern = 0;
+        } else {
+            since_pattern++;
+        }
+        host_uart.rx_written++;
+    }
+    pthread_cond_broadcast(&host_uart.changed);
+    pthread_mutex_unlock(&host_uart.lock);
+
+    for (size_t i = 0; i < patterns; i++) {
+        host_uart_post(UART_PATTERN_DET, 0);
+    }
+    if (since_pattern > 0) {
+        host_uart_post(UART_DATA, since_pattern);
+    }
+    if (full) {
+        host_uart_post(UART_BUFFER_FULL, 0);
+    }
+}
+
+uint32_t host_mock_uart_get_baud_rate(void) {
+    pthread_mutex_lock(&host_uart.lock);
+    uint32_t baud_rate = host_uart.baud_rate;
+    pthread_mutex_unlock(&host_uart.lock);
+    return baud_rate;
+}
@@ -0,0 +1,13 @@
+/*
+ * Copyright © 2025 Tomaz Miklavcic
+ *
+ * Use this code for whatever you want. No restrictions, no warranty.
+ * Attribution appreciated but not required.
+ */
+
+#ifndef HOST_MOCK_SDKCONFIG_H
+#define HOST_MOCK_SDKCONFIG_H
+
+/* No menuconfig on the host, the test Makefiles set the CONFIG_ options they need with -D */
+
+#endif // HOST_MOCK_SDKCONFIG_H
@@ -0,0 +1,113 @@
+import struct
+import zlib
+from logging_util import get_logger
+
+# Export archive (.dca) sent by /export, see embedded_firmware/components/file_system_littlefs/lfs_archive.h
+ARCHIVE_MAGIC = b"DCGA"
+ARCHIVE_VERSION = 1
+ARCHIVE_HEADER_FORMAT = "<4sBBBBI"   # magic, version, header_size, entry_size, reserved, cursor
+ARCHIVE_ENTRY_FORMAT = "<IIIIB3s"    # size, mtime, crc32, cursor, name_len, reserved
+
+logger = get_logger(__name__)
+
+
+class ArchiveFormatError(Exception):
+    pass
+
+
+class CollarArchiveParser:
+    """Unpacks an export archive while it is downloaded.
+
+    feed() takes the bytes in chunks of any size. For every file open_entry(entry) returns a binary file
+    object that receives the data, close_entry(entry, crc_ok) is called when the file is complete.
+    entry is a dict with name, size, mtime, crc32 and cursor.
+    """
+
+    def __init__(self, open_entry, close_entry):
+        self.open_entry = open_entry
+        self.close_entry = close_entry
+        self.header_size = struct.calcsize(ARCHIVE_HEADER_FORMAT)
+        self.entry_size = struct.calcsize(ARCHIVE_ENTRY_FORMAT)
+
+        self.pending = b""          # Header bytes not parsed yet
+        self.cursor = None          # Archive cursor, known after the header
+        self.finished = False       # End of archive entry received
+        self.entries = 0
+
+        self.entry = None           # File being received
+        self.entry_file = None
+        self.entry_remaining = 0
+        self.entry_crc = 0
+
+    def feed(self, data: bytes) -> None:
+
+        while data:
+            if self.finished:
+                raise ArchiveFormatError("Data after the end of the archive")
+
+            # 1) File data
+            if self.entry is not None:
+                chunk = data[:self.entry_remaining]
+                data = data[len(chunk):]
+                self.entry_file.write(chunk)
+                self.entry_crc = zlib.crc32(chunk, self.entry_crc)
+                self.entry_remaining -= len(chunk)
+                if self.entry_remaining == 0:
+                    self.finish_entry()
+                continue
+
+            # 2) Archive header, then entry header + name (name_len is the byte at offset 16)
+            if self.cursor is None:
+                needed = self.header_size
+            elif len(self.pending) < self.entry_size:
+                needed = self.entry_size
+            else:
+                needed = self.entry_size + self.pending[16]
+
+            take = needed - len(self.pending)
+            self.pending += data[:take]
+            data = data[take:]
+            if len(self.pending) < needed or (self.cursor is not None and len(self.pending) < self.entry_size + self.pending[16]):
+                continue  # Wait for more data, or read the name that follows the entry header
+
+            if self.cursor is None:
+                self.parse_header()
+            else:
+                self.parse_entry()
+            self.pending = b""
+
+        # An entry without data is complete as soon as its header is
+        if self.entry is not None and self.entry_remaining == 0:
+            self.finish_entry()
+
+    def parse_header(self) -> None:
+        magic, version, header_size, entry_size, _, cursor = struct.unpack(ARCHIVE_HEADER_FORMAT, self.pending)
+        if magic != ARCHIVE_MAGIC or version != ARCHIVE_VERSION or header_size != self.header_size or entry_size != self.entry_size:
+            raise ArchiveFormatError("Not a supported export archive")
+        self.cursor = cursor
+
+    def parse_entry(self) -> None:
+        size, mtime, crc32, cursor, name_len, _ = struct.unpack_from(ARCHIVE_ENTRY_FORMAT, self.pending)
+        if name_len == 0:
+            self.finished = True
+            return
+        self.entry = {
+            "name": self.pending[self.entry_size:].decode("utf-8"),
+            "size": size,
+            "mtime": mtime,
+            "crc32": crc32,
+            "cursor": cursor,
+        }
+        self.entry_file = self.open_entry(self.entry)
+        self.entry_remaining = size
+        self.entry_crc = 0
+
+    def finish_entry(self) -> None:
+        crc_ok = self.entry_crc == self.entry["crc32"]
+        if not crc_ok:
+            logger.error(f"CRC mismatch for '{self.entry['name']}' in the export archive.")
+        self.entry_file.close()
+        self.close_entry(self.entry, crc_ok)
+        self.entries += 1
+        self.entry = None
+        self.entry_file = None
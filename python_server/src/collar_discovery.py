@@ -0,0 +1,96 @@
+import threading
+from dataclasses import dataclass
+from zeroconf import ServiceBrowser, ServiceListener, Zeroconf
+from logging_util import get_logger
+
+SERVICE_TYPE = "_dogcollar._tcp.local."    # Advertised by the collar while its Wi-Fi sync is running
+SERVICE_INFO_TIMEOUT_MS = 3000
+
+logger = get_logger(__name__)
+
+
+@dataclass
+class CollarAnnouncement:
+    name: str               # mDNS instance name, unique per collar on the network
+    url: str
+    pending_files: int      # Files the collar has that no client acknowledged
+    pending_bytes: int
+    cursor: int             # Latest sync cursor on the collar
+    soc: int                # Battery state of charge in %
+    firmware: str
+    track_format: int
+
+
+class CollarBrowser(ServiceListener):
+    """Browses for collars over mDNS, the collar TXT records tell whether a sync is needed without connecting."""
+
+    def __init__(self) -> None:
+        self.collars = {}               # Instance name -> CollarAnnouncement
+        self.handled = {}               # Instance name -> (cursor, pending_files) of the last sync
+        self.lock = threading.Lock()
+        self.changed = threading.Event()
+        self.zeroconf = Zeroconf()
+        self.browser = ServiceBrowser(self.zeroconf, SERVICE_TYPE, self)
+
+    def close(self) -> None:
+        self.zeroconf.close()
+
+    # ---------------- ServiceListener callbacks (zeroconf thread) ----------------
+    def add_service(self, zc: Zeroconf, type_: str, name: str) -> None:
+        self.update_service(zc, type_, name)
+
+    def update_service(self, zc: Zeroconf, type_: str, name: str) -> None:
+        info = zc.get_service_info(type_, name, timeout=SERVICE_INFO_TIMEOUT_MS)
+        if info is None or not info.parsed_addresses():
+            return
+        announcement = self.parse_announcement(name, info)
+        if announcement is None:
+            return
+        with self.lock:
+            self.collars[name] = announcement
+        logger.info(f"Collar {name} at {announcement.url}: {announcement.pending_files} files "
+                    f"({announcement.pending_bytes} bytes) pending, battery {announcement.soc} %.")
+        self.changed.set()
+
+    def remove_service(self, zc: Zeroconf, type_: str, name: str) -> None:
+        # The collar went to sleep, the next time it wakes up it is synced again if files are still pending
+        with self.lock:
+            self.collars.pop(name, None)
+            self.handled.pop(name, None)
+        logger.info(f"Collar {name} left the network.")
+
+    def parse_announcement(self, name: str, info) -> CollarAnnouncement | None:
+        txt = {key.decode(): (value or b"").decode() for key, value in info.properties.items()}
+        try:
+            return CollarAnnouncement(
+                name=name,
+                url=f"http://{info.parsed_addresses()[0]}:{info.port}",
+                pending_files=int(txt.get("pending", 0)),
+                pending_bytes=int(txt.get("bytes", 0)),
+                cursor=int(txt.get("cursor", 0)),
+                soc=int(txt.get("soc", 0)),
+                firmware=txt.get("fw", ""),
+                track_format=int(txt.get("fmt", 0)),
+            )
+        except ValueError as e:
+            logger.warning(f"Invalid TXT records from {name}: {txt} ({e})")
+            return None
+
+    # ---------------- Client side ----------------
+    def wait_for_pending(self, timeout: float | None = None) -> list[CollarAnnouncement]:
+
+        # Returns the collars with files pending that were not synced in their current state,
+        # or an empty list on timeout. A collar is not synced twice until its TXT records change.
+        while True:
+            self.changed.clear()
+            with self.lock:
+                pending = [collar for name, collar in self.collars.items()
+                           if collar.pending_files > 0 and self.handled.get(name) != (collar.cursor, collar.pending_files)]
+            if pending:
+                return pending
+            if not self.changed.wait(timeout):
+                return []
+
+    def mark_synced(self, collar: CollarAnnouncement) -> None:
+        with self.lock:
+            self.handled[collar.name] = (collar.cursor, collar.pending_files)
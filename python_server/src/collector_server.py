@@ -0,0 +1,182 @@
+"""Reference collector for the collar push upload (push_upload.h), for local testing.
+
+Run it on the PC, during the next Wi-Fi sync the collar finds it over mDNS and uploads its new files:
+
+    python collector_server.py [port]
+
+Files are stored in collector_files/<collar id>/, track files are decoded to CSV next to the raw file.
+"""
+import os
+import socket
+import sys
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from urllib.parse import urlparse, parse_qs
+from track_decoder import TrackDecoder
+from local_storage_manager import TRACK_FILE_EXTENSION, PARTIAL_FILE_EXTENSION, ETAG_FILE_EXTENSION
+from logging_util import get_logger, setup_logging
+
+try:
+    from zeroconf import ServiceInfo, Zeroconf
+except ImportError:     # Without mDNS the collar does not find the collector
+    Zeroconf = None
+
+COLLECTOR_SERVICE_TYPE = "_dogcollector._tcp.local."
+COLLECTOR_PORT = 8080
+COLLECTOR_FILES_DIR = "collector_files"
+CURSOR_FILE = "cursor"          # Last cursor the collar completed, in the collar directory
+HTTP_OK = 200
+HTTP_BAD_REQUEST = 400
+HTTP_NOT_FOUND = 404
+HTTP_CONFLICT = 409
+
+logger = get_logger(__name__)
+
+
+def safe_name(name: str | None) -> str | None:
+    # Collar ids and collar file names are plain names, anything with a path in it is refused
+    if not name or name != os.path.basename(name) or name.startswith("."):
+        return None
+    return name
+
+
+class CollectorHandler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"   # Keep-alive, the collar sends all pieces over one connection
+    track_decoder = TrackDecoder()
+
+    def log_message(self, format: str, *args) -> None:
+        logger.debug(format % args)
+
+    def send_text(self, status: int, text: str) -> None:
+        body = text.encode()
+        self.send_response(status)
+        self.send_header("Content-Type", "text/plain")
+        self.send_header("Content-Length", str(len(body)))
+        self.end_headers()
+        self.wfile.write(body)
+
+    def parse_request_target(self) -> tuple[str, str | None, dict]:
+        url = urlparse(self.path)
+        query = {key: values[0] for key, values in parse_qs(url.query).items()}
+        return url.path, safe_name(query.get("collar")), query
+
+    # ---------------- Upload state on disk ----------------
+    def file_paths(self, collar: str, file_name: str) -> tuple[str, str, str]:
+        collar_dir = os.path.join(COLLECTOR_FILES_DIR, collar)
+        os.makedirs(collar_dir, exist_ok=True)
+        path = os.path.join(collar_dir, file_name)
+        return path, path + PARTIAL_FILE_EXTENSION, path + ETAG_FILE_EXTENSION
+
+    def current_offset(self, collar: str, file_name: str, etag: str, length: int) -> int:
+
+        # Bytes we have of this version of the file, a partial file of another version is dropped
+        path, part_path, etag_path = self.file_paths(collar, file_name)
+        stored_etag = open(etag_path).read() if os.path.exists(etag_path) else None
+        if stored_etag == etag and os.path.exists(path) and not os.path.exists(part_path):
+            return length    # Uploaded before, the collar did not get to /upload/done
+        if stored_etag != etag or not os.path.exists(part_path):
+            with open(part_path, "wb"), open(etag_path, "w") as etag_file:
+                etag_file.write(etag)
+        offset = os.path.getsize(part_path)
+        if offset == length:
+            self.finish_file(collar, file_name)
+        return offset
+
+    def finish_file(self, collar: str, file_name: str) -> None:
+        path, part_path, _ = self.file_paths(collar, file_name)
+        os.replace(part_path, path)
+        logger.info(f"{collar}: received {file_name} ({os.path.getsize(path)} bytes).")
+        if file_name.endswith(TRACK_FILE_EXTENSION):
+            with open(path, "rb") as file:
+                csv_file = self.track_decoder.decode_to_csv(file.read(), file_name)
+            if csv_file is not None:
+                with open(path.replace(TRACK_FILE_EXTENSION, ".csv"), "wb") as file:
+                    file.write(csv_file)
+
+    # ---------------- Requests ----------------
+    def do_GET(self) -> None:
+        path, collar, query = self.parse_request_target()
+        file_name = safe_name(query.get("file"))
+        if path != "/upload" or collar is None or file_name is None:
+            self.send_text(HTTP_NOT_FOUND, "not found")
+            return
+        try:
+            length = int(self.headers.get("Upload-Length", ""))
+        except ValueError:
+            self.send_text(HTTP_BAD_REQUEST, "missing Upload-Length")
+            return
+        self.send_text(HTTP_OK, str(self.current_offset(collar, file_name, self.headers.get("Upload-Etag", ""), length)))
+
+    def do_POST(self) -> None:
+        path, collar, query = self.parse_request_target()
+        body = self.rfile.read(int(self.headers.get("Content-Length", 0)))
+        if collar is None:
+            self.send_text(HTTP_NOT_FOUND, "not found")
+        elif path == "/upload/done":
+            self.upload_done(collar, query.get("cursor", ""))
+        elif path == "/upload" and safe_name(query.get("file")) is not None:
+            self.upload_piece(collar, safe_name(query.get("file")), body)
+        else:
+            self.send_text(HTTP_NOT_FOUND, "not found")
+
+    def upload_piece(self, collar: str, file_name: str, body: bytes) -> None:
+        try:
+            length = int(self.headers["Upload-Length"])
+            offset = int(self.headers["Upload-Offset"])
+        except (KeyError, ValueError):
+            self.send_text(HTTP_BAD_REQUEST, "missing Upload-Length or Upload-Offset")
+            return
+
+        # The piece must continue exactly where we are, otherwise the collar continues from our offset
+        current = self.current_offset(collar, file_name, self.headers.get("Upload-Etag", ""), length)
+        if offset != current or offset + len(body) > length:
+            logger.warning(f"{collar}: {file_name} piece at {offset}, have {current} bytes.")
+            self.send_text(HTTP_CONFLICT, str(current))
+            return
+        # A piece cut off by a dropped connection keeps the bytes that arrived, the collar asks for the offset again
+        _, part_path, _ = self.file_paths(collar, file_name)
+        with open(part_path, "ab") as file:
+            file.write(body)
+        if offset + len(body) == length:
+            self.finish_file(collar, file_name)
+        self.send_text(HTTP_OK, str(offset + len(body)))
+
+    def upload_done(self, collar: str, cursor: str) -> None:
+        if not cursor.isdigit():
+            self.send_text(HTTP_BAD_REQUEST, "missing cursor")
+            return
+        with open(os.path.join(COLLECTOR_FILES_DIR, collar, CURSOR_FILE), "w") as file:
+            file.write(cursor)
+        logger.info(f"{collar}: upload complete up to cursor {cursor}.")
+        self.send_text(HTTP_OK, cursor)
+
+
+def advertise(port: int):
+    if Zeroconf is None:
+        logger.warning("zeroconf is not installed, collars will not find the collector")
+        return None
+    host_name = socket.gethostname()
+    with socket.socket(socket.AF_INET, socket.SOCK_DGRAM) as probe:
+        probe.connect(("10.255.255.255", 1))    # No packet is sent, only picks the interface of the default route
+        address = probe.getsockname()[0]
+    info = ServiceInfo(COLLECTOR_SERVICE_TYPE, f"{host_name}.{COLLECTOR_SERVICE_TYPE}",
+                       addresses=[socket.inet_aton(address)], port=port)
+    zeroconf = Zeroconf()
+    zeroconf.register_service(info)
+    logger.info(f"Advertising {COLLECTOR_SERVICE_TYPE} at {address}:{port}")
+    return zeroconf
+
+
+if __name__ == "__main__":
+
+    setup_logging()
+    port = int(sys.argv[1]) if len(sys.argv) > 1 else COLLECTOR_PORT
+    os.makedirs(COLLECTOR_FILES_DIR, exist_ok=True)
+    zeroconf = advertise(port)
+    try:
+        ThreadingHTTPServer(("", port), CollectorHandler).serve_forever()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if zeroconf is not None:
+            zeroconf.unregister_all_services()
+            zeroconf.close()
@@ -1,24 +1,37 @@
 from multiprocessing import get_logger
+import zlib
 import requests
 from bs4 import BeautifulSoup
-from local_storage_manager import LocalStorageManager, FILE_LIST_ENDPOINT, GPX_FILES_DIR, DOWNLOAD_FILE_ENDPOINT
+from local_storage_manager import LocalStorageManager, FILE_LIST_ENDPOINT, GPX_FILES_DIR, DOWNLOAD_FILE_ENDPOINT, TRACK_FILE_EXTENSION, MANIFEST_ENDPOINT, EXPORT_ENDPOINT, ACK_ENDPOINT
 from gpx_converter import GPXConverter
+from track_decoder import TrackDecoder
+from collar_archive import CollarArchiveParser, ArchiveFormatError
 from strava_uploader import StravaUploader
 from logging_util import get_logger
 HTTP_OK = 200   
+HTTP_NOT_FOUND = 404
+HTTP_PARTIAL_CONTENT = 206
+HTTP_RANGE_NOT_SATISFIABLE = 416
 DOWNLOAD_TIMEOUT = 10 
+DOWNLOAD_RETRIES = 3        # Attempts per sync, every attempt continues where the previous one stopped
+DOWNLOAD_CHUNK_SIZE = 1460     # Collar sends TCP MSS sized pieces, at most one is lost when the link drops
+EXPORT_CHUNK_SIZE = 4096
 
 logger = get_logger(__name__)
 class DogCollarClient:
-    def __init__(self, esp_32_server_url: str) -> None:
-        self.storage_manager = LocalStorageManager()
+    def __init__(self, esp_32_server_url: str, collar_name: str | None = None) -> None:
+        self.storage_manager = LocalStorageManager(collar_name)
         self.GPXConverter = GPXConverter()
+        self.track_decoder = TrackDecoder()
         self.strava_uploader = StravaUploader()
         self.esp_32_server_url = esp_32_server_url
+        self.session = requests.Session()   # Keep-alive: one TCP connection for all requests of a sync
+        self.manifest = {}              # File name -> manifest entry (size, mtime, crc32, cursor) of the last listing
+        self.manifest_cursor = None     # Cursor of the last manifest, saved by commit_sync_cursor()
 
     def is_connected(self) -> bool:
         try:
-            response = requests.get(self.esp_32_server_url, timeout=DOWNLOAD_TIMEOUT)
+            response = self.session.get(self.esp_32_server_url, timeout=DOWNLOAD_TIMEOUT)
             return response.status_code == HTTP_OK
         except requests.exceptions.RequestException as e:
             return False
@@ -32,12 +45,17 @@ class DogCollarClient:
         if not self.is_connected():
             return []
 
+        # Collars with the manifest only list what changed since the last sync
+        file_names = self.get_manifest_file_list()
+        if file_names is not None:
+            return file_names
+
         # Construct the URL for the file list endpoint
         url = f"{self.esp_32_server_url}{FILE_LIST_ENDPOINT}" #---> dogcollar.local/files
 
         # Make the request to retrieve the file list
         try:
-            response = requests.get(url, timeout=DOWNLOAD_TIMEOUT)
+            response = self.session.get(url, timeout=DOWNLOAD_TIMEOUT)
             response.raise_for_status()  # Raises HTTPError for bad responses
         except requests.exceptions.HTTPError as e:
             logger.error(f"HTTP error while retrieving file list: {e.response.status_code}")
@@ -57,6 +75,137 @@ class DogCollarClient:
             logger.error(f"Failed to parse file list: {str(e)}")
             return []
 
+    def export_files(self) -> list[str] | None:
+
+        # All files changed since the last sync in one request. Returns the collar file names that are new locally,
+        # or None if the collar has no /export (older firmware) and the files have to be downloaded one by one
+        since = self.storage_manager.get_sync_cursor()
+        url = f"{self.esp_32_server_url}{EXPORT_ENDPOINT}?since={since}" #---> dogcollar.local/export?since=CURSOR
+        new_files = []
+
+        def open_entry(entry: dict):
+            return self.storage_manager.open_partial_download(entry["name"], None, append=False)
+
+        def close_entry(entry: dict, crc_ok: bool) -> None:
+            if not crc_ok:
+                self.storage_manager.discard_partial_download(entry["name"])
+                return
+            if self.store_exported_file(entry["name"]):
+                new_files.append(entry["name"])
+
+        # Files are unpacked while they arrive, the ones before an interruption are kept
+        parser = CollarArchiveParser(open_entry, close_entry)
+        try:
+            with self.session.get(url, stream=True, timeout=DOWNLOAD_TIMEOUT) as response:
+                if response.status_code == HTTP_NOT_FOUND:
+                    return None
+                response.raise_for_status()
+                for chunk in response.iter_content(chunk_size=EXPORT_CHUNK_SIZE):
+                    parser.feed(chunk)
+        except requests.exceptions.RequestException as e:
+            logger.warning(f"Export interrupted after {parser.entries} files: {e}")
+        except ArchiveFormatError as e:
+            logger.error(f"Invalid export archive: {e}")
+
+        if not parser.finished:
+            if parser.entry is not None:    # Drop the file that was cut off
+                parser.entry_file.close()
+                self.storage_manager.discard_partial_download(parser.entry["name"])
+            return new_files    # Cursor stays, the rest comes with the next sync
+
+        # A lower cursor means the collar was formatted - export everything again
+        if parser.cursor < since:
+            logger.warning(f"Collar sync cursor went back from {since} to {parser.cursor}, exporting all files.")
+            self.storage_manager.save_sync_cursor(0)
+            return new_files + (self.export_files() or [])
+
+        self.storage_manager.save_sync_cursor(parser.cursor)
+        self.ack_sync_cursor(parser.cursor)
+        logger.info(f"Exported {parser.entries} files ({len(new_files)} new) up to cursor {parser.cursor}.")
+        return new_files
+
+    def store_exported_file(self, file_name: str) -> bool:
+
+        # Same rule as download_file(): files that are already stored locally are not processed again
+        local_file_name = self.get_local_file_name(file_name)
+        is_new = not self.storage_manager.file_exists(local_file_name)
+        self.storage_manager.finish_partial_download(file_name)
+
+        if not is_new or not file_name.endswith(TRACK_FILE_EXTENSION):
+            return is_new
+
+        csv_file = self.track_decoder.decode_to_csv(self.storage_manager.get_file_locally(file_name), file_name)
+        if csv_file is None:
+            return False
+        self.storage_manager.save_file_locally(local_file_name, csv_file)
+        return True
+
+    def get_manifest_file_list(self) -> list[str] | None:
+
+        # Returns None if the collar has no manifest (older firmware), the caller then scrapes /files
+        since = self.storage_manager.get_sync_cursor()
+        url = f"{self.esp_32_server_url}{MANIFEST_ENDPOINT}?since={since}" #---> dogcollar.local/manifest?since=CURSOR
+
+        try:
+            response = self.session.get(url, timeout=DOWNLOAD_TIMEOUT)
+            if response.status_code == HTTP_NOT_FOUND:
+                return None
+            response.raise_for_status()
+            manifest = response.json()
+        except requests.exceptions.RequestException as e:
+            logger.error(f"Network error while retrieving manifest: {e}")
+            return []
+        except ValueError as e:
+            logger.error(f"Failed to parse manifest: {e}")
+            return []
+
+        # A lower cursor means the collar was formatted - list everything again
+        if manifest["cursor"] < since:
+            logger.warning(f"Collar sync cursor went back from {since} to {manifest['cursor']}, listing all files.")
+            self.storage_manager.save_sync_cursor(0)
+            return self.get_manifest_file_list()
+
+        self.manifest = {entry["name"]: entry for entry in manifest["files"]}
+        self.manifest_cursor = manifest["cursor"]
+        logger.info(f"Got the manifest: {len(self.manifest)} files changed since cursor {since}.")
+        return list(self.manifest)
+
+    def commit_sync_cursor(self, file_names: list[str]) -> None:
+
+        # The cursor only moves on once every listed file is stored locally, otherwise they are listed again
+        if self.manifest_cursor is None:
+            return
+        if all(self.storage_manager.file_exists(self.get_local_file_name(name)) for name in file_names):
+            self.storage_manager.save_sync_cursor(self.manifest_cursor)
+            self.ack_sync_cursor(self.manifest_cursor)
+            self.manifest_cursor = None
+
+    def ack_sync_cursor(self, cursor: int) -> None:
+
+        # Tells the collar what we have stored, it turns Wi-Fi off early once nothing is pending
+        url = f"{self.esp_32_server_url}{ACK_ENDPOINT}?cursor={cursor}" #---> dogcollar.local/ack?cursor=CURSOR
+        try:
+            response = self.session.post(url, timeout=DOWNLOAD_TIMEOUT)
+            if response.status_code == HTTP_NOT_FOUND:
+                return  # Older firmware, it keeps Wi-Fi on for the whole sync window
+            response.raise_for_status()
+            logger.info(f"Acknowledged cursor {cursor}, collar reports {response.json()['pending_files']} files pending.")
+        except (requests.exceptions.RequestException, ValueError, KeyError) as e:
+            logger.warning(f"Failed to acknowledge cursor {cursor}: {e}")
+
+    def verify_downloaded_file(self, file_name: str) -> bool:
+
+        # Only checked if we got exactly the listed bytes, the collar may have appended to the file since the listing
+        entry = self.manifest.get(file_name)
+        data = self.storage_manager.get_file_locally(file_name)
+        if entry is None or data is None or len(data) != entry["size"]:
+            return True
+        if zlib.crc32(data) != int(entry["crc32"], 16):
+            logger.error(f"CRC of '{file_name}' does not match the manifest, discarding it.")
+            self.storage_manager.delete_file_locally(file_name)
+            return False
+        return True
+
     def parse_file_list(self, response_content: str) -> list[str]:
         soup = BeautifulSoup(response_content, "html.parser")
         file_names = []
@@ -66,6 +215,12 @@ class DogCollarClient:
                 file_names.append(link.text)
         return file_names
 
+    def get_local_file_name(self, file_name: str) -> str:
+        # Binary track files are decoded to CSV after downloading
+        if file_name.endswith(TRACK_FILE_EXTENSION):
+            return file_name[:-len(TRACK_FILE_EXTENSION)] + ".csv"
+        return file_name
+
     def download_file(self, file_name: str) -> bool:
 
         # Ensure the file name is valid
@@ -74,20 +229,20 @@ class DogCollarClient:
             return False
 
         # Check if the file already exists locally
-        if self.storage_manager.file_exists(file_name):
-            logger.info(f"File '{file_name}' already exists locally. Skipping download.")
+        local_file_name = self.get_local_file_name(file_name)
+        if self.storage_manager.file_exists(local_file_name):
+            logger.info(f"File '{local_file_name}' already exists locally. Skipping download.")
             return False
 
+        if file_name.endswith(TRACK_FILE_EXTENSION):
+            return self.download_track_file(file_name, local_file_name)
+
         # Construct the URL for the download endpoint
         url = f"{self.esp_32_server_url}/{DOWNLOAD_FILE_ENDPOINT}{file_name}" #---> dogcollar.local/download?file=FILENAME
 
-        # Check if the client is connected before attempting to download
-        if not self.is_connected():
-            return False
-
         # Make the request to download the file
         try:
-            response = requests.get(url, timeout=DOWNLOAD_TIMEOUT)
+            response = self.session.get(url, timeout=DOWNLOAD_TIMEOUT)
             response.raise_for_status()
         except requests.exceptions.HTTPError as e:
             logger.error(f"HTTP error while downloading '{file_name}': {e.response.status_code}")
@@ -100,11 +255,90 @@ class DogCollarClient:
             return False
 
         # Save the downloaded file locally
-        self.storage_manager.save_file_locally(file_name, response.content)
-        logger.info(f"Downloaded '{file_name}' successfully.")
+        self.storage_manager.save_file_locally(local_file_name, response.content)
+        logger.info(f"Downloaded '{file_name}' as '{local_file_name}' successfully.")
+
+        return True
+
+    def download_track_file(self, file_name: str, local_file_name: str) -> bool:
+
+        # Track files are downloaded raw (smaller than CSV and resumable), then decoded here
+        for attempt in range(1, DOWNLOAD_RETRIES + 1):
+            try:
+                if self.download_raw_file_resumable(file_name):
+                    break
+            except requests.exceptions.RequestException as e:
+                offset, _ = self.storage_manager.get_partial_download(file_name)
+                logger.warning(f"Download of '{file_name}' interrupted at {offset} bytes "
+                               f"(attempt {attempt}/{DOWNLOAD_RETRIES}): {e}")
+            except Exception as e:
+                logger.error(f"Unexpected error while downloading '{file_name}': {e}")
+                return False
+        else:
+            logger.error(f"Failed to download '{file_name}', will resume on the next sync.")
+            return False
+
+        if not self.verify_downloaded_file(file_name):
+            return False
+
+        raw_file = self.storage_manager.get_file_locally(file_name)
+        csv_file = self.track_decoder.decode_to_csv(raw_file, file_name) if raw_file is not None else None
+        if csv_file is None:
+            return False
+
+        self.storage_manager.save_file_locally(local_file_name, csv_file)
+        logger.info(f"Downloaded '{file_name}' as '{local_file_name}' successfully.")
+        return True
+
+    def download_raw_file_resumable(self, file_name: str) -> bool:
+
+        url = f"{self.esp_32_server_url}/{DOWNLOAD_FILE_ENDPOINT}{file_name}&format=raw"
+        offset, etag = self.storage_manager.get_partial_download(file_name)
+
+        # Ask only for the missing bytes; If-Range makes the collar send the whole file if it changed since
+        headers = {}
+        if offset > 0 and etag:
+            headers = {"Range": f"bytes={offset}-", "If-Range": etag}
+
+        with self.session.get(url, headers=headers, stream=True, timeout=DOWNLOAD_TIMEOUT) as response:
+
+            if response.status_code == HTTP_RANGE_NOT_SATISFIABLE:
+                # Nothing after offset: done if it is still the same file, otherwise start over
+                if offset > 0 and response.headers.get("ETag") == etag:
+                    self.storage_manager.finish_partial_download(file_name)
+                    return True
+                self.storage_manager.discard_partial_download(file_name)
+                return False
+
+            response.raise_for_status()
+            new_etag = response.headers.get("ETag")
+
+            if response.status_code == HTTP_PARTIAL_CONTENT:
+                # Content-Range: bytes <first>-<last>/<total>
+                content_range = response.headers.get("Content-Range", "")
+                first, _, total = content_range.removeprefix("bytes ").replace("/", "-").split("-")
+                if int(first) != offset:
+                    logger.warning(f"Collar sent '{file_name}' from byte {first} instead of {offset}, restarting.")
+                    self.storage_manager.discard_partial_download(file_name)
+                    return False
+                append, total_size = True, int(total)
+                logger.info(f"Resuming '{file_name}' at {offset} of {total_size} bytes.")
+            else:
+                append, total_size = False, int(response.headers.get("Content-Length", -1))
+                offset = 0
+
+            # Every chunk is on disk as soon as it arrives, so an interrupted download loses nothing
+            with self.storage_manager.open_partial_download(file_name, new_etag, append) as part_file:
+                for chunk in response.iter_content(chunk_size=DOWNLOAD_CHUNK_SIZE):
+                    part_file.write(chunk)
+                    offset += len(chunk)
+
+        if total_size >= 0 and offset != total_size:
+            logger.warning(f"Got {offset} of {total_size} bytes of '{file_name}'.")
+            return False
 
+        self.storage_manager.finish_partial_download(file_name)
         return True
-    
 
 
 
@@ -0,0 +1,184 @@
+"""Host side consumer of the collar live stream (WebSocket /live, live_stream.h).
+
+Prints every fix and, at the end, the frame latency:
+
+    python live_client.py [ws://dogcollar.local/live] [frames]
+
+- collar age: from the end of the NMEA line on the collar UART to the send of the frame (collar clock)
+- fix to host: from the GPS time of the fix to the arrival on this host, only meaningful with an NTP synced clock
+"""
+import base64
+import hashlib
+import os
+import socket
+import struct
+import sys
+import time
+from dataclasses import dataclass
+from datetime import datetime, timezone
+from urllib.parse import urlparse
+from logging_util import get_logger, setup_logging
+
+LIVE_URL = "ws://dogcollar.local/live"
+LIVE_FRAME_VERSION = 1
+LIVE_FRAME = struct.Struct("<BBHIIIiiIHHiI")    # live_stream_frame_t
+LIVE_FLAG_VALID = 0x01
+HDOP_UNKNOWN = 0xFFFF
+ALTITUDE_UNKNOWN = -2**31
+CONNECT_TIMEOUT = 10
+WS_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+WS_OPCODE_BINARY = 0x2
+WS_OPCODE_CLOSE = 0x8
+WS_OPCODE_PING = 0x9
+WS_OPCODE_PONG = 0xA
+
+logger = get_logger(__name__)
+
+
+@dataclass
+class LiveFix:
+    seq: int
+    dropped: int            # Fixes the collar dropped before this one (slow link)
+    valid: bool
+    utc: datetime
+    latitude: float
+    longitude: float
+    speed_m_s: float
+    course_deg: float
+    hdop: float | None
+    altitude_m: float | None
+    collar_age_ms: float    # UART line to send, on the collar
+    received: float         # time.time() on arrival
+
+    @classmethod
+    def from_frame(cls, payload: bytes, received: float) -> "LiveFix":
+        (version, flags, dropped, seq, date, time_ms, lat_e6, lon_e6, speed_mm_s, course_cdeg,
+         hdop_x100, altitude_dm, age_us) = LIVE_FRAME.unpack(payload[:LIVE_FRAME.size])
+        if version != LIVE_FRAME_VERSION:
+            raise ValueError(f"unsupported live frame version {version}")
+        try:
+            utc = datetime(date // 10000, date // 100 % 100, date % 100, tzinfo=timezone.utc).timestamp() + time_ms / 1000
+            utc = datetime.fromtimestamp(utc, timezone.utc)
+        except ValueError:  # No date before the first fix
+            utc = datetime.fromtimestamp(0, timezone.utc)
+        return cls(seq, dropped, bool(flags & LIVE_FLAG_VALID), utc, lat_e6 / 1e6, lon_e6 / 1e6, speed_mm_s / 1000,
+                   course_cdeg / 100, None if hdop_x100 == HDOP_UNKNOWN else hdop_x100 / 100,
+                   None if altitude_dm == ALTITUDE_UNKNOWN else altitude_dm / 10, age_us / 1000, received)
+
+    @property
+    def fix_to_host_ms(self) -> float:
+        return (self.received - self.utc.timestamp()) * 1000
+
+
+class LiveClient:
+    """Minimal WebSocket client (RFC 6455), only what the collar stream needs: binary frames, ping, close."""
+
+    def __init__(self, url: str = LIVE_URL) -> None:
+        self.url = urlparse(url)
+        self.sock = None
+        self.buffer = b""
+
+    def connect(self) -> None:
+        self.sock = socket.create_connection((self.url.hostname, self.url.port or 80), timeout=CONNECT_TIMEOUT)
+        self.sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        key = base64.b64encode(os.urandom(16)).decode()
+        self.sock.sendall((f"GET {self.url.path or '/'} HTTP/1.1\r\nHost: {self.url.hostname}\r\n"
+                           f"Upgrade: websocket\r\nConnection: Upgrade\r\n"
+                           f"Sec-WebSocket-Key: {key}\r\nSec-WebSocket-Version: 13\r\n\r\n").encode())
+        while b"\r\n\r\n" not in self.buffer:
+            self.buffer += self.recv_some()
+        head, self.buffer = self.buffer.split(b"\r\n\r\n", 1)
+        lines = head.decode(errors="replace").split("\r\n")
+        headers = {name.strip().lower(): value.strip() for name, _, value in (line.partition(":") for line in lines[1:])}
+        accept = base64.b64encode(hashlib.sha1((key + WS_GUID).encode()).digest()).decode()
+        if " 101 " not in lines[0] + " " or headers.get("sec-websocket-accept") != accept:
+            raise ConnectionError(f"WebSocket handshake failed: {lines[0]}")
+        self.sock.settimeout(None)  # Fixes come once per second, wait as long as it takes
+
+    def close(self) -> None:
+        if self.sock is not None:
+            try:
+                self.send_frame(WS_OPCODE_CLOSE, b"")
+            except OSError:
+                pass
+            self.sock.close()
+            self.sock = None
+
+    def recv_some(self) -> bytes:
+        data = self.sock.recv(4096)
+        if not data:
+            raise ConnectionError("collar closed the connection")
+        return data
+
+    def recv_exact(self, n: int) -> bytes:
+        while len(self.buffer) < n:
+            self.buffer += self.recv_some()
+        data, self.buffer = self.buffer[:n], self.buffer[n:]
+        return data
+
+    def send_frame(self, opcode: int, payload: bytes) -> None:
+        mask = os.urandom(4)    # Client frames must be masked
+        masked = bytes(byte ^ mask[i % 4] for i, byte in enumerate(payload))
+        self.sock.sendall(bytes([0x80 | opcode, 0x80 | len(payload)]) + mask + masked)
+
+    def frames(self):
+        # Yields LiveFix for every binary frame until the collar closes the stream
+        while True:
+            first, second = self.recv_exact(2)
+            opcode, length = first & 0x0F, second & 0x7F
+            if length == 126:
+                length = struct.unpack(">H", self.recv_exact(2))[0]
+            elif length == 127:
+                length = struct.unpack(">Q", self.recv_exact(8))[0]
+            payload = self.recv_exact(length)   # Server frames are not masked
+            received = time.time()
+            if opcode == WS_OPCODE_BINARY:
+                yield LiveFix.from_frame(payload, received)
+            elif opcode == WS_OPCODE_PING:
+                self.send_frame(WS_OPCODE_PONG, payload)
+            elif opcode == WS_OPCODE_CLOSE:
+                return
+
+
+def percentile(values: list[float], p: float) -> float:
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(len(ordered) * p))]
+
+
+def log_latency(fixes: list[LiveFix]) -> None:
+    if not fixes:
+        logger.info("No frames received.")
+        return
+    ages = [fix.collar_age_ms for fix in fixes]
+    host = [fix.fix_to_host_ms for fix in fixes if fix.valid]
+    dropped = sum(fix.dropped for fix in fixes)
+    logger.info(f"{len(fixes)} frames, {dropped} fixes dropped on the collar.")
+    logger.info(f"Collar age ms: p50 {percentile(ages, 0.5):.1f} p95 {percentile(ages, 0.95):.1f} max {max(ages):.1f}")
+    if host:
+        logger.info(f"Fix to host ms: p50 {percentile(host, 0.5):.1f} p95 {percentile(host, 0.95):.1f} max {max(host):.1f}")
+
+
+if __name__ == "__main__":
+
+    setup_logging()
+    url = sys.argv[1] if len(sys.argv) > 1 else LIVE_URL
+    count = int(sys.argv[2]) if len(sys.argv) > 2 else None
+    client = LiveClient(url)
+    fixes = []
+    try:
+        client.connect()
+        logger.info(f"Connected to {url}")
+        for fix in client.frames():
+            fixes.append(fix)
+            logger.info(f"#{fix.seq} {fix.utc:%H:%M:%S.%f}"[:-3] + f" {'A' if fix.valid else 'V'} "
+                        f"{fix.latitude:.6f},{fix.longitude:.6f} {fix.speed_m_s:.1f} m/s "
+                        f"age {fix.collar_age_ms:.1f} ms" + (f", {fix.dropped} dropped" if fix.dropped else ""))
+            if count is not None and len(fixes) >= count:
+                break
+    except KeyboardInterrupt:
+        pass
+    except (OSError, ConnectionError, ValueError) as e:
+        logger.error(f"Live stream stopped: {e}")
+    finally:
+        client.close()
+        log_latency(fixes)
@@ -2,7 +2,14 @@ from logging_util import get_logger
 import os
 
 FILE_LIST_ENDPOINT = "/files"
+MANIFEST_ENDPOINT = "/manifest"
+EXPORT_ENDPOINT = "/export"
+ACK_ENDPOINT = "/ack"
+SYNC_CURSOR_FILE = "sync_cursor"   # Manifest cursor of the last complete sync, in RAW_ESP32_FILES_DIR
 DOWNLOAD_FILE_ENDPOINT = "download?file="
+TRACK_FILE_EXTENSION = ".trk"    # Binary track files on the collar, downloaded raw and decoded to CSV
+PARTIAL_FILE_EXTENSION = ".part" # Download in progress, resumed with an HTTP Range request
+ETAG_FILE_EXTENSION = ".etag"    # ETag of the partial download, the collar only resumes if the file did not change
 RAW_ESP32_FILES_DIR = "raw_esp32_files"
 GPX_FILES_DIR = "gpx_files"
 
@@ -10,8 +17,11 @@ logger = get_logger(__name__)
 
 
 class LocalStorageManager:
-    def __init__(self):
+    def __init__(self, collar_name: str | None = None):
         self.ensure_directories() # Make sure directories exist
+        # Every collar has its own cursor, collars found over mDNS are told apart by their instance name
+        self.sync_cursor_file = SYNC_CURSOR_FILE if collar_name is None else \
+            f"{SYNC_CURSOR_FILE}_{''.join(c if c.isalnum() else '_' for c in collar_name)}"
 
     def ensure_directories(self) -> None:
         if not os.path.exists(RAW_ESP32_FILES_DIR):
@@ -23,7 +33,7 @@ class LocalStorageManager:
     def get_file_path_from_extension(self, file_name: str) -> str | None:
         if ".gpx" in file_name:
             return os.path.join(GPX_FILES_DIR, file_name)
-        elif "csv" in file_name:
+        elif "csv" in file_name or TRACK_FILE_EXTENSION in file_name:
             return os.path.join(RAW_ESP32_FILES_DIR, file_name)
         
         return None
@@ -71,6 +81,44 @@ class LocalStorageManager:
     def file_exists(self, file_name: str) -> bool:
         return os.path.exists(os.path.join(RAW_ESP32_FILES_DIR, file_name))
 
+    def get_sync_cursor(self) -> int:
+        try:
+            with open(os.path.join(RAW_ESP32_FILES_DIR, self.sync_cursor_file), 'r') as file:
+                return int(file.read().strip() or 0)
+        except (FileNotFoundError, ValueError):
+            return 0
+
+    def save_sync_cursor(self, cursor: int) -> None:
+        with open(os.path.join(RAW_ESP32_FILES_DIR, self.sync_cursor_file), 'w') as file:
+            file.write(str(cursor))
+
+    # ---------------- Partial downloads (resumed with HTTP Range) ----------------
+    def get_partial_download(self, file_name: str) -> tuple[int, str | None]:
+        part_path = os.path.join(RAW_ESP32_FILES_DIR, file_name + PARTIAL_FILE_EXTENSION)
+        etag_path = os.path.join(RAW_ESP32_FILES_DIR, file_name + ETAG_FILE_EXTENSION)
+        if not os.path.exists(part_path) or not os.path.exists(etag_path):
+            return 0, None
+        with open(etag_path, 'r') as file:
+            etag = file.read().strip()
+        return os.path.getsize(part_path), etag or None
+
+    def open_partial_download(self, file_name: str, etag: str | None, append: bool):
+        # Returns the open .part file, the caller writes the received bytes and closes it
+        with open(os.path.join(RAW_ESP32_FILES_DIR, file_name + ETAG_FILE_EXTENSION), 'w') as file:
+            file.write(etag or "")
+        return open(os.path.join(RAW_ESP32_FILES_DIR, file_name + PARTIAL_FILE_EXTENSION), 'ab' if append else 'wb')
+
+    def finish_partial_download(self, file_name: str) -> None:
+        os.replace(os.path.join(RAW_ESP32_FILES_DIR, file_name + PARTIAL_FILE_EXTENSION),
+                   os.path.join(RAW_ESP32_FILES_DIR, file_name))
+        self.discard_partial_download(file_name)
+
+    def discard_partial_download(self, file_name: str) -> None:
+        for extension in (PARTIAL_FILE_EXTENSION, ETAG_FILE_EXTENSION):
+            path = os.path.join(RAW_ESP32_FILES_DIR, file_name + extension)
+            if os.path.exists(path):
+                os.remove(path)
+
 # Example usage
 if __name__ == "__main__":
 
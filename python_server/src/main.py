@@ -7,33 +7,63 @@ import time
 setup_logging()
 logger = get_logger(__name__)
 
-if __name__ == "__main__":
+try:
+    from collar_discovery import CollarBrowser
+except ImportError:     # zeroconf is not installed, poll http://dogcollar.local instead
+    CollarBrowser = None
 
-        logger.info("Starting Dog Collar GPS Client")
-        client = DogCollarClient("http://dogcollar.local")
+DISCOVERY_TIMEOUT = 60  # Seconds, only bounds a wait, collars are synced as soon as they announce pending files
+
+
+def sync_collar(client: DogCollarClient) -> None:
+
+    # 1) Get all files changed since the last sync in one request
+    file_names = client.export_files()
 
-        # 1) Get the list of files 
-        while True:
-            file_names = client.get_file_list()
+    # 2) Older collars: get the list of files and download each file
+    if file_names is None:
+        listed_files = client.get_file_list()
+        file_names = [file_name for file_name in listed_files if client.download_file(file_name)]
+        client.commit_sync_cursor(listed_files) # Next time only ask for files that changed after this sync
 
-            for file_name in file_names:
+    for file_name in file_names:
 
-                # 2) Download each file 
-                if not client.download_file(file_name):
-                    continue # If file was already downloaded, we don't do any operations
+        # 3) Open file (track files are saved as CSV)
+        local_file_name = client.get_local_file_name(file_name)
+        file = client.storage_manager.get_file_locally(local_file_name)
 
-                # 3) Open file
-                file = client.storage_manager.get_file_locally(file_name)
+        # 4) Convert to gpx
+        gpx_file = client.GPXConverter.convert_to_gpx(file, local_file_name)
 
-                # 4) Convert to gpx
-                gpx_file = client.GPXConverter.convert_to_gpx(file, file_name)
+        # 5) Save gpx file locally
+        gpx_file_name = local_file_name.replace('.csv', '.gpx')
+        client.storage_manager.save_file_locally(gpx_file_name, gpx_file)
 
-                # 5) Save gpx file locally
-                gpx_file_name = file_name.replace('.csv', '.gpx')
-                client.storage_manager.save_file_locally(gpx_file_name, gpx_file)
+        # 6) Upload to Strava
+        client.strava_uploader.upload_gpx_file(os.path.join(GPX_FILES_DIR, gpx_file_name))
 
-                # 6) Upload to Strava
-                client.strava_uploader.upload_gpx_file(os.path.join(GPX_FILES_DIR, gpx_file_name))
 
+if __name__ == "__main__":
+
+        logger.info("Starting Dog Collar GPS Client")
+
+        if CollarBrowser is None:
+            logger.warning("zeroconf is not installed, polling http://dogcollar.local")
+            client = DogCollarClient("http://dogcollar.local")
+            while True:
+                sync_collar(client)
 
-    
\ No newline at end of file
+        # Collars announce pending files in their mDNS TXT records, only connect to the ones that have something new
+        browser = CollarBrowser()
+        clients = {}    # Instance name -> DogCollarClient
+        try:
+            while True:
+                for collar in browser.wait_for_pending(DISCOVERY_TIMEOUT):
+                    logger.info(f"Syncing {collar.name}: {collar.pending_files} files ({collar.pending_bytes} bytes) pending.")
+                    client = clients.get(collar.name)
+                    if client is None or client.esp_32_server_url != collar.url:
+                        client = clients[collar.name] = DogCollarClient(collar.url, collar.name)
+                    sync_collar(client)
+                    browser.mark_synced(collar)
+        finally:
+            browser.close()
@@ -0,0 +1,69 @@
+import struct
+from datetime import datetime, timezone
+from logging_util import get_logger
+
+# Binary track file (.trk) written by the collar, see embedded_firmware/components/track_format/track_format.h
+TRACK_FILE_MAGIC = b"DCGT"
+TRACK_FILE_VERSION = 1
+TRACK_HEADER_FORMAT = "<4sBBBBI4s"   # magic, version, header_size, record_size, flags, start_time, reserved
+TRACK_RECORD_FORMAT = "<iiHHBBh"     # dlat_e6, dlon_e6, dt_s, speed_cm_s, course, hdop_x10, altitude_m
+TRACK_RECORD_TIME_JUMP = 0xFFFF
+TRACK_RECORD_HDOP_UNKNOWN = 0xFF
+TRACK_RECORD_ALT_UNKNOWN = -32768
+
+CSV_HEADER = "timestamp,latitude,longitude,altitude,speed,course,hdop\n"
+
+logger = get_logger(__name__)
+
+
+def _wrap_int32(value: int) -> int:
+    return (value + 0x80000000) % 0x100000000 - 0x80000000
+
+
+def _e6_to_string(value_e6: int) -> str:
+    sign = "-" if value_e6 < 0 else ""
+    value_e6 = abs(value_e6)
+    return f"{sign}{value_e6 // 1000000}.{value_e6 % 1000000:06d}"
+
+
+class TrackDecoder:
+    """Converts a raw .trk file to the same CSV the collar sends for /download?format=csv."""
+
+    def decode_to_csv(self, data: bytes, file_name: str) -> bytes | None:
+
+        header_size = struct.calcsize(TRACK_HEADER_FORMAT)
+        if len(data) < header_size:
+            logger.error(f"Track file {file_name} has no header.")
+            return None
+
+        magic, version, file_header_size, record_size, _, start_time, _ = struct.unpack_from(TRACK_HEADER_FORMAT, data)
+        if magic != TRACK_FILE_MAGIC or version != TRACK_FILE_VERSION or file_header_size != header_size \
+                or record_size < struct.calcsize(TRACK_RECORD_FORMAT):
+            logger.error(f"Track file {file_name} has an unsupported header.")
+            return None
+
+        lines = [CSV_HEADER]
+        lat_e6, lon_e6, time = 0, 0, start_time
+
+        # A partial record at the end (file still being written) is ignored
+        for offset in range(header_size, len(data) - record_size + 1, record_size):
+            dlat, dlon, dt_s, speed_cm_s, course, hdop_x10, altitude_m = struct.unpack_from(TRACK_RECORD_FORMAT, data, offset)
+
+            if dt_s == TRACK_RECORD_TIME_JUMP:
+                time = (time + dlat) & 0xFFFFFFFF
+                continue
+
+            lat_e6 = _wrap_int32(lat_e6 + dlat)
+            lon_e6 = _wrap_int32(lon_e6 + dlon)
+            time = (time + dt_s) & 0xFFFFFFFF
+
+            timestamp = datetime.fromtimestamp(time, tz=timezone.utc).strftime("%Y-%m-%dT%H:%M:%SZ")
+            altitude = "" if altitude_m == TRACK_RECORD_ALT_UNKNOWN else str(altitude_m)
+            hdop = "" if hdop_x10 == TRACK_RECORD_HDOP_UNKNOWN else f"{hdop_x10 // 10}.{hdop_x10 % 10}"
+            course_deg = ((course * 36000 // 256) + 50) // 100 % 360
+
+            lines.append(f"{timestamp},{_e6_to_string(lat_e6)},{_e6_to_string(lon_e6)},{altitude},"
+                         f"{speed_cm_s // 100}.{speed_cm_s % 100:02d},{course_deg},{hdop}\n")
+
+        logger.info(f"Decoded {len(lines) - 1} points from {file_name}.")
+        return "".join(lines).encode("utf-8")